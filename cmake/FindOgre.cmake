@@ -109,7 +109,9 @@ endmacro()
 endif()
 
 macro(link_ogre)
-    if (WIN32)
+    if (BUILD_HEADLESS_SERVER)
+        # Headless server builds do not use Ogre, see BUILD_HEADLESS_SERVER in the root CMakeLists.txt.
+    elseif (WIN32)
         if (ENABLE_DIRECTX)
             target_link_libraries(${TARGET_NAME} debug OgreMain_d debug RenderSystem_Direct3D9_d)
             target_link_libraries(${TARGET_NAME} optimized OgreMain optimized RenderSystem_Direct3D9)
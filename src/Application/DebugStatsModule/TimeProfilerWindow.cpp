@@ -1872,6 +1872,17 @@ void TimeProfilerWindow::RefreshSceneComplexityProfilingData()
     text << "# of mesh entities in the scene: " << meshentities << std::endl;
     text << "# of animated entities in the scene: " << animated << std::endl;
     text << std::endl;
+
+    SceneMemoryUsage memoryUsage = scene->MemoryUsage();
+    text << "Scene memory" << std::endl;
+    text << "Total: " << memoryUsage.Total() / 1024 << " KBytes" << std::endl;
+    text << "Entities: " << memoryUsage.entityBytes / 1024 << " KBytes, components: " << memoryUsage.componentBytes / 1024 << " KBytes" << std::endl;
+    text << "# of pooled entities: " << memoryUsage.numPooledEntities << " (" << memoryUsage.pooledEntityBytes / 1024 << " KBytes)" << std::endl;
+    for(std::map<QString, ComponentTypeMemoryUsage>::const_iterator iter = memoryUsage.componentTypes.begin(); iter != memoryUsage.componentTypes.end(); ++iter)
+        text << iter->first.toStdString() << ": " << iter->second.numComponents << " components, " << iter->second.numBytes / 1024 << " KBytes" << std::endl;
+    if (!memoryUsage.entities.empty())
+        text << "Largest entity: " << memoryUsage.entities.front().first << " (" << memoryUsage.entities.front().second / 1024 << " KBytes)" << std::endl;
+    text << std::endl;
     
     // Count total vertices/triangles per mesh
     std::set<Ogre::Mesh*>::iterator mi = all_meshes.begin();
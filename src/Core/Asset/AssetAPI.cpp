@@ -13,6 +13,8 @@
 #include "GenericAssetFactory.h"
 #include "NullAssetFactory.h"
 #include "AssetCache.h"
+#include "AssetLoadQueue.h"
+#include "AssetLoadTelemetry.h"
 
 #include "Framework.h"
 #include "LoggingFunctions.h"
@@ -21,31 +23,86 @@
 #include "Profiler.h"
 #include "CoreStringUtils.h"
 #include "QtUtils.h"
+#include "HighPerfClock.h"
 
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QFileSystemWatcher>
 #include <QList>
 #include <QMap>
+#include <QThread>
 
 #include <boost/regex.hpp>
 
+#include <algorithm>
+
 #include "MemoryLeakCheck.h"
 
 AssetAPI::AssetAPI(Framework *framework, bool headless) :
     fw(framework),
     isHeadless(headless),
     assetCache(0),
-    diskSourceChangeWatcher(0)
+    diskSourceChangeWatcher(0),
+    loadQueue(0),
+    loadHandoffBudget(0.008),
+    decodeGeneration(0),
+    assetMemoryBudget(0),
+    totalAssetCpuMemory(0),
+    totalAssetGpuMemory(0),
+    assetUseCounter(0),
+    timeSinceMemoryBudgetCheck(0.0),
+    loadTelemetry(new AssetLoadTelemetry)
 {
     // The Asset API always understands at least this single built-in asset type "Binary".
     // You can use this type to request asset data as binary, without generating any kind of in-memory representation or loading for it.
     // Your module/component can then parse the content in a custom way.
     RegisterAssetTypeFactory(AssetTypeFactoryPtr(new BinaryAssetFactory("Binary")));
+
+    // By default, leave one core for the main thread, and do not use more than four asset load threads.
+    int numLoadThreads = std::min(std::max(QThread::idealThreadCount() - 1, 1), 4);
+    QStringList loadThreadsParam = fw->CommandLineParameters("--assetLoadThreads");
+    if (loadThreadsParam.size() > 0)
+    {
+        bool ok = false;
+        int value = loadThreadsParam.last().toInt(&ok);
+        if (ok && value >= 0)
+            numLoadThreads = value;
+        else
+            LogWarning("AssetAPI: Erroneous value given with --assetLoadThreads: " + loadThreadsParam.last() + ". Ignoring.");
+    }
+    QStringList loadBudgetParam = fw->CommandLineParameters("--assetLoadBudget");
+    if (loadBudgetParam.size() > 0)
+    {
+        bool ok = false;
+        double msecs = loadBudgetParam.last().toDouble(&ok);
+        if (ok && msecs > 0.0)
+            loadHandoffBudget = msecs / 1000.0;
+        else
+            LogWarning("AssetAPI: Erroneous value given with --assetLoadBudget: " + loadBudgetParam.last() + ". Ignoring.");
+    }
+    QStringList memoryBudgetParam = fw->CommandLineParameters("--assetMemoryBudget");
+    if (memoryBudgetParam.size() > 0)
+    {
+        bool ok = false;
+        double megabytes = memoryBudgetParam.last().toDouble(&ok);
+        if (ok && megabytes >= 0.0)
+            assetMemoryBudget = (u64)(megabytes * 1024.0 * 1024.0);
+        else
+            LogWarning("AssetAPI: Erroneous value given with --assetMemoryBudget: " + memoryBudgetParam.last() + ". Ignoring.");
+    }
+    if (numLoadThreads > 0)
+    {
+        loadQueue = new AssetLoadQueue(numLoadThreads);
+        if (loadQueue->NumThreads() == 0)
+            SAFE_DELETE(loadQueue);
+    }
 }
 
 AssetAPI::~AssetAPI()
 {
     Reset();
+    SAFE_DELETE(loadTelemetry);
 }
 
 void AssetAPI::OpenAssetCache(QString directory)
@@ -445,9 +502,11 @@ AssetPtr AssetAPI::CreateAssetFromFile(QString assetType, QString assetFile)
 
 void AssetAPI::ForgetAsset(QString assetRef, bool removeDiskSource)
 {
-    AssetPtr asset = GetAsset(assetRef);
+    AssetPtr asset = FindAsset(assetRef);
     if (asset.get())
         ForgetAsset(asset, removeDiskSource);
+    else if (contentAliases.erase(ResolveAssetRef("", assetRef)) > 0 && removeDiskSource && assetCache)
+        assetCache->DeleteAsset(ResolveAssetRef("", assetRef)); // The ref only shared the content of another asset, which is left alone.
 }
 
 void AssetAPI::ForgetAsset(AssetPtr asset, bool removeDiskSource)
@@ -456,6 +515,7 @@ void AssetAPI::ForgetAsset(AssetPtr asset, bool removeDiskSource)
         return;
 
     emit AssetAboutToBeRemoved(asset);
+    ForgetContentAliases(asset.get());
 
     // If we are supposed to remove the cached (or original for local assets) version of the asset, do so.
     if (removeDiskSource && !asset->DiskSource().isEmpty())
@@ -482,11 +542,36 @@ void AssetAPI::ForgetAsset(AssetPtr asset, bool removeDiskSource)
     if (diskSourceChangeWatcher && !asset->DiskSource().isEmpty())
         diskSourceChangeWatcher->removePath(asset->DiskSource());
     assets.erase(iter);
+
+    // The references of AssetRefListeners are kept, as the listeners release them by name later.
+    AssetMemoryUsageMap::iterator usage = assetMemoryUsage.find(asset->Name());
+    if (usage != assetMemoryUsage.end())
+    {
+        if (usage->second.numReferences > 0)
+        {
+            int numReferences = usage->second.numReferences;
+            usage->second = AssetMemoryUsage();
+            usage->second.numReferences = numReferences;
+        }
+        else
+            assetMemoryUsage.erase(usage);
+    }
+
+    // The assets depending on this one keep waiting for it, but its own dependencies are no longer tracked.
+    SetDependencyLoaded(asset->Name(), false);
+    RemoveAssetDependencies(asset->Name());
+    AssetDependencyGraph::iterator node = dependencyGraph.find(asset->Name());
+    if (node != dependencyGraph.end())
+    {
+        node->second.numPendingDependencies = 0;
+        if (node->second.dependents.empty())
+            dependencyGraph.erase(node);
+    }
 }
 
 void AssetAPI::DeleteAssetFromStorage(QString assetRef)
 {
-    AssetPtr asset = GetAsset(assetRef);
+    AssetPtr asset = FindAsset(assetRef);
 
     AssetProviderPtr provider = (asset.get() ? asset->GetAssetProvider() : AssetProviderPtr());
     if (!provider)
@@ -637,6 +722,8 @@ void AssetAPI::ForgetAllAssets()
 
 void AssetAPI::Reset()
 {
+    // Stop the asset load threads before any asset type is unloaded.
+    SAFE_DELETE(loadQueue);
     ForgetAllAssets();
     SAFE_DELETE(assetCache);
     SAFE_DELETE(diskSourceChangeWatcher);
@@ -645,7 +732,14 @@ void AssetAPI::Reset()
     assetTypeFactories.clear();
     defaultStorage.reset();
     readyTransfers.clear();
-    assetDependencies.clear();
+    dependencyGraph.clear();
+    contentSharedAssets.clear();
+    contentAliases.clear();
+    assetMemoryUsage.clear();
+    totalAssetCpuMemory = 0;
+    totalAssetGpuMemory = 0;
+    if (loadTelemetry)
+        loadTelemetry->Clear();
     currentUploadTransfers.clear();
     currentTransfers.clear();
     providers.clear();
@@ -719,10 +813,13 @@ AssetTransferPtr AssetAPI::RequestAsset(QString assetRef, QString assetType, boo
     if (iter2 != assets.end())
     {
         existing = iter2->second;
+        TouchAsset(assetRef);
         if (!assetType.isEmpty() && assetType != existing->Type())
             LogWarning("AssetAPI::RequestAsset: Tried to request asset \"" + assetRef + "\" by type \"" + assetType + "\". Asset by that name exists, but it is of type \"" + existing->Type() + "\"!");
         assetType = existing->Type();
     }
+    else if (!forceTransfer && (existing = ContentSharedAsset(assetRef)))
+        assetType = existing->Type();
     else
     {
         if (assetType.isEmpty())
@@ -751,6 +848,29 @@ AssetTransferPtr AssetAPI::RequestAsset(QString assetRef, QString assetType, boo
         return transfer;
     }
 
+    // An asset that was unloaded to stay within the memory budget is reloaded from its disk source, without asking its provider again.
+    AssetMemoryUsageMap::iterator usage = (existing && !forceTransfer ? assetMemoryUsage.find(assetRef) : assetMemoryUsage.end());
+    if (usage != assetMemoryUsage.end() && usage->second.unloadedByBudget && !existing->IsLoaded() && QFile::exists(existing->DiskSource()))
+    {
+        AssetTransferPtr transfer = AssetTransferPtr(new IAssetTransfer);
+        transfer->asset = existing;
+        transfer->source.ref = assetRef;
+        transfer->assetType = assetType;
+        transfer->provider = existing->GetAssetProvider();
+        transfer->storage = existing->GetAssetStorage();
+        transfer->diskSourceType = existing->DiskSourceType();
+        transfer->SetCachingBehavior(false, existing->DiskSource());
+        currentTransfers[assetRef] = transfer;
+        loadTelemetry->BeginTransfer(assetRef, assetType, "DiskSource");
+
+        // Like the asset providers, complete the transfer on a later frame, after the client has connected to its signals.
+        if (loadQueue)
+            CompleteTransferFromFile(transfer, existing->DiskSource());
+        else
+            readyTransfers.push_back(transfer); // AssetTransferCompleted loads the asset from its disk source, as the transfer has no data.
+        return transfer;
+    }
+
     // See if there is an asset upload that should block this download. If the same asset is being uploaded and downloaded simultaneously, make the download
     // wait until the upload completes.
     if (currentUploadTransfers.find(assetRef) != currentUploadTransfers.end())
@@ -783,6 +903,7 @@ AssetTransferPtr AssetAPI::RequestAsset(QString assetRef, QString assetType, boo
     }
     transfer->provider = provider;
     transfer->asset = existing; // Fill the asset if it exists in the system
+    loadTelemetry->BeginTransfer(assetRef, assetType, provider->Name());
 
     // Store the newly allocated AssetTransfer internally, so that any duplicated requests to this asset will return the same request pointer,
     // so we'll avoid multiple downloads to the exact same asset.
@@ -935,7 +1056,7 @@ QString AssetAPI::GenerateUniqueAssetName(QString assetTypePrefix, QString asset
     for(int i = 0; i < 10000; ++i) // The intent is to loop 'infinitely' until a name is found, but do an artificial limit to avoid voodoo bugs.
     {
         assetName = assetTypePrefix + "_" + assetNamePrefix + (assetNamePrefix.isEmpty() ? "" : "_") + QString::number(uniqueRunningAssetCounter++);
-        if (!GetAsset(assetName))
+        if (!FindAsset(assetName))
             return assetName;
     }
     assert(false);
@@ -1018,6 +1139,7 @@ AssetPtr AssetAPI::CreateNewAsset(QString type, QString name, AssetStoragePtr st
 
     // Remember this asset in the global AssetAPI storage.
     assets[name] = asset;
+    connect(asset.get(), SIGNAL(Unloaded(IAsset*)), this, SLOT(OnAssetUnloaded(IAsset*)), Qt::UniqueConnection);
 
     ///\bug DiskSource and DiskSourceType are not set yet.
     {
@@ -1038,7 +1160,20 @@ AssetTypeFactoryPtr AssetAPI::GetAssetTypeFactory(QString typeName) const
     return AssetTypeFactoryPtr();
 }
 
-AssetPtr AssetAPI::GetAsset(QString assetRef) const
+AssetPtr AssetAPI::GetAsset(QString assetRef)
+{
+    AssetPtr asset = FindAsset(assetRef);
+    // An asset that was unloaded to stay within the memory budget is in use again. RequestAsset reloads it from its disk source.
+    if (asset && !asset->IsLoaded())
+    {
+        AssetMemoryUsageMap::const_iterator usage = assetMemoryUsage.find(asset->Name());
+        if (usage != assetMemoryUsage.end() && usage->second.unloadedByBudget)
+            RequestAsset(asset->Name(), asset->Type());
+    }
+    return asset;
+}
+
+AssetPtr AssetAPI::FindAsset(QString assetRef) const
 {
     // First try to see if the ref has an exact match.
     AssetMap::const_iterator iter = assets.find(assetRef);
@@ -1071,6 +1206,97 @@ void AssetAPI::Update(f64 frametime)
     for(size_t i = 0; i < readyTransfers.size(); ++i)
         AssetTransferCompleted(readyTransfers[i].get());
     readyTransfers.clear();
+
+    ProcessFinishedAssetLoads();
+
+    if (assetCache)
+        assetCache->Update(frametime);
+
+    if (assetMemoryBudget > 0)
+    {
+        timeSinceMemoryBudgetCheck += frametime;
+        if (timeSinceMemoryBudgetCheck >= 1.0)
+        {
+            timeSinceMemoryBudgetCheck = 0.0;
+            UpdateAssetMemoryUsage();
+            // Unload a tenth below the budget, so that the assets are not unloaded a few at a time on every check.
+            if (totalAssetCpuMemory + totalAssetGpuMemory > assetMemoryBudget)
+                UnloadLeastRecentlyUsedAssets(assetMemoryBudget - assetMemoryBudget / 10);
+        }
+    }
+}
+
+int AssetAPI::NumPendingAssetLoads() const
+{
+    return loadQueue ? (int)loadQueue->NumPendingJobs() : 0;
+}
+
+void AssetAPI::ProcessFinishedAssetLoads()
+{
+    if (!loadQueue)
+        return;
+
+    PROFILE(AssetAPI_ProcessFinishedAssetLoads);
+
+    // Hand over at least one finished load per frame, and then as many as fit in the budget.
+    const tick_t startTime = GetCurrentClockTime();
+    const tick_t budget = (tick_t)(GetCurrentClockFreq() * loadHandoffBudget);
+    AssetLoadQueue::JobPtr job;
+    while(loadQueue && loadQueue->TakeFinished(job))
+    {
+        AssetPtr asset = job->asset;
+        if (!asset)
+        {
+            // A read job: complete the transfer, unless it was aborted or failed while the file was being read.
+            AssetTransferPtr transfer = job->transfer;
+            if (FindTransferIterator(transfer.get()) != currentTransfers.end())
+            {
+                if (job->success)
+                {
+                    transfer->rawAssetData.swap(job->data);
+                    AssetTransferCompleted(transfer.get());
+                }
+                else
+                    AssetTransferFailed(transfer.get(), "Failed to read asset data for asset \"" + transfer->source.ref + "\" from file \"" + job->filename + "\"");
+            }
+        }
+        else
+        {
+            // The asset may have been forgotten, unloaded or reloaded while it was being decoded. A newer job of a reloaded asset
+            // completes its transfer, but the transfer of an asset that was unloaded would be left waiting, so it is failed.
+            std::map<QString, u32>::iterator latest = latestDecodeJobs.find(asset->Name());
+            const bool superseded = (latest != latestDecodeJobs.end() && latest->second != job->generation);
+            const bool unloaded = (latest == latestDecodeJobs.end());
+            if (!superseded && !unloaded)
+                latestDecodeJobs.erase(latest);
+            AssetMap::const_iterator iter = assets.find(asset->Name());
+            if (iter != assets.end() && iter->second == asset && !superseded)
+            {
+                if (unloaded)
+                    AssetLoadFailed(asset->Name());
+                else
+                {
+                    if (job->decodeStartTime != 0)
+                    {
+                        loadTelemetry->MarkStage(asset->Name(), AssetLoadTelemetry::StageDecodeStarted, job->decodeStartTime);
+                        loadTelemetry->MarkStage(asset->Name(), AssetLoadTelemetry::StageDecodeFinished, job->decodeEndTime);
+                    }
+                    bool success = job->success && asset->LoadFromDecodedData(job->decoded);
+                    // An asset that was read from a cached file that could not be loaded is downloaded again.
+                    if (!success && (job->filename.isEmpty() || !RetryTransferFromSource(asset->Name())))
+                    {
+                        if (!job->error.isEmpty())
+                            LogError("AssetAPI: Failed to load asset \"" + asset->Name() + "\": " + job->error + ".");
+                        AssetLoadFailed(asset->Name());
+                    }
+                }
+            }
+        }
+
+        job.reset();
+        if (GetCurrentClockTime() - startTime >= budget)
+            break;
+    }
 }
 
 QString GuaranteeTrailingSlash(const QString &source)
@@ -1177,14 +1403,34 @@ void AssetAPI::AssetTransferCompleted(IAssetTransfer *transfer_)
     AssetTransferMap::const_iterator iter = FindTransferIterator(transfer_);
     if (iter == currentTransfers.end())
         LogError("AssetAPI: Asset \"" + transfer->assetType + "\", name \"" + transfer->source.ref + "\" transfer finished, but no corresponding AssetTransferPtr was tracked by AssetAPI!");
+    loadTelemetry->MarkStage(transfer->source.ref, AssetLoadTelemetry::StageDownloaded);
+
+    // Save this asset to cache, and find out which file will represent a cached version of this asset.
+    QString assetDiskSource = transfer->DiskSource(); // The asset provider may have specified an explicit filename to use as a disk source.
+    if (transfer->CachingAllowed() && transfer->rawAssetData.size() > 0 && assetCache)
+    {
+        assetDiskSource = assetCache->StoreAsset(&transfer->rawAssetData[0], transfer->rawAssetData.size(), transfer->source.ref);
+        loadTelemetry->MarkStage(transfer->source.ref, AssetLoadTelemetry::StageCacheWritten);
+    }
+
+    // If disksource is still empty, forcibly look up if the asset exists in the cache now.
+    if (assetDiskSource.isEmpty() && assetCache)
+        assetDiskSource = assetCache->FindInCache(transfer->source.ref);
+    
+    // With a content-addressed cache, identical content that is already loaded can be shared instead of loading it again.
+    if (!transfer->asset && CompleteTransferWithSharedContent(transfer))
+        return;
 
     // We've finished an asset data download, now create an actual instance of an asset of that type if it did not exist already
     if (!transfer->asset)
         transfer->asset = CreateNewAsset(transfer->assetType, transfer->source.ref);
+    else
+        ForgetContentAliases(transfer->asset.get()); // The content of an existing asset is being replaced, so it can no longer be shared by other refs.
     if (!transfer->asset)
     {
         QString error("AssetAPI: Failed to create new asset of type \"" + transfer->assetType + "\" and name \"" + transfer->source.ref + "\"");
         LogError(error);
+        loadTelemetry->MarkFailed(transfer->source.ref);
         transfer->EmitAssetFailed(error);
         return;
     }
@@ -1192,39 +1438,167 @@ void AssetAPI::AssetTransferCompleted(IAssetTransfer *transfer_)
     // Connect to Loaded() signal of the asset to be able to notify any dependent assets
     connect(transfer->asset.get(), SIGNAL(Loaded(AssetPtr)), this, SLOT(OnAssetLoaded(AssetPtr)), Qt::UniqueConnection);
 
-    // Save this asset to cache, and find out which file will represent a cached version of this asset.
-    QString assetDiskSource = transfer->DiskSource(); // The asset provider may have specified an explicit filename to use as a disk source.
-    if (transfer->CachingAllowed() && transfer->rawAssetData.size() > 0 && assetCache)
-        assetDiskSource = assetCache->StoreAsset(&transfer->rawAssetData[0], transfer->rawAssetData.size(), transfer->source.ref);
+    // Remember the content of shareable assets, so that other refs with identical content can use this asset.
+    if (assetCache && transfer->asset->IsContentShareable())
+    {
+        QString contentHash = assetCache->ContentHash(transfer->source.ref);
+        if (!contentHash.isEmpty())
+            contentSharedAssets[transfer->assetType + "/" + contentHash] = transfer->asset;
+    }
 
-    // If disksource is still empty, forcibly look up if the asset exists in the cache now.
-    if (assetDiskSource.isEmpty() && assetCache)
-        assetDiskSource = assetCache->FindInCache(transfer->source.ref);
-    
     // Save for the asset the storage and provider it came from.
     transfer->asset->SetDiskSource(assetDiskSource.trimmed());
     transfer->asset->SetDiskSourceType(transfer->diskSourceType);
     transfer->asset->SetAssetStorage(transfer->storage.lock());
     transfer->asset->SetAssetProvider(transfer->provider.lock());
 
+    // Remember the size of the asset data, as the memory usage estimate of asset types that do not estimate it themselves.
+    AssetMemoryUsage &usage = assetMemoryUsage[transfer->asset->Name()];
+    if (transfer->rawAssetData.size() > 0)
+        usage.dataSize = transfer->rawAssetData.size();
+    else if (!assetDiskSource.isEmpty())
+        usage.dataSize = QFileInfo(assetDiskSource).size();
+
     // Tell everyone this transfer has now been downloaded. Note that when this signal is fired, the asset dependencies may not yet be loaded.
     transfer->EmitAssetDownloaded();
 
+    // Asset types that support threaded decoding are read and decoded on the asset load threads.
+    // ProcessFinishedAssetLoads hands the decoded data to the asset on the main thread.
+    if (loadQueue && transfer->asset->SupportsThreadedDecode())
+    {
+        // A new job supersedes any decode of the asset still in progress, f.ex. when the asset is reloaded before the previous load finished.
+        const u32 generation = ++decodeGeneration;
+        latestDecodeJobs[transfer->asset->Name()] = generation;
+        AssetLoadQueue::JobPtr job(new AssetLoadQueue::Job(transfer->asset, generation));
+        // The transfer no longer needs the data, it was handed out with the Downloaded signal above.
+        if (transfer->rawAssetData.size() > 0)
+            job->data.swap(transfer->rawAssetData);
+        else
+            job->filename = transfer->asset->DiskSource();
+        loadQueue->Enqueue(job);
+        return;
+    }
+
     bool success = false;
     const u8 *data = (transfer->rawAssetData.size() > 0 ? &transfer->rawAssetData[0] : 0);
+    loadTelemetry->MarkStage(transfer->source.ref, AssetLoadTelemetry::StageDecodeStarted);
     if (data)
         success = transfer->asset->LoadFromFileInMemory(data, transfer->rawAssetData.size());
     else
         success = transfer->asset->LoadFromFile(transfer->asset->DiskSource());
+    loadTelemetry->MarkStage(transfer->source.ref, AssetLoadTelemetry::StageDecodeFinished);
 
     // If the load from either of in memory data or file data failed, update the internal state.
     // Otherwise the transfer will be left dangling in currentTransfers. For successful loads
     // we do no need to call AssetLoadCompleted because success can mean asynchronous loading,
     // in which case the call will arrive once the asynchronous loading is completed.
-    if (!success)
+    // An asset that was loaded from a cached file that could not be loaded is downloaded again.
+    if (!success && (data || !RetryTransferFromSource(transfer->asset->Name())))
         AssetLoadFailed(transfer->asset->Name());
 }
 
+bool AssetAPI::RetryTransferFromSource(const QString &assetRef)
+{
+    AssetTransferMap::iterator iter = FindTransferIterator(assetRef);
+    if (iter == currentTransfers.end() || iter->second->DiskSourceType() != IAsset::Cached)
+        return false;
+    AssetTransferPtr transfer = iter->second;
+    AssetProviderPtr provider = transfer->provider.lock();
+    if (!provider)
+        return false;
+
+    // The cached file is missing or damaged, f.ex. deleted from outside while Tundra is running, so it is dropped from the cache index.
+    const QString diskSource = transfer->DiskSource();
+    if (assetCache)
+        assetCache->ForgetAsset(transfer->source.ref);
+    if (!provider->RetryTransfer(transfer))
+        return false;
+    LogWarning("AssetAPI: Failed to load asset \"" + transfer->source.ref + "\" from the cached file \"" + diskSource + "\". Requesting it again from " + provider->Name() + ".");
+    return true;
+}
+
+AssetPtr AssetAPI::ContentSharedAsset(const QString &assetRef)
+{
+    std::map<QString, AssetWeakPtr>::iterator iter = contentAliases.find(assetRef);
+    if (iter == contentAliases.end())
+        return AssetPtr();
+    AssetPtr asset = iter->second.lock();
+    if (!asset || !asset->IsLoaded())
+    {
+        contentAliases.erase(iter);
+        return AssetPtr();
+    }
+    return asset;
+}
+
+bool AssetAPI::CompleteTransferWithSharedContent(AssetTransferPtr transfer)
+{
+    if (!assetCache || !assetCache->IsContentAddressed())
+        return false;
+    QString contentHash = assetCache->ContentHash(transfer->source.ref);
+    if (contentHash.isEmpty())
+        return false;
+
+    std::map<QString, AssetWeakPtr>::iterator iter = contentSharedAssets.find(transfer->assetType + "/" + contentHash);
+    if (iter == contentSharedAssets.end())
+        return false;
+    AssetPtr shared = iter->second.lock();
+    if (!shared)
+    {
+        contentSharedAssets.erase(iter);
+        return false;
+    }
+    // An asset that is still loading, or that was reloaded with different content, cannot be shared.
+    if (!shared->IsLoaded() || assetCache->ContentHash(shared->Name()) != contentHash)
+        return false;
+
+    contentAliases[transfer->source.ref] = shared;
+    transfer->asset = shared;
+    transfer->EmitAssetDownloaded();
+    transfer->EmitTransferSucceeded();
+    loadTelemetry->MarkStage(transfer->source.ref, AssetLoadTelemetry::StageLoaded);
+    pendingDownloadRequests.erase(transfer->source.ref);
+    AssetTransferMap::iterator transferIter = FindTransferIterator(transfer.get());
+    if (transferIter != currentTransfers.end())
+        currentTransfers.erase(transferIter);
+    // Assets that depend on the alias ref wait for it in the dependency graph like for any other asset.
+    if (dependencyGraph.find(transfer->source.ref) != dependencyGraph.end())
+        SetDependencyLoaded(transfer->source.ref, true);
+    return true;
+}
+
+void AssetAPI::ForgetContentAliases(IAsset *asset)
+{
+    for(std::map<QString, AssetWeakPtr>::iterator iter = contentAliases.begin(); iter != contentAliases.end();)
+    {
+        if (iter->second.lock().get() == asset)
+            contentAliases.erase(iter++);
+        else
+            ++iter;
+    }
+    for(std::map<QString, AssetWeakPtr>::iterator iter = contentSharedAssets.begin(); iter != contentSharedAssets.end();)
+    {
+        if (iter->second.lock().get() == asset)
+            contentSharedAssets.erase(iter++);
+        else
+            ++iter;
+    }
+}
+
+void AssetAPI::CompleteTransferFromFile(AssetTransferPtr transfer, const QString &filename)
+{
+    if (loadQueue)
+    {
+        loadQueue->Enqueue(AssetLoadQueue::JobPtr(new AssetLoadQueue::Job(transfer, filename)));
+        return;
+    }
+
+    if (LoadFileToVector(filename, transfer->rawAssetData))
+        AssetTransferCompleted(transfer.get());
+    else
+        AssetTransferFailed(transfer.get(), "Failed to read asset data for asset \"" + transfer->source.ref + "\" from file \"" + filename + "\"");
+}
+
 void AssetAPI::AssetTransferFailed(IAssetTransfer *transfer, QString reason)
 {
     assert(transfer);
@@ -1233,12 +1607,14 @@ void AssetAPI::AssetTransferFailed(IAssetTransfer *transfer, QString reason)
         
     LogError("Transfer of asset \"" + transfer->assetType + "\", name \"" + transfer->source.ref + "\" failed! Reason: \"" + reason + "\"");
 
-    ///\todo In this function, there is a danger of reaching an infinite recursion. Remember recursion parents and avoid infinite loops. (A -> B -> C -> A)
+    // Dependency cycles are never added to the dependency graph, so the propagation below cannot recurse infinitely.
 
     AssetTransferMap::iterator iter = currentTransfers.find(transfer->source.ref);
     if (iter == currentTransfers.end())
         LogError("AssetAPI: Asset \"" + transfer->assetType + "\", name \"" + transfer->source.ref + "\" transfer failed, but no corresponding AssetTransferPtr was tracked by AssetAPI!");
 
+    loadTelemetry->MarkFailed(transfer->source.ref);
+
     // Signal any listeners that this asset transfer failed.
     transfer->EmitAssetFailed(reason);
 
@@ -1276,7 +1652,10 @@ void AssetAPI::AssetLoadCompleted(const QString assetRef)
 
     if (asset.get())
     {
-        asset->LoadCompleted();
+        loadTelemetry->MarkStage(asset->Name(), AssetLoadTelemetry::StageContentLoaded);
+
+        TouchAsset(asset->Name());
+        assetMemoryUsage[asset->Name()].unloadedByBudget = false;
 
         // Add to watch this path for changed, note this does nothing if the path is already added
         // so we should not be having duplicate paths and/or double emits on changes.
@@ -1312,13 +1691,21 @@ void AssetAPI::AssetLoadCompleted(const QString assetRef)
 
         PROFILE(AssetAPI_AssetLoadCompleted_ProcessDependencies);
 
+        // Build the graph node and edges of the asset before marking it loaded, so that it becomes ready only if its dependencies are.
         // If this asset depends on any other assets, we have to make asset requests for those assets as well (and all assets that they refer to, and so on).
+        const QString name = asset->Name();
+        AssetDependencyGraph::iterator node = dependencyGraph.find(name);
+        if (node == dependencyGraph.end())
+            node = dependencyGraph.insert(std::make_pair(name, AssetDependencyNode())).first;
+        const bool wasReady = node->second.Ready();
         RequestAssetDependencies(asset);
 
-        // If we don't have any outstanding dependencies 
-        // for the transfer, succeed and remove the transfer
-        if (iter != currentTransfers.end() && !HasPendingDependencies(asset))
-            AssetDependenciesCompleted(iter->second);
+        // Marking the asset loaded emits Loaded and completes the transfers of it and of the assets that were only waiting for it.
+        // An asset that was already ready has been reloaded, and its readiness does not change, so Loaded is emitted for the new content here.
+        SetDependencyLoaded(name, true);
+        node = dependencyGraph.find(name);
+        if (wasReady && node != dependencyGraph.end() && node->second.Ready())
+            EmitAssetsReady(std::vector<QString>(1, name));
     }
     else
         LogError("AssetAPI: Asset \"" + assetRef + "\" load completed, but no corresponding transfer or existing asset is being tracked!");
@@ -1332,6 +1719,7 @@ void AssetAPI::AssetLoadFailed(const QString assetRef)
     if (iter != currentTransfers.end())
     {
         AssetTransferPtr transfer = iter->second;
+        loadTelemetry->MarkFailed(transfer->source.ref);
         transfer->EmitAssetFailed("Failed to load " + transfer->assetType + " '" + transfer->source.ref + "' from asset data.");
         currentTransfers.erase(iter);
     }
@@ -1353,7 +1741,7 @@ void AssetAPI::AssetUploadTransferCompleted(IAssetUploadTransfer *uploadTransfer
     
     // If we have the asset (with possible old contents) in memory, unload it now
     {
-        AssetPtr asset = GetAsset(assetRef);
+        AssetPtr asset = FindAsset(assetRef);
         if (asset && asset->IsLoaded())
             asset->Unload();
     }
@@ -1383,8 +1771,10 @@ void AssetAPI::AssetUploadTransferCompleted(IAssetUploadTransfer *uploadTransfer
 void AssetAPI::AssetDependenciesCompleted(AssetTransferPtr transfer)
 {
     PROFILE(AssetAPI_AssetDependenciesCompleted);
+    loadTelemetry->MarkStage(transfer->source.ref, AssetLoadTelemetry::StageDependenciesReady);
     // Emit success for this transfer
     transfer->EmitTransferSucceeded();
+    loadTelemetry->MarkStage(transfer->source.ref, AssetLoadTelemetry::StageLoaded);
     
     // This asset transfer has finished - remove it from the internal list of ongoing transfers.
     AssetTransferMap::iterator iter = FindTransferIterator(transfer.get());
@@ -1400,20 +1790,73 @@ void AssetAPI::NotifyAssetDependenciesChanged(AssetPtr asset)
 {
     PROFILE(AssetAPI_NotifyAssetDependenciesChanged);
 
-    /// Delete all old stored asset dependencies for this asset.
-    RemoveAssetDependencies(asset->Name());
+    const QString name = asset->Name();
+    AssetDependencyGraph::iterator nodeIter = dependencyGraph.find(name);
+    if (nodeIter == dependencyGraph.end())
+    {
+        // An asset that is not yet in the graph may already have been loaded without going through AssetLoadCompleted.
+        nodeIter = dependencyGraph.insert(std::make_pair(name, AssetDependencyNode())).first;
+        nodeIter->second.loaded = asset->IsLoaded();
+        nodeIter->second.propagatedReady = nodeIter->second.Ready();
+    }
+    AssetDependencyNode &node = nodeIter->second;
+
+    /// Delete all old stored asset dependencies for this asset, and count the pending ones again from scratch.
+    RemoveAssetDependencies(name);
+    node.numPendingDependencies = 0;
+
+    // A new dependency closes a cycle if this asset can be reached from it, that is, if the dependency already depends on this asset.
+    // The assets depending on this one are collected once, so that each dependency is checked with a lookup.
+    std::set<QString, QStringLessThanNoCase> dependents;
+    CollectDependents(name, dependents);
 
     std::vector<AssetReference> refs = asset->FindReferences();
     for(size_t i = 0; i < refs.size(); ++i)
     {
+        if (refs[i].ref.isEmpty())
+            continue;
+
+        // We silently ignore this dependency if the asset type in question is disabled.
+        if (dynamic_cast<NullAssetFactory*>(GetAssetTypeFactory(GetResourceTypeFromAssetRef(refs[i])).get()))
+            continue;
+
         // Turn named storage (and default storage) specifiers to absolute specifiers.
-        QString ref = refs[i].ref;
-        if (ref.isEmpty())
+        QString ref = ResolveAssetRef("", refs[i].ref);
+        if (ref.isEmpty() || std::find(node.dependencies.begin(), node.dependencies.end(), ref) != node.dependencies.end())
             continue;
 
+        if (QString::compare(ref, name, Qt::CaseInsensitive) == 0 || dependents.find(ref) != dependents.end())
+        {
+            // The path of the cycle is searched only for the warning.
+            std::vector<QString> cycle;
+            std::set<QString, QStringLessThanNoCase> visited;
+            FindDependencyPath(ref, name, cycle, visited);
+            QString path = name;
+            for(std::vector<QString>::reverse_iterator iter = cycle.rbegin(); iter != cycle.rend(); ++iter)
+                path += " -> " + *iter;
+            LogWarning("AssetAPI: Asset dependency cycle detected: " + path + ". Ignoring the dependency from \"" + name + "\" to \"" + ref + "\".");
+            continue;
+        }
+
         // Remember this assetref for future lookup.
-        assetDependencies.push_back(std::make_pair(asset->Name(), ref));
+        node.dependencies.push_back(ref);
+        AssetDependencyGraph::iterator dependency = dependencyGraph.find(ref);
+        if (dependency == dependencyGraph.end())
+        {
+            // First time this asset is referred to. It may already have been loaded without going through AssetLoadCompleted.
+            dependency = dependencyGraph.insert(std::make_pair(ref, AssetDependencyNode())).first;
+            AssetPtr existing = FindAsset(ref);
+            dependency->second.loaded = existing && existing->IsLoaded();
+            dependency->second.propagatedReady = dependency->second.Ready();
+        }
+        dependency->second.dependents.insert(name);
+        if (!dependency->second.propagatedReady)
+            ++node.numPendingDependencies;
     }
+
+    std::vector<QString> becameReady;
+    PropagateReadiness(name, becameReady);
+    EmitAssetsReady(becameReady);
 }
 
 void AssetAPI::RequestAssetDependencies(AssetPtr asset)
@@ -1429,7 +1872,7 @@ void AssetAPI::RequestAssetDependencies(AssetPtr asset)
         if (ref.ref.isEmpty())
             continue;
 
-        AssetPtr existing = GetAsset(ref.ref);
+        AssetPtr existing = FindAsset(ref.ref);
         if (!existing || !existing->IsLoaded())
         {
 //            LogDebug("Asset " + asset->ToString() + " depends on asset " + ref.ref + " (type=\"" + ref.type + "\") which has not been loaded yet. Requesting..");
@@ -1441,12 +1884,135 @@ void AssetAPI::RequestAssetDependencies(AssetPtr asset)
 void AssetAPI::RemoveAssetDependencies(QString asset)
 {
     PROFILE(AssetAPI_RemoveAssetDependencies);
-    for(size_t i = 0; i < assetDependencies.size(); ++i)
-        if (QString::compare(assetDependencies[i].first, asset, Qt::CaseInsensitive) == 0)
+    AssetDependencyGraph::iterator node = dependencyGraph.find(asset);
+    if (node == dependencyGraph.end())
+        return;
+
+    for(size_t i = 0; i < node->second.dependencies.size(); ++i)
+    {
+        AssetDependencyGraph::iterator dependency = dependencyGraph.find(node->second.dependencies[i]);
+        if (dependency == dependencyGraph.end())
+            continue;
+        dependency->second.dependents.erase(asset);
+        // Drop the nodes of assets that are no longer referred to and were never created.
+        if (dependency->second.dependents.empty() && dependency->second.dependencies.empty() && assets.find(dependency->first) == assets.end())
+            dependencyGraph.erase(dependency);
+    }
+    node->second.dependencies.clear();
+}
+
+void AssetAPI::SetDependencyLoaded(const QString &assetRef, bool loaded)
+{
+    AssetDependencyGraph::iterator node = dependencyGraph.find(assetRef);
+    if (node == dependencyGraph.end() || node->second.loaded == loaded)
+        return;
+
+    node->second.loaded = loaded;
+    std::vector<QString> becameReady;
+    PropagateReadiness(assetRef, becameReady);
+    EmitAssetsReady(becameReady);
+}
+
+void AssetAPI::PropagateReadiness(const QString &assetRef, std::vector<QString> &becameReady)
+{
+    PROFILE(AssetAPI_PropagateReadiness);
+
+    // Each change in readiness adjusts the pending dependency counts of the direct dependents only. If that in turn changes the readiness
+    // of a dependent, the change is propagated further. As the graph has no cycles, this terminates.
+    // The readiness is compared to the one already propagated, so a dependent reached through several paths is counted, and reported, only once.
+    std::vector<QString> changed;
+    changed.push_back(assetRef);
+    while(!changed.empty())
+    {
+        AssetDependencyGraph::iterator node = dependencyGraph.find(changed.back());
+        changed.pop_back();
+        if (node == dependencyGraph.end())
+            continue;
+        const bool ready = node->second.Ready();
+        if (ready == node->second.propagatedReady)
+            continue;
+        node->second.propagatedReady = ready;
+        if (ready)
+            becameReady.push_back(node->first);
+
+        const std::set<QString, QStringLessThanNoCase> &dependents = node->second.dependents;
+        for(std::set<QString, QStringLessThanNoCase>::const_iterator iter = dependents.begin(); iter != dependents.end(); ++iter)
+        {
+            AssetDependencyGraph::iterator dependent = dependencyGraph.find(*iter);
+            if (dependent == dependencyGraph.end())
+                continue;
+            dependent->second.numPendingDependencies += (ready ? -1 : 1);
+            changed.push_back(dependent->first);
+        }
+    }
+}
+
+void AssetAPI::EmitAssetsReady(const std::vector<QString> &assetRefs)
+{
+    PROFILE(AssetAPI_EmitAssetsReady);
+
+    // The assets are in dependency order, so each asset is announced only after the assets it depends on.
+    for(size_t i = 0; i < assetRefs.size(); ++i)
+    {
+        AssetTransferMap::iterator iter = currentTransfers.find(assetRefs[i]);
+        AssetPtr asset;
+        if (iter != currentTransfers.end())
+            asset = iter->second->asset;
+        else
+        {
+            AssetMap::iterator assetIter = assets.find(assetRefs[i]);
+            if (assetIter != assets.end())
+                asset = assetIter->second;
+        }
+        // An asset may be marked loaded before it can be used, f.ex. a material is created only when its dependencies have loaded.
+        if (!asset || !asset->IsLoaded())
+            continue;
+
+        asset->LoadCompleted();
+
+        // The handlers of Loaded may have already completed or replaced the transfer, so it is looked up again.
+        iter = currentTransfers.find(assetRefs[i]);
+        if (iter != currentTransfers.end() && iter->second->asset == asset)
+            AssetDependenciesCompleted(iter->second);
+    }
+}
+
+void AssetAPI::CollectDependents(const QString &assetRef, std::set<QString, QStringLessThanNoCase> &dependents) const
+{
+    std::vector<QString> unvisited(1, assetRef);
+    while(!unvisited.empty())
+    {
+        AssetDependencyGraph::const_iterator node = dependencyGraph.find(unvisited.back());
+        unvisited.pop_back();
+        if (node == dependencyGraph.end())
+            continue;
+        const std::set<QString, QStringLessThanNoCase> &refs = node->second.dependents;
+        for(std::set<QString, QStringLessThanNoCase>::const_iterator iter = refs.begin(); iter != refs.end(); ++iter)
+            if (dependents.insert(*iter).second)
+                unvisited.push_back(*iter);
+    }
+}
+
+bool AssetAPI::FindDependencyPath(const QString &from, const QString &to, std::vector<QString> &path, std::set<QString, QStringLessThanNoCase> &visited) const
+{
+    if (QString::compare(from, to, Qt::CaseInsensitive) == 0)
+    {
+        path.push_back(from);
+        return true;
+    }
+    if (!visited.insert(from).second)
+        return false;
+
+    AssetDependencyGraph::const_iterator node = dependencyGraph.find(from);
+    if (node == dependencyGraph.end())
+        return false;
+    for(size_t i = 0; i < node->second.dependencies.size(); ++i)
+        if (FindDependencyPath(node->second.dependencies[i], to, path, visited))
         {
-            assetDependencies.erase(assetDependencies.begin() + i);
-            --i;
+            path.push_back(from);
+            return true;
         }
+    return false;
 }
 
 std::vector<AssetPtr> AssetAPI::FindDependents(QString dependee)
@@ -1454,18 +2020,29 @@ std::vector<AssetPtr> AssetAPI::FindDependents(QString dependee)
     PROFILE(AssetAPI_FindDependents);
 
     std::vector<AssetPtr> dependents;
-    for(size_t i = 0; i < assetDependencies.size(); ++i)
+    AssetDependencyGraph::const_iterator node = dependencyGraph.find(ResolveAssetRef("", dependee));
+    if (node == dependencyGraph.end())
+        return dependents;
+
+    const std::set<QString, QStringLessThanNoCase> &refs = node->second.dependents;
+    for(std::set<QString, QStringLessThanNoCase>::const_iterator iter = refs.begin(); iter != refs.end(); ++iter)
     {
-        if (QString::compare(assetDependencies[i].second, dependee, Qt::CaseInsensitive) == 0)
-        {
-            AssetMap::iterator iter = assets.find(assetDependencies[i].first);
-            if (iter != assets.end())
-                dependents.push_back(iter->second);
-        }
+        AssetMap::iterator asset = assets.find(*iter);
+        if (asset != assets.end())
+            dependents.push_back(asset->second);
     }
     return dependents;
 }
 
+AssetAPI::AssetDependenciesMap AssetAPI::DebugGetAssetDependencies() const
+{
+    AssetDependenciesMap dependencies;
+    for(AssetDependencyGraph::const_iterator iter = dependencyGraph.begin(); iter != dependencyGraph.end(); ++iter)
+        for(size_t i = 0; i < iter->second.dependencies.size(); ++i)
+            dependencies.push_back(std::make_pair(iter->first, iter->second.dependencies[i]));
+    return dependencies;
+}
+
 int AssetAPI::NumPendingDependencies(AssetPtr asset) const
 {
     PROFILE(AssetAPI_NumPendingDependencies);
@@ -1482,7 +2059,7 @@ int AssetAPI::NumPendingDependencies(AssetPtr asset) const
         if (dynamic_cast<NullAssetFactory*>(GetAssetTypeFactory(GetResourceTypeFromAssetRef(refs[i])).get()))
             continue;
 
-        AssetPtr existing = GetAsset(refs[i].ref);
+        AssetPtr existing = FindAsset(refs[i].ref);
         if (!existing)
         {
             // Not loaded, just mark the single one
@@ -1510,40 +2087,9 @@ int AssetAPI::NumPendingDependencies(AssetPtr asset) const
 
 bool AssetAPI::HasPendingDependencies(AssetPtr asset) const
 {
-    PROFILE(AssetAPI_HasPendingDependencies);
-
-    std::vector<AssetReference> refs = asset->FindReferences();
-    for(size_t i = 0; i < refs.size(); ++i)
-    {
-        if (refs[i].ref.isEmpty())
-            continue;
-
-        // We silently ignore this dependency if the asset type in question is disabled.
-        if (dynamic_cast<NullAssetFactory*>(GetAssetTypeFactory(GetResourceTypeFromAssetRef(refs[i])).get()))
-            continue;
-
-        AssetPtr existing = GetAsset(refs[i].ref);
-        if (!existing) // Not loaded, just mark the single one
-            return true;
-        else
-        {            
-            if (existing->IsEmpty())
-                return true; // If asset is empty, count it as an unloaded dependency
-            else
-            {
-                if (!existing->IsLoaded())
-                    return true;
-                // Ask the dependencies of the dependency, we want all of the asset
-                // down the chain to be loaded before we load the base asset
-                // Note: if the dependency is unloaded, it may or may not be able to tell the dependencies correctly
-                bool dependencyHasDependencies = HasPendingDependencies(existing);
-                if (dependencyHasDependencies)
-                    return true;
-            }
-        }
-    }
-
-    return false;
+    // The dependencies of an asset are known only after it has been loaded, and then they are tracked in the dependency graph.
+    AssetDependencyGraph::const_iterator node = dependencyGraph.find(asset->Name());
+    return node != dependencyGraph.end() && node->second.numPendingDependencies > 0;
 }
 
 void AssetAPI::HandleAssetDiscovery(const QString &assetRef, const QString &assetType)
@@ -1553,7 +2099,7 @@ void AssetAPI::HandleAssetDiscovery(const QString &assetRef, const QString &asse
 
 void AssetAPI::HandleAssetDiscovery(const QString &assetRef, const QString &assetType, AssetStoragePtr storage)
 {
-    AssetPtr existing = GetAsset(assetRef);
+    AssetPtr existing = FindAsset(assetRef);
     // If asset did not exist, create new empty asset
     if (!existing)
     {
@@ -1571,7 +2117,7 @@ void AssetAPI::HandleAssetDiscovery(const QString &assetRef, const QString &asse
 void AssetAPI::HandleAssetDeleted(const QString &assetRef)
 {
     // If the asset is unloaded, delete it from memory. If it is loaded, it might be in use, so do nothing
-    AssetPtr existing = GetAsset(assetRef);
+    AssetPtr existing = FindAsset(assetRef);
     if (!existing)
         return;
     if (!existing->IsLoaded())
@@ -1625,23 +2171,143 @@ void AssetAPI::OnAssetLoaded(AssetPtr asset)
 {
     PROFILE(AssetAPI_OnAssetLoaded);
 
+    // Notify the direct dependents that one of their dependencies has now been loaded in. Loaded is emitted for the dependents, and their
+    // transfers are completed, when they become ready in the dependency graph.
     std::vector<AssetPtr> dependents = FindDependents(asset->Name());
     for(size_t i = 0; i < dependents.size(); ++i)
+        dependents[i]->DependencyLoaded(asset);
+}
+
+void AssetAPI::OnAssetUnloaded(IAsset *asset)
+{
+    // A forgotten asset may be unloaded only when it is destroyed, after a new asset with the same name has been created.
+    AssetMap::iterator iter = assets.find(asset->Name());
+    if (iter != assets.end() && iter->second.get() == asset)
     {
-        AssetPtr dependent = dependents[i];
+        SetDependencyLoaded(asset->Name(), false);
+        // Drop the result of a decode that is still in progress, it would load the asset again.
+        latestDecodeJobs.erase(asset->Name());
+    }
+}
+
+void AssetAPI::AddAssetReference(const QString &assetRef)
+{
+    AssetMemoryUsage &usage = assetMemoryUsage[assetRef];
+    ++usage.numReferences;
+    usage.lastUse = ++assetUseCounter;
+}
 
-        // Notify the asset that one of its dependencies has now been loaded in.
-        dependent->DependencyLoaded(asset);
+void AssetAPI::RemoveAssetReference(const QString &assetRef)
+{
+    AssetMemoryUsageMap::iterator iter = assetMemoryUsage.find(assetRef);
+    if (iter == assetMemoryUsage.end() || iter->second.numReferences <= 0)
+        return;
+    --iter->second.numReferences;
+    // The least recently used order of unreferenced assets is the order they were released in.
+    iter->second.lastUse = ++assetUseCounter;
+}
 
-        // Check if this dependency was the last one of the given asset's dependencies.
-        AssetTransferMap::iterator iter = currentTransfers.find(dependent->Name());
-        if (iter != currentTransfers.end())
+void AssetAPI::TouchAsset(const QString &assetRef)
+{
+    assetMemoryUsage[assetRef].lastUse = ++assetUseCounter;
+}
+
+void AssetAPI::UpdateAssetMemoryUsage()
+{
+    PROFILE(AssetAPI_UpdateAssetMemoryUsage);
+
+    totalAssetCpuMemory = 0;
+    totalAssetGpuMemory = 0;
+    for(AssetMap::const_iterator iter = assets.begin(); iter != assets.end(); ++iter)
+    {
+        const AssetPtr &asset = iter->second;
+        AssetMemoryUsage &usage = assetMemoryUsage[iter->first];
+        if (asset->IsLoaded())
         {
-            AssetTransferPtr transfer = iter->second;
-            if (!HasPendingDependencies(dependent))
-                AssetDependenciesCompleted(transfer);
+            usage.cpuBytes = asset->CpuMemoryUsage();
+            if (usage.cpuBytes == 0)
+                usage.cpuBytes = usage.dataSize;
+            usage.gpuBytes = asset->GpuMemoryUsage();
         }
+        else
+        {
+            usage.cpuBytes = 0;
+            usage.gpuBytes = 0;
+        }
+        totalAssetCpuMemory += usage.cpuBytes;
+        totalAssetGpuMemory += usage.gpuBytes;
+    }
+}
+
+int AssetAPI::UnloadUnreferencedAssets(u64 targetBytes)
+{
+    UpdateAssetMemoryUsage();
+    return UnloadLeastRecentlyUsedAssets(targetBytes);
+}
+
+int AssetAPI::UnloadLeastRecentlyUsedAssets(u64 targetBytes)
+{
+    PROFILE(AssetAPI_UnloadLeastRecentlyUsedAssets);
+
+    u64 totalBytes = totalAssetCpuMemory + totalAssetGpuMemory;
+    if (totalBytes <= targetBytes)
+        return 0;
+
+    // Collect the assets that can be unloaded and reloaded later, with the time of their last use.
+    std::vector<std::pair<u64, QString> > candidates;
+    for(AssetMap::const_iterator iter = assets.begin(); iter != assets.end(); ++iter)
+    {
+        const AssetPtr &asset = iter->second;
+        if (!asset->IsLoaded() || asset->IsModified() || asset->DiskSourceType() == IAsset::Programmatic)
+            continue;
+        if (asset->DiskSource().isEmpty() && !asset->GetAssetProvider())
+            continue;
+        // A strong reference outside the asset map, f.ex. from a transfer or a script, means that the asset is in use.
+        if (asset.use_count() > 1 || currentTransfers.find(iter->first) != currentTransfers.end())
+            continue;
+
+        AssetMemoryUsageMap::const_iterator usage = assetMemoryUsage.find(iter->first);
+        if (usage == assetMemoryUsage.end() || usage->second.numReferences > 0 || usage->second.cpuBytes + usage->second.gpuBytes == 0)
+            continue;
+
+        // The loaded assets that depend on this asset use it, f.ex. a material uses its textures.
+        bool hasLoadedDependents = false;
+        AssetDependencyGraph::const_iterator node = dependencyGraph.find(iter->first);
+        if (node != dependencyGraph.end())
+            for(std::set<QString, QStringLessThanNoCase>::const_iterator dependent = node->second.dependents.begin();
+                dependent != node->second.dependents.end() && !hasLoadedDependents; ++dependent)
+            {
+                AssetMap::const_iterator dependentAsset = assets.find(*dependent);
+                hasLoadedDependents = (dependentAsset != assets.end() && dependentAsset->second->IsLoaded());
+            }
+        if (hasLoadedDependents)
+            continue;
+
+        candidates.push_back(std::make_pair(usage->second.lastUse, iter->first));
     }
+    std::sort(candidates.begin(), candidates.end());
+
+    int numUnloaded = 0;
+    for(size_t i = 0; i < candidates.size() && totalBytes > targetBytes; ++i)
+    {
+        AssetMemoryUsage &usage = assetMemoryUsage[candidates[i].second];
+        AssetMap::iterator iter = assets.find(candidates[i].second);
+        iter->second->Unload();
+        totalBytes -= std::min(totalBytes, usage.cpuBytes + usage.gpuBytes);
+        totalAssetCpuMemory -= std::min(totalAssetCpuMemory, usage.cpuBytes);
+        totalAssetGpuMemory -= std::min(totalAssetGpuMemory, usage.gpuBytes);
+        usage.cpuBytes = 0;
+        usage.gpuBytes = 0;
+        usage.unloadedByBudget = true;
+        ++numUnloaded;
+    }
+
+    if (numUnloaded > 0)
+        LogDebug(QString("AssetAPI: Unloaded %1 unreferenced assets, estimated asset memory usage is now %2 MB.").arg(numUnloaded).arg(totalBytes / (1024.0 * 1024.0), 0, 'f', 1));
+    if (totalBytes > targetBytes)
+        LogDebug(QString("AssetAPI: Asset memory usage of %1 MB exceeds the target of %2 MB, but the rest of the assets are in use.")
+            .arg(totalBytes / (1024.0 * 1024.0), 0, 'f', 1).arg(targetBytes / (1024.0 * 1024.0), 0, 'f', 1));
+    return numUnloaded;
 }
 
 void AssetAPI::OnAssetDiskSourceChanged(const QString &path_)
@@ -1683,7 +2349,7 @@ void AssetAPI::OnAssetStorageRefsChanged(AssetStoragePtr storage)
     {
         // If the asset does not exist at all, create a new empty asset.
         // However, if the asset already exists, do not refresh its data now (as we may be getting a huge amount of refs)
-        if (!GetAsset(refs[i]))
+        if (!FindAsset(refs[i]))
             // Use optimized discovery: the storage does not have to be looked up as it is known
             HandleAssetDiscovery(refs[i], "", storage);
     }
@@ -1701,7 +2367,7 @@ void AssetAPI::OnAssetChanged(QString localName, QString diskSource, IAssetStora
 
     QString assetRef = storage->GetFullAssetURL(localName);
     QString assetType = GetResourceTypeFromAssetRef(assetRef);
-    AssetPtr existing = GetAsset(assetRef);
+    AssetPtr existing = FindAsset(assetRef);
     if (change == IAssetStorage::AssetCreate && existing)
     {
         LogDebug("AssetAPI: Received AssetCreate notification for existing and loaded asset " + assetRef + ". Handling this as AssetModify.");
@@ -6,6 +6,7 @@
 #include <vector>
 #include <utility>
 #include <map>
+#include <set>
 
 #include "CoreTypes.h"
 #include "CoreStringUtils.h"
@@ -13,6 +14,8 @@
 #include "IAssetStorage.h"
 
 class QFileSystemWatcher;
+class AssetLoadQueue;
+class AssetLoadTelemetry;
 
 /// Loads the given local file into the specified vector. Clears all data previously in the vector.
 /// Returns true on success.
@@ -82,6 +85,12 @@ public:
     /** Do not call this function from client code. */
     void AssetTransferCompleted(IAssetTransfer *transfer);
 
+    /// Called by an AssetProvider to read the data of an asset transfer from a local file and then complete the transfer.
+    /** If the asset load threads are enabled, the file is read on a worker thread and the transfer is completed on a later frame.
+        Otherwise the file is read, and the transfer completed, immediately. If the file cannot be read, the transfer fails.
+        Do not call this function from client code. */
+    void CompleteTransferFromFile(AssetTransferPtr transfer, const QString &filename);
+
     /// Called by each AssetProvider to notify the Asset API that the asset transfer finished in a failure.
     /** The Asset API will erase this transfer and also fail any transfers of assets which depended on this transfer. */
     void AssetTransferFailed(IAssetTransfer *transfer, QString reason);
@@ -99,6 +108,8 @@ public:
 
     void AssetDependenciesCompleted(AssetTransferPtr transfer);
 
+    /// Rebuilds the dependency graph edges of the given asset from IAsset::FindReferences.
+    /** Dependencies that would close a dependency cycle are reported and left out of the graph. */
     void NotifyAssetDependenciesChanged(AssetPtr asset);
 
     bool IsHeadless() const { return isHeadless; }
@@ -232,7 +243,8 @@ public slots:
 
     /// Returns the given asset by full URL ref if it exists, or null otherwise.
     /// @note The "name" of an asset is in most cases the URL ref of the asset, so use this function to query an asset by name.
-    AssetPtr GetAsset(QString assetRef) const;
+    /// @note An asset that was unloaded to stay within the memory budget is requested again, and emits Loaded when the reload completes.
+    AssetPtr GetAsset(QString assetRef);
     
     /// Returns the asset cache object that genereates a disk source for all assets.
     AssetCache *GetAssetCache() const { return assetCache; }
@@ -373,8 +385,8 @@ public slots:
     int NumPendingDependencies(AssetPtr asset) const;
 
     /// A utility function that returns true if the given asset still has some unloaded dependencies left to process.
-    /// @note For performance reasons, calling this function is highly advisable instead of calling NumPendingDependencies, if it is only
-    ///       desirable to known whether the asset has any pending dependencies or not.
+    /// @note This is a constant time lookup of the outstanding dependency count in the dependency graph. It is highly advisable to call this
+    ///       function instead of NumPendingDependencies, if it is only desirable to known whether the asset has any pending dependencies or not.
     bool HasPendingDependencies(AssetPtr asset) const;
 
     /// Handle discovery of a new asset through the AssetDiscovery network message
@@ -394,9 +406,52 @@ public slots:
 
     /// A utility function that counts the number of current asset transfers.
     int NumCurrentTransfers() const { return currentTransfers.size(); }
+
+    /// Returns true if assets that support threaded decoding are read and decoded on worker threads.
+    /** The number of worker threads can be set with the --assetLoadThreads command line parameter. Zero disables the worker threads. */
+    bool HasAssetLoadThreads() const { return loadQueue != 0; }
+
+    /// Returns the number of asset loads that are queued or in progress on the asset load threads.
+    int NumPendingAssetLoads() const;
+
+    /// Sets the memory budget of the loaded assets in bytes. Zero, the default, disables the automatic unloading of assets.
+    /** When the estimated main and GPU memory usage of the loaded assets together exceeds the budget, the least recently used
+        unreferenced assets are unloaded, see UnloadUnreferencedAssets. The budget is checked once per second.
+        The budget can be given in megabytes with the --assetMemoryBudget command line parameter. */
+    void SetAssetMemoryBudget(u64 bytes) { assetMemoryBudget = bytes; }
+
+    /// Returns the memory budget of the loaded assets in bytes, or zero if the assets are not unloaded automatically.
+    u64 AssetMemoryBudget() const { return assetMemoryBudget; }
+
+    /// Queries the memory usage estimates of all the loaded assets and updates the totals.
+    /** This is done on each budget check and UnloadUnreferencedAssets call, so call this only to get up-to-date totals in between. */
+    void UpdateAssetMemoryUsage();
+
+    /// Returns the estimated main memory usage of the loaded assets in bytes, as of the last UpdateAssetMemoryUsage call.
+    u64 AssetCpuMemoryUsage() const { return totalAssetCpuMemory; }
+
+    /// Returns the estimated GPU memory usage of the loaded assets in bytes, as of the last UpdateAssetMemoryUsage call.
+    u64 AssetGpuMemoryUsage() const { return totalAssetGpuMemory; }
+
+    /// Unloads the least recently used unreferenced assets until the estimated memory usage of the loaded assets is at most targetBytes.
+    /** An asset is unreferenced when no AssetRefListener refers to it, no loaded asset depends on it, and nothing else than AssetAPI
+        holds a strong reference to it. Assets that could not be reloaded, i.e. modified and programmatically created assets, are never unloaded.
+        The unloaded assets stay in the asset map, and are reloaded from their disk source, or from their provider if the disk source is gone,
+        when they are requested or looked up with GetAsset again.
+        @return The number of assets unloaded. */
+    int UnloadUnreferencedAssets(u64 targetBytes);
+
+    /// Called by AssetRefListener when it starts to refer to an asset. Do not call this function from client code.
+    void AddAssetReference(const QString &assetRef);
+
+    /// Called by AssetRefListener when it stops referring to an asset. Do not call this function from client code.
+    void RemoveAssetReference(const QString &assetRef);
+
+    /// Returns the timestamps of the load pipeline stages of the transferred assets, aggregated by asset type and provider.
+    AssetLoadTelemetry *LoadTelemetry() const { return loadTelemetry; }
     
-    /// Return the current asset dependency map (debugging)
-    const AssetDependenciesMap& DebugGetAssetDependencies() const { return assetDependencies; }
+    /// Return the current asset dependencies as (dependent, dependee) pairs (debugging)
+    AssetDependenciesMap DebugGetAssetDependencies() const;
     
     /// Return ready asset transfers (debugging)
     const std::vector<AssetTransferPtr>& DebugGetReadyTransfers() const { return readyTransfers; }
@@ -434,6 +489,9 @@ private slots:
     /// The Asset API listens on each asset when they get loaded, to track the completion of the dependencies of other loaded assets.
     void OnAssetLoaded(AssetPtr asset);
 
+    /// Marks the asset as not ready in the dependency graph, so that the assets depending on it wait for it to load again.
+    void OnAssetUnloaded(IAsset *asset);
+
     /// The Asset API reloads all assets from file when their disk source contents change.
     void OnAssetDiskSourceChanged(const QString &path);
 
@@ -451,15 +509,59 @@ private:
     AssetTransferMap::iterator FindTransferIterator(IAssetTransfer *transfer);
     AssetTransferMap::const_iterator FindTransferIterator(IAssetTransfer *transfer) const;
 
-    /// Removes from AssetDependenciesMap all dependencies the given asset has.
+    /// Removes from the dependency graph all dependencies the given asset has.
+    /** The pending dependency count of the asset is not updated. */
     void RemoveAssetDependencies(QString asset);
 
+    /// Sets the loaded state of an asset in the dependency graph, and completes the transfers of the assets that became ready because of it.
+    void SetDependencyLoaded(const QString &assetRef, bool loaded);
+
+    /// Updates the pending dependency counts of the dependents of an asset whose readiness may have changed, transitively.
+    /// @param becameReady [out] The assets that became ready are appended here.
+    void PropagateReadiness(const QString &assetRef, std::vector<QString> &becameReady);
+
+    /// Emits Loaded for the given assets, which have just become ready, and completes their pending transfers.
+    void EmitAssetsReady(const std::vector<QString> &assetRefs);
+
+    /// Collects the assets that depend on the given asset, directly or indirectly.
+    void CollectDependents(const QString &assetRef, std::set<QString, QStringLessThanNoCase> &dependents) const;
+
+    /// Searches the dependency graph for a chain of dependencies from the asset 'from' to the asset 'to'.
+    /// @param path [out] If a chain is found, the assets of the chain are appended here, starting from 'to'.
+    bool FindDependencyPath(const QString &from, const QString &to, std::vector<QString> &path, std::set<QString, QStringLessThanNoCase> &visited) const;
+
     /// Handle discovery of a new asset, when the storage is already known. This is used internally for optimization, so that providers don't need to be queried
     void HandleAssetDiscovery(const QString &assetRef, const QString &assetType, AssetStoragePtr storage);
     
     /// Create new asset, when the storage is already known. This is used internally for optimization
     AssetPtr CreateNewAsset(QString type, QString name, AssetStoragePtr storage);
 
+    /// Requests the asset of a transfer again from its provider if the transfer was completed with a cached file, which then could not be loaded.
+    /// @return True if the asset was requested again, and the transfer continues.
+    bool RetryTransferFromSource(const QString &assetRef);
+
+    /// Hands the assets decoded on the asset load threads over to the main thread, within the per-frame handoff budget.
+    void ProcessFinishedAssetLoads();
+
+    /// Returns a loaded asset that is shared with the given ref because of identical content, or null if there is none.
+    AssetPtr ContentSharedAsset(const QString &assetRef);
+
+    /// Completes the transfer with an already loaded asset of identical content, if a content-addressed cache is in use.
+    /// @return True if the transfer was completed.
+    bool CompleteTransferWithSharedContent(AssetTransferPtr transfer);
+
+    /// Stops sharing the given asset with other refs, f.ex. when its content changes.
+    void ForgetContentAliases(IAsset *asset);
+
+    /// Returns the given asset by full URL ref if it exists, or null otherwise. Unlike GetAsset, does not reload an asset unloaded by the memory budget.
+    AssetPtr FindAsset(QString assetRef) const;
+
+    /// Unloads the least recently used unreferenced assets, based on the estimates of the last UpdateAssetMemoryUsage call.
+    int UnloadLeastRecentlyUsedAssets(u64 targetBytes);
+
+    /// Marks the asset as used now, for the least recently used order of unloading.
+    void TouchAsset(const QString &assetRef);
+
     bool isHeadless;
 
     /// Stores all the currently ongoing asset transfers.
@@ -469,9 +571,27 @@ private:
     /// Stores all the currently ongoing asset uploads, maps full assetRefs to the asset upload transfer structures.
     AssetUploadTransferMap currentUploadTransfers;
 
-    /// Keeps track of all the dependencies each asset has to each other asset.
-    /// \todo Find a more effective data structure for this. Needs something like boost::bimap but for multi-indices.
-    AssetDependenciesMap assetDependencies;
+    /// A node of the asset dependency graph.
+    struct AssetDependencyNode
+    {
+        AssetDependencyNode() : numPendingDependencies(0), loaded(false), propagatedReady(false) {}
+
+        std::vector<QString> dependencies; ///< The assets this asset depends on.
+        std::set<QString, QStringLessThanNoCase> dependents; ///< The assets that depend on this asset.
+        int numPendingDependencies; ///< Number of direct dependencies that are not ready.
+        bool loaded; ///< True if the asset itself is loaded.
+        /// The readiness of the asset that the pending dependency counts of its dependents reflect.
+        /** An asset is counted as pending by its dependents unless this is set. */
+        bool propagatedReady;
+
+        /// An asset is ready when it and all of its dependencies, recursively, have been loaded.
+        bool Ready() const { return loaded && numPendingDependencies == 0; }
+    };
+    typedef std::map<QString, AssetDependencyNode, QStringLessThanNoCase> AssetDependencyGraph;
+
+    /// Keeps track of all the dependencies each asset has to each other asset, keyed by the full asset ref.
+    /** An asset that is referred to, but does not exist, has a node with only dependents. */
+    AssetDependencyGraph dependencyGraph;
 
     /// Stores a list of asset requests to assets that have already been downloaded into the system. These requests don't go to the asset providers
     /// to process, but are internally filled by the Asset API. This member vector is needed to be able to delay the requests and virtual completions
@@ -509,6 +629,56 @@ private:
 
     AssetCache *assetCache;
 
+    /// Reads and decodes assets that support threaded decoding. Null if the asset load threads are disabled.
+    AssetLoadQueue *loadQueue;
+
+    /// Maximum time in seconds spent per frame in ProcessFinishedAssetLoads.
+    double loadHandoffBudget;
+
+    /// Generation of the latest decode job started.
+    u32 decodeGeneration;
+
+    /// Generation of the latest decode job of each asset that is being decoded, by asset name.
+    /** The finished decode jobs of other generations are stale, and dropped. */
+    std::map<QString, u32> latestDecodeJobs;
+
+    /// Content-shareable assets by asset type and content hash ("type/hash").
+    std::map<QString, AssetWeakPtr> contentSharedAssets;
+
+    /// Refs that were resolved to a loaded asset of another ref with identical content.
+    std::map<QString, AssetWeakPtr> contentAliases;
+
+    /// Memory usage and use of an asset, for keeping the loaded assets within the memory budget.
+    struct AssetMemoryUsage
+    {
+        AssetMemoryUsage() : cpuBytes(0), gpuBytes(0), dataSize(0), numReferences(0), lastUse(0), unloadedByBudget(false) {}
+
+        u64 cpuBytes; ///< Estimated main memory usage, zero if the asset is not loaded.
+        u64 gpuBytes; ///< Estimated GPU memory usage, zero if the asset is not loaded.
+        u64 dataSize; ///< Size of the data the asset was loaded from, used if the asset does not estimate its main memory usage.
+        int numReferences; ///< Number of AssetRefListeners that refer to the asset.
+        u64 lastUse; ///< Value of assetUseCounter when the asset was last requested, loaded or referred to.
+        bool unloadedByBudget; ///< True if the asset was unloaded by UnloadUnreferencedAssets and has not been loaded since.
+    };
+    typedef std::map<QString, AssetMemoryUsage, QStringLessThanNoCase> AssetMemoryUsageMap;
+    AssetMemoryUsageMap assetMemoryUsage;
+
+    /// Memory budget of the loaded assets in bytes, zero if unlimited.
+    u64 assetMemoryBudget;
+
+    /// Totals of the memory usage estimates, as of the last UpdateAssetMemoryUsage call.
+    u64 totalAssetCpuMemory;
+    u64 totalAssetGpuMemory;
+
+    /// Incremented each time an asset is used, gives the least recently used order of the assets.
+    u64 assetUseCounter;
+
+    /// Seconds since the memory budget was last checked.
+    f64 timeSinceMemoryBudgetCheck;
+
+    /// Timestamps of the load pipeline stages of each transferred asset.
+    AssetLoadTelemetry *loadTelemetry;
+
     Framework *fw;
 };
 
@@ -0,0 +1,262 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "DebugOperatorNew.h"
+
+#include "AssetBundle.h"
+#include "LoggingFunctions.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QStringList>
+
+#include <climits>
+
+#include "MemoryLeakCheck.h"
+
+namespace
+{
+const u32 cBundleMagic = 0x4C444254; // 'TBDL'
+const u32 cBundleVersion = 1;
+const int cHeaderSize = 4 + 4 + 4 + 8;
+const int cMinIndexEntrySize = 2 + 8 + 4 + 4 + 1; ///< Size of an index entry with an empty name.
+
+/// Returns the file name part of a bundle entry name.
+QString EntryFilename(const QString &name)
+{
+    return name.mid(name.lastIndexOf('/') + 1);
+}
+}
+
+AssetBundle::AssetBundle() :
+    data(0),
+    dataSize(0)
+{
+}
+
+AssetBundle::~AssetBundle()
+{
+    Close();
+}
+
+bool AssetBundle::Open(const QString &filename)
+{
+    Close();
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < cHeaderSize)
+    {
+        LogError("AssetBundle: Could not open bundle file " + filename);
+        Close();
+        return false;
+    }
+
+    dataSize = file.size();
+    data = file.map(0, dataSize);
+    if (!data)
+    {
+        fallbackData = file.readAll();
+        data = (const uchar *)fallbackData.constData();
+    }
+
+    if (!ReadIndex())
+    {
+        LogError("AssetBundle: " + filename + " is not a valid asset bundle.");
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void AssetBundle::Close()
+{
+    if (data && fallbackData.isEmpty())
+        file.unmap(const_cast<uchar *>(data));
+    data = 0;
+    dataSize = 0;
+    fallbackData.clear();
+    file.close();
+    entries.clear();
+    entriesByPath.clear();
+    entriesByName.clear();
+}
+
+bool AssetBundle::ReadIndex()
+{
+    // The header and the index are read through streams over their own ranges of the file, as a QByteArray cannot span a bundle over 2 GB.
+    QByteArray header = QByteArray::fromRawData((const char *)data, cHeaderSize);
+    QDataStream headerStream(header);
+    headerStream.setByteOrder(QDataStream::LittleEndian);
+
+    u32 magic = 0, version = 0, numEntries = 0;
+    u64 indexOffset = 0;
+    headerStream >> magic >> version >> numEntries >> indexOffset;
+    if (magic != cBundleMagic || version != cBundleVersion || indexOffset < (u64)cHeaderSize || indexOffset > (u64)dataSize)
+        return false;
+
+    // Bound the entry count by the size of the index before reserving memory for the entries.
+    const u64 indexSize = (u64)dataSize - indexOffset;
+    if (indexSize > (u64)INT_MAX || numEntries > indexSize / cMinIndexEntrySize)
+        return false;
+
+    QByteArray index = QByteArray::fromRawData((const char *)data + indexOffset, (int)indexSize);
+    QDataStream stream(index);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    entries.reserve(numEntries);
+    for(u32 i = 0; i < numEntries; ++i)
+    {
+        u16 nameLength = 0;
+        stream >> nameLength;
+        QByteArray name(nameLength, 0);
+        if (stream.readRawData(name.data(), nameLength) != nameLength)
+            return false;
+
+        Entry entry;
+        entry.name = QString::fromUtf8(name.constData(), name.size());
+        stream >> entry.offset >> entry.storedSize >> entry.size >> entry.compression;
+        // The data must lie between the header and the index. The checks are ordered so that they cannot overflow.
+        if (stream.status() != QDataStream::Ok || entry.offset < (u64)cHeaderSize || entry.offset > indexOffset ||
+            entry.storedSize > indexOffset - entry.offset || entry.compression > CompressionZlib ||
+            (entry.compression == CompressionNone && entry.storedSize != entry.size) ||
+            (entry.compression == CompressionZlib && entry.storedSize > (u32)INT_MAX)) // qUncompress takes the size as an int.
+            return false;
+
+        entriesByPath[entry.name] = entries.size();
+        entriesByName.insert(std::make_pair(EntryFilename(entry.name), entries.size()));
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+const AssetBundle::Entry *AssetBundle::Find(const QString &name) const
+{
+    QString path = QDir::fromNativeSeparators(name);
+    while(path.startsWith("./"))
+        path = path.mid(2);
+
+    std::map<QString, size_t, QStringLessThanNoCase>::const_iterator iter = entriesByPath.find(path);
+    if (iter == entriesByPath.end())
+    {
+        iter = entriesByName.find(EntryFilename(path));
+        if (iter == entriesByName.end())
+            return 0;
+    }
+    return &entries[iter->second];
+}
+
+bool AssetBundle::Read(const Entry &entry, std::vector<u8> &dst) const
+{
+    if (!data)
+        return false;
+
+    const uchar *src = data + entry.offset;
+    if (entry.compression == CompressionNone)
+    {
+        dst.assign(src, src + entry.size);
+        return true;
+    }
+
+    QByteArray uncompressed = qUncompress(src, (int)entry.storedSize);
+    if ((u32)uncompressed.size() != entry.size)
+    {
+        LogError("AssetBundle: Could not decompress " + entry.name + " in " + file.fileName());
+        return false;
+    }
+    dst.assign(uncompressed.constData(), uncompressed.constData() + uncompressed.size());
+    return true;
+}
+
+bool AssetBundle::Build(const QString &directory, const QString &filename, bool compress)
+{
+    QDir root(directory);
+    if (!root.exists())
+    {
+        LogError("AssetBundle: Directory " + directory + " does not exist.");
+        return false;
+    }
+
+    // Sort the files, so that building the same directory twice gives identical bundles.
+    const QString outputPath = QFileInfo(filename).absoluteFilePath();
+    QStringList files;
+    QDirIterator it(root.absolutePath(), QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+    while(it.hasNext())
+    {
+        QString path = it.next();
+        if (QFileInfo(path).absoluteFilePath() != outputPath)
+            files << path;
+    }
+    files.sort();
+
+    QFile out(filename);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        LogError("AssetBundle: Could not open " + filename + " for writing.");
+        return false;
+    }
+    QDataStream stream(&out);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << cBundleMagic << cBundleVersion << (u32)0 << (u64)0; // The entry count and the index offset are filled in at the end.
+
+    std::vector<Entry> entries;
+    std::map<QString, QString, QStringLessThanNoCase> filenames;
+    foreach(const QString &path, files)
+    {
+        QFile in(path);
+        if (!in.open(QIODevice::ReadOnly))
+        {
+            LogWarning("AssetBundle: Skipping " + path + ", could not open it for reading.");
+            continue;
+        }
+        QByteArray contents = in.readAll();
+
+        Entry entry;
+        entry.name = root.relativeFilePath(path);
+        entry.offset = (u64)out.pos();
+        entry.size = (u32)contents.size();
+        entry.compression = CompressionNone;
+        if (compress && contents.size() > 0)
+        {
+            // Keep the compressed data only if it saves at least a tenth, as decompression is not free.
+            QByteArray compressed = qCompress(contents);
+            if (compressed.size() < contents.size() - contents.size() / 10)
+            {
+                contents = compressed;
+                entry.compression = CompressionZlib;
+            }
+        }
+        entry.storedSize = (u32)contents.size();
+        if (out.write(contents) != contents.size())
+        {
+            LogError("AssetBundle: Writing " + filename + " failed.");
+            return false;
+        }
+
+        // local:// refs ignore subdirectories, so files with the same name in different directories cannot all be addressed.
+        QString entryFilename = EntryFilename(entry.name);
+        if (filenames.find(entryFilename) != filenames.end())
+            LogWarning("AssetBundle: " + entry.name + " has the same file name as " + filenames[entryFilename] + ", so it can only be referred to by its path.");
+        else
+            filenames[entryFilename] = entry.name;
+        entries.push_back(entry);
+    }
+
+    const u64 indexOffset = (u64)out.pos();
+    for(size_t i = 0; i < entries.size(); ++i)
+    {
+        QByteArray name = entries[i].name.toUtf8();
+        stream << (u16)name.size();
+        stream.writeRawData(name.constData(), name.size());
+        stream << entries[i].offset << entries[i].storedSize << entries[i].size << entries[i].compression;
+    }
+
+    out.seek(0);
+    stream << cBundleMagic << cBundleVersion << (u32)entries.size() << indexOffset;
+    if (stream.status() != QDataStream::Ok)
+    {
+        LogError("AssetBundle: Writing " + filename + " failed.");
+        return false;
+    }
+
+    LogInfo(QString("AssetBundle: Wrote %1 files from %2 to %3 (%4 KB).").arg(entries.size()).arg(directory).arg(filename).arg(out.size() / 1024));
+    return true;
+}
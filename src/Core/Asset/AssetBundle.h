@@ -0,0 +1,92 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "CoreStringUtils.h"
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+
+#include <map>
+#include <vector>
+
+/// A read-only archive of asset files with an index, where each entry can optionally be compressed.
+/** Reading many small assets from a bundle avoids the open, stat and read calls of reading each of them from its own file.
+    Opening a bundle maps the file into memory and parses only the index. The asset data is read straight from the mapped memory.
+
+    The file layout is, with all integers in little endian:
+    @code
+    u32 magic 'TBDL', u32 version, u32 number of entries, u64 offset of the index
+    the data of each entry
+    index: for each entry u16 name length, name in UTF-8, u64 data offset, u32 stored size, u32 original size, u8 compression
+    @endcode
+    Entry names are paths relative to the bundled directory, with '/' as the separator. Bundles are built with Build, or with the AssetBundleTool executable. */
+class AssetBundle
+{
+public:
+    /// Compression of a single entry.
+    enum Compression
+    {
+        CompressionNone = 0,
+        CompressionZlib = 1 ///< Compressed with qCompress.
+    };
+
+    /// A single file in the bundle.
+    struct Entry
+    {
+        QString name; ///< Path relative to the bundled directory.
+        u64 offset; ///< Offset of the stored data from the beginning of the bundle file.
+        u32 storedSize; ///< Size of the stored, possibly compressed, data.
+        u32 size; ///< Size of the original file.
+        u8 compression; ///< One of the Compression values.
+    };
+
+    AssetBundle();
+    ~AssetBundle();
+
+    /// Maps the bundle file into memory and reads its index.
+    /** @return False if the file could not be mapped or is not a valid bundle. */
+    bool Open(const QString &filename);
+
+    /// Unmaps the bundle file.
+    void Close();
+
+    /// Returns true if a bundle file is open.
+    bool IsOpen() const { return data != 0; }
+
+    /// Returns the file name of the open bundle.
+    QString Filename() const { return file.fileName(); }
+
+    /// Returns all the entries of the bundle.
+    const std::vector<Entry> &Entries() const { return entries; }
+
+    /// Finds an entry by its relative path, or if there is no such path, by its file name like LocalAssetStorage does.
+    /** The lookup is case-insensitive. @return Null if the bundle does not contain the file. */
+    const Entry *Find(const QString &name) const;
+
+    /// Reads, and if necessary decompresses, the data of an entry.
+    bool Read(const Entry &entry, std::vector<u8> &dst) const;
+
+    /// Builds a bundle of all the files in a directory and its subdirectories.
+    /** @param compress If true, the entries that shrink noticeably are compressed. Entries that would not benefit, f.ex. images that are already compressed, are stored as is.
+        @return True if the bundle was written successfully. */
+    static bool Build(const QString &directory, const QString &filename, bool compress);
+
+private:
+    Q_DISABLE_COPY(AssetBundle)
+
+    /// Reads the index from the mapped file.
+    bool ReadIndex();
+
+    QFile file;
+    QByteArray fallbackData; ///< The bundle contents, if the file could not be mapped to memory.
+    const uchar *data;
+    qint64 dataSize;
+    std::vector<Entry> entries;
+    /// Maps relative paths to their index in entries.
+    std::map<QString, size_t, QStringLessThanNoCase> entriesByPath;
+    /// Maps file names without the path to their index in entries. If several files have the same name, the first one is used.
+    std::map<QString, size_t, QStringLessThanNoCase> entriesByName;
+};
@@ -9,6 +9,7 @@
 #include "CoreDefines.h"
 #include "Framework.h"
 #include "LoggingFunctions.h"
+#include "Profiler.h"
 
 #include <QDateTime>
 #include <QUrl>
@@ -16,6 +17,12 @@
 #include <QDataStream>
 #include <QFileInfo>
 #include <QScopedPointer>
+#include <QCryptographicHash>
+#include <QRegExp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #ifdef Q_WS_WIN
 #include "Win.h"
@@ -26,9 +33,25 @@
 
 #include "MemoryLeakCheck.h"
 
+namespace
+{
+/// Identifies the asset cache index file, and its format version.
+const quint32 cIndexMagic = 0x54434958; // "TCIX"
+const quint32 cIndexVersion = 4;
+
+/// Interval in seconds at which a changed index is saved, so that a crash loses at most this much of the access statistics.
+const f64 cIndexSaveInterval = 60.0;
+}
+
 AssetCache::AssetCache(AssetAPI *owner, QString assetCacheDirectory) : 
     assetAPI(owner),
-    cacheDirectory(GuaranteeTrailingSlash(QDir::fromNativeSeparators(assetCacheDirectory)))
+    cacheDirectory(GuaranteeTrailingSlash(QDir::fromNativeSeparators(assetCacheDirectory))),
+    totalSize(0),
+    maxSize(0),
+    evictionPolicy(EvictLeastRecentlyUsed),
+    contentAddressed(false),
+    indexDirty(false),
+    timeSinceIndexSave(0.0)
 {
     LogInfo("* Asset cache directory: " + cacheDirectory);  
 
@@ -48,28 +71,75 @@ AssetCache::AssetCache(AssetAPI *owner, QString assetCacheDirectory) :
         assetDir.mkdir("data");
     assetDataDir = QDir(cacheDirectory + "data");
 
+    Framework *fw = owner->GetFramework();
+    QStringList sizeParam = fw->CommandLineParameters("--assetCacheSize");
+    if (sizeParam.size() > 0)
+    {
+        bool ok = false;
+        qint64 megabytes = sizeParam.last().toLongLong(&ok);
+        if (ok && megabytes >= 0)
+            maxSize = megabytes * 1024 * 1024;
+        else
+            LogWarning("AssetCache: Erroneous value given with --assetCacheSize: " + sizeParam.last() + ". Ignoring.");
+    }
+    QStringList policyParam = fw->CommandLineParameters("--assetCacheEviction");
+    if (policyParam.size() > 0)
+    {
+        if (policyParam.last().compare("lfu", Qt::CaseInsensitive) == 0)
+            evictionPolicy = EvictLeastFrequentlyUsed;
+        else if (policyParam.last().compare("lru", Qt::CaseInsensitive) != 0)
+            LogWarning("AssetCache: Unknown eviction policy given with --assetCacheEviction: " + policyParam.last() + ". Using 'lru'.");
+    }
+
+    contentAddressed = fw->HasCommandLineParameter("--contentAddressedCache");
+
     // Check --clear-asset-cache start param
-    if (owner->GetFramework()->HasCommandLineParameter("--clear-asset-cache"))
+    if (fw->HasCommandLineParameter("--clear-asset-cache"))
     {
         LogInfo("AssetCache: Removing all data and metadata files from cache, found 'clear-asset-cache' from start params!");
         ClearAssetCache();
     }
+    else if (!LoadIndex())
+        RebuildIndex();
+
+    if (maxSize > 0 && totalSize > maxSize)
+        EvictFiles("");
+}
+
+AssetCache::~AssetCache()
+{
+    SaveIndex();
+}
+
+void AssetCache::Update(f64 frametime)
+{
+    timeSinceIndexSave += frametime;
+    if (timeSinceIndexSave >= cIndexSaveInterval)
+    {
+        timeSinceIndexSave = 0.0;
+        SaveIndex();
+    }
 }
 
 QString AssetCache::FindInCache(const QString &assetRef)
 {
-    QString absolutePath = GetDiskSourceByRef(assetRef);
-    if (QFile::exists(absolutePath))
-        return absolutePath;
-    else // The file is not in cache, return an empty string to denote that.
+    Entry *entry = FindEntry(assetRef);
+    if (!entry) // The file is not in cache, return an empty string to denote that.
         return "";
+
+    if (entry->assetRef.isEmpty())
+        entry->assetRef = assetRef;
+    entry->lastAccess = QDateTime::currentMSecsSinceEpoch();
+    ++entry->accessCount;
+    indexDirty = true;
+    return GetDiskSourceByRef(assetRef);
 }
 
 QString AssetCache::GetDiskSourceByRef(const QString &assetRef)
 {
     // Return the path where the given asset ref would be stored, if it was saved in the cache
     // (regardless of whether it now exists in the cache).
-    return assetDataDir.absolutePath() + "/" + AssetAPI::SanitateAssetRef(assetRef);
+    return assetDataDir.absolutePath() + "/" + FileNameForRef(assetRef);
 }
 
 QString AssetCache::CacheDirectory() const
@@ -86,64 +156,66 @@ QString AssetCache::StoreAsset(AssetPtr asset)
 
 QString AssetCache::StoreAsset(const u8 *data, size_t numBytes, const QString &assetName)
 {
-    QString absolutePath = GetDiskSourceByRef(assetName);
-    bool success = SaveAssetFromMemoryToFile(data, numBytes, absolutePath);
-    if (success)
-        return absolutePath;
-    return "";
-}
-
-QDateTime AssetCache::LastModified(const QString &assetRef)
-{
-    QString absolutePath = FindInCache(assetRef);
-    if (absolutePath.isEmpty())
-        return QDateTime();
-
-#ifdef Q_WS_WIN
-    HANDLE fileHandle = (HANDLE)OpenFileHandle(absolutePath);
-    if (fileHandle == INVALID_HANDLE_VALUE)
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QString fileName = AssetAPI::SanitateAssetRef(assetName);
+    if (contentAddressed)
     {
-        LogError("AssetCache: Failed to open cache file to read last modified time: " + assetRef);
-        return QDateTime();
+        const QString contentFileName = ContentFileName(data, numBytes, fileName);
+        RefEntry &ref = refs[fileName];
+        const QString oldFileName = ref.fileName;
+        ref.fileName = contentFileName;
+        ref.lastModified = now;
+        ref.lastValidated = now;
+        if (!oldFileName.isEmpty() && oldFileName != contentFileName)
+            RemoveIfUnreferenced(oldFileName);
+        fileName = contentFileName;
     }
 
-    // Get last write time.
-    FILETIME fileTime;
-    BOOL success = GetFileTime(fileHandle, 0, 0, &fileTime); // http://msdn.microsoft.com/en-us/library/windows/desktop/ms724320(v=VS.85).aspx
-    CloseHandle(fileHandle);
-    if (!success)
+    QString absolutePath = assetDataDir.absolutePath() + "/" + fileName;
+    EntryMap::iterator existing = entries.find(fileName);
+    // Identical content is already stored under its hash, there is no need to write it again.
+    const bool write = (!contentAddressed || existing == entries.end());
+    if (write)
     {
-        LogError("AssetCache: Failed to read cache file last modified time: " + assetRef);
-        return QDateTime();
+        bool success = SaveAssetFromMemoryToFile(data, numBytes, absolutePath);
+        if (!success)
+        {
+            if (contentAddressed)
+                refs.erase(AssetAPI::SanitateAssetRef(assetName));
+            return "";
+        }
     }
 
-    // Convert to UTC.
-    SYSTEMTIME sysTime;
-    if (!FileTimeToSystemTime(&fileTime, &sysTime)) // http://msdn.microsoft.com/en-us/library/windows/desktop/ms724280(v=VS.85).aspx
-    {
-        LogError("Win32 FileTimeToSystemTime failed for asset ref " + assetRef);
+    Entry &entry = entries[fileName];
+    if (write)
+        entry.fileTime = QFileInfo(absolutePath).lastModified().toMSecsSinceEpoch();
+    totalSize += (qint64)numBytes - entry.size;
+    if (entry.assetRef.isEmpty() || !contentAddressed)
+        entry.assetRef = assetName;
+    entry.size = (qint64)numBytes;
+    entry.lastModified = now;
+    entry.lastValidated = now;
+    entry.lastAccess = now;
+    ++entry.accessCount;
+    indexDirty = true;
+
+    if (maxSize > 0 && totalSize > maxSize)
+        EvictFiles(fileName);
+    return absolutePath;
+}
+
+QDateTime AssetCache::LastModified(const QString &assetRef)
+{
+    Entry *entry = FindEntry(assetRef);
+    if (!entry)
         return QDateTime();
-    }
 
-    // Ignore msec
+    // With content addressing, the last modified time is kept per ref, as the same content can have a different time at each source.
+    RefMap::const_iterator ref = refs.find(AssetAPI::SanitateAssetRef(assetRef));
     QDateTime dateTime;
     dateTime.setTimeSpec(Qt::UTC);
-    dateTime.setDate(QDate((int)sysTime.wYear, (int)sysTime.wMonth, (int)sysTime.wDay));
-    dateTime.setTime(QTime((int)sysTime.wHour, (int)sysTime.wMinute, (int)sysTime.wSecond, 0));
+    dateTime.setMSecsSinceEpoch(ref != refs.end() ? ref->second.lastModified : entry->lastModified);
     return dateTime;
-#else
-    QDateTime dateTime;
-    QString nativePath = QDir::toNativeSeparators(absolutePath);
-    struct stat fileStats;
-    if (stat(nativePath.toStdString().c_str(), &fileStats) == 0)
-    {
-        qint64 msecFromEpoch = (qint64)fileStats.st_mtime * 1000;
-        dateTime.setMSecsSinceEpoch(msecFromEpoch);
-    }
-    else
-        LogError("AssetCache: Failed to read cache file last modified time: " + assetRef);
-    return dateTime;
-#endif
 }
 
 bool AssetCache::SetLastModified(const QString &assetRef, const QDateTime &dateTime)
@@ -154,10 +226,23 @@ bool AssetCache::SetLastModified(const QString &assetRef, const QDateTime &dateT
         return false;
     }
 
-    QString absolutePath = FindInCache(assetRef);
-    if (absolutePath.isEmpty())
+    Entry *entry = FindEntry(assetRef);
+    if (!entry)
         return false;
+    // The time is kept in the index with second precision, like the file system time stamp it mirrors.
+    const qint64 lastModified = (dateTime.toMSecsSinceEpoch() / 1000) * 1000;
+    indexDirty = true;
+    RefMap::iterator ref = refs.find(AssetAPI::SanitateAssetRef(assetRef));
+    if (ref != refs.end())
+    {
+        // A content-addressed file can be shared by several refs, so its time stamp is not touched.
+        ref->second.lastModified = lastModified;
+        return true;
+    }
+    entry->lastModified = lastModified;
 
+    // Also set the file time stamp, so that the time is not lost if the index needs to be rebuilt.
+    QString absolutePath = GetDiskSourceByRef(assetRef);
     QDate date = dateTime.date();
     QTime time = dateTime.time();
 
@@ -193,6 +278,7 @@ bool AssetCache::SetLastModified(const QString &assetRef, const QDateTime &dateT
         LogError("AssetCache: Failed to update cache file last modified time: " + assetRef);
         return false;
     }
+    entry->fileTime = QFileInfo(absolutePath).lastModified().toMSecsSinceEpoch();
     return true;
 #else
     QString nativePath = QDir::toNativeSeparators(absolutePath);
@@ -204,8 +290,8 @@ bool AssetCache::SetLastModified(const QString &assetRef, const QDateTime &dateT
         LogError("AssetCache: Failed to read cache file last modified time: " + assetRef);
         return false;
     }
-    else
-        return true;
+    entry->fileTime = QFileInfo(absolutePath).lastModified().toMSecsSinceEpoch();
+    return true;
 #endif
 }
 
@@ -220,11 +306,61 @@ void *AssetCache::OpenFileHandle(const QString &absolutePath)
 }
 #endif
 
+QDateTime AssetCache::LastValidated(const QString &assetRef)
+{
+    Entry *entry = FindEntry(assetRef);
+    if (!entry || entry->lastValidated == 0)
+        return QDateTime();
+
+    RefMap::const_iterator ref = refs.find(AssetAPI::SanitateAssetRef(assetRef));
+    QDateTime dateTime;
+    dateTime.setTimeSpec(Qt::UTC);
+    dateTime.setMSecsSinceEpoch(ref != refs.end() ? ref->second.lastValidated : entry->lastValidated);
+    return dateTime;
+}
+
+void AssetCache::SetValidated(const QString &assetRef)
+{
+    Entry *entry = FindEntry(assetRef);
+    if (!entry)
+        return;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    RefMap::iterator ref = refs.find(AssetAPI::SanitateAssetRef(assetRef));
+    if (ref != refs.end())
+        ref->second.lastValidated = now;
+    entry->lastValidated = now;
+    indexDirty = true;
+}
+
 void AssetCache::DeleteAsset(const QString &assetRef)
 {
-    QString absolutePath = GetDiskSourceByRef(assetRef);
-    if (QFile::exists(absolutePath))
-        QFile::remove(absolutePath);
+    const QString refFileName = AssetAPI::SanitateAssetRef(assetRef);
+    RefMap::iterator ref = refs.find(refFileName);
+    if (ref != refs.end())
+    {
+        // The content file is removed only when no other ref uses it.
+        const QString fileName = ref->second.fileName;
+        refs.erase(ref);
+        indexDirty = true;
+        RemoveIfUnreferenced(fileName);
+        return;
+    }
+
+    EntryMap::iterator iter = entries.find(refFileName);
+    if (iter == entries.end())
+        return;
+
+    QFile::remove(assetDataDir.absolutePath() + "/" + refFileName);
+    totalSize -= iter->second.size;
+    entries.erase(iter);
+    indexDirty = true;
+}
+
+QString AssetCache::ContentHash(const QString &assetRef) const
+{
+    RefMap::const_iterator ref = refs.find(AssetAPI::SanitateAssetRef(assetRef));
+    return ref != refs.end() ? ref->second.fileName.section('.', 0, 0) : QString();
 }
 
 void AssetCache::ClearAssetCache()
@@ -240,4 +376,323 @@ void AssetCache::ClearAssetCache()
                 LogWarning("AssetCache::ClearAssetCache could not remove file " + entry.absoluteFilePath());
         }
     }
+    RebuildIndex();
+}
+
+void AssetCache::SetMaxSize(qint64 bytes)
+{
+    maxSize = std::max(bytes, (qint64)0);
+    if (maxSize > 0 && totalSize > maxSize)
+        EvictFiles("");
+}
+
+AssetCache::Entry *AssetCache::FindEntry(const QString &assetRef)
+{
+    EntryMap::iterator iter = entries.find(FileNameForRef(assetRef));
+    return iter != entries.end() ? &iter->second : 0;
+}
+
+QString AssetCache::FileNameForRef(const QString &assetRef) const
+{
+    const QString fileName = AssetAPI::SanitateAssetRef(assetRef);
+    RefMap::const_iterator ref = refs.find(fileName);
+    return ref != refs.end() ? ref->second.fileName : fileName;
+}
+
+QString AssetCache::ContentFileName(const u8 *data, size_t numBytes, const QString &refFileName)
+{
+    // Keep the file suffix of the ref, as Ogre picks the codec of a resource by its suffix.
+    QString hash = QCryptographicHash::hash(QByteArray::fromRawData((const char *)data, (int)numBytes), QCryptographicHash::Sha1).toHex();
+    QString suffix = refFileName.section('.', -1);
+    if (suffix != refFileName && suffix.length() <= 8 && QRegExp("[A-Za-z0-9]+").exactMatch(suffix))
+        return hash + "." + suffix.toLower();
+    return hash;
+}
+
+void AssetCache::RemoveIfUnreferenced(const QString &fileName)
+{
+    for(RefMap::const_iterator iter = refs.begin(); iter != refs.end(); ++iter)
+        if (iter->second.fileName == fileName)
+            return;
+
+    EntryMap::iterator iter = entries.find(fileName);
+    if (iter == entries.end())
+        return;
+    assetDataDir.remove(fileName);
+    totalSize -= iter->second.size;
+    entries.erase(iter);
+    indexDirty = true;
+}
+
+void AssetCache::ForgetAsset(const QString &assetRef)
+{
+    ForgetFile(FileNameForRef(assetRef));
+}
+
+void AssetCache::ForgetFile(const QString &fileName)
+{
+    EntryMap::iterator iter = entries.find(fileName);
+    if (iter != entries.end())
+    {
+        totalSize -= iter->second.size;
+        entries.erase(iter);
+    }
+    for(RefMap::iterator ref = refs.begin(); ref != refs.end();)
+    {
+        if (ref->second.fileName == fileName)
+            refs.erase(ref++);
+        else
+            ++ref;
+    }
+    indexDirty = true;
+}
+
+QString AssetCache::IndexFile() const
+{
+    return cacheDirectory + "index.dat";
+}
+
+bool AssetCache::LoadIndex()
+{
+    QFile file(IndexFile());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    quint32 magic = 0, version = 0, numEntries = 0;
+    stream >> magic >> version >> numEntries;
+    if (magic != cIndexMagic || version < 1 || version > cIndexVersion)
+        return false;
+
+    entries.clear();
+    refs.clear();
+    totalSize = 0;
+    for(quint32 i = 0; i < numEntries && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString fileName;
+        Entry entry;
+        stream >> fileName >> entry.assetRef >> entry.size >> entry.lastModified >> entry.lastAccess >> entry.accessCount;
+        if (version >= 3)
+            stream >> entry.lastValidated;
+        if (version >= 4)
+            stream >> entry.fileTime;
+        totalSize += entry.size;
+        entries[fileName] = entry;
+    }
+    // Version 2 added the ref to content mapping of the content-addressed cache.
+    quint32 numRefs = 0;
+    if (version >= 2)
+        stream >> numRefs;
+    for(quint32 i = 0; i < numRefs && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString refFileName;
+        RefEntry ref;
+        stream >> refFileName >> ref.fileName >> ref.lastModified;
+        if (version >= 3)
+            stream >> ref.lastValidated;
+        if (entries.find(ref.fileName) != entries.end())
+            refs[refFileName] = ref;
+    }
+    if (stream.status() != QDataStream::Ok)
+    {
+        LogWarning("AssetCache: Index file " + IndexFile() + " is corrupt, rebuilding it.");
+        return false;
+    }
+
+    // Files may have been added, removed or rewritten while the index was not up to date, f.ex. if the previous run crashed.
+    indexDirty = false;
+    ReconcileIndex();
+    return true;
+}
+
+void AssetCache::SaveIndex()
+{
+    if (!indexDirty)
+        return;
+
+    // Write to a temporary file first, so that a crash while writing cannot leave a truncated index behind.
+    const QString tempFile = IndexFile() + ".tmp";
+    QFile file(tempFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        LogWarning("AssetCache: Could not write index file " + tempFile);
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << cIndexMagic << cIndexVersion << (quint32)entries.size();
+    for(EntryMap::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+    {
+        const Entry &entry = iter->second;
+        stream << iter->first << entry.assetRef << entry.size << entry.lastModified << entry.lastAccess << entry.accessCount << entry.lastValidated << entry.fileTime;
+    }
+    stream << (quint32)refs.size();
+    for(RefMap::const_iterator iter = refs.begin(); iter != refs.end(); ++iter)
+        stream << iter->first << iter->second.fileName << iter->second.lastModified << iter->second.lastValidated;
+    file.close();
+
+    QFile::remove(IndexFile());
+    if (stream.status() != QDataStream::Ok || !QFile::rename(tempFile, IndexFile()))
+    {
+        LogWarning("AssetCache: Could not write index file " + IndexFile());
+        QFile::remove(tempFile);
+        return;
+    }
+    indexDirty = false;
+}
+
+void AssetCache::RebuildIndex()
+{
+    // Note: the ref to content mapping cannot be recovered from the data directory. Content-addressed files
+    // that lose their refs here are eventually evicted, or removed with --clear-asset-cache.
+    entries.clear();
+    refs.clear();
+    totalSize = 0;
+    indexDirty = true;
+    ReconcileIndex();
+}
+
+void AssetCache::ReconcileIndex()
+{
+    PROFILE(AssetCache_ReconcileIndex);
+
+    if (!assetDataDir.exists())
+        return;
+
+    std::set<QString> contentFiles;
+    for(RefMap::const_iterator iter = refs.begin(); iter != refs.end(); ++iter)
+        contentFiles.insert(iter->second.fileName);
+
+    std::set<QString> existingFiles;
+    int numAdded = 0, numChanged = 0;
+    QFileInfoList files = assetDataDir.entryInfoList(QDir::Files|QDir::NoSymLinks|QDir::NoDotAndDotDot);
+    foreach(const QFileInfo &fileInfo, files)
+    {
+        const QString fileName = fileInfo.fileName();
+        const qint64 size = fileInfo.size();
+        const qint64 fileTime = fileInfo.lastModified().toMSecsSinceEpoch();
+        existingFiles.insert(fileName);
+
+        EntryMap::iterator iter = entries.find(fileName);
+        if (iter == entries.end())
+        {
+            Entry entry;
+            entry.size = size;
+            entry.fileTime = fileTime;
+            entry.lastModified = fileTime;
+            entry.lastAccess = fileTime;
+            totalSize += size;
+            entries[fileName] = entry;
+            ++numAdded;
+            continue;
+        }
+
+        // Indices older than version 4 do not have the file times, take them as they are if the size matches.
+        Entry &entry = iter->second;
+        if (entry.size == size && (entry.fileTime == fileTime || entry.fileTime == 0))
+        {
+            entry.fileTime = fileTime;
+            continue;
+        }
+
+        ++numChanged;
+        if (contentFiles.find(fileName) != contentFiles.end())
+        {
+            // The content no longer matches the hash it is stored under.
+            ForgetFile(fileName);
+            assetDataDir.remove(fileName);
+            continue;
+        }
+        totalSize += size - entry.size;
+        entry.size = size;
+        entry.fileTime = fileTime;
+        entry.lastModified = fileTime;
+        entry.lastValidated = 0; // The source of the file is not known anymore, so it is revalidated on the next request.
+    }
+
+    std::vector<QString> missingFiles;
+    for(EntryMap::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+        if (existingFiles.find(iter->first) == existingFiles.end())
+            missingFiles.push_back(iter->first);
+    for(size_t i = 0; i < missingFiles.size(); ++i)
+        ForgetFile(missingFiles[i]);
+
+    if (numAdded > 0 || numChanged > 0 || !missingFiles.empty())
+    {
+        indexDirty = true;
+        LogInfo(QString("AssetCache: Index updated from the data directory: %1 files added, %2 changed, %3 removed.").arg(numAdded).arg(numChanged).arg(missingFiles.size()));
+    }
+}
+
+std::set<QString> AssetCache::LoadedAssetFiles() const
+{
+    std::set<QString> files;
+    const QString dataDir = CacheDirectory();
+    AssetMap assets = assetAPI->GetAllAssets();
+    for(AssetMap::const_iterator iter = assets.begin(); iter != assets.end(); ++iter)
+    {
+        const QString diskSource = QDir::fromNativeSeparators(iter->second->DiskSource());
+        if (iter->second->IsLoaded() && diskSource.startsWith(dataDir, Qt::CaseInsensitive))
+            files.insert(diskSource.mid(dataDir.length()));
+    }
+    return files;
+}
+
+void AssetCache::EvictFiles(const QString &keep)
+{
+    PROFILE(AssetCache_EvictFiles);
+
+    // Evict down to a low watermark, so that storing the next few assets does not trigger another eviction pass.
+    const qint64 targetSize = maxSize - maxSize / 10;
+
+    // Loaded assets are found by their disk sources as well as by the refs of the entries, as the entries rebuilt
+    // from the data directory, and content-addressed files shared by several refs, do not know all their refs.
+    const std::set<QString> loadedFiles = LoadedAssetFiles();
+
+    std::vector<std::pair<std::pair<qint64, qint64>, QString> > candidates;
+    candidates.reserve(entries.size());
+    for(EntryMap::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+    {
+        const Entry &entry = iter->second;
+        if (iter->first == keep || loadedFiles.find(iter->first) != loadedFiles.end())
+            continue;
+        AssetPtr asset = entry.assetRef.isEmpty() ? AssetPtr() : assetAPI->GetAsset(entry.assetRef);
+        if (asset && asset->IsLoaded())
+            continue;
+        if (evictionPolicy == EvictLeastFrequentlyUsed)
+            candidates.push_back(std::make_pair(std::make_pair((qint64)entry.accessCount, entry.lastAccess), iter->first));
+        else
+            candidates.push_back(std::make_pair(std::make_pair(entry.lastAccess, (qint64)entry.accessCount), iter->first));
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    int numEvicted = 0;
+    const qint64 oldSize = totalSize;
+    for(size_t i = 0; i < candidates.size() && totalSize > targetSize; ++i)
+    {
+        EntryMap::iterator iter = entries.find(candidates[i].second);
+        if (!assetDataDir.remove(iter->first) && assetDataDir.exists(iter->first))
+        {
+            LogWarning("AssetCache: Could not evict file " + assetDataDir.absoluteFilePath(iter->first));
+            continue;
+        }
+        totalSize -= iter->second.size;
+        entries.erase(iter);
+        ++numEvicted;
+    }
+    indexDirty = true;
+
+    // Forget the refs whose content was evicted.
+    for(RefMap::iterator iter = refs.begin(); iter != refs.end();)
+    {
+        if (entries.find(iter->second.fileName) == entries.end())
+            refs.erase(iter++);
+        else
+            ++iter;
+    }
+
+    LogDebug("AssetCache: Evicted " + QString::number(numEvicted) + " files, " + QString::number((oldSize - totalSize) / 1024) + " KB. Cache size is now " +
+        QString::number(totalSize / 1024) + " KB of maximum " + QString::number(maxSize / 1024) + " KB.");
+    if (totalSize > maxSize)
+        LogWarning("AssetCache: Cache is over its maximum size, the remaining files belong to loaded assets.");
 }
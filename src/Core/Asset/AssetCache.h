@@ -10,13 +10,39 @@
 #include <QObject>
 #include <QDateTime>
 
+#include <map>
+#include <set>
+
 /// Implements a disk cache for asset files to avoid re-downloading assets between runs.
+/** The cache keeps an index of the size, last modified time and access statistics of each cached file. The index is stored
+    to disk regularly and on exit, and read back on startup, so that lookups only need to check that the file still exists.
+    On startup the index is reconciled with a single listing of the data directory: files that were added, removed, or rewritten
+    in place while the index was not up to date are detected by their size and modification time. If the index is missing, it is
+    rebuilt from the listing.
+
+    The total size of the cache can be limited with --assetCacheSize. When the limit is exceeded, the least recently used
+    (--assetCacheEviction lru, the default) or least frequently used (--assetCacheEviction lfu) files are deleted until the cache
+    is below 90% of the limit. Files of assets that are currently loaded are never evicted.
+
+    With --contentAddressedCache, data is stored under the SHA-1 hash of its content, and the index maps each ref to its content.
+    Refs with identical content, f.ex. the same file mirrored on several storages, share a single cache file. */
 class AssetCache : public QObject
 {
     Q_OBJECT
 
 public:
     explicit AssetCache(AssetAPI *owner, QString assetCacheDirectory);
+    ~AssetCache();
+
+    /// Saves the index to disk at regular intervals if it has changed. Called by AssetAPI, do not call from elsewhere.
+    void Update(f64 frametime);
+
+    /// Cache file eviction policies.
+    enum EvictionPolicy
+    {
+        EvictLeastRecentlyUsed,
+        EvictLeastFrequentlyUsed
+    };
 
 public slots:
     /// Returns the absolute path on the local file system that contains a cached copy of the given asset ref.
@@ -50,10 +76,22 @@ public slots:
     /// @return bool Returns true if successful, false otherwise.
     bool SetLastModified(const QString &assetRef, const QDateTime &dateTime);
 
+    /// Returns the time the cached copy of assetRef was last downloaded or confirmed to be up to date with its source.
+    /// Returns an invalid QDateTime if the asset is not in the cache or the time is not known.
+    QDateTime LastValidated(const QString &assetRef);
+
+    /// Records that the cached copy of assetRef was just confirmed to be up to date with its source, f.ex. by a '304 Not Modified' reply.
+    void SetValidated(const QString &assetRef);
+
     /// Deletes the asset with the given assetRef from the cache, if it exists.
     /// @param QString asset reference.
     void DeleteAsset(const QString &assetRef);
 
+    /// Removes the cached file of the given asset ref from the cache index, without deleting the file.
+    /// Used when the cached file could not be read, f.ex. because it was deleted from outside while Tundra is running.
+    /// @param QString asset reference.
+    void ForgetAsset(const QString &assetRef);
+
     /// Deletes all data and metadata files from the asset cache.
     /// Will not clear sub folders in the cache folders, or remove any folders.
     void ClearAssetCache();
@@ -61,8 +99,92 @@ public slots:
     /// Get the cache directory. Returned path is guaranteed to have a trailing slash /.
     /// @return QString absolute path to the caches data directory
     QString CacheDirectory() const;
-    
+
+    /// Returns the total size of the cached files in bytes.
+    qint64 TotalSize() const { return totalSize; }
+
+    /// Returns the maximum size of the cache in bytes, or 0 if the size is not limited.
+    qint64 MaxSize() const { return maxSize; }
+
+    /// Sets the maximum size of the cache in bytes. 0 disables the limit. If the cache is over the new limit, files are evicted immediately.
+    void SetMaxSize(qint64 bytes);
+
+    /// Returns the number of files in the cache.
+    int NumFiles() const { return (int)entries.size(); }
+
+    /// Returns true if the cache stores data by content hash.
+    bool IsContentAddressed() const { return contentAddressed; }
+
+    /// Returns the SHA-1 hash, in hex, of the cached content of the given asset ref.
+    /// Returns an empty string if the cache is not content-addressed or the ref is not in the cache.
+    QString ContentHash(const QString &assetRef) const;
+
 private:
+    /// Index information of a single cached file.
+    struct Entry
+    {
+        Entry() : size(0), fileTime(0), lastModified(0), lastValidated(0), lastAccess(0), accessCount(0) {}
+
+        QString assetRef; ///< The asset ref the file was cached for, if known. Empty for files found by scanning the data directory.
+        qint64 size; ///< File size in bytes.
+        qint64 fileTime; ///< Modification time of the cached file itself, in msecs since epoch. Used to detect files rewritten outside the cache.
+        qint64 lastModified; ///< Last modified time of the source asset, in msecs since epoch.
+        qint64 lastValidated; ///< Time the file was last downloaded or revalidated from its source, in msecs since epoch. 0 if not known.
+        qint64 lastAccess; ///< Time the file was last stored or looked up, in msecs since epoch.
+        quint32 accessCount; ///< How many times the file has been stored or looked up.
+    };
+    typedef std::map<QString, Entry> EntryMap;
+
+    /// Maps an asset ref to its content in a content-addressed cache.
+    struct RefEntry
+    {
+        RefEntry() : lastModified(0), lastValidated(0) {}
+
+        QString fileName; ///< File name of the content in the data directory: the content hash and the suffix of the ref.
+        qint64 lastModified; ///< Last modified time of the source asset of this ref, in msecs since epoch.
+        qint64 lastValidated; ///< Time this ref was last downloaded or revalidated from its source, in msecs since epoch.
+    };
+    typedef std::map<QString, RefEntry> RefMap;
+
+    /// Returns the index entry of the given asset ref, or null if the asset is not in the cache.
+    Entry *FindEntry(const QString &assetRef);
+
+    /// Returns the file name in the data directory of the given asset ref, regardless of whether the ref is in the cache.
+    QString FileNameForRef(const QString &assetRef) const;
+
+    /// Returns the content-addressed file name for the given data.
+    static QString ContentFileName(const u8 *data, size_t numBytes, const QString &refFileName);
+
+    /// Deletes a content-addressed file, if no ref refers to it anymore.
+    void RemoveIfUnreferenced(const QString &fileName);
+
+    /// Removes a file from the index, and the refs to it. Does not delete the file.
+    void ForgetFile(const QString &fileName);
+
+    /// Reads the index file and reconciles it with the data directory. Returns false if the index is missing or corrupt.
+    bool LoadIndex();
+
+    /// Updates the index to match the files in the data directory. Files that are not in the index are added, and the entries of
+    /// missing files are removed. Files whose size or modification time differ from the index were rewritten outside the cache:
+    /// content-addressed files no longer match their hash and are deleted, other files get their new size and are revalidated.
+    void ReconcileIndex();
+
+    /// Writes the index file, if it has changed since it was last read or written.
+    void SaveIndex();
+
+    /// Rebuilds the index by scanning the data directory.
+    void RebuildIndex();
+
+    /// Returns the files in the data directory that loaded assets were loaded from.
+    std::set<QString> LoadedAssetFiles() const;
+
+    /// Deletes files until the cache is below 90% of the maximum size.
+    /// @param keep File name that must not be evicted, f.ex. the file just stored.
+    void EvictFiles(const QString &keep);
+
+    /// Returns the path of the index file.
+    QString IndexFile() const;
+
 #ifdef Q_WS_WIN
     /// Windows specific helper to open a file handle to absolutePath
     void *OpenFileHandle(const QString &absolutePath);
@@ -75,4 +197,28 @@ private:
 
     /// Asset data dir.
     QDir assetDataDir;
+
+    /// Index of the cached files, keyed by the file name in the data directory.
+    EntryMap entries;
+
+    /// Ref to content mapping of the content-addressed cache, keyed by the sanitated ref.
+    RefMap refs;
+
+    /// Sum of the sizes of all the cached files.
+    qint64 totalSize;
+
+    /// Maximum total size of the cached files, or 0 for no limit.
+    qint64 maxSize;
+
+    /// Which files are evicted first when the cache is full.
+    EvictionPolicy evictionPolicy;
+
+    /// If true, new data is stored by content hash.
+    bool contentAddressed;
+
+    /// True if the index has changed since it was last read or written.
+    bool indexDirty;
+
+    /// Time in seconds since the index was last saved by Update.
+    f64 timeSinceIndexSave;
 };
@@ -30,6 +30,9 @@ typedef boost::shared_ptr<IAssetUploadTransfer> AssetUploadTransferPtr;
 struct AssetReference;
 struct AssetReferenceList;
 
+class IAssetDecodeData;
+typedef boost::shared_ptr<IAssetDecodeData> AssetDecodeDataPtr;
+
 class IAssetTypeFactory;
 typedef boost::shared_ptr<IAssetTypeFactory> AssetTypeFactoryPtr;
 
@@ -0,0 +1,145 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "DebugOperatorNew.h"
+
+#include "AssetLoadQueue.h"
+#include "IAsset.h"
+#include "LoggingFunctions.h"
+
+#include <QFile>
+
+#include <boost/bind.hpp>
+
+#include <exception>
+
+#include "MemoryLeakCheck.h"
+
+AssetLoadQueue::AssetLoadQueue(int numThreads_) :
+    numRunningJobs(0),
+    numThreads(0),
+    stopping(false)
+{
+    for(int i = 0; i < numThreads_; ++i)
+    {
+        try
+        {
+            threads.create_thread(boost::bind(&AssetLoadQueue::ThreadMain, this));
+            ++numThreads;
+        }
+        catch(const boost::thread_resource_error &)
+        {
+            LogError("AssetLoadQueue: Failed to start asset load worker thread " + QString::number(i + 1) + ".");
+            break;
+        }
+    }
+}
+
+AssetLoadQueue::~AssetLoadQueue()
+{
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        stopping = true;
+        pendingJobs.clear();
+    }
+    jobAvailable.notify_all();
+    threads.join_all();
+}
+
+void AssetLoadQueue::Enqueue(const JobPtr &job)
+{
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        pendingJobs.push_back(job);
+    }
+    jobAvailable.notify_one();
+}
+
+bool AssetLoadQueue::TakeFinished(JobPtr &job)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    if (finishedJobs.empty())
+        return false;
+    job = finishedJobs.front();
+    finishedJobs.pop_front();
+    return true;
+}
+
+size_t AssetLoadQueue::NumPendingJobs() const
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return pendingJobs.size() + numRunningJobs;
+}
+
+void AssetLoadQueue::ThreadMain()
+{
+    for(;;)
+    {
+        JobPtr job;
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            while(!stopping && pendingJobs.empty())
+                jobAvailable.wait(lock);
+            if (stopping)
+                return;
+            job = pendingJobs.front();
+            pendingJobs.pop_front();
+            ++numRunningJobs;
+        }
+
+        Process(*job);
+
+        boost::mutex::scoped_lock lock(mutex);
+        finishedJobs.push_back(job);
+        job.reset(); // The finished queue now holds a reference, so the asset cannot be destroyed on this thread.
+        --numRunningJobs;
+    }
+}
+
+void AssetLoadQueue::Process(Job &job)
+{
+    // Read the file here instead of with LoadFileToVector, which logs its errors. Logging is not allowed on the worker threads.
+    if (job.data.empty())
+    {
+        QFile file(job.filename);
+        qint64 fileSize = (!job.filename.isEmpty() && file.open(QIODevice::ReadOnly)) ? file.size() : 0;
+        if (fileSize > 0)
+        {
+            job.data.resize((size_t)fileSize);
+            if (file.read((char*)&job.data[0], fileSize) < fileSize)
+                job.data.clear();
+        }
+        if (job.data.empty())
+        {
+            job.error = "Could not read asset data from file \"" + job.filename + "\"";
+            return;
+        }
+    }
+
+    if (!job.asset)
+    {
+        job.success = true;
+        return;
+    }
+
+    try
+    {
+        job.decodeStartTime = GetCurrentClockTime();
+        job.decoded = job.asset->DecodeData(&job.data[0], job.data.size());
+        job.decodeEndTime = GetCurrentClockTime();
+    }
+    catch(const std::exception &e)
+    {
+        job.error = "Decoding threw an exception: " + QString(e.what());
+        return;
+    }
+
+    if (!job.decoded)
+    {
+        job.error = "Decoding the asset data failed";
+        return;
+    }
+
+    // The raw data is no longer needed, free it already on the worker thread.
+    std::vector<u8>().swap(job.data);
+    job.success = true;
+}
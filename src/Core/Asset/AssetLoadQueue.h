@@ -0,0 +1,82 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "AssetFwd.h"
+#include "HighPerfClock.h"
+
+#include <QString>
+
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <list>
+#include <vector>
+
+/// Reads asset data and runs the CPU-only decode step of assets on a pool of worker threads.
+/** There are two kinds of jobs. A read job reads the data of an asset transfer from a local file, after which AssetAPI completes the transfer.
+    A decode job is created for assets that return true from IAsset::SupportsThreadedDecode: the worker thread reads the asset data
+    from its disk source if the data is not already in memory, and calls IAsset::DecodeData. The finished jobs are taken on the main thread
+    by AssetAPI, which hands the decoded data to IAsset::LoadFromDecodedData.
+    @note The worker threads never release the last reference to an asset or a transfer, so they are always destroyed on the main thread. */
+class AssetLoadQueue
+{
+public:
+    /// A single asset read or decode job.
+    struct Job
+    {
+        /// Creates a decode job.
+        Job(const AssetPtr &asset_, u32 generation_) : asset(asset_), generation(generation_), success(false), decodeStartTime(0), decodeEndTime(0) {}
+        /// Creates a read job.
+        Job(const AssetTransferPtr &transfer_, const QString &filename_) : transfer(transfer_), filename(filename_), generation(0), success(false), decodeStartTime(0), decodeEndTime(0) {}
+
+        AssetPtr asset; ///< The asset being decoded. Null for a read job.
+        AssetTransferPtr transfer; ///< The transfer whose data is read. Null for a decode job.
+        QString filename; ///< If data is empty, the asset data is read from this file.
+        u32 generation; ///< Identifies the latest decode job of the asset, so that the results of superseded jobs are dropped. Zero for a read job.
+        std::vector<u8> data; ///< The raw asset data.
+        AssetDecodeDataPtr decoded; ///< The result of IAsset::DecodeData, filled by the worker thread.
+        bool success; ///< True if the data was read, and for a decode job, decoded successfully.
+        QString error; ///< Reason of the failure, if success is false.
+        tick_t decodeStartTime; ///< Clock time when the worker thread started decoding, zero for a read job.
+        tick_t decodeEndTime; ///< Clock time when the worker thread finished decoding, zero for a read job.
+    };
+    typedef boost::shared_ptr<Job> JobPtr;
+
+    /// Starts the worker threads.
+    explicit AssetLoadQueue(int numThreads);
+
+    /// Stops the worker threads. Jobs that have not been started are discarded.
+    ~AssetLoadQueue();
+
+    /// Adds a job to the end of the queue.
+    void Enqueue(const JobPtr &job);
+
+    /// Takes the oldest finished job from the queue.
+    /** @return False if there are no finished jobs. */
+    bool TakeFinished(JobPtr &job);
+
+    /// Returns the number of jobs that are queued or being processed.
+    size_t NumPendingJobs() const;
+
+    /// Returns the number of worker threads.
+    int NumThreads() const { return numThreads; }
+
+private:
+    /// Worker thread entry point.
+    void ThreadMain();
+
+    /// Reads, and for a decode job, decodes the data of a job.
+    static void Process(Job &job);
+
+    boost::thread_group threads;
+    mutable boost::mutex mutex;
+    boost::condition_variable jobAvailable;
+    std::list<JobPtr> pendingJobs;
+    std::list<JobPtr> finishedJobs;
+    size_t numRunningJobs;
+    int numThreads;
+    bool stopping;
+};
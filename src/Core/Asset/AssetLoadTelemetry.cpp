@@ -0,0 +1,313 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "DebugOperatorNew.h"
+
+#include "AssetLoadTelemetry.h"
+
+#include <algorithm>
+
+#include "MemoryLeakCheck.h"
+
+namespace
+{
+/// The stages each phase starts and ends at, in the order of AssetLoadTelemetry::Phase.
+const AssetLoadTelemetry::Stage cPhaseStart[AssetLoadTelemetry::NumPhases] =
+{
+    AssetLoadTelemetry::StageRequested, AssetLoadTelemetry::StageDownloaded, AssetLoadTelemetry::StageCacheWritten, AssetLoadTelemetry::StageDecodeStarted,
+    AssetLoadTelemetry::StageDecodeFinished, AssetLoadTelemetry::StageContentLoaded, AssetLoadTelemetry::StageRequested
+};
+const AssetLoadTelemetry::Stage cPhaseEnd[AssetLoadTelemetry::NumPhases] =
+{
+    AssetLoadTelemetry::StageDownloaded, AssetLoadTelemetry::StageCacheWritten, AssetLoadTelemetry::StageDecodeStarted, AssetLoadTelemetry::StageDecodeFinished,
+    AssetLoadTelemetry::StageContentLoaded, AssetLoadTelemetry::StageDependenciesReady, AssetLoadTelemetry::StageLoaded
+};
+
+/// Orders records by their total load time, slowest first.
+bool SlowerThan(const AssetLoadTelemetry::Record *a, const AssetLoadTelemetry::Record *b)
+{
+    return a->PhaseSeconds(AssetLoadTelemetry::PhaseTotal) > b->PhaseSeconds(AssetLoadTelemetry::PhaseTotal);
+}
+
+QString Msecs(double seconds)
+{
+    return QString::number(seconds * 1000.0, 'f', 1);
+}
+
+/// Returns the string as a quoted JSON string.
+QString JsonString(const QString &str)
+{
+    QString escaped = str;
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n").replace("\r", "\\r").replace("\t", "\\t");
+    return "\"" + escaped + "\"";
+}
+
+/// Returns the phase durations as a JSON object.
+QString PhasesToJson(const double (&seconds)[AssetLoadTelemetry::NumPhases])
+{
+    QString json = "{";
+    for(int i = 0; i < AssetLoadTelemetry::NumPhases; ++i)
+        json += (i > 0 ? ", " : "") + JsonString(AssetLoadTelemetry::PhaseName((AssetLoadTelemetry::Phase)i)) + ": " + QString::number(seconds[i], 'g', 6);
+    return json + "}";
+}
+
+QString RecordToJson(const AssetLoadTelemetry::Record &record)
+{
+    double seconds[AssetLoadTelemetry::NumPhases];
+    for(int i = 0; i < AssetLoadTelemetry::NumPhases; ++i)
+        seconds[i] = record.PhaseSeconds((AssetLoadTelemetry::Phase)i);
+    QStringList scenes;
+    foreach(const QString &scene, record.scenes)
+        scenes << JsonString(scene);
+    return "{\"ref\": " + JsonString(record.ref) + ", \"type\": " + JsonString(record.type) + ", \"provider\": " + JsonString(record.provider) +
+        ", \"failed\": " + (record.failed ? "true" : "false") + ", \"scenes\": [" + scenes.join(", ") + "], \"seconds\": " + PhasesToJson(seconds) + "}";
+}
+
+QString AggregatesToJson(const AssetLoadTelemetry::AggregateMap &aggregates)
+{
+    QString json = "{";
+    for(AssetLoadTelemetry::AggregateMap::const_iterator iter = aggregates.begin(); iter != aggregates.end(); ++iter)
+    {
+        const AssetLoadTelemetry::Aggregate &a = iter->second;
+        double meanSeconds[AssetLoadTelemetry::NumPhases];
+        for(int i = 0; i < AssetLoadTelemetry::NumPhases; ++i)
+            meanSeconds[i] = a.totalSeconds[i] / std::max(a.numAssets, 1);
+        json += (iter != aggregates.begin() ? ",\n    " : "\n    ") + JsonString(iter->first) + ": {\"assets\": " + QString::number(a.numAssets) +
+            ", \"failed\": " + QString::number(a.numFailed) + ", \"meanSeconds\": " + PhasesToJson(meanSeconds) + ", \"maxSeconds\": " + PhasesToJson(a.maxSeconds) + "}";
+    }
+    return json + (aggregates.empty() ? "}" : "\n  }");
+}
+
+QString AggregateToString(const QString &name, const AssetLoadTelemetry::Aggregate &a)
+{
+    const double n = std::max(a.numAssets, 1);
+    return QString("  %1: %2 assets (%3 failed), total mean %4 ms, max %5 ms | mean transfer %6, cache %7, queue %8, decode %9, upload %10, dependencies %11 ms")
+        .arg(name).arg(a.numAssets).arg(a.numFailed).arg(Msecs(a.totalSeconds[AssetLoadTelemetry::PhaseTotal] / n)).arg(Msecs(a.maxSeconds[AssetLoadTelemetry::PhaseTotal]))
+        .arg(Msecs(a.totalSeconds[AssetLoadTelemetry::PhaseTransfer] / n)).arg(Msecs(a.totalSeconds[AssetLoadTelemetry::PhaseCacheWrite] / n))
+        .arg(Msecs(a.totalSeconds[AssetLoadTelemetry::PhaseDecodeQueue] / n)).arg(Msecs(a.totalSeconds[AssetLoadTelemetry::PhaseDecode] / n))
+        .arg(Msecs(a.totalSeconds[AssetLoadTelemetry::PhaseUpload] / n)).arg(Msecs(a.totalSeconds[AssetLoadTelemetry::PhaseDependencyWait] / n));
+}
+
+QString RecordToString(const AssetLoadTelemetry::Record &r)
+{
+    return QString("  %1 ms %2 (%3, %4)%5 | transfer %6, cache %7, queue %8, decode %9, upload %10, dependencies %11 ms")
+        .arg(Msecs(r.PhaseSeconds(AssetLoadTelemetry::PhaseTotal))).arg(r.ref).arg(r.type).arg(r.provider).arg(r.failed ? " FAILED" : "")
+        .arg(Msecs(r.PhaseSeconds(AssetLoadTelemetry::PhaseTransfer))).arg(Msecs(r.PhaseSeconds(AssetLoadTelemetry::PhaseCacheWrite)))
+        .arg(Msecs(r.PhaseSeconds(AssetLoadTelemetry::PhaseDecodeQueue))).arg(Msecs(r.PhaseSeconds(AssetLoadTelemetry::PhaseDecode)))
+        .arg(Msecs(r.PhaseSeconds(AssetLoadTelemetry::PhaseUpload))).arg(Msecs(r.PhaseSeconds(AssetLoadTelemetry::PhaseDependencyWait)));
+}
+}
+
+double AssetLoadTelemetry::Record::PhaseSeconds(Phase phase) const
+{
+    if (phase < 0 || phase >= NumPhases)
+        return 0.0;
+
+    // A stage that was not reached is taken to be reached at the same time as the last stage before it.
+    tick_t effective[NumStages];
+    tick_t previous = stages[StageRequested];
+    for(int i = 0; i < NumStages; ++i)
+        effective[i] = previous = (stages[i] != 0 ? std::max(stages[i], previous) : previous);
+
+    const tick_t start = effective[cPhaseStart[phase]];
+    const tick_t end = effective[cPhaseEnd[phase]];
+    return end > start ? (double)(end - start) / (double)GetCurrentClockFreq() : 0.0;
+}
+
+void AssetLoadTelemetry::Aggregate::Add(const Record &record)
+{
+    ++numAssets;
+    if (record.failed)
+        ++numFailed;
+    for(int i = 0; i < NumPhases; ++i)
+    {
+        double seconds = record.PhaseSeconds((Phase)i);
+        totalSeconds[i] += seconds;
+        maxSeconds[i] = std::max(maxSeconds[i], seconds);
+    }
+}
+
+void AssetLoadTelemetry::BeginTransfer(const QString &ref, const QString &type, const QString &provider)
+{
+    Record &record = records[ref];
+    QStringList scenes = record.scenes; // The scenes still refer to the asset if it is transferred again.
+    record = Record();
+    record.ref = ref;
+    record.type = type;
+    record.provider = provider;
+    record.scenes = scenes;
+    record.stages[StageRequested] = GetCurrentClockTime();
+}
+
+void AssetLoadTelemetry::MarkStage(const QString &ref, Stage stage, tick_t time)
+{
+    RecordMap::iterator iter = records.find(ref);
+    if (iter == records.end() || iter->second.Finished() || stage < 0 || stage >= NumStages)
+        return;
+    if (iter->second.stages[stage] == 0)
+        iter->second.stages[stage] = (time != 0 ? time : GetCurrentClockTime());
+}
+
+void AssetLoadTelemetry::MarkFailed(const QString &ref)
+{
+    RecordMap::iterator iter = records.find(ref);
+    if (iter == records.end() || iter->second.Finished())
+        return;
+    // The loaded stage of a failed asset is the time of the failure.
+    iter->second.stages[StageLoaded] = GetCurrentClockTime();
+    iter->second.failed = true;
+}
+
+void AssetLoadTelemetry::AddScene(const QString &ref, const QString &sceneName)
+{
+    if (sceneName.isEmpty())
+        return;
+    RecordMap::iterator iter = records.find(ref);
+    if (iter != records.end() && !iter->second.scenes.contains(sceneName))
+        iter->second.scenes << sceneName;
+}
+
+const AssetLoadTelemetry::Record *AssetLoadTelemetry::Find(const QString &ref) const
+{
+    RecordMap::const_iterator iter = records.find(ref);
+    return iter != records.end() ? &iter->second : 0;
+}
+
+AssetLoadTelemetry::AggregateMap AssetLoadTelemetry::AggregateByType() const
+{
+    AggregateMap aggregates;
+    for(RecordMap::const_iterator iter = records.begin(); iter != records.end(); ++iter)
+        if (iter->second.Finished())
+            aggregates[iter->second.type].Add(iter->second);
+    return aggregates;
+}
+
+AssetLoadTelemetry::AggregateMap AssetLoadTelemetry::AggregateByProvider() const
+{
+    AggregateMap aggregates;
+    for(RecordMap::const_iterator iter = records.begin(); iter != records.end(); ++iter)
+        if (iter->second.Finished())
+            aggregates[iter->second.provider].Add(iter->second);
+    return aggregates;
+}
+
+QStringList AssetLoadTelemetry::Scenes() const
+{
+    QStringList scenes;
+    for(RecordMap::const_iterator iter = records.begin(); iter != records.end(); ++iter)
+        foreach(const QString &scene, iter->second.scenes)
+            if (!scenes.contains(scene))
+                scenes << scene;
+    scenes.sort();
+    return scenes;
+}
+
+std::vector<const AssetLoadTelemetry::Record *> AssetLoadTelemetry::WorstOffenders(const QString &sceneName, size_t count) const
+{
+    std::vector<const Record *> offenders;
+    for(RecordMap::const_iterator iter = records.begin(); iter != records.end(); ++iter)
+        if (iter->second.Finished() && (sceneName.isEmpty() || iter->second.scenes.contains(sceneName)))
+            offenders.push_back(&iter->second);
+    std::sort(offenders.begin(), offenders.end(), SlowerThan);
+    if (offenders.size() > count)
+        offenders.resize(count);
+    return offenders;
+}
+
+QStringList AssetLoadTelemetry::Summary(size_t numWorstOffenders) const
+{
+    QStringList lines;
+    size_t numFinished = 0;
+    for(RecordMap::const_iterator iter = records.begin(); iter != records.end(); ++iter)
+        if (iter->second.Finished())
+            ++numFinished;
+    lines << QString("Asset load telemetry: %1 assets finished, %2 loading.").arg(numFinished).arg(records.size() - numFinished);
+
+    lines << "By asset type:";
+    AggregateMap aggregates = AggregateByType();
+    for(AggregateMap::const_iterator iter = aggregates.begin(); iter != aggregates.end(); ++iter)
+        lines << AggregateToString(iter->first, iter->second);
+
+    lines << "By asset provider:";
+    aggregates = AggregateByProvider();
+    for(AggregateMap::const_iterator iter = aggregates.begin(); iter != aggregates.end(); ++iter)
+        lines << AggregateToString(iter->first, iter->second);
+
+    lines << "Slowest assets:";
+    std::vector<const Record *> offenders = WorstOffenders("", numWorstOffenders);
+    for(size_t i = 0; i < offenders.size(); ++i)
+        lines << RecordToString(*offenders[i]);
+
+    foreach(const QString &scene, Scenes())
+    {
+        lines << "Slowest assets of scene " + scene + ":";
+        offenders = WorstOffenders(scene, numWorstOffenders);
+        for(size_t i = 0; i < offenders.size(); ++i)
+            lines << RecordToString(*offenders[i]);
+    }
+    return lines;
+}
+
+QByteArray AssetLoadTelemetry::ToJson(size_t numWorstOffenders) const
+{
+    QString json = "{\n  \"byType\": " + AggregatesToJson(AggregateByType()) + ",\n  \"byProvider\": " + AggregatesToJson(AggregateByProvider()) + ",\n";
+
+    json += "  \"worstOffenders\": [";
+    std::vector<const Record *> offenders = WorstOffenders("", numWorstOffenders);
+    for(size_t i = 0; i < offenders.size(); ++i)
+        json += (i > 0 ? ",\n    " : "\n    ") + RecordToJson(*offenders[i]);
+    json += (offenders.empty() ? "],\n" : "\n  ],\n");
+
+    json += "  \"worstOffendersByScene\": {";
+    QStringList scenes = Scenes();
+    for(int s = 0; s < scenes.size(); ++s)
+    {
+        json += (s > 0 ? ",\n    " : "\n    ") + JsonString(scenes[s]) + ": [";
+        offenders = WorstOffenders(scenes[s], numWorstOffenders);
+        for(size_t i = 0; i < offenders.size(); ++i)
+            json += (i > 0 ? ",\n      " : "\n      ") + RecordToJson(*offenders[i]);
+        json += (offenders.empty() ? "]" : "\n    ]");
+    }
+    json += (scenes.empty() ? "},\n" : "\n  },\n");
+
+    json += "  \"assets\": [";
+    bool first = true;
+    for(RecordMap::const_iterator iter = records.begin(); iter != records.end(); ++iter)
+        if (iter->second.Finished())
+        {
+            json += (first ? "\n    " : ",\n    ") + RecordToJson(iter->second);
+            first = false;
+        }
+    json += (first ? "]\n}\n" : "\n  ]\n}\n");
+    return json.toUtf8();
+}
+
+QString AssetLoadTelemetry::StageName(Stage stage)
+{
+    switch(stage)
+    {
+    case StageRequested: return "requested";
+    case StageDownloaded: return "downloaded";
+    case StageCacheWritten: return "cacheWritten";
+    case StageDecodeStarted: return "decodeStarted";
+    case StageDecodeFinished: return "decodeFinished";
+    case StageContentLoaded: return "contentLoaded";
+    case StageDependenciesReady: return "dependenciesReady";
+    case StageLoaded: return "loaded";
+    default: return "";
+    }
+}
+
+QString AssetLoadTelemetry::PhaseName(Phase phase)
+{
+    switch(phase)
+    {
+    case PhaseTransfer: return "transfer";
+    case PhaseCacheWrite: return "cacheWrite";
+    case PhaseDecodeQueue: return "decodeQueue";
+    case PhaseDecode: return "decode";
+    case PhaseUpload: return "upload";
+    case PhaseDependencyWait: return "dependencyWait";
+    case PhaseTotal: return "total";
+    default: return "";
+    }
+}
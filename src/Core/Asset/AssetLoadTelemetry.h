@@ -0,0 +1,137 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "CoreStringUtils.h"
+#include "HighPerfClock.h"
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+#include <map>
+#include <vector>
+
+/// Records when each asset transfer reaches each stage of the asset load pipeline, and aggregates the results.
+/** AssetAPI timestamps the stages of every transfer that goes to an asset provider. The time between two consecutive stages is a phase,
+    f.ex. the transfer phase is the time from the request until all the bytes of the asset have been received.
+    A stage an asset skips, f.ex. the cache write of a local asset, takes no time, and the time is counted in the next phase.
+    The aggregates only include the assets that have finished loading or failed.
+
+    The scenes that refer to each asset are recorded as well, so that the slowest assets of each scene can be listed. */
+class AssetLoadTelemetry
+{
+public:
+    /// The stages of loading an asset, in the order they are reached.
+    enum Stage
+    {
+        StageRequested = 0, ///< The asset was requested from its provider.
+        StageDownloaded, ///< All the bytes of the asset have been received.
+        StageCacheWritten, ///< The asset data was written to the asset cache.
+        StageDecodeStarted, ///< Decoding the asset data started.
+        StageDecodeFinished, ///< Decoding the asset data finished. For assets that are not decoded on the asset load threads, this includes creating the GPU resources.
+        StageContentLoaded, ///< The asset itself has been loaded, including its GPU resources.
+        StageDependenciesReady, ///< All the dependencies of the asset have been loaded.
+        StageLoaded, ///< The transfer has completed and its listeners have been signaled.
+        NumStages
+    };
+
+    /// The time between two stages.
+    enum Phase
+    {
+        PhaseTransfer = 0, ///< From the request to receiving all the bytes, i.e. network or disk time.
+        PhaseCacheWrite, ///< Writing the asset to the asset cache.
+        PhaseDecodeQueue, ///< Waiting for an asset load thread, or for the main thread.
+        PhaseDecode, ///< Decoding the asset data.
+        PhaseUpload, ///< Creating the asset from the decoded data, f.ex. uploading a texture to the GPU.
+        PhaseDependencyWait, ///< Waiting for the dependencies of the asset to load.
+        PhaseTotal, ///< From the request until the transfer has completed.
+        NumPhases
+    };
+
+    /// The timestamps of loading a single asset.
+    struct Record
+    {
+        Record() : failed(false) { for(int i = 0; i < NumStages; ++i) stages[i] = 0; }
+
+        QString ref;
+        QString type;
+        QString provider;
+        tick_t stages[NumStages]; ///< Clock time when each stage was reached, zero if not reached.
+        bool failed; ///< True if the transfer or loading the asset failed.
+        QStringList scenes; ///< Names of the scenes that refer to the asset.
+
+        /// Returns true if the asset has finished loading or has failed.
+        bool Finished() const { return failed || stages[StageLoaded] != 0; }
+
+        /// Returns the duration of a phase in seconds.
+        double PhaseSeconds(Phase phase) const;
+    };
+
+    /// Aggregated phase durations of a group of assets.
+    struct Aggregate
+    {
+        Aggregate() : numAssets(0), numFailed(0) { for(int i = 0; i < NumPhases; ++i) totalSeconds[i] = maxSeconds[i] = 0.0; }
+
+        int numAssets; ///< Number of finished assets in the group, including the failed ones.
+        int numFailed;
+        double totalSeconds[NumPhases];
+        double maxSeconds[NumPhases];
+
+        /// Adds a finished record to the aggregate.
+        void Add(const Record &record);
+    };
+    typedef std::map<QString, Aggregate> AggregateMap;
+
+    /// Starts a new record for the asset, replacing any earlier record of it, and marks it requested now.
+    void BeginTransfer(const QString &ref, const QString &type, const QString &provider);
+
+    /// Marks the asset to have reached the stage at the given clock time, or now if time is zero.
+    /** Does nothing if the asset has no record, i.e. it is not being transferred, or if the record is already finished. */
+    void MarkStage(const QString &ref, Stage stage, tick_t time = 0);
+
+    /// Marks the transfer of the asset failed.
+    void MarkFailed(const QString &ref);
+
+    /// Records that the scene refers to the asset.
+    void AddScene(const QString &ref, const QString &sceneName);
+
+    /// Removes all records.
+    void Clear() { records.clear(); }
+
+    /// Returns the record of an asset, or null if the asset has no record.
+    const Record *Find(const QString &ref) const;
+
+    /// Returns the number of records, including the assets that are still loading.
+    size_t NumRecords() const { return records.size(); }
+
+    /// Aggregates the finished assets by asset type.
+    AggregateMap AggregateByType() const;
+
+    /// Aggregates the finished assets by the name of the asset provider they were requested from.
+    AggregateMap AggregateByProvider() const;
+
+    /// Returns the names of all the scenes that refer to the recorded assets.
+    QStringList Scenes() const;
+
+    /// Returns the finished assets of a scene that took the longest to load, slowest first.
+    /** @param sceneName The scene, or an empty string for all the assets. */
+    std::vector<const Record *> WorstOffenders(const QString &sceneName, size_t count) const;
+
+    /// Returns the aggregates, and the worst offenders overall and of each scene, as human-readable lines.
+    QStringList Summary(size_t numWorstOffenders) const;
+
+    /// Returns the aggregates, the worst offenders of each scene, and the records of all finished assets as JSON.
+    QByteArray ToJson(size_t numWorstOffenders) const;
+
+    /// Returns the name of a stage, f.ex. "decodeStarted".
+    static QString StageName(Stage stage);
+
+    /// Returns the name of a phase, f.ex. "dependencyWait".
+    static QString PhaseName(Phase phase);
+
+private:
+    typedef std::map<QString, Record, QStringLessThanNoCase> RecordMap;
+    RecordMap records;
+};
@@ -0,0 +1,181 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "DebugOperatorNew.h"
+
+#include "AssetPrefetchManifest.h"
+#include "AssetAPI.h"
+#include "IAsset.h"
+#include "IAssetTransfer.h"
+#include "NullAssetFactory.h"
+#include "LoggingFunctions.h"
+
+#include <QFile>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
+
+#include "MemoryLeakCheck.h"
+
+namespace
+{
+/// Orders manifest entries by distance, and entries at the same distance by ref, so that the order is stable between runs.
+bool EntryLessThan(const AssetPrefetchManifest::Entry &a, const AssetPrefetchManifest::Entry &b)
+{
+    if (a.distance != b.distance)
+        return a.distance < b.distance;
+    return a.ref < b.ref;
+}
+}
+
+void AssetPrefetchManifest::Add(const QString &ref, const QString &type, qint64 size, float distance)
+{
+    if (ref.trimmed().isEmpty())
+        return;
+
+    std::map<QString, size_t>::iterator iter = assetIndices.find(ref);
+    if (iter != assetIndices.end())
+    {
+        Entry &entry = assets[iter->second];
+        entry.distance = std::min(entry.distance, distance);
+        if (entry.size < 0)
+            entry.size = size;
+        if (entry.type.isEmpty())
+            entry.type = type;
+        return;
+    }
+
+    Entry entry;
+    entry.ref = ref;
+    entry.type = type;
+    entry.size = size;
+    entry.distance = distance;
+    assetIndices[ref] = assets.size();
+    assets.push_back(entry);
+}
+
+void AssetPrefetchManifest::Sort()
+{
+    std::stable_sort(assets.begin(), assets.end(), EntryLessThan);
+    for(size_t i = 0; i < assets.size(); ++i)
+        assetIndices[assets[i].ref] = i;
+}
+
+qint64 AssetPrefetchManifest::TotalSize() const
+{
+    qint64 totalSize = 0;
+    for(size_t i = 0; i < assets.size(); ++i)
+        if (assets[i].size > 0)
+            totalSize += assets[i].size;
+    return totalSize;
+}
+
+QByteArray AssetPrefetchManifest::Serialize() const
+{
+    QByteArray data;
+    QXmlStreamWriter writer(&data);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement("prefetchmanifest");
+    writer.writeAttribute("version", "1");
+    if (!sceneName.isEmpty())
+        writer.writeAttribute("scene", sceneName);
+    for(size_t i = 0; i < assets.size(); ++i)
+    {
+        const Entry &entry = assets[i];
+        writer.writeStartElement("asset");
+        writer.writeAttribute("ref", entry.ref);
+        if (!entry.type.isEmpty())
+            writer.writeAttribute("type", entry.type);
+        if (entry.size >= 0)
+            writer.writeAttribute("size", QString::number(entry.size));
+        writer.writeAttribute("distance", QString::number(entry.distance));
+        writer.writeEndElement();
+    }
+    writer.writeEndElement();
+    writer.writeEndDocument();
+    return data;
+}
+
+bool AssetPrefetchManifest::Deserialize(const QByteArray &data)
+{
+    assets.clear();
+    assetIndices.clear();
+    sceneName.clear();
+
+    QXmlStreamReader reader(data);
+    if (!reader.readNextStartElement() || reader.name() != "prefetchmanifest")
+    {
+        LogError("AssetPrefetchManifest: Data is not an asset prefetch manifest.");
+        return false;
+    }
+    sceneName = reader.attributes().value("scene").toString();
+
+    while(reader.readNextStartElement())
+    {
+        if (reader.name() == "asset")
+        {
+            QXmlStreamAttributes attributes = reader.attributes();
+            bool ok = false;
+            qint64 size = attributes.value("size").toString().toLongLong(&ok);
+            Add(attributes.value("ref").toString(), attributes.value("type").toString(), ok ? size : -1,
+                attributes.value("distance").toString().toFloat());
+        }
+        reader.skipCurrentElement();
+    }
+
+    if (reader.hasError())
+    {
+        LogError(QString("AssetPrefetchManifest: Parsing failed: %1 at line %2.").arg(reader.errorString()).arg(reader.lineNumber()));
+        return false;
+    }
+    return true;
+}
+
+bool AssetPrefetchManifest::SaveToFile(const QString &filename) const
+{
+    QByteArray data = Serialize();
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(data) != data.size())
+    {
+        LogError("AssetPrefetchManifest: Could not write to " + filename);
+        return false;
+    }
+    return true;
+}
+
+bool AssetPrefetchManifest::LoadFromFile(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        LogError("AssetPrefetchManifest: Could not open " + filename);
+        return false;
+    }
+    return Deserialize(file.readAll());
+}
+
+int AssetPrefetchManifest::Prefetch(AssetAPI *assetApi) const
+{
+    int numRequested = 0;
+    for(size_t i = 0; i < assets.size(); ++i)
+    {
+        const Entry &entry = assets[i];
+        AssetPtr existing = assetApi->GetAsset(entry.ref);
+        if (existing && existing->IsLoaded())
+            continue;
+
+        // Don't spend bandwidth on assets that would not be loaded, f.ex. textures in headless mode.
+        QString type = entry.type.isEmpty() ? AssetAPI::GetResourceTypeFromAssetRef(entry.ref) : entry.type;
+        AssetTypeFactoryPtr factory = assetApi->GetAssetTypeFactory(type);
+        if (!factory || dynamic_cast<NullAssetFactory*>(factory.get()))
+            continue;
+
+        AssetTransferPtr transfer = assetApi->RequestAsset(entry.ref, type);
+        if (!transfer)
+            continue;
+        transfer->SetPriority(-entry.distance);
+        ++numRequested;
+    }
+    return numRequested;
+}
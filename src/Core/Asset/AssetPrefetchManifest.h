@@ -0,0 +1,84 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "AssetFwd.h"
+
+#include <QString>
+#include <QByteArray>
+
+#include <map>
+#include <vector>
+
+/// Lists the assets a scene refers to, in the order they should be prefetched.
+/** A manifest is generated offline from a scene file with Scene::CreatePrefetchManifest, or recorded from a running scene.
+    The client can prefetch the assets as soon as it has connected to the server, in parallel with the initial scene sync,
+    instead of discovering them only when the entities that refer to them arrive.
+
+    The assets are ordered by their distance to the scene origin, so that the assets closest to where the users typically
+    enter the scene are requested first. Assets that are not attached to any position, f.ex. scripts, have a distance of zero.
+
+    The manifest is stored as XML:
+    @code
+    <prefetchmanifest version="1" scene="scene.txml">
+     <asset ref="local://house.mesh" type="OgreMesh" size="123456" distance="12.5"/>
+    </prefetchmanifest>
+    @endcode */
+class AssetPrefetchManifest
+{
+public:
+    /// A single asset in the manifest.
+    struct Entry
+    {
+        Entry() : size(-1), distance(0.f) {}
+
+        QString ref; ///< The asset ref, as it appears in the scene.
+        QString type; ///< The asset type.
+        qint64 size; ///< Size of the asset data in bytes, or -1 if not known.
+        float distance; ///< Distance of the closest entity referring to the asset from the scene origin.
+    };
+
+    /// Adds an asset to the manifest. If the asset is already in the manifest, the smaller distance and the known size are kept.
+    void Add(const QString &ref, const QString &type, qint64 size, float distance);
+
+    /// Sorts the assets by distance, closest first.
+    void Sort();
+
+    /// Returns the assets in prefetch order.
+    const std::vector<Entry> &Assets() const { return assets; }
+
+    /// Returns the number of assets in the manifest.
+    size_t NumAssets() const { return assets.size(); }
+
+    /// Returns the sum of the known asset sizes in bytes.
+    qint64 TotalSize() const;
+
+    /// Name of the scene the manifest was created from.
+    QString SceneName() const { return sceneName; }
+    void SetSceneName(const QString &name) { sceneName = name; }
+
+    /// Returns the manifest as XML.
+    QByteArray Serialize() const;
+
+    /// Reads the manifest from XML, replacing the current contents.
+    /** @return False if the data is not a valid manifest. */
+    bool Deserialize(const QByteArray &data);
+
+    /// Saves the manifest to a file.
+    bool SaveToFile(const QString &filename) const;
+
+    /// Loads the manifest from a file.
+    bool LoadFromFile(const QString &filename);
+
+    /// Requests each asset in the manifest that has not been loaded yet.
+    /** The transfers are given a priority of the negated distance. Assets of types that are not loaded in this instance are skipped.
+        @return The number of assets requested. */
+    int Prefetch(AssetAPI *assetApi) const;
+
+private:
+    std::vector<Entry> assets;
+    /// Maps asset refs to their index in assets.
+    std::map<QString, size_t> assetIndices;
+    QString sceneName;
+};
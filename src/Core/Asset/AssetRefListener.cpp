@@ -6,14 +6,28 @@
 #include "IAttribute.h"
 #include "AssetReference.h"
 #include "IComponent.h"
+#include "Scene.h"
 #include "Framework.h"
 #include "AssetAPI.h"
 #include "IAsset.h"
 #include "IAssetTransfer.h"
+#include "AssetLoadTelemetry.h"
 #include "LoggingFunctions.h"
 
 #include "MemoryLeakCheck.h"
 
+AssetRefListener::~AssetRefListener()
+{
+    ReleaseAssetReference();
+}
+
+void AssetRefListener::ReleaseAssetReference()
+{
+    if (!referencedAsset.isEmpty() && myAssetAPI)
+        myAssetAPI->RemoveAssetReference(referencedAsset);
+    referencedAsset.clear();
+}
+
 AssetPtr AssetRefListener::Asset() const
 {
     return asset.lock();
@@ -28,7 +42,14 @@ void AssetRefListener::HandleAssetRefChange(IAttribute *assetRef, const QString&
             (assetRef == 0 ? "null" : assetRef->TypeName()) + " instead).");
         return;
     }
-    HandleAssetRefChange(attr->Owner()->GetFramework()->Asset(), attr->Get().ref, assetType);
+    AssetAPI *assetApi = attr->Owner()->GetFramework()->Asset();
+    HandleAssetRefChange(assetApi, attr->Get().ref, assetType);
+
+    // Record the scene of the component for the load telemetry, so that the slowest assets of each scene can be listed.
+    AssetTransferPtr transfer = currentTransfer.lock();
+    Scene *scene = attr->Owner()->ParentScene();
+    if (transfer && scene)
+        assetApi->LoadTelemetry()->AddScene(transfer->source.ref, scene->Name());
 }
 
 void AssetRefListener::HandleAssetRefChange(AssetAPI *assetApi, QString assetRef, const QString& assetType)
@@ -74,6 +95,7 @@ void AssetRefListener::HandleAssetRefChange(AssetAPI *assetApi, QString assetRef
     if (assetData)
         disconnect(assetData.get(), SIGNAL(Loaded(AssetPtr)), this, SIGNAL(Loaded(AssetPtr)));
     asset = AssetPtr();
+    ReleaseAssetReference();
 }
 
 void AssetRefListener::OnTransferSucceeded(AssetPtr assetData)
@@ -83,6 +105,15 @@ void AssetRefListener::OnTransferSucceeded(AssetPtr assetData)
         return;
     
     asset = assetData;
+    if (referencedAsset != assetData->Name())
+    {
+        ReleaseAssetReference();
+        if (myAssetAPI)
+        {
+            referencedAsset = assetData->Name();
+            myAssetAPI->AddAssetReference(referencedAsset);
+        }
+    }
     
     // Connect to further reloads of the asset to be able to notify of them.
     connect(assetData.get(), SIGNAL(Loaded(AssetPtr)), this, SLOT(OnAssetLoaded(AssetPtr)), Qt::UniqueConnection);
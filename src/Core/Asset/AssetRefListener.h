@@ -3,6 +3,7 @@
 #pragma once
 
 #include <QObject>
+#include <QPointer>
 #include "AssetFwd.h"
 #include "AssetReference.h"
 
@@ -16,6 +17,9 @@ class AssetRefListener : public QObject
 public:
     AssetRefListener() : myAssetAPI(0), requestedRef(""), /** \todo This needs to be removed. */ inspectCreated(false) {};
 
+    /// Releases the reference to the current asset, so that it can be unloaded when the asset memory budget is exceeded.
+    ~AssetRefListener();
+
     /// Issues a new asset request to the given AssetReference.
     /// @param assetRef A pointer to an attribute of type AssetReference.
     /// @param assetType Optional asset type name
@@ -46,8 +50,13 @@ private slots:
     void OnAssetCreated(AssetPtr asset);
 
 private:
-    AssetAPI *myAssetAPI;
+    /// Tells AssetAPI that this listener no longer refers to the current asset.
+    void ReleaseAssetReference();
+
+    QPointer<AssetAPI> myAssetAPI;
     AssetWeakPtr asset;
+    /// Name of the asset this listener has told AssetAPI it refers to, empty if none.
+    QString referencedAsset;
     AssetTransferWeakPtr currentTransfer;
     AssetReference requestedRef;
 
@@ -52,6 +52,11 @@ public:
         return data.size() > 0;
     }
 
+    virtual size_t CpuMemoryUsage() const
+    {
+        return data.size();
+    }
+
     std::vector<u8> data;
 };
 
@@ -179,10 +179,7 @@ bool IAsset::LoadFromFileInMemory(const u8 *data, size_t numBytes, bool allowAsy
 
 void IAsset::DependencyLoaded(AssetPtr dependee)
 {
-    // If we are loaded, and this was the last dependency, emit Loaded().
-    // No need to have exact duplicate code here even if LoadCompleted is not the most 
-    // informative name in the world for the situation.
-    LoadCompleted();
+    // Loaded() is emitted by AssetAPI when the last dependency has loaded.
 }
 
 void IAsset::LoadCompleted()
@@ -10,6 +10,14 @@
 #include "AssetFwd.h"
 #include "AssetReference.h"
 
+/// Base class for the CPU-side data an asset type produces when its data is decoded on a worker thread.
+/** @see IAsset::SupportsThreadedDecode, IAsset::DecodeData and IAsset::LoadFromDecodedData. */
+class IAssetDecodeData
+{
+public:
+    virtual ~IAssetDecodeData() {}
+};
+
 /// Base class for all assets loaded in the system.
 class IAsset : public QObject, public boost::enable_shared_from_this<IAsset>
 {
@@ -143,12 +151,42 @@ public:
     /// This should be set to false if you are expecting the asset to be loaded when this function returns like in LoadFromFile and LoadFromCache.
     bool LoadFromFileInMemory(const u8 *data, size_t numBytes, bool allowAsynchronous = true);
 
-    /// Called when this asset is loaded by AssetAPI::AssetLoadCompleted and DependencyLoaded functions.
+    /// Returns true if a loaded instance of this asset can be shared by all refs that have identical content.
+    /** This is used with a content-addressed asset cache. Only asset types whose content does not refer to other assets by relative
+        refs, and which are not modified per ref, should return true. The default implementation returns false. */
+    virtual bool IsContentShareable() const { return false; }
+
+    /// Returns an estimate of the main memory in bytes this asset uses while it is loaded.
+    /** AssetAPI uses the estimates to keep the loaded assets within the asset memory budget. The default implementation returns zero,
+        in which case AssetAPI uses the size of the data the asset was loaded from as the estimate. */
+    virtual size_t CpuMemoryUsage() const { return 0; }
+
+    /// Returns an estimate of the GPU memory in bytes this asset uses while it is loaded. The default implementation returns zero.
+    virtual size_t GpuMemoryUsage() const { return 0; }
+
+    /// Returns true if this asset type can decode its data on a worker thread with DecodeData.
+    /// If true, AssetAPI reads and decodes the data of completed transfers on its asset load threads, and only calls LoadFromDecodedData on the main thread.
+    /// The default implementation returns false.
+    virtual bool SupportsThreadedDecode() const { return false; }
+
+    /// Decodes the given asset data into a CPU-side representation. Called on a worker thread.
+    /// The implementation must only do CPU work: it must not modify this asset, emit signals, or call AssetAPI or the renderer.
+    /// @param data A pointer to the data to be decoded, never null.
+    /// @param numBytes The size of the data, always greater than zero.
+    /// @return The decoded data, or a null pointer if decoding failed. The default implementation returns a null pointer.
+    virtual AssetDecodeDataPtr DecodeData(const u8 *data, size_t numBytes) const { return AssetDecodeDataPtr(); }
+
+    /// Loads this asset from data returned by DecodeData. Called on the main thread.
+    /// Like DeserializeFromData, the implementation has to call AssetAPI::AssetLoadCompleted after loading succesfully.
+    /// AssetAPI::AssetLoadFailed will be called automatically if false is returned. The default implementation returns false.
+    virtual bool LoadFromDecodedData(const AssetDecodeDataPtr &decoded) { return false; }
+
+    /// Called by AssetAPI when this asset and all of its dependencies have been loaded, or when it is reloaded after that.
     /// Emits Loaded() signal if all the dependencies have been loaded, otherwise does nothing.
     void LoadCompleted();
 
-    /// Called whenever another asset this asset depends on is loaded. The default implementation will check if the asset itself is loaded, and the
-    /// number of dependencies: if it was the last dependency, Loaded() will be emitted.
+    /// Called whenever another asset this asset depends on is loaded. The default implementation does nothing.
+    /// Loaded() is emitted by AssetAPI after this, when the asset is loaded and it was the last dependency.
     virtual void DependencyLoaded(AssetPtr dependee);
 
     /// Returns all the assets this asset refers to (but not the references those assets refer to).
@@ -35,6 +35,16 @@ public:
     /** Override this function in a provider implementation if it supports aborting. */
     virtual bool AbortTransfer(IAssetTransfer *transfer) { return false; }
 
+    /// Requests the asset of an ongoing transfer again from its source, f.ex. when the cached copy the transfer was completed with could not be loaded.
+    /** The transfer is then completed again with AssetAPI::AssetTransferCompleted or AssetAPI::AssetTransferFailed.
+        Override this function in a provider implementation if it completes transfers from the asset cache.
+        @return True if the asset was requested again. */
+    virtual bool RetryTransfer(const AssetTransferPtr &transfer) { return false; }
+
+    /// Changes the download priority of a transfer that has not been started yet. Higher priorities are downloaded first.
+    /** Override this function in a provider implementation if it queues its transfers. */
+    virtual void SetTransferPriority(IAssetTransfer *transfer, float priority) {}
+
     /// Performs time-based update of asset provider, to for example handle timeouts.
     /** The system will call this periodically for all registered asset providers, so
         it does not need to be called manually.
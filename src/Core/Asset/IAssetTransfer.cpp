@@ -9,7 +9,8 @@
 
 IAssetTransfer::IAssetTransfer() : 
     cachingAllowed(true),
-    diskSourceType(IAsset::Original)
+    diskSourceType(IAsset::Original),
+    priority(0.f)
 {
 }
 
@@ -44,6 +45,14 @@ bool IAssetTransfer::Abort()
     }
 }
 
+void IAssetTransfer::SetPriority(float priority_)
+{
+    priority = priority_;
+    AssetProviderPtr assetProvider = provider.lock();
+    if (assetProvider)
+        assetProvider->SetTransferPriority(this, priority);
+}
+
 void IAssetTransfer::SetCachingBehavior(bool cachingAllowed, QString diskSource)
 {
     this->cachingAllowed = cachingAllowed; 
@@ -72,6 +72,13 @@ public slots:
         this field has no effect, as diskSource will be created to be a filename in the asset cache. */
     void SetCachingBehavior(bool cachingAllowed, QString diskSource);
 
+    /// Sets the download priority of this transfer. Higher priorities are downloaded first, f.ex. use the negated distance to the camera.
+    /** Has an effect only if the transfer is still queued by a provider that supports priorities. The default priority is 0. */
+    void SetPriority(float priority);
+
+    /// Returns the download priority of this transfer.
+    float Priority() const { return priority; }
+
     /// Returns the disk source of this transfer.
     QString DiskSource() const;
 
@@ -111,6 +118,7 @@ signals:
 private:
     QString diskSource;
     bool cachingAllowed;
+    float priority;
     
 };
 
@@ -0,0 +1,61 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "DebugOperatorNew.h"
+
+#include "AssetBundle.h"
+#include "Framework.h"
+#include "LoggingFunctions.h"
+
+#include <vector>
+
+#include "MemoryLeakCheck.h"
+
+/// Builds an asset bundle from a directory, or lists the contents of a bundle.
+/** Command line options, in addition to the Framework options:
+    --input    Directory whose files, including the files in its subdirectories, are bundled.
+    --output   The bundle file to write, f.ex. assets.tbundle.
+    --compress Compresses the files that shrink noticeably.
+    --list     Lists the contents of the given bundle file instead of building one. */
+int main(int argc, char **argv)
+{
+    std::vector<char *> args(argv, argv + argc);
+    char headless[] = "--headless";
+    args.push_back(headless);
+    int numArgs = (int)args.size();
+
+    int returnValue = EXIT_SUCCESS;
+    Framework *fw = new Framework(numArgs, &args[0]);
+    if (!fw->IsExiting())
+    {
+        QStringList listParam = fw->CommandLineParameters("--list");
+        QStringList inputParam = fw->CommandLineParameters("--input");
+        QStringList outputParam = fw->CommandLineParameters("--output");
+        if (listParam.size() > 0)
+        {
+            AssetBundle bundle;
+            if (bundle.Open(listParam.last()))
+            {
+                const std::vector<AssetBundle::Entry> &entries = bundle.Entries();
+                for(size_t i = 0; i < entries.size(); ++i)
+                    LogInfo(QString("%1 %2 bytes, stored %3 bytes%4").arg(entries[i].name).arg(entries[i].size).arg(entries[i].storedSize)
+                        .arg(entries[i].compression == AssetBundle::CompressionZlib ? ", compressed" : ""));
+                LogInfo(QString("AssetBundleTool: %1 contains %2 files.").arg(bundle.Filename()).arg(entries.size()));
+            }
+            else
+                returnValue = EXIT_FAILURE;
+        }
+        else if (inputParam.size() > 0 && outputParam.size() > 0)
+        {
+            if (!AssetBundle::Build(inputParam.last(), outputParam.last(), fw->HasCommandLineParameter("--compress")))
+                returnValue = EXIT_FAILURE;
+        }
+        else
+        {
+            LogError("Usage: AssetBundleTool --input <directory> --output <file.tbundle> [--compress], or AssetBundleTool --list <file.tbundle>");
+            returnValue = EXIT_FAILURE;
+        }
+    }
+    delete fw;
+
+    return returnValue;
+}
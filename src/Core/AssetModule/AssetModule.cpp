@@ -4,12 +4,17 @@
 #include "DebugOperatorNew.h"
 #include "AssetModule.h"
 #include "LocalAssetProvider.h"
+#include "BundleAssetProvider.h"
+#include "BundleAssetStorage.h"
 #include "HttpAssetProvider.h"
 #include "HttpAssetStorage.h"
 #include "Framework.h"
 #include "Profiler.h"
 #include "CoreException.h"
 #include "AssetAPI.h"
+#include "AssetPrefetchManifest.h"
+#include "AssetLoadTelemetry.h"
+#include "IAssetTransfer.h"
 #include "LocalAssetStorage.h"
 #include "ConsoleAPI.h"
 #include "Application.h"
@@ -28,9 +33,13 @@
 #include <kNet/MessageConnection.h>
 
 #include <QDir>
+#include <QFile>
 
 #include "MemoryLeakCheck.h"
 
+/// Number of the slowest assets listed by the asset load telemetry commands, overall and for each scene.
+static const size_t cNumWorstOffenders = 10;
+
 AssetModule::AssetModule()
 :IModule("Asset")
 {
@@ -45,6 +54,10 @@ void AssetModule::Initialize()
     boost::shared_ptr<HttpAssetProvider> http = boost::shared_ptr<HttpAssetProvider>(new HttpAssetProvider(framework_));
     framework_->Asset()->RegisterAssetProvider(boost::dynamic_pointer_cast<IAssetProvider>(http));
     
+    // The bundle provider is registered before the local provider, so that local refs to assets in bundles are served from the bundles.
+    boost::shared_ptr<BundleAssetProvider> bundle = boost::shared_ptr<BundleAssetProvider>(new BundleAssetProvider(framework_));
+    framework_->Asset()->RegisterAssetProvider(boost::dynamic_pointer_cast<IAssetProvider>(bundle));
+
     boost::shared_ptr<LocalAssetProvider> local = boost::shared_ptr<LocalAssetProvider>(new LocalAssetProvider(framework_));
     framework_->Asset()->RegisterAssetProvider(boost::dynamic_pointer_cast<IAssetProvider>(local));
     
@@ -86,6 +99,30 @@ void AssetModule::Initialize()
     framework_->Console()->RegisterCommand(
         "DumpAssets", "Lists all assets known to the Asset API", 
         this, SLOT(ConsoleDumpAssets()));
+
+    framework_->Console()->RegisterCommand(
+        "PrefetchAssets", "Requests all assets listed in an asset prefetch manifest. Usage: PrefetchAssets(manifest file or assetref)",
+        this, SLOT(PrefetchAssets(const QString &)));
+
+    framework_->Console()->RegisterCommand(
+        "AssetMemoryUsage", "Prints the estimated memory usage of the loaded assets and the asset memory budget",
+        this, SLOT(ConsoleAssetMemoryUsage()));
+
+    framework_->Console()->RegisterCommand(
+        "UnloadUnusedAssets", "Unloads all assets that are not in use. They are reloaded from their disk source when requested again.",
+        this, SLOT(ConsoleUnloadUnusedAssets()));
+
+    framework_->Console()->RegisterCommand(
+        "AssetLoadTelemetry", "Prints the load pipeline timings of the transferred assets by asset type and provider, and the slowest assets of each scene",
+        this, SLOT(ConsoleAssetLoadTelemetry()));
+
+    framework_->Console()->RegisterCommand(
+        "ExportAssetLoadTelemetry", "Writes the asset load pipeline timings to a JSON file. Usage: ExportAssetLoadTelemetry(filename)",
+        this, SLOT(ExportAssetLoadTelemetry(const QString &)));
+
+    framework_->Console()->RegisterCommand(
+        "ResetAssetLoadTelemetry", "Forgets the recorded asset load pipeline timings",
+        this, SLOT(ConsoleResetAssetLoadTelemetry()));
     
     ProcessCommandLineOptions();
 
@@ -98,14 +135,24 @@ void AssetModule::Initialize()
     connect(client, SIGNAL(Disconnected()), this, SLOT(ClientDisconnectedFromServer()));
 
     KristalliProtocolModule *kristalli = framework_->GetModule<KristalliProtocolModule>();
-    connect(kristalli, SIGNAL(NetworkMessageReceived(kNet::MessageConnection *, kNet::packet_id_t, kNet::message_id_t, const char *, size_t)), 
-        this, SLOT(HandleKristalliMessage(kNet::MessageConnection*, kNet::packet_id_t, kNet::message_id_t, const char*, size_t)), Qt::UniqueConnection);
+    kristalli->RegisterMessageHandler<MsgAssetDiscovery>(boost::bind(&AssetModule::HandleAssetDiscovery, this, _1, _2));
+    kristalli->RegisterMessageHandler<MsgAssetDeleted>(boost::bind(&AssetModule::HandleAssetDeleted, this, _1, _2));
 
     // Connect to asset uploads & deletions from storage to be able to broadcast asset discovery & deletion messages
     connect(framework_->Asset(), SIGNAL(AssetUploaded(const QString &)), this, SLOT(OnAssetUploaded(const QString &)));
     connect(framework_->Asset(), SIGNAL(AssetDeletedFromStorage(const QString&)), this, SLOT(OnAssetDeleted(const QString&)));
 }
 
+void AssetModule::Uninitialize()
+{
+    KristalliProtocolModule *kristalli = framework_->GetModule<KristalliProtocolModule>();
+    if (kristalli)
+    {
+        kristalli->UnregisterMessageHandler(MsgAssetDiscovery::messageID);
+        kristalli->UnregisterMessageHandler(MsgAssetDeleted::messageID);
+    }
+}
+
 void AssetModule::ProcessCommandLineOptions()
 {
     assert(framework_);
@@ -143,6 +190,11 @@ void AssetModule::ProcessCommandLineOptions()
         else
             LogError("Parameter --defaultstorage may be specified exactly once, and must contain a single value!");
     }
+
+    // A server does not prefetch its own manifest, but advertises it to the clients when they connect.
+    QStringList manifests = framework_->CommandLineParameters("--prefetchManifest");
+    if (!manifests.isEmpty() && !framework_->HasCommandLineParameter("--server"))
+        PrefetchAssets(manifests.last().trimmed());
 }
 
 void AssetModule::ConsoleRefreshHttpStorages()
@@ -206,7 +258,7 @@ void AssetModule::ServerNewUserConnected(int connectionID, UserConnection *conne
     std::vector<AssetStoragePtr> storages = framework_->Asset()->GetAssetStorages();
     for(size_t i = 0; i < storages.size(); ++i)
     {
-        bool isLocalStorage = (dynamic_cast<LocalAssetStorage*>(storages[i].get()) != 0);
+        bool isLocalStorage = (dynamic_cast<LocalAssetStorage*>(storages[i].get()) != 0 || dynamic_cast<BundleAssetStorage*>(storages[i].get()) != 0);
         if (storages[i]->IsReplicated() && (!isLocalStorage || isLocalhostConnection))
         {
             QDomElement storage = doc.createElement("storage");
@@ -217,7 +269,7 @@ void AssetModule::ServerNewUserConnected(int connectionID, UserConnection *conne
 
     // Specify which storage to use as default.
     AssetStoragePtr defaultStorage = framework_->Asset()->GetDefaultAssetStorage();
-    bool defaultStorageIsLocal = (dynamic_cast<LocalAssetStorage*>(defaultStorage.get()) != 0);
+    bool defaultStorageIsLocal = (dynamic_cast<LocalAssetStorage*>(defaultStorage.get()) != 0 || dynamic_cast<BundleAssetStorage*>(defaultStorage.get()) != 0);
     if (defaultStorage && (!defaultStorageIsLocal || isLocalhostConnection))
     {
         QDomElement storage = doc.createElement("defaultStorage");
@@ -226,6 +278,15 @@ void AssetModule::ServerNewUserConnected(int connectionID, UserConnection *conne
         if (!defaultStorage->IsReplicated())
             LogWarning("Server specified the client to use the storage \"" + defaultStorage->Name() + "\" as default, but it is not a replicated storage!");
     }
+
+    // Tell the client where to find the prefetch manifest, so that it can load the scene assets in parallel with the initial scene sync.
+    QStringList manifests = framework_->CommandLineParameters("--prefetchManifest");
+    if (!manifests.isEmpty())
+    {
+        QDomElement manifest = doc.createElement("prefetchManifest");
+        manifest.setAttribute("ref", manifests.last().trimmed());
+        assetRoot.appendChild(manifest);
+    }
 }
 
 void AssetModule::DetermineStorageTrustStatus(AssetStoragePtr storage)
@@ -272,6 +333,11 @@ void AssetModule::ClientConnectedToServer(UserConnectedResponseData *responseDat
             if (defaultStoragePtr)
                 framework_->Asset()->SetDefaultAssetStorage(defaultStoragePtr);
         }
+
+        // The login reply arrives before any scene data, so the prefetch runs in parallel with the initial scene sync.
+        QDomElement manifest = assetRoot.firstChildElement("prefetchManifest");
+        if (!manifest.isNull())
+            PrefetchAssets(manifest.attribute("ref"));
     }
 }
 
@@ -286,25 +352,6 @@ void AssetModule::ClientDisconnectedFromServer()
     storagesReceivedFromServer.clear();
 }
 
-void AssetModule::HandleKristalliMessage(kNet::MessageConnection* source, kNet::packet_id_t, kNet::message_id_t id, const char* data, size_t numBytes)
-{
-    switch (id)
-    {
-    case cAssetDiscoveryMessage:
-        {
-            MsgAssetDiscovery msg(data, numBytes);
-            HandleAssetDiscovery(source, msg);
-        }
-        break;
-    case cAssetDeletedMessage:
-        {
-            MsgAssetDeleted msg(data, numBytes);
-            HandleAssetDeleted(source, msg);
-        }
-        break;
-    }
-}
-
 void AssetModule::HandleAssetDiscovery(kNet::MessageConnection* source, MsgAssetDiscovery& msg)
 {
     QString assetRef = QString::fromStdString(BufferToString(msg.assetRef));
@@ -447,6 +494,92 @@ void AssetModule::ConsoleDumpAssets()
     }
 }
 
+void AssetModule::ConsoleAssetMemoryUsage()
+{
+    AssetAPI *assetApi = framework_->Asset();
+    assetApi->UpdateAssetMemoryUsage();
+    const double megabyte = 1024.0 * 1024.0;
+    LogInfo(QString("Estimated asset memory usage: %1 MB main memory, %2 MB GPU memory.")
+        .arg(assetApi->AssetCpuMemoryUsage() / megabyte, 0, 'f', 1).arg(assetApi->AssetGpuMemoryUsage() / megabyte, 0, 'f', 1));
+    if (assetApi->AssetMemoryBudget() > 0)
+        LogInfo(QString("Asset memory budget: %1 MB.").arg(assetApi->AssetMemoryBudget() / megabyte, 0, 'f', 1));
+    else
+        LogInfo("Asset memory budget: unlimited.");
+}
+
+void AssetModule::ConsoleUnloadUnusedAssets()
+{
+    int numUnloaded = framework_->Asset()->UnloadUnreferencedAssets(0);
+    LogInfo(QString("Unloaded %1 unused assets.").arg(numUnloaded));
+}
+
+void AssetModule::ConsoleAssetLoadTelemetry()
+{
+    foreach(const QString &line, framework_->Asset()->LoadTelemetry()->Summary(cNumWorstOffenders))
+        LogInfo(line);
+}
+
+void AssetModule::ExportAssetLoadTelemetry(const QString &filename)
+{
+    if (filename.trimmed().isEmpty())
+    {
+        LogError("ExportAssetLoadTelemetry: No filename given.");
+        return;
+    }
+
+    QFile file(filename.trimmed());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        LogError("ExportAssetLoadTelemetry: Could not open " + filename + " for writing.");
+        return;
+    }
+    file.write(framework_->Asset()->LoadTelemetry()->ToJson(cNumWorstOffenders));
+    LogInfo("Asset load telemetry written to " + filename.trimmed());
+}
+
+void AssetModule::ConsoleResetAssetLoadTelemetry()
+{
+    framework_->Asset()->LoadTelemetry()->Clear();
+}
+
+void AssetModule::PrefetchAssets(const QString &manifestRef)
+{
+    if (manifestRef.isEmpty())
+        return;
+
+    // A manifest on the local file system is read right away, others are fetched like any other asset.
+    if (QFile::exists(manifestRef))
+    {
+        AssetPrefetchManifest manifest;
+        if (manifest.LoadFromFile(manifestRef))
+            StartPrefetch(manifest);
+        return;
+    }
+
+    AssetTransferPtr transfer = framework_->Asset()->RequestAsset(manifestRef, "Binary");
+    if (transfer)
+        connect(transfer.get(), SIGNAL(Succeeded(AssetPtr)), this, SLOT(OnPrefetchManifestLoaded(AssetPtr)), Qt::UniqueConnection);
+    else
+        LogError("AssetModule: Could not request asset prefetch manifest " + manifestRef);
+}
+
+void AssetModule::OnPrefetchManifestLoaded(AssetPtr asset)
+{
+    std::vector<u8> data;
+    AssetPrefetchManifest manifest;
+    if (asset->SerializeTo(data) && !data.empty() && manifest.Deserialize(QByteArray((const char *)&data[0], (int)data.size())))
+        StartPrefetch(manifest);
+    else
+        LogError("AssetModule: Asset prefetch manifest " + asset->Name() + " could not be read.");
+}
+
+void AssetModule::StartPrefetch(const AssetPrefetchManifest &manifest)
+{
+    int numRequested = manifest.Prefetch(framework_->Asset());
+    LogInfo(QString("AssetModule: Prefetching %1 of the %2 assets of scene \"%3\" (%4 KB in total).").arg(numRequested)
+        .arg(manifest.NumAssets()).arg(manifest.SceneName()).arg(manifest.TotalSize() / 1024));
+}
+
 bool AssetModule::ShouldReplicateAssetDiscovery(const QString& assetRef)
 {
     QString protocol;
@@ -10,6 +10,8 @@
 #include "kNet/Types.h"
 #include "TundraProtocolModuleFwd.h"
 
+class AssetPrefetchManifest;
+
 /// Implements asset providers and storages for local disk assets and HTTP assets.
 class ASSET_MODULE_API AssetModule : public IModule
 {
@@ -20,6 +22,7 @@ public:
     virtual ~AssetModule();
 
     virtual void Initialize();
+    virtual void Uninitialize();
 
 public slots:
     void ConsoleRequestAsset(const QString &assetRef, const QString &assetType);
@@ -36,6 +39,21 @@ public slots:
 
     void ConsoleDumpAssets();
 
+    /// Prints the estimated memory usage of the loaded assets and the asset memory budget.
+    void ConsoleAssetMemoryUsage();
+
+    /// Unloads all the assets that are not in use, and can be reloaded when they are requested again.
+    void ConsoleUnloadUnusedAssets();
+
+    /// Prints the asset load pipeline timings by asset type and provider, and the slowest assets overall and of each scene.
+    void ConsoleAssetLoadTelemetry();
+
+    /// Writes the asset load pipeline timings to a JSON file.
+    void ExportAssetLoadTelemetry(const QString &filename);
+
+    /// Forgets the recorded asset load pipeline timings, f.ex. before loading the next scene.
+    void ConsoleResetAssetLoadTelemetry();
+
     /// Loads from all the registered local storages all assets that have the given suffix.
     /// Type can also be optionally specified
     /// \todo Will be replaced with AssetStorage's GetAllAssetsRefs / GetAllAssets functionality
@@ -51,10 +69,11 @@ public slots:
     /// If we are the client, this function gets called when we disconnected. Removes all storages received from the server from our storage list.
     void ClientDisconnectedFromServer();
 
+    /// Requests all assets listed in an asset prefetch manifest, closest to the scene origin first.
+    /** @param manifestRef A local file name or an assetref of the manifest. @see AssetPrefetchManifest. */
+    void PrefetchAssets(const QString &manifestRef);
+
 private slots:
-    /// Handles a Kristalli protocol message. Used for AssetDiscovery & AssetDeleted messages
-    void HandleKristalliMessage(kNet::MessageConnection* source, kNet::packet_id_t packetId, kNet::message_id_t messageId, const char* data, size_t numBytes);
-    
     /// Handle incoming asset discovery message.
     void HandleAssetDiscovery(kNet::MessageConnection* source, MsgAssetDiscovery& msg);
     
@@ -66,10 +85,16 @@ private slots:
 
     /// Asset deleted from a storage. Send AssetDeleted network message
     void OnAssetDeleted(const QString& assetRef);
+
+    /// An asset prefetch manifest requested by PrefetchAssets has been downloaded.
+    void OnPrefetchManifestLoaded(AssetPtr asset);
     
 private:
     void ProcessCommandLineOptions();
 
+    /// Requests the assets of a loaded prefetch manifest.
+    void StartPrefetch(const AssetPrefetchManifest &manifest);
+
     /// Check from an assetref whether it should be replicated when a modify or a delete to it is detected.
     bool ShouldReplicateAssetDiscovery(const QString& assetRef);
 
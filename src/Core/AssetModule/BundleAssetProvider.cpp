@@ -0,0 +1,252 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "BundleAssetProvider.h"
+#include "BundleAssetStorage.h"
+#include "IAssetTransfer.h"
+#include "AssetAPI.h"
+#include "IAsset.h"
+
+#include "Framework.h"
+#include "LoggingFunctions.h"
+#include "HighPerfClock.h"
+#include "Profiler.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMap>
+
+#include "MemoryLeakCheck.h"
+
+BundleAssetProvider::BundleAssetProvider(Framework* framework_)
+:framework(framework_)
+{
+}
+
+BundleAssetProvider::~BundleAssetProvider()
+{
+}
+
+QString BundleAssetProvider::Name()
+{
+    static const QString name("Bundle");
+    return name;
+}
+
+bool BundleAssetProvider::IsValidRef(QString assetRef, QString)
+{
+    return FindEntry(assetRef, 0) != 0;
+}
+
+AssetTransferPtr BundleAssetProvider::RequestAsset(QString assetRef, QString assetType)
+{
+    PROFILE(BundleAssetProvider_RequestAsset);
+    if (assetRef.isEmpty())
+        return AssetTransferPtr();
+    assetType = assetType.trimmed();
+    if (assetType.isEmpty())
+        assetType = AssetAPI::GetResourceTypeFromAssetRef(assetRef);
+
+    AssetTransferPtr transfer = AssetTransferPtr(new IAssetTransfer);
+    transfer->source.ref = assetRef.trimmed();
+    transfer->assetType = assetType;
+    transfer->diskSourceType = IAsset::Original;
+
+    pendingDownloads.push_back(transfer);
+
+    return transfer;
+}
+
+bool BundleAssetProvider::AbortTransfer(IAssetTransfer *transfer)
+{
+    if (!transfer)
+        return false;
+
+    for (std::vector<AssetTransferPtr>::iterator iter = pendingDownloads.begin(); iter != pendingDownloads.end(); ++iter)
+        if (iter->get() == transfer)
+        {
+            transfer->EmitAssetFailed("Transfer aborted.");
+            pendingDownloads.erase(iter);
+            return true;
+        }
+    return false;
+}
+
+void BundleAssetProvider::Update(f64 /*frametime*/)
+{
+    PROFILE(BundleAssetProvider_Update);
+    CompletePendingDownloads();
+}
+
+void BundleAssetProvider::DeleteAssetFromStorage(QString assetRef)
+{
+    LogError("BundleAssetProvider::DeleteAssetFromStorage: Cannot delete \"" + assetRef + "\", asset bundles are read-only.");
+}
+
+bool BundleAssetProvider::RemoveAssetStorage(QString storageName)
+{
+    for(size_t i = 0; i < storages.size(); ++i)
+        if (storages[i]->name.compare(storageName, Qt::CaseInsensitive) == 0)
+        {
+            storages.erase(storages.begin() + i);
+            return true;
+        }
+
+    return false;
+}
+
+BundleAssetStoragePtr BundleAssetProvider::AddBundle(QString filename, QString storageName)
+{
+    filename = QFileInfo(filename.trimmed()).absoluteFilePath();
+    storageName = storageName.trimmed();
+    if (storageName.isEmpty())
+        storageName = QFileInfo(filename).completeBaseName();
+
+    for(size_t i = 0; i < storages.size(); ++i)
+        if (storages[i]->name.compare(storageName, Qt::CaseInsensitive) == 0)
+        {
+            if (storages[i]->bundle.Filename() != filename)
+            {
+                LogWarning("BundleAssetProvider: Storage '" + storageName + "' already exists for '" + storages[i]->bundle.Filename() + "', not adding with '" + filename + "'.");
+                return BundleAssetStoragePtr();
+            }
+            else // We already have a storage with that name and bundle registered, just return that.
+                return storages[i];
+        }
+
+    BundleAssetStoragePtr storage = BundleAssetStoragePtr(new BundleAssetStorage());
+    if (!storage->bundle.Open(filename))
+        return BundleAssetStoragePtr();
+    storage->name = storageName;
+    storage->provider = shared_from_this();
+    storages.push_back(storage);
+
+    LogInfo(QString("BundleAssetProvider: Added bundle %1 with %2 assets as storage '%3'.").arg(filename).arg(storage->bundle.Entries().size()).arg(storageName));
+
+    // Tell the Asset API that we have created a new storage.
+    framework->Asset()->EmitAssetStorageAdded(storage);
+
+    return storage;
+}
+
+std::vector<AssetStoragePtr> BundleAssetProvider::GetStorages() const
+{
+    std::vector<AssetStoragePtr> stores;
+    for(size_t i = 0; i < storages.size(); ++i)
+        stores.push_back(storages[i]);
+    return stores;
+}
+
+AssetStoragePtr BundleAssetProvider::GetStorageByName(const QString &name) const
+{
+    for(size_t i = 0; i < storages.size(); ++i)
+        if (storages[i]->name.compare(name, Qt::CaseInsensitive) == 0)
+            return storages[i];
+
+    return AssetStoragePtr();
+}
+
+AssetStoragePtr BundleAssetProvider::GetStorageForAssetRef(const QString &assetRef) const
+{
+    BundleAssetStoragePtr storage;
+    FindEntry(assetRef, &storage);
+    return boost::static_pointer_cast<IAssetStorage>(storage);
+}
+
+AssetStoragePtr BundleAssetProvider::TryDeserializeStorageFromString(const QString &storage, bool fromNetwork)
+{
+    QMap<QString, QString> s = AssetAPI::ParseAssetStorageString(storage);
+    if (!s.contains("src"))
+        return AssetStoragePtr();
+    if (s.contains("type"))
+    {
+        if (s["type"].compare("BundleAssetStorage", Qt::CaseInsensitive) != 0)
+            return AssetStoragePtr();
+    }
+    else if (!s["src"].endsWith(".tbundle", Qt::CaseInsensitive))
+        return AssetStoragePtr();
+
+    // Bundles are files on this computer, so a server cannot make the client open one.
+    if (fromNetwork)
+        return AssetStoragePtr();
+
+    QString path;
+    AssetAPI::AssetRefType refType = AssetAPI::ParseAssetRef(s["src"], 0, 0, 0, 0, &path);
+    if (refType != AssetAPI::AssetRefLocalPath && refType != AssetAPI::AssetRefRelativePath)
+        return AssetStoragePtr();
+
+    BundleAssetStoragePtr storagePtr = AddBundle(path, s.contains("name") ? s["name"] : "");
+    if (storagePtr && s.contains("replicated"))
+        storagePtr->SetReplicated(ParseBool(s["replicated"]));
+
+    return storagePtr;
+}
+
+const AssetBundle::Entry *BundleAssetProvider::FindEntry(const QString &assetRef, BundleAssetStoragePtr *storage) const
+{
+    if (storages.empty())
+        return 0;
+
+    QString namedStorage;
+    QString path_filename;
+    AssetAPI::AssetRefType refType = AssetAPI::ParseAssetRef(assetRef.trimmed(), 0, &namedStorage, 0, 0, &path_filename);
+    if (refType != AssetAPI::AssetRefLocalUrl && refType != AssetAPI::AssetRefRelativePath && refType != AssetAPI::AssetRefNamedStorage)
+        return 0;
+    // 'file://C:/path/to/asset.png' refers to a file outside any storage.
+    if (refType == AssetAPI::AssetRefLocalUrl && AssetAPI::ParseAssetRef(path_filename) == AssetAPI::AssetRefLocalPath)
+        return 0;
+
+    for(size_t i = 0; i < storages.size(); ++i)
+    {
+        if (refType == AssetAPI::AssetRefNamedStorage && storages[i]->name.compare(namedStorage, Qt::CaseInsensitive) != 0)
+            continue;
+        const AssetBundle::Entry *entry = storages[i]->bundle.Find(path_filename);
+        if (entry)
+        {
+            if (storage)
+                *storage = storages[i];
+            return entry;
+        }
+    }
+    return 0;
+}
+
+void BundleAssetProvider::CompletePendingDownloads()
+{
+    tick_t startTime = GetCurrentClockTime();
+
+    while(pendingDownloads.size() > 0)
+    {
+        PROFILE(BundleAssetProvider_ProcessPendingDownload);
+
+        AssetTransferPtr transfer = pendingDownloads.back();
+        pendingDownloads.pop_back();
+
+        BundleAssetStoragePtr storage;
+        const AssetBundle::Entry *entry = FindEntry(transfer->source.ref, &storage);
+        if (!entry)
+        {
+            framework->Asset()->AssetTransferFailed(transfer.get(), "Failed to find asset \"" + transfer->source.ref + "\" in the asset bundles!");
+            continue;
+        }
+        if (!storage->bundle.Read(*entry, transfer->rawAssetData))
+        {
+            framework->Asset()->AssetTransferFailed(transfer.get(), "Failed to read asset \"" + transfer->source.ref + "\" from " + storage->bundle.Filename());
+            continue;
+        }
+
+        // The data is already in memory and there is no file of its own to use as a disk source, and caching a copy of it
+        // would bring back the per-file reads the bundle avoids.
+        transfer->SetCachingBehavior(false, "");
+        transfer->storage = storage;
+
+        framework->Asset()->AssetTransferCompleted(transfer.get());
+
+        // Throttle asset loading to at most 16 msecs/frame.
+        const int maxLoadMSecs = 16;
+        if (GetCurrentClockTime() - startTime >= GetCurrentClockFreq() * maxLoadMSecs / 1000)
+            break;
+    }
+}
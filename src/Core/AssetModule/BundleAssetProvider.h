@@ -0,0 +1,78 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include <boost/enable_shared_from_this.hpp>
+#include "AssetModuleApi.h"
+#include "IAssetProvider.h"
+#include "AssetFwd.h"
+#include "AssetBundle.h"
+
+class BundleAssetStorage;
+
+typedef boost::shared_ptr<BundleAssetStorage> BundleAssetStoragePtr;
+
+/// Serves 'local://' asset refs from memory-mapped asset bundle files.
+/** The provider is registered before LocalAssetProvider, so an asset that is found in a bundle is read from the bundle,
+    and the refs that no bundle contains fall through to the local directory storages.
+    Bundles are added as storages with f.ex. --storage assets.tbundle. */
+class ASSET_MODULE_API BundleAssetProvider : public QObject, public IAssetProvider, public boost::enable_shared_from_this<BundleAssetProvider>
+{
+    Q_OBJECT
+
+public:
+    explicit BundleAssetProvider(Framework* framework);
+
+    virtual ~BundleAssetProvider();
+
+    /// Returns name of asset provider
+    virtual QString Name();
+
+    /// Returns true if the ref is a local ref to an asset in one of the open bundles.
+    virtual bool IsValidRef(QString assetRef, QString assetType);
+
+    /// Requests an asset from a bundle, returns resulted transfer.
+    virtual AssetTransferPtr RequestAsset(QString assetRef, QString assetType);
+
+    /// Aborts the ongoing bundle transfer.
+    virtual bool AbortTransfer(IAssetTransfer *transfer);
+
+    /// Completes the pending transfers.
+    /** @param frametime Seconds since last frame */
+    virtual void Update(f64 frametime);
+
+    /// Bundles are read-only, so this only logs an error.
+    virtual void DeleteAssetFromStorage(QString assetRef);
+
+    /// @param storageName An identifier for the storage. Remember that Asset Storage names are case-insensitive.
+    virtual bool RemoveAssetStorage(QString storageName);
+
+    /// Opens the given bundle file and adds it as an asset storage.
+    /** @param filename The path name of the bundle file.
+        @param storageName An identifier for the storage. Remember that Asset Storage names are case-insensitive.
+        Returns the newly created storage, or 0 if the bundle could not be opened, or if a storage with the given name already existed. */
+    BundleAssetStoragePtr AddBundle(QString filename, QString storageName);
+
+    virtual std::vector<AssetStoragePtr> GetStorages() const;
+
+    virtual AssetStoragePtr GetStorageByName(const QString &name) const;
+
+    virtual AssetStoragePtr GetStorageForAssetRef(const QString &assetRef) const;
+
+    /// Accepts storage strings of type BundleAssetStorage, and untyped storage strings whose src is a .tbundle file.
+    virtual AssetStoragePtr TryDeserializeStorageFromString(const QString &storage, bool fromNetwork);
+
+private:
+    Q_DISABLE_COPY(BundleAssetProvider)
+
+    /// Finds the bundle entry a local asset ref refers to. Searches through all bundles in the order they were added.
+    /// @param storage [out] Receives the storage that contains the asset.
+    const AssetBundle::Entry *FindEntry(const QString &assetRef, BundleAssetStoragePtr *storage) const;
+
+    /// Takes the pending transfers and finishes them.
+    void CompletePendingDownloads();
+
+    Framework *framework;
+    std::vector<BundleAssetStoragePtr> storages; ///< Open bundles, searched in the order they were added.
+    std::vector<AssetTransferPtr> pendingDownloads; ///< The following asset downloads are pending to be completed by this provider.
+};
@@ -0,0 +1,50 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "BundleAssetStorage.h"
+
+#include "CoreStringUtils.h"
+
+#include <QStringList>
+
+#include "MemoryLeakCheck.h"
+
+BundleAssetStorage::BundleAssetStorage()
+{
+    writable = false;
+    liveUpdate = false;
+    autoDiscoverable = false;
+}
+
+QString BundleAssetStorage::GetFullAssetURL(const QString &localName)
+{
+    QString filename = localName;
+    int lastSlash = filename.lastIndexOf('/');
+    if (lastSlash != -1)
+        filename = filename.mid(lastSlash + 1);
+    return BaseURL() + filename;
+}
+
+QString BundleAssetStorage::Type() const
+{
+    return "BundleAssetStorage";
+}
+
+QStringList BundleAssetStorage::GetAllAssetRefs()
+{
+    QStringList refs;
+    const std::vector<AssetBundle::Entry> &entries = bundle.Entries();
+    for(size_t i = 0; i < entries.size(); ++i)
+        refs << GetFullAssetURL(entries[i].name);
+    return refs;
+}
+
+QString BundleAssetStorage::SerializeToString(bool networkTransfer) const
+{
+    if (networkTransfer)
+        return ""; // The bundle file is local to this system, like the directory of a LocalAssetStorage.
+    else
+        return "type=" + Type() + ";name=" + name + ";src=" + bundle.Filename() + ";replicated=" + BoolToString(isReplicated);
+}
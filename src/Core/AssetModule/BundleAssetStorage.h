@@ -0,0 +1,52 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include "AssetModuleApi.h"
+#include "IAssetStorage.h"
+#include "AssetBundle.h"
+
+/// Represents a single asset bundle file on the local file system.
+/** The assets of the bundle are referred to with ordinary 'local://' refs, so a directory of assets can be replaced with
+    a bundle of it without changing the scenes that refer to the assets. */
+class ASSET_MODULE_API BundleAssetStorage : public IAssetStorage
+{
+    Q_OBJECT
+
+public:
+    BundleAssetStorage();
+
+    /// Specifies a human-readable name for this storage.
+    QString name;
+
+    /// The opened bundle file.
+    AssetBundle bundle;
+
+public slots:
+    /// Bundle storages are always trusted, like local storages.
+    virtual bool Trusted() const { return true; }
+
+    virtual TrustState GetTrustState() const { return StorageTrusted; }
+
+    /// Returns "local://" + localName. Like LocalAssetStorage, the subdirectories of localName are ignored.
+    QString GetFullAssetURL(const QString &localName);
+
+    /// Returns the type of this storage: "BundleAssetStorage".
+    virtual QString Type() const;
+
+    /// Returns the local refs of all the assets in the bundle.
+    virtual QStringList GetAllAssetRefs();
+
+    QString Name() const { return name; }
+
+    QString BaseURL() const { return "local://"; }
+
+    /// Returns a convenient human-readable representation of this storage.
+    QString ToString() const { return Name() + " (" + bundle.Filename() + ")"; }
+
+    /// Serializes this storage to a string for machine transfer.
+    virtual QString SerializeToString(bool networkTransfer = false) const;
+
+private:
+    Q_DISABLE_COPY(BundleAssetStorage)
+};
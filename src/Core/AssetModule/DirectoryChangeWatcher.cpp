@@ -0,0 +1,643 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "DirectoryChangeWatcher.h"
+#include "AssetAPI.h"
+#include "LoggingFunctions.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStringList>
+#include <QEventLoop>
+#include <QTimer>
+#include <QFileSystemWatcher>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+#include "MemoryLeakCheck.h"
+
+namespace
+{
+typedef std::pair<QString, tick_t> PathAndTime;
+
+bool EarlierEvent(const PathAndTime &a, const PathAndTime &b)
+{
+    return a.second < b.second;
+}
+
+/// Returns the first path after the paths inside the given directory, which ends with a slash.
+/** The paths inside a directory are a contiguous range in a map or a set sorted by path, as '0' follows '/'. */
+QString DirectoryRangeEnd(const QString &dir)
+{
+    return dir.left(dir.length() - 1) + '0';
+}
+
+/// Returns true if the path, which begins with the given directory, is a file or a directory directly in it.
+bool IsInDirectory(const QString &path, const QString &dir)
+{
+    const int slash = path.indexOf('/', dir.length());
+    return slash < 0 || slash == path.length() - 1;
+}
+}
+
+DirectoryChangeWatcher::DirectoryChangeWatcher(const QString &directory_, bool recursive_, bool forcePolling, int pollIntervalMsecs) :
+    directory(GuaranteeTrailingSlash(QDir::fromNativeSeparators(directory_))),
+    recursive(recursive_),
+    pollInterval(std::max(pollIntervalMsecs, 100)),
+    stopping(false),
+    polling(forcePolling)
+{
+    try
+    {
+        threads.create_thread(boost::bind(&DirectoryChangeWatcher::ThreadMain, this));
+    }
+    catch(const boost::thread_resource_error &)
+    {
+        LogError("DirectoryChangeWatcher: Failed to start the watcher thread for " + directory + ". File changes will not be detected.");
+    }
+}
+
+DirectoryChangeWatcher::~DirectoryChangeWatcher()
+{
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        stopping = true;
+    }
+    stopRequested.notify_all();
+    threads.join_all();
+}
+
+std::vector<DirectoryChangeWatcher::Change> DirectoryChangeWatcher::TakeChanges(int quietMsecs, size_t maxChanges)
+{
+    std::vector<Change> changes;
+    const tick_t now = GetCurrentClockTime();
+    const tick_t quietTime = (tick_t)(GetCurrentClockFreq() * std::max(quietMsecs, 0) / 1000);
+
+    boost::mutex::scoped_lock lock(mutex);
+
+    std::vector<PathAndTime> quietFiles;
+    for(PendingChangeMap::const_iterator iter = pendingChanges.begin(); iter != pendingChanges.end(); ++iter)
+        if (now - iter->second.lastEvent >= quietTime)
+            quietFiles.push_back(std::make_pair(iter->first, iter->second.lastEvent));
+    std::sort(quietFiles.begin(), quietFiles.end(), EarlierEvent);
+    if (quietFiles.size() > maxChanges)
+        quietFiles.resize(maxChanges);
+
+    for(size_t i = 0; i < quietFiles.size(); ++i)
+    {
+        PendingChangeMap::iterator iter = pendingChanges.find(quietFiles[i].first);
+        const PendingChange &pending = iter->second;
+        // A file that was created and deleted again between the takes has not changed as far as the owner knows.
+        if (pending.existedBefore || pending.exists)
+        {
+            Change change;
+            change.path = iter->first;
+            change.type = (!pending.existedBefore ? FileCreated : (pending.exists ? FileModified : FileDeleted));
+            changes.push_back(change);
+        }
+        pendingChanges.erase(iter);
+    }
+    return changes;
+}
+
+size_t DirectoryChangeWatcher::NumPendingChanges() const
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return pendingChanges.size();
+}
+
+bool DirectoryChangeWatcher::IsPolling() const
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return polling;
+}
+
+QString DirectoryChangeWatcher::TakeFallbackReason()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    QString reason = fallbackReason;
+    fallbackReason.clear();
+    return reason;
+}
+
+bool DirectoryChangeWatcher::IsIgnored(const QString &path)
+{
+    return path.contains("/.git/") || path.endsWith("/.git") || path.contains("/.svn/") || path.endsWith("/.svn") ||
+        path.contains("/.hg/") || path.endsWith("/.hg");
+}
+
+void DirectoryChangeWatcher::ThreadMain()
+{
+    bool usePolling;
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        usePolling = polling;
+    }
+#ifdef Q_OS_LINUX
+    if (!usePolling && WatchWithInotify())
+        return;
+#else
+    if (!usePolling && WatchWithFileSystemWatcher())
+        return;
+#endif
+    Poll();
+}
+
+void DirectoryChangeWatcher::AddEvent(const QString &path, ChangeType type)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    PendingChangeMap::iterator iter = pendingChanges.find(path);
+    if (iter == pendingChanges.end())
+    {
+        PendingChange pending;
+        pending.existedBefore = (type != FileCreated);
+        iter = pendingChanges.insert(std::make_pair(path, pending)).first;
+    }
+    iter->second.exists = (type != FileDeleted);
+    iter->second.lastEvent = GetCurrentClockTime();
+}
+
+void DirectoryChangeWatcher::FallBackToPolling(const QString &reason)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    polling = true;
+    fallbackReason = reason;
+}
+
+bool DirectoryChangeWatcher::IsStopping() const
+{
+    boost::mutex::scoped_lock lock(mutex);
+    return stopping;
+}
+
+#ifdef Q_OS_LINUX
+bool DirectoryChangeWatcher::WatchWithInotify()
+{
+    int fd = inotify_init();
+    if (fd < 0)
+    {
+        FallBackToPolling("inotify_init failed: " + QString(strerror(errno)));
+        return false;
+    }
+
+    std::map<int, QString> watches;
+    if (!AddInotifyWatches(fd, directory, watches, 0))
+    {
+        close(fd);
+        FallBackToPolling(QString("Ran out of inotify watches after watching %1 directories. Increase fs.inotify.max_user_watches to watch the storage with inotify.").arg(watches.size()));
+        return false;
+    }
+
+    // The snapshot is taken after the watches are added, so that no change falls between the two. It is kept up to date from the events,
+    // so that the changes of the events lost in an event queue overflow can be found by rescanning the directory tree against it.
+    FileSnapshot snapshot;
+    ScanDirectory(directory, true, snapshot);
+
+    // Read the events in large chunks, a version control checkout can generate thousands of them at once.
+    const size_t cBufferSize = 64 * 1024;
+    std::vector<char> buffer(cBufferSize);
+    while(!IsStopping())
+    {
+        // Wake up regularly to check whether the watcher was stopped.
+        pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 250) <= 0)
+            continue;
+        ssize_t numBytes = read(fd, &buffer[0], buffer.size());
+        if (numBytes <= 0)
+            continue;
+
+        for(ssize_t offset = 0; offset + (ssize_t)sizeof(inotify_event) <= numBytes;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(&buffer[offset]);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                // Events were lost. Watch the directories that may have been created meanwhile, adding an existing watch again
+                // just returns it, and then find the lost changes by rescanning the directory tree against the snapshot.
+                if (!AddInotifyWatches(fd, directory, watches, 0))
+                {
+                    close(fd);
+                    FallBackToPolling(QString("Ran out of inotify watches after watching %1 directories. Increase fs.inotify.max_user_watches to watch the storage with inotify.").arg(watches.size()));
+                    return false;
+                }
+                RescanDirectory(directory, true, snapshot);
+                continue;
+            }
+
+            std::map<int, QString>::iterator watch = watches.find(event->wd);
+            if (watch == watches.end())
+                continue;
+            if (event->mask & IN_IGNORED) // The directory was deleted or moved away.
+            {
+                watches.erase(watch);
+                continue;
+            }
+            if (event->mask & IN_MOVE_SELF)
+            {
+                // The moves of subdirectories are handled through the events of their parents. If the watched directory itself is moved,
+                // the watches follow it to its new location, so its files are reported deleted and its path is polled instead, in case it reappears.
+                if (watch->second == directory)
+                {
+                    close(fd);
+                    RescanDirectory(directory, true, snapshot);
+                    FallBackToPolling("The watched directory " + directory + " was moved.");
+                    return false;
+                }
+                continue;
+            }
+            if (event->len == 0)
+                continue;
+
+            const QString path = watch->second + QFile::decodeName(event->name);
+            if (IsIgnored(path))
+                continue;
+
+            if (event->mask & IN_ISDIR)
+            {
+                if (!recursive)
+                    continue;
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    if (!AddInotifyWatches(fd, path + "/", watches, &snapshot))
+                    {
+                        close(fd);
+                        FallBackToPolling(QString("Ran out of inotify watches after watching %1 directories. Increase fs.inotify.max_user_watches to watch the storage with inotify.").arg(watches.size()));
+                        return false;
+                    }
+                }
+                else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    // A directory moved out of the watched tree takes its files with it. Its watches would follow it, so they are removed.
+                    RemoveInotifyWatches(fd, path + "/", watches);
+                    RescanDirectory(path + "/", true, snapshot);
+                }
+                continue;
+            }
+
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                AddEvent(path, FileCreated);
+            else if (event->mask & IN_CLOSE_WRITE)
+                AddEvent(path, FileModified);
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                AddEvent(path, FileDeleted);
+            else
+                continue;
+            UpdateSnapshot(snapshot, path);
+        }
+    }
+
+    close(fd);
+    return true;
+}
+
+bool DirectoryChangeWatcher::AddInotifyWatches(int fd, const QString &dir, std::map<int, QString> &watches, FileSnapshot *newFiles)
+{
+    // Walking a large tree takes a while, so stop early if the watcher is being destroyed. The caller notices the stop on its next check.
+    if (IsStopping())
+        return true;
+
+    // Modifications are detected when the file is closed, so that the file is not reported while it is still being written.
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW;
+    int wd = inotify_add_watch(fd, QFile::encodeName(dir).constData(), mask);
+    if (wd < 0)
+        return errno != ENOSPC; // Directories that are deleted before the watch is added are skipped.
+    watches[wd] = dir;
+
+    if (!recursive && !newFiles)
+        return true;
+
+    QDir::Filters filters = QDir::NoDotAndDotDot | QDir::NoSymLinks;
+    if (recursive)
+        filters |= QDir::Dirs;
+    if (newFiles)
+        filters |= QDir::Files;
+    foreach(const QFileInfo &entry, QDir(QDir::cleanPath(dir)).entryInfoList(filters))
+    {
+        const QString path = entry.absoluteFilePath();
+        if (IsIgnored(path))
+            continue;
+        if (entry.isDir())
+        {
+            if (!AddInotifyWatches(fd, path + "/", watches, newFiles))
+                return false;
+        }
+        else
+        {
+            AddEvent(path, FileCreated);
+            UpdateSnapshot(*newFiles, path);
+        }
+    }
+    return true;
+}
+
+void DirectoryChangeWatcher::RemoveInotifyWatches(int fd, const QString &dir, std::map<int, QString> &watches)
+{
+    for(std::map<int, QString>::iterator iter = watches.begin(); iter != watches.end();)
+    {
+        if (iter->second.startsWith(dir))
+        {
+            inotify_rm_watch(fd, iter->first);
+            watches.erase(iter++);
+        }
+        else
+            ++iter;
+    }
+}
+
+#else
+
+struct DirectoryChangeWatcher::NativeWatches
+{
+    QFileSystemWatcher watcher;
+    std::set<QString> directories; ///< The watched directories, with a trailing slash.
+    std::set<QString> files; ///< The watched files.
+};
+
+bool DirectoryChangeWatcher::WatchWithFileSystemWatcher()
+{
+    // QFileSystemWatcher delivers its signals through the event loop of the thread it lives in, so this thread runs one.
+    // The event loop is created first, as it sets up the event dispatcher of the thread.
+    QEventLoop eventLoop;
+    NativeWatches watches;
+    DirectoryChangeCollector collector;
+    QObject::connect(&watches.watcher, SIGNAL(directoryChanged(const QString &)), &collector, SLOT(OnDirectoryChanged(const QString &)));
+    QObject::connect(&watches.watcher, SIGNAL(fileChanged(const QString &)), &collector, SLOT(OnFileChanged(const QString &)));
+    // Wake up regularly to check whether the watcher was stopped.
+    QTimer wakeUpTimer;
+    wakeUpTimer.start(250);
+
+    // Files are watched as well, as the native watchers of some platforms report only the entries created and deleted in a directory.
+    AddNativeWatches(watches, directory, true);
+    // QFileSystemWatcher does not report the paths it failed to watch, so the watched paths are counted instead.
+    const int numPaths = (int)(watches.directories.size() + watches.files.size());
+    const int numWatched = watches.watcher.directories().size() + watches.watcher.files().size();
+    if (numWatched < numPaths)
+    {
+        FallBackToPolling(QString("Could watch only %1 of the %2 directories and files of the storage natively.").arg(numWatched).arg(numPaths));
+        return false;
+    }
+
+    // The snapshot is taken after the watches are added, so that no change falls between the two.
+    FileSnapshot snapshot;
+    ScanDirectory(directory, true, snapshot);
+
+    while(!IsStopping())
+    {
+        eventLoop.processEvents(QEventLoop::WaitForMoreEvents);
+
+        std::set<QString> changedDirectories;
+        std::set<QString> changedFiles;
+        changedDirectories.swap(collector.changedDirectories);
+        changedFiles.swap(collector.changedFiles);
+        for(std::set<QString>::const_iterator iter = changedDirectories.begin(); iter != changedDirectories.end() && !IsStopping(); ++iter)
+            HandleDirectoryChange(watches, GuaranteeTrailingSlash(*iter), snapshot);
+        for(std::set<QString>::const_iterator iter = changedFiles.begin(); iter != changedFiles.end(); ++iter)
+            if (!IsIgnored(*iter))
+                RescanFile(*iter, snapshot);
+    }
+    return true;
+}
+
+void DirectoryChangeWatcher::AddNativeWatches(NativeWatches &watches, const QString &dir, bool subdirectories)
+{
+    // The paths are collected first and added at once, as QFileSystemWatcher sets up the watches faster that way.
+    QStringList paths;
+    std::vector<QString> dirs(1, dir);
+    while(!dirs.empty())
+    {
+        // Walking a large tree takes a while, so stop early if the watcher is being destroyed.
+        if (IsStopping())
+            return;
+
+        const QString current = dirs.back();
+        dirs.pop_back();
+        if (watches.directories.insert(current).second)
+            paths << QDir::cleanPath(current);
+
+        QDir::Filters filters = QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks;
+        if (subdirectories && recursive)
+            filters |= QDir::Dirs;
+        foreach(const QFileInfo &entry, QDir(QDir::cleanPath(current)).entryInfoList(filters))
+        {
+            const QString path = entry.absoluteFilePath();
+            if (IsIgnored(path))
+                continue;
+            if (entry.isDir())
+                dirs.push_back(path + "/");
+            else if (watches.files.insert(path).second)
+                paths << path;
+        }
+    }
+    if (!paths.isEmpty())
+        watches.watcher.addPaths(paths);
+}
+
+void DirectoryChangeWatcher::RemoveNativeWatches(NativeWatches &watches, const QString &dir)
+{
+    QStringList paths;
+    const QString rangeEnd = DirectoryRangeEnd(dir);
+    std::set<QString>::iterator first = watches.directories.lower_bound(dir);
+    std::set<QString>::iterator last = watches.directories.lower_bound(rangeEnd);
+    for(std::set<QString>::const_iterator iter = first; iter != last; ++iter)
+        paths << QDir::cleanPath(*iter);
+    watches.directories.erase(first, last);
+
+    first = watches.files.lower_bound(dir);
+    last = watches.files.lower_bound(rangeEnd);
+    for(std::set<QString>::const_iterator iter = first; iter != last; ++iter)
+        paths << *iter;
+    watches.files.erase(first, last);
+
+    if (!paths.isEmpty())
+        watches.watcher.removePaths(paths);
+}
+
+void DirectoryChangeWatcher::HandleDirectoryChange(NativeWatches &watches, const QString &dir, FileSnapshot &snapshot)
+{
+    // A directory that was deleted or moved away takes its files and subdirectories with it.
+    if (!QFileInfo(dir).isDir())
+    {
+        RemoveNativeWatches(watches, dir);
+        RescanDirectory(dir, true, snapshot);
+        return;
+    }
+
+    // A change in a directory means that an entry was created, deleted or renamed in it, so its files are rescanned.
+    RescanDirectory(dir, false, snapshot);
+
+    // Stop watching the files that are gone.
+    QStringList removedFiles;
+    std::set<QString>::iterator file = watches.files.lower_bound(dir);
+    const std::set<QString>::iterator filesEnd = watches.files.lower_bound(DirectoryRangeEnd(dir));
+    while(file != filesEnd)
+    {
+        if (IsInDirectory(*file, dir) && snapshot.find(*file) == snapshot.end())
+        {
+            removedFiles << *file;
+            watches.files.erase(file++);
+        }
+        else
+            ++file;
+    }
+    if (!removedFiles.isEmpty())
+        watches.watcher.removePaths(removedFiles);
+
+    if (recursive)
+    {
+        // The subdirectories that are gone take their files with them.
+        std::vector<QString> removedDirectories;
+        const std::set<QString>::const_iterator directoriesEnd = watches.directories.lower_bound(DirectoryRangeEnd(dir));
+        for(std::set<QString>::const_iterator iter = watches.directories.upper_bound(dir); iter != directoriesEnd; ++iter)
+            if (IsInDirectory(*iter, dir) && !QFileInfo(*iter).isDir())
+                removedDirectories.push_back(*iter);
+        for(size_t i = 0; i < removedDirectories.size(); ++i)
+        {
+            RemoveNativeWatches(watches, removedDirectories[i]);
+            RescanDirectory(removedDirectories[i], true, snapshot);
+        }
+
+        // The files of new subdirectories are reported created.
+        foreach(const QFileInfo &entry, QDir(QDir::cleanPath(dir)).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks))
+        {
+            const QString subdir = entry.absoluteFilePath() + "/";
+            if (!IsIgnored(subdir) && watches.directories.find(subdir) == watches.directories.end())
+            {
+                AddNativeWatches(watches, subdir, true);
+                RescanDirectory(subdir, true, snapshot);
+            }
+        }
+    }
+
+    // Watch the new files of the directory for modifications.
+    AddNativeWatches(watches, dir, false);
+}
+
+void DirectoryChangeWatcher::RescanFile(const QString &path, FileSnapshot &snapshot)
+{
+    const bool existed = (snapshot.find(path) != snapshot.end());
+    UpdateSnapshot(snapshot, path);
+    const bool exists = (snapshot.find(path) != snapshot.end());
+    // The file was reported changed, so it is reported modified even if its modification time and size happen to be the same.
+    if (exists)
+        AddEvent(path, existed ? FileModified : FileCreated);
+    else if (existed)
+        AddEvent(path, FileDeleted);
+}
+#endif
+
+void DirectoryChangeWatcher::Poll()
+{
+    FileSnapshot previous;
+    ScanDirectory(directory, true, previous);
+
+    while(!WaitForStop(pollInterval))
+    {
+        FileSnapshot current;
+        ScanDirectory(directory, true, current);
+        ReportDifferences(previous, current);
+        previous.swap(current);
+    }
+}
+
+void DirectoryChangeWatcher::ScanDirectory(const QString &dir, bool subdirectories, FileSnapshot &snapshot) const
+{
+    QDirIterator iter(QDir::cleanPath(dir), QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+        (subdirectories && recursive) ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+    while(iter.hasNext())
+    {
+        // Scanning a large tree takes a while, so stop early if the watcher is being destroyed.
+        if (IsStopping())
+            return;
+        const QString path = iter.next();
+        if (IsIgnored(path))
+            continue;
+        const QFileInfo info = iter.fileInfo();
+        snapshot[path] = std::make_pair(info.lastModified().toMSecsSinceEpoch(), info.size());
+    }
+}
+
+void DirectoryChangeWatcher::RescanDirectory(const QString &dir, bool subdirectories, FileSnapshot &snapshot)
+{
+    FileSnapshot current;
+    ScanDirectory(dir, subdirectories, current);
+
+    FileSnapshot previous;
+    FileSnapshot::iterator iter = snapshot.lower_bound(dir);
+    const FileSnapshot::iterator end = snapshot.lower_bound(DirectoryRangeEnd(dir));
+    while(iter != end)
+    {
+        if (subdirectories || IsInDirectory(iter->first, dir))
+        {
+            previous.insert(*iter);
+            snapshot.erase(iter++);
+        }
+        else
+            ++iter;
+    }
+
+    ReportDifferences(previous, current);
+    snapshot.insert(current.begin(), current.end());
+}
+
+void DirectoryChangeWatcher::UpdateSnapshot(FileSnapshot &snapshot, const QString &path)
+{
+    const QFileInfo info(path);
+    if (info.exists())
+        snapshot[path] = std::make_pair(info.lastModified().toMSecsSinceEpoch(), info.size());
+    else
+        snapshot.erase(path);
+}
+
+void DirectoryChangeWatcher::ReportDifferences(const FileSnapshot &previous, const FileSnapshot &current)
+{
+    // Both snapshots are sorted by path, so they can be compared in a single pass.
+    FileSnapshot::const_iterator prev = previous.begin();
+    FileSnapshot::const_iterator cur = current.begin();
+    while(prev != previous.end() || cur != current.end())
+    {
+        if (cur == current.end() || (prev != previous.end() && prev->first < cur->first))
+        {
+            AddEvent(prev->first, FileDeleted);
+            ++prev;
+        }
+        else if (prev == previous.end() || cur->first < prev->first)
+        {
+            AddEvent(cur->first, FileCreated);
+            ++cur;
+        }
+        else
+        {
+            if (prev->second != cur->second)
+                AddEvent(cur->first, FileModified);
+            ++prev;
+            ++cur;
+        }
+    }
+}
+
+bool DirectoryChangeWatcher::WaitForStop(int msecs)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    if (!stopping)
+        stopRequested.timed_wait(lock, boost::posix_time::milliseconds(msecs));
+    return stopping;
+}
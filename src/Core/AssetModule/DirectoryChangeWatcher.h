@@ -0,0 +1,181 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "HighPerfClock.h"
+
+#include <QObject>
+#include <QString>
+
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <map>
+#include <set>
+#include <vector>
+
+/// Watches a directory tree for file changes on a worker thread.
+/** On Linux the directory and its subdirectories are watched with inotify. On other platforms the directories and files are watched
+    with QFileSystemWatcher, and a change reported in a directory is resolved by rescanning the directory. When the native watches
+    cannot be used, f.ex. when inotify runs out of watches or the watched directory is moved away, or when polling is requested,
+    the directory tree is instead scanned at an interval and the modification times and sizes of the files are compared to the previous scan.
+
+    A snapshot of the modification times and sizes of the files is taken when the watches are set up, and kept up to date from the events.
+    If the inotify event queue overflows, the lost changes are found by rescanning the directory tree against the snapshot.
+    The files of a directory that is deleted or moved out of the watched tree are reported deleted.
+
+    The events of a file are coalesced into a single change: a file that is created and then written to is reported created once,
+    and a file that is created and deleted again is not reported at all. The changes are handed out only after the file has had
+    no events for a while, so that a file that is still being written, or a directory that is being checked out, is not reported
+    file by file as the writes happen.
+
+    Files in .git, .svn and .hg directories are ignored. Symbolic links are not followed. */
+class DirectoryChangeWatcher
+{
+public:
+    enum ChangeType
+    {
+        FileCreated,
+        FileModified,
+        FileDeleted
+    };
+
+    struct Change
+    {
+        QString path; ///< Absolute path of the file, with forward slashes.
+        ChangeType type;
+    };
+
+    /// Starts watching the directory on a worker thread.
+    /** @param recursive If true, the subdirectories are watched as well.
+        @param forcePolling If true, the directory is always polled, f.ex. for network file systems that do not deliver change notifications.
+        @param pollIntervalMsecs Time between the scans of the directory tree when polling. */
+    DirectoryChangeWatcher(const QString &directory, bool recursive, bool forcePolling, int pollIntervalMsecs = 2000);
+
+    /// Stops the worker thread. Changes that have not been taken are discarded.
+    ~DirectoryChangeWatcher();
+
+    /// Takes the changes of the files that have had no events for at least quietMsecs milliseconds, at most maxChanges of them, oldest first.
+    std::vector<Change> TakeChanges(int quietMsecs, size_t maxChanges);
+
+    /// Returns the number of files with changes that have not been taken yet.
+    size_t NumPendingChanges() const;
+
+    /// Returns true if the directory tree is polled instead of watched natively.
+    bool IsPolling() const;
+
+    /// Returns the reason the watcher had to fall back to polling, or stop watching, if it did so since the previous call. Otherwise returns an empty string.
+    /** Logging is not allowed on the worker thread, so the owner calls this on the main thread and logs the reason. */
+    QString TakeFallbackReason();
+
+    /// Returns true for paths inside version control directories.
+    static bool IsIgnored(const QString &path);
+
+private:
+    Q_DISABLE_COPY(DirectoryChangeWatcher)
+
+    /// The events of a file since its changes were last taken.
+    struct PendingChange
+    {
+        bool existedBefore; ///< True if the file existed before its first event.
+        bool exists; ///< True if the file exists after its latest event.
+        tick_t lastEvent; ///< Clock time of the latest event.
+    };
+    typedef std::map<QString, PendingChange> PendingChangeMap;
+
+    /// Modification time in msecs and size of each file, by absolute path.
+    typedef std::map<QString, std::pair<qint64, qint64> > FileSnapshot;
+
+    void ThreadMain();
+
+    /// Records an event of a file. Called on the worker thread.
+    void AddEvent(const QString &path, ChangeType type);
+
+    /// Switches to polling, and remembers the reason for the owner to log.
+    void FallBackToPolling(const QString &reason);
+
+    /// Returns true if the watcher is being stopped.
+    bool IsStopping() const;
+
+#ifdef Q_OS_LINUX
+    /// Watches the directory tree with inotify until the watcher is stopped.
+    /** @return False if inotify cannot be used and the watcher should fall back to polling. */
+    bool WatchWithInotify();
+
+    /// Adds an inotify watch for the directory and, if recursive, its subdirectories.
+    /** Returns early without an error if the watcher is being stopped.
+        @param newFiles If not null, the files that already exist in the directories are reported created and added to this snapshot.
+        This is used for new directories, whose files may have been created before the watch was added.
+        @return False if the watch limit was reached. */
+    bool AddInotifyWatches(int fd, const QString &dir, std::map<int, QString> &watches, FileSnapshot *newFiles);
+
+    /// Removes the inotify watches of the directory and its subdirectories, f.ex. when the directory is moved out of the watched tree.
+    void RemoveInotifyWatches(int fd, const QString &dir, std::map<int, QString> &watches);
+#else
+    /// The QFileSystemWatcher and the paths it watches. Lives on the worker thread.
+    struct NativeWatches;
+
+    /// Watches the directory tree with QFileSystemWatcher until the watcher is stopped.
+    /** @return False if the paths cannot all be watched and the watcher should fall back to polling. */
+    bool WatchWithFileSystemWatcher();
+
+    /// Watches the directory and its files, and if subdirectories is true and the watcher is recursive, its subdirectories. Paths that are already watched are skipped.
+    void AddNativeWatches(NativeWatches &watches, const QString &dir, bool subdirectories);
+
+    /// Stops watching the directory, and the files and directories below it.
+    void RemoveNativeWatches(NativeWatches &watches, const QString &dir);
+
+    /// Rescans a directory that QFileSystemWatcher reported changed, along with its new and removed subdirectories.
+    void HandleDirectoryChange(NativeWatches &watches, const QString &dir, FileSnapshot &snapshot);
+
+    /// Checks a file that QFileSystemWatcher reported changed against the snapshot, reports the change and updates the snapshot.
+    void RescanFile(const QString &path, FileSnapshot &snapshot);
+#endif
+
+    /// Polls the directory tree until the watcher is stopped.
+    void Poll();
+
+    /// Lists the files in the directory, and if subdirectories is true and the watcher is recursive, in its subdirectories.
+    void ScanDirectory(const QString &dir, bool subdirectories, FileSnapshot &snapshot) const;
+
+    /// Rescans the files of the directory, and if subdirectories is true, of its subdirectories, and reports the differences to the snapshot.
+    /** The files are replaced in the snapshot with the new scan. */
+    void RescanDirectory(const QString &dir, bool subdirectories, FileSnapshot &snapshot);
+
+    /// Updates the modification time and size of the file in the snapshot, or removes the file if it no longer exists.
+    static void UpdateSnapshot(FileSnapshot &snapshot, const QString &path);
+
+    /// Reports the files that were created, modified or deleted between the two snapshots.
+    void ReportDifferences(const FileSnapshot &previous, const FileSnapshot &current);
+
+    /// Waits until the watcher is stopped or the time has passed. Returns true if the watcher was stopped.
+    bool WaitForStop(int msecs);
+
+    const QString directory; ///< The watched directory, with forward slashes and a trailing slash.
+    const bool recursive;
+    const int pollInterval;
+
+    mutable boost::mutex mutex;
+    boost::condition_variable stopRequested;
+    bool stopping; ///< Set to stop the worker thread.
+    bool polling; ///< True if the directory tree is polled instead of watched natively.
+    QString fallbackReason; ///< The reason of the latest fallback, not yet taken by the owner.
+    PendingChangeMap pendingChanges;
+    boost::thread_group threads; ///< Holds the single worker thread.
+};
+
+/// Collects the paths QFileSystemWatcher reports changed, for DirectoryChangeWatcher to handle on its worker thread.
+class DirectoryChangeCollector : public QObject
+{
+    Q_OBJECT
+
+public:
+    std::set<QString> changedDirectories;
+    std::set<QString> changedFiles;
+
+public slots:
+    void OnDirectoryChanged(const QString &path) { changedDirectories.insert(path); }
+    void OnFileChanged(const QString &path) { changedFiles.insert(path); }
+};
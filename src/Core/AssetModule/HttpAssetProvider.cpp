@@ -18,6 +18,7 @@
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QLocale>
+#include <QFile>
 
 // Disable C4245 warning (signed/unsigned mismatch) coming from boost
 #ifdef _MSC_VER
@@ -31,9 +32,23 @@
 
 #include "MemoryLeakCheck.h"
 
+namespace
+{
+/// Returns the value of a non-negative integer command line parameter, or defaultValue if it is not given or is invalid.
+int IntParameter(Framework *fw, const QString &name, int defaultValue)
+{
+    QStringList values = fw->CommandLineParameters(name);
+    bool ok = false;
+    int value = values.size() > 0 ? values.last().toInt(&ok) : 0;
+    return (ok && value >= 0) ? value : defaultValue;
+}
+}
+
 HttpAssetProvider::HttpAssetProvider(Framework *framework_) :
     framework(framework_),
-    networkAccessManager(0)
+    networkAccessManager(0),
+    transferScheduler(IntParameter(framework_, "--httpMaxConnectionsPerHost", 6), IntParameter(framework_, "--httpMaxConnections", 24)),
+    freshnessTtl(IntParameter(framework_, "--httpCacheTtl", 0))
 {
     CreateAccessManager();
     connect(framework->App(), SIGNAL(ExitRequested()), SLOT(AboutToExit()));
@@ -152,18 +167,59 @@ QByteArray HttpAssetProvider::ToHttpDate(const QDateTime &dateTime)
     return QLocale::c().toString(dateTime, "ddd, dd MMM yyyy hh:mm:ss").toAscii() + QByteArray(" GMT");
 }
 
-#ifdef HTTPASSETPROVIDER_NO_HTTP_IF_MODIFIED_SINCE
+void HttpAssetProvider::Update(f64 frametime)
+{
+    // Completing the cached transfers is deferred from RequestAsset so that the requester has connected to the transfer signals.
+    std::vector<HttpAssetTransferPtr> completed;
+    completed.swap(cachedTransfers);
+    for(size_t i = 0; i < completed.size(); ++i)
+        framework->Asset()->AssetTransferCompleted(completed[i].get());
+
+    // The requests made during the frame are started here, so that the requesters have had the chance to set their priorities.
+    StartQueuedTransfers();
+}
 
-std::vector<HttpAssetTransferPtr> delayedTransfers;
+void HttpAssetProvider::StartQueuedTransfers()
+{
+    if (!networkAccessManager)
+        return;
 
-void HttpAssetProvider::Update(f64 frametime)
+    PROFILE(HttpAssetProvider_StartQueuedTransfers);
+    HttpTransferScheduler::Request next;
+    while(transferScheduler.TakeNext(next))
+    {
+        QNetworkReply *reply = networkAccessManager->get(next.request);
+        transfers[reply] = next.transfer;
+    }
+}
+
+bool HttpAssetProvider::RetryTransfer(const AssetTransferPtr &transfer)
 {
-    for(size_t i = 0; i < delayedTransfers.size(); ++i)
-        framework->Asset()->AssetTransferCompleted(delayedTransfers[i].get());
-    delayedTransfers.clear();
+    // A transfer is requested again only once, so that a reply that cannot be loaded does not cause a loop of requests.
+    HttpAssetTransferPtr httpTransfer = boost::dynamic_pointer_cast<HttpAssetTransfer>(transfer);
+    if (!httpTransfer || httpTransfer->retriedFromSource)
+        return false;
+    httpTransfer->retriedFromSource = true;
+    if (!networkAccessManager)
+        CreateAccessManager();
+
+    QString assetRefWithoutSubAssetName;
+    AssetAPI::ParseAssetRef(transfer->source.ref.trimmed(), 0, 0, 0, 0, 0, 0, 0, 0, 0, &assetRefWithoutSubAssetName);
+
+    // The request has no 'If-Modified-Since' header, as there is no usable cached copy, and the reply is cached again.
+    httpTransfer->rawAssetData.clear();
+    httpTransfer->SetCachingBehavior(true, "");
+    QNetworkRequest request;
+    request.setUrl(QUrl(assetRefWithoutSubAssetName));
+    request.setRawHeader("User-Agent", "realXtend Tundra");
+    transferScheduler.Enqueue(request, httpTransfer, httpTransfer->Priority());
+    return true;
 }
 
-#endif
+void HttpAssetProvider::SetTransferPriority(IAssetTransfer *transfer, float priority)
+{
+    transferScheduler.SetPriority(transfer, priority);
+}
 
 AssetTransferPtr HttpAssetProvider::RequestAsset(QString assetRef, QString assetType)
 {
@@ -205,21 +261,26 @@ AssetTransferPtr HttpAssetProvider::RequestAsset(QString assetRef, QString asset
 
     AssetCache *cache = framework->Asset()->GetAssetCache();
     QString filenameInCache = cache ? cache->FindInCache(assetRef) : QString();
+
+    // A cached copy that was downloaded or revalidated within the freshness TTL is used without asking the server whether it has changed.
+    bool useCachedCopy = false;
+    if (!filenameInCache.isEmpty() && freshnessTtl > 0)
+    {
+        QDateTime lastValidated = cache->LastValidated(assetRef);
+        qint64 age = lastValidated.isValid() ? QDateTime::currentMSecsSinceEpoch() - lastValidated.toMSecsSinceEpoch() : -1;
+        useCachedCopy = (age >= 0 && age < (qint64)freshnessTtl * 1000);
+    }
 #ifdef HTTPASSETPROVIDER_NO_HTTP_IF_MODIFIED_SINCE
     if (cache && framework->HasCommandLineParameter("--disable_http_ifmodifiedsince") && !filenameInCache.isEmpty())
-    {
-        PROFILE(HttpAssetProvider_ReadFileFromCache);
+        useCachedCopy = true;
+#endif
 
-        if (QFile::exists(filenameInCache))
-        {
-            transfer->SetCachingBehavior(false, filenameInCache);
-            delayedTransfers.push_back(transfer);
-        }
-        else
-            framework->Asset()->AssetTransferFailed(transfer.get(), "HttpAssetProvider: Failed to read file '" + filenameInCache + "' from cache!");
+    if (useCachedCopy)
+    {
+        transfer->SetCachingBehavior(false, filenameInCache);
+        cachedTransfers.push_back(transfer);
     }
     else
-#endif
     {
         QNetworkRequest request;
         request.setUrl(QUrl(assetRef));
@@ -227,13 +288,11 @@ AssetTransferPtr HttpAssetProvider::RequestAsset(QString assetRef, QString asset
     
         // Fill 'If-Modified-Since' header if we have a valid cache item.
         // Server can then reply with 304 Not Modified.
-        QDateTime cacheLastModified = framework->Asset()->GetAssetCache()->LastModified(assetRef);
-        if (cacheLastModified.isValid())
+        QDateTime cacheLastModified = cache ? cache->LastModified(assetRef) : QDateTime();
+        if (cacheLastModified.isValid() && !filenameInCache.isEmpty())
             request.setRawHeader("If-Modified-Since", ToHttpDate(cacheLastModified));
         
-        QNetworkReply *reply = networkAccessManager->get(request);
-
-        transfers[reply] = transfer;
+        transferScheduler.Enqueue(request, transfer, transfer->Priority());
     }
     return transfer;
 }
@@ -243,6 +302,18 @@ bool HttpAssetProvider::AbortTransfer(IAssetTransfer *transfer)
     if (!transfer)
         return false;
 
+    // Transfers that have not been started only need to be removed from the queue.
+    std::vector<HttpAssetTransferPtr>::iterator cached = cachedTransfers.begin();
+    while(cached != cachedTransfers.end() && cached->get() != transfer)
+        ++cached;
+    if (transferScheduler.Remove(transfer) || cached != cachedTransfers.end())
+    {
+        if (cached != cachedTransfers.end())
+            cachedTransfers.erase(cached);
+        transfer->EmitAssetFailed("Transfer aborted.");
+        return true;
+    }
+
     for (TransferMap::iterator iter = transfers.begin(); iter != transfers.end(); ++iter)
     {
         AssetTransferPtr ongoingTransfer = iter->second;
@@ -378,6 +449,10 @@ void HttpAssetProvider::OnHttpTransferFinished(QNetworkReply *reply)
     {
     case QNetworkAccessManager::GetOperation:
     {
+        // A request slot to the host was freed, start the next queued transfer right away.
+        transferScheduler.Finished(reply->request().url());
+        StartQueuedTransfers();
+
         // If the transfer is not in our transfers map it was aborted via AbortTransfer.
         TransferMap::iterator iter = transfers.find(reply);
         if (iter == transfers.end())
@@ -400,7 +475,9 @@ void HttpAssetProvider::OnHttpTransferFinished(QNetworkReply *reply)
             if (replyCode == 304)
             {
                 // Read cache file to transfer asset data
-                if (cache->FindInCache(sourceRef).isEmpty())
+                if (!cache->FindInCache(sourceRef).isEmpty())
+                    cache->SetValidated(sourceRef);
+                else
                     error = "Http GET for address \"" + reply->url().toString() + "\" returned '304 Not Modified' but existing cache file could not be opened: \"" + cache->GetDiskSourceByRef(sourceRef) + "\"";
             }
             // 200 OK
@@ -8,6 +8,7 @@
 #include "AssetFwd.h"
 #include "HttpAssetTransfer.h"
 #include "HttpAssetStorage.h"
+#include "HttpTransferScheduler.h"
 
 #include <QDateTime>
 #include <QByteArray>
@@ -24,6 +25,9 @@ typedef boost::shared_ptr<HttpAssetStorage> HttpAssetStoragePtr;
 // #define HTTPASSETPROVIDER_NO_HTTP_IF_MODIFIED_SINCE
 
 /// Adds support for downloading assets over the web using the 'http://' specifier.
+/** Asset requests are queued in a HttpTransferScheduler, which starts them in priority order with a limited number of requests
+    in flight per host (--httpMaxConnectionsPerHost) and in total (--httpMaxConnections). A cached asset that was downloaded or
+    revalidated within the freshness TTL (--httpCacheTtl) is loaded from the cache without an If-Modified-Since request. */
 class ASSET_MODULE_API HttpAssetProvider : public QObject, public IAssetProvider, public boost::enable_shared_from_this<HttpAssetProvider>
 {
     Q_OBJECT
@@ -45,6 +49,15 @@ public:
 
     /// Aborts the ongoing http transfer.
     virtual bool AbortTransfer(IAssetTransfer *transfer);
+
+    /// Requests the asset of a transfer from the server again, without using the cached copy.
+    virtual bool RetryTransfer(const AssetTransferPtr &transfer);
+
+    /// Changes the priority of a queued http transfer.
+    virtual void SetTransferPriority(IAssetTransfer *transfer, float priority);
+
+    /// Starts queued transfers and completes the transfers that were fulfilled from the asset cache.
+    virtual void Update(f64 frametime);
     
     /// Adds the given http URL to the list of current asset storages.
     /// Returns the newly created storage, or 0 if a storage with the given name already existed, or if some other error occurred.
@@ -83,10 +96,6 @@ public:
     /// Constructs a QByteArray from QDateTime. Returns value as Sun, 06 Nov 1994 08:49:37 GMT - RFC 822.
     QByteArray ToHttpDate(const QDateTime &dateTime);
 
-#ifdef HTTPASSETPROVIDER_NO_HTTP_IF_MODIFIED_SINCE
-    virtual void Update(f64 frametime);
-#endif
-
 private slots:
     void AboutToExit();
     void OnHttpTransferFinished(QNetworkReply *reply);
@@ -97,6 +106,9 @@ private:
     /// Creates our QNetworkAccessManager
     void CreateAccessManager();
 
+    /// Starts as many queued transfers as the scheduler allows.
+    void StartQueuedTransfers();
+
     /// Add assetref to http storage(s) after successful upload or discovery
     void AddAssetRefToStorages(const QString& ref);
 
@@ -114,6 +126,15 @@ private:
     typedef std::map<QNetworkReply*, HttpAssetTransferPtr> TransferMap;
     TransferMap transfers;
 
+    /// Asset requests that have not been started yet.
+    HttpTransferScheduler transferScheduler;
+
+    /// Transfers fulfilled from the asset cache without a http request. They are completed on the next Update.
+    std::vector<HttpAssetTransferPtr> cachedTransfers;
+
+    /// Cached assets validated within this many seconds are not revalidated from the server. 0 always revalidates.
+    int freshnessTtl;
+
     /// Maps each Qt Http upload transfer we start to Asset API internal HttpAssetTransfer struct.
     typedef std::map<QNetworkReply*, AssetUploadTransferPtr> UploadTransferMap;
     UploadTransferMap uploadTransfers;
@@ -10,7 +10,10 @@ class HttpAssetTransfer : public IAssetTransfer
 Q_OBJECT
 
 public:
+    HttpAssetTransfer() : retriedFromSource(false) {}
 
+    /// True if the asset was requested from the server again because its cached copy could not be loaded.
+    bool retriedFromSource;
 };
 
 typedef boost::shared_ptr<HttpAssetTransfer> HttpAssetTransferPtr;
@@ -0,0 +1,110 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "HttpTransferScheduler.h"
+
+#include <QUrl>
+
+#include <algorithm>
+
+#include "MemoryLeakCheck.h"
+
+HttpTransferScheduler::HttpTransferScheduler(int maxPerHost_, int maxTotal_) :
+    nextSequence(0),
+    maxPerHost(std::max(maxPerHost_, 1)),
+    maxTotal(std::max(maxTotal_, 1)),
+    numInFlight(0)
+{
+}
+
+QString HttpTransferScheduler::HostKey(const QUrl &url)
+{
+    return url.scheme().toLower() + "://" + url.host().toLower() + ":" + QString::number(url.port());
+}
+
+void HttpTransferScheduler::Enqueue(const QNetworkRequest &request, const HttpAssetTransferPtr &transfer, float priority)
+{
+    Remove(transfer.get());
+
+    const QString host = HostKey(request.url());
+    const QueueKey key(priority, nextSequence++);
+    Request &queuedRequest = hosts[host].queue[key];
+    queuedRequest.request = request;
+    queuedRequest.transfer = transfer;
+    queued[transfer.get()] = std::make_pair(host, key);
+}
+
+bool HttpTransferScheduler::SetPriority(IAssetTransfer *transfer, float priority)
+{
+    std::map<IAssetTransfer*, std::pair<QString, QueueKey> >::iterator iter = queued.find(transfer);
+    if (iter == queued.end())
+        return false;
+    if (iter->second.second.first == priority)
+        return true;
+
+    // Keep the original sequence number, so that the request keeps its place among the requests of its new priority.
+    RequestQueue &queue = hosts[iter->second.first].queue;
+    RequestQueue::iterator requestIter = queue.find(iter->second.second);
+    Request request = requestIter->second;
+    queue.erase(requestIter);
+    const QueueKey key(priority, iter->second.second.second);
+    queue[key] = request;
+    iter->second.second = key;
+    return true;
+}
+
+bool HttpTransferScheduler::Remove(IAssetTransfer *transfer)
+{
+    std::map<IAssetTransfer*, std::pair<QString, QueueKey> >::iterator iter = queued.find(transfer);
+    if (iter == queued.end())
+        return false;
+
+    HostMap::iterator host = hosts.find(iter->second.first);
+    host->second.queue.erase(iter->second.second);
+    if (host->second.queue.empty() && host->second.numInFlight == 0)
+        hosts.erase(host);
+    queued.erase(iter);
+    return true;
+}
+
+bool HttpTransferScheduler::TakeNext(Request &request)
+{
+    if (numInFlight >= maxTotal)
+        return false;
+
+    // The number of distinct hosts is small, so a linear search for the best request among the hosts with free slots is cheap.
+    HostMap::iterator best = hosts.end();
+    QueueOrder order;
+    for(HostMap::iterator iter = hosts.begin(); iter != hosts.end(); ++iter)
+    {
+        Host &host = iter->second;
+        if (host.queue.empty() || host.numInFlight >= maxPerHost)
+            continue;
+        if (best == hosts.end() || order(host.queue.begin()->first, best->second.queue.begin()->first))
+            best = iter;
+    }
+    if (best == hosts.end())
+        return false;
+
+    RequestQueue::iterator front = best->second.queue.begin();
+    request = front->second;
+    best->second.queue.erase(front);
+    queued.erase(request.transfer.get());
+    ++best->second.numInFlight;
+    ++numInFlight;
+    return true;
+}
+
+void HttpTransferScheduler::Finished(const QUrl &url)
+{
+    HostMap::iterator host = hosts.find(HostKey(url));
+    if (host == hosts.end() || host->second.numInFlight <= 0)
+        return;
+
+    --host->second.numInFlight;
+    --numInFlight;
+    if (host->second.queue.empty() && host->second.numInFlight == 0)
+        hosts.erase(host);
+}
@@ -0,0 +1,89 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include "AssetModuleApi.h"
+#include "HttpAssetTransfer.h"
+
+#include <QNetworkRequest>
+#include <QString>
+
+#include <map>
+#include <utility>
+
+class QUrl;
+
+/// Orders pending HTTP asset requests by priority and limits the number of requests in flight, in total and per host.
+/** The scheduler does not touch the network itself. HttpAssetProvider enqueues its requests here, starts the requests
+    returned by TakeNext, and reports each finished request with Finished. Requests of equal priority are started in the
+    order they were enqueued. */
+class ASSET_MODULE_API HttpTransferScheduler
+{
+public:
+    /// A request waiting to be started.
+    struct Request
+    {
+        QNetworkRequest request;
+        HttpAssetTransferPtr transfer;
+    };
+
+    /// @param maxPerHost Maximum number of requests in flight to a single host.
+    /// @param maxTotal Maximum number of requests in flight in total.
+    HttpTransferScheduler(int maxPerHost, int maxTotal);
+
+    /// Adds a request to the queue of its host.
+    /// @param priority Requests with higher priority are started first, f.ex. the negated distance of the requesting object to the camera.
+    void Enqueue(const QNetworkRequest &request, const HttpAssetTransferPtr &transfer, float priority);
+
+    /// Changes the priority of a queued request.
+    /// @return False if the transfer is not queued, f.ex. because it was already started.
+    bool SetPriority(IAssetTransfer *transfer, float priority);
+
+    /// Removes a queued request.
+    /// @return False if the transfer is not queued.
+    bool Remove(IAssetTransfer *transfer);
+
+    /// Returns true if the transfer is queued and not yet started.
+    bool IsQueued(IAssetTransfer *transfer) const { return queued.find(transfer) != queued.end(); }
+
+    /// Takes the highest priority request that can be started without exceeding the limits, and counts it as being in flight.
+    /// @return False if no request can be started now.
+    bool TakeNext(Request &request);
+
+    /// Marks a request to the given URL, previously returned by TakeNext, as finished.
+    void Finished(const QUrl &url);
+
+    /// Returns the number of requests waiting to be started.
+    size_t NumQueued() const { return queued.size(); }
+
+    /// Returns the number of requests in flight.
+    int NumInFlight() const { return numInFlight; }
+
+private:
+    /// Queue order: highest priority first, and oldest first within the same priority.
+    typedef std::pair<float, unsigned long long> QueueKey;
+    struct QueueOrder
+    {
+        bool operator()(const QueueKey &a, const QueueKey &b) const { return a.first > b.first || (a.first == b.first && a.second < b.second); }
+    };
+    typedef std::map<QueueKey, Request, QueueOrder> RequestQueue;
+
+    /// Queued and in flight requests of a single host.
+    struct Host
+    {
+        Host() : numInFlight(0) {}
+        RequestQueue queue;
+        int numInFlight;
+    };
+    typedef std::map<QString, Host> HostMap;
+
+    /// Returns the key that identifies the host of the given URL, consisting of the scheme, host name and port.
+    static QString HostKey(const QUrl &url);
+
+    HostMap hosts;
+    std::map<IAssetTransfer*, std::pair<QString, QueueKey> > queued;
+    unsigned long long nextSequence;
+    int maxPerHost;
+    int maxTotal;
+    int numInFlight;
+};
@@ -6,6 +6,7 @@
 #include "Win.h"
 #include "LocalAssetProvider.h"
 #include "LocalAssetStorage.h"
+#include "DirectoryChangeWatcher.h"
 #include "AssetModule.h"
 #include "IAssetUploadTransfer.h"
 #include "IAssetTransfer.h"
@@ -23,15 +24,16 @@
 #include <QByteArray>
 #include <QFile>
 #include <QFileInfo>
-#include <QFileSystemWatcher>
 #include <QMap>
 
 #include "MemoryLeakCheck.h"
 
 LocalAssetProvider::LocalAssetProvider(Framework* framework_)
-:framework(framework_)
+:framework(framework_),
+nextStorageToCheck(0)
 {
     enableRequestsOutsideStorages = framework_->HasCommandLineParameter("--accept_unknown_local_sources");
+    pollFileChanges = framework_->HasCommandLineParameter("--pollFileChanges");
 }
 
 LocalAssetProvider::~LocalAssetProvider()
@@ -241,9 +243,7 @@ LocalAssetStoragePtr LocalAssetProvider::AddStorageDirectory(QString directory,
     storage->name = storageName;
     storage->recursive = recursive;
     storage->provider = shared_from_this();
-    storage->SetupWatcher(); // Start listening on file change notifications. Note: it's important that recursive is set before calling this!
-    connect(storage->changeWatcher, SIGNAL(directoryChanged(const QString&)), SLOT(OnDirectoryChanged(const QString &)), Qt::UniqueConnection);
-    connect(storage->changeWatcher, SIGNAL(fileChanged(const QString &)), SLOT(OnFileChanged(const QString &)), Qt::UniqueConnection);
+    storage->SetupWatcher(pollFileChanges); // Start listening on file change notifications. Note: it's important that recursive is set before calling this!
     storages.push_back(storage);
 
     // Tell the Asset API that we have created a new storage.
@@ -342,23 +342,14 @@ void LocalAssetProvider::CompletePendingFileDownloads()
         }
         QString absoluteFilename = file.absoluteFilePath();
 
-        bool success = LoadFileToVector(absoluteFilename, transfer->rawAssetData);
-        if (!success)
-        {
-            QString reason = "Failed to read asset data for asset \"" + ref + "\" from file \"" + absoluteFilename + "\"";
-//            AssetModule::LogError(reason);
-            framework->Asset()->AssetTransferFailed(transfer.get(), reason);
-            continue;
-        }
-        
         // Tell the Asset API that this asset should not be cached into the asset cache, and instead the original filename should be used
         // as a disk source, rather than generating a cache file for it.
         transfer->SetCachingBehavior(false, absoluteFilename);
 
         transfer->storage = storage;
 
-        // Signal the Asset API that this asset is now successfully downloaded.
-        framework->Asset()->AssetTransferCompleted(transfer.get());
+        // Have the Asset API read the file, on the asset load threads if they are enabled, and then signal that this asset is now successfully downloaded.
+        framework->Asset()->CompleteTransferFromFile(transfer, absoluteFilename);
 
         // Throttle asset loading to at most 16 msecs/frame.
         const int maxLoadMSecs = 16;
@@ -504,243 +495,46 @@ void LocalAssetProvider::CompletePendingFileUploads()
 void LocalAssetProvider::CheckForPendingFileSystemChanges()
 {
     PROFILE(LocalAssetProvider_CheckForPendingFileSystemChanges);
-    QStringList files = changedFiles.toList();
-    while(!files.isEmpty())
-    {
-        QString file = files.front();
-        files.pop_front();
-
-//        // If some watched file is changed, so is watched directory. Remove the directory from 
-//        // changedDirectories so we can ignore it later on when checking directory changes.
-//        
-//        QString dir = QFileInfo(file).dir().path();
-//        if (qFind(changedDirectories, dir) != changedDirectories.end())
-//        {
-//            LogInfo("REMOVING " + dir + "FROM changedDirectories");
-//            changedDirectories.removeOne(dir);
-//        }
-//        
-        LocalAssetStoragePtr storage = FindStorageForPath(file);
-        if (storage)
-        {
-            if (!storage->AutoDiscoverable())
-            {
-                LogWarning("Received file change notification for storage of which auto-discovery is false.");
-                continue;
-            }
 
-            assert(storage->changeWatcher);
-            QString assetRef = file;
-            int lastSlash = assetRef.lastIndexOf('/');
-            if (lastSlash != -1)
-                assetRef = assetRef.right(assetRef.length() - lastSlash - 1);
-            assetRef.prepend("local://");
+    // The changes of a file are taken only after it has been quiet for a while, and at most a limited number of them per frame,
+    // so that f.ex. a version control checkout is not reloaded file by file as it is written, or thousands of assets in a single frame.
+    const int cFileChangeDelayMsecs = 300;
+    const size_t cMaxFileChangesPerFrame = 32;
 
-            // Note: if file was removed, it's removed automatically from tracked files of QFileSystemWatcher.
-            const QStringList watchedFiles = storage->changeWatcher->files();
-            if (qFind(watchedFiles, file) == watchedFiles.end() && !QFile::exists(file))
-            {
-                // Tracked file was not found from the list of tracked files and it doesn't exist so 
-                // it must be deleted (info about new files is retrieved by directoryChanged signal).
-                LogInfo("File " + file + " not found from watch list. So it must be deleted.");
-                storage->EmitAssetChanged(file, IAssetStorage::AssetDelete);
-            }
-            else
-            {
-                // File was tracked and found from watched files: must've been modified.
-                LogInfo("File " + file + " found from watch list so it must be modified. Asset ref: " + assetRef);
-                storage->EmitAssetChanged(file, IAssetStorage::AssetModify);
-            }
-        }
-        else
-        {
-            LogError("LocalAssetProvider::CheckForPendingFileSystemChanges: Could not find storage for file " + file);
-        }
-    }
-
-    QStringList dirs = changedDirectories.toList();
-    while(!dirs.isEmpty())
+    size_t numChanges = 0;
+    for(size_t i = 0; i < storages.size() && numChanges < cMaxFileChangesPerFrame; ++i)
     {
-        QString path = dirs.front();
-        dirs.pop_front();
-        LocalAssetStoragePtr storage = FindStorageForPath(path);
-        if (storage)
-        {
-            if (!storage->AutoDiscoverable())
-            {
-                LogWarning("Received directory change notification for storage of which auto-discovery is false.");
-                continue;
-            }
+        // Start from a different storage each frame, so that a storage with a constant stream of changes cannot starve the others.
+        LocalAssetStoragePtr storage = storages[(nextStorageToCheck + i) % storages.size()];
+        if (!storage->changeWatcher)
+            continue;
 
-            assert(storage->changeWatcher);
-            const QStringList watchedDirs = storage->changeWatcher->directories();
-            if (qFind(watchedDirs, path) != watchedDirs.end())
-            {
-                //LogError("CheckForPendingFileSystemChanges: " + path + " was on the watch list.");
-                // Remove path from watch list in case the directory was removed.
-                // We'll add it back anyways in case of this change was addition of new directory.
-                // Remove the path only if it's not the root directory of the storage
-                //if (!QString(path + "/").compare(QDir::fromNativeSeparators(storage->directory), Qt::CaseInsensitive) != 0)
-                //{
-                    //LogInfo("LocalAssetProvider: Directory " + path + " was on the watch list, removing it by default always.");
-                   // storage->changeWatcher->removePath(path);
-                //}
-/*
-                if (!QDir(path).exists()) // 1: Was directory deleted?
-                {
-                    LogDebug("Directory " + path + " removed.");
-                    QStringList subdirs = DirectorySearch(path, true, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
-                    if (!subdirs.isEmpty())
-                    {
-                        LogInfo("Directory " + path + " was removed. Removing all of its subdirs too:\n" + subdirs.join("\n"));
-                        storage->changeWatcher->removePaths(subdirs);
-                    }
-                    // Add parent dir back to watch list.
-                    if (!watchedDirs.contains(path), Qt::CaseInsensitive)
-                        storage->changeWatcher->addPath(path);
-                }
-                else // 2: Was new directory added, an existing one renamed, or something else?
-*/
-                {
-                    // Was new file added?
-                    QStringList oldFiles, currentFiles;
-                    currentFiles = DirectorySearch(path, false, QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
-                    const QStringList watchedFiles = storage->changeWatcher->files();
-                    foreach(const QString &file, watchedFiles)
-                        if (GuaranteeTrailingSlash(path) == GuaranteeTrailingSlash(QFileInfo(file).dir().path()))
-                            oldFiles.append(file);
-
-                    if (currentFiles.size() > oldFiles.size())
-                    {
-                        LogDebug("NumOldFiles for " + path + " " + QString::number(oldFiles.size()) + " NumCurFiles: " + QString::number(currentFiles.size()));
-                        LogDebug("Conclusion: new file added.");
-                        foreach(const QString &file, currentFiles)
-                        {
-                            QStringList::const_iterator it = qFind(oldFiles, file);
-                            if (it == oldFiles.end())
-                            {
-                                LogInfo("New file " + file + " added to storage " + storage->ToString());
-                                storage->changeWatcher->addPath(file);
-                                storage->EmitAssetChanged(file, IAssetStorage::AssetCreate);
-                                break;
-                            }
-                    }
-                    //else if(if (currentFiles.size() > oldFiles.size())
-                    //{
-                    //}
-/*
-                    // Check out the path's subdir count. Find all old watched dirs and replace them with the new dirs.
-                    QStringList curSubdirs = DirectorySearch(path, true, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
-                    QStringList oldSubdirs;
-                    foreach(const QString &dir, watchedDirs)
-                        if (dir.contains(path, Qt::CaseInsensitive) && dir.compare(path, Qt::CaseInsensitive) != 0)
-                            oldSubdirs << dir;
-
-                    LogWarning("CURRENT DIRS " + curSubdirs.join("\n"));
-                    LogWarning("OLD DIRS " + oldSubdirs.join("\n"));
-                    LogInfo("NumOldSubdirs for " + path + ": " + QString::number(oldSubdirs.size()) + ", NumCurDirs: " + QString::number(curSubdirs.size()));
-                    if (!oldSubdirs.isEmpty() && !curSubdirs.isEmpty() && oldSubdirs.size() == curSubdirs.size())
-                    {
-                        // Folder rename occurred. Remove all subdirs and add them back.
-                        LogError("SOME FOLDER WAS RENAMED");
-                        LogInfo("Removing\n" + oldSubdirs.join("\n"));
-
-                        storage->changeWatcher->removePaths(oldSubdirs);
-
-                        LogInfo("Adding\n" + curSubdirs.join("\n"));
-                        foreach(const QString &d, curSubdirs) // for some odd reason addPaths() fails, so have to call addPath() for individual paths instead.
-                            if (!watchedDirs.contains(d), Qt::CaseInsensitive)
-                                storage->changeWatcher->addPath(d);
-
-                        // Add parent dir back to watch list.
-                        if (!watchedDirs.contains(path), Qt::CaseInsensitive)
-                            storage->changeWatcher->addPath(path);
-                    }
-                    else if (oldSubdirs.size() != curSubdirs.size())
-                    {
-                        LogError("NEW DIRECTORY");
-                        LogInfo("New directory added to " + path);
-                        //LogInfo("Directory structure changed: number of old subdirs for " + path + " " + QString::number(oldSubdirs.size()) +
-                        //    ", number of current dirs " + QString::number(curSubdirs.size()));
-                        LogInfo("This means we got a new directory to watch.");
-                        if (!oldSubdirs.isEmpty())
-                        {
-                            LogInfo("Removing oldSubdirs:\n" + oldSubdirs.join("\n"));
-                            storage->changeWatcher->removePaths(oldSubdirs);
-                        }
-                        if (!curSubdirs.isEmpty())
-                        {
-                            LogInfo("Adding curSubdirs:\n" + curSubdirs.join("\n"));
-                            foreach(const QString &d, curSubdirs) // for some odd reason addPaths() fails, so have to call addPath() for individual paths instead.
-                                if (!watchedDirs.contains(d), Qt::CaseInsensitive)
-                                    storage->changeWatcher->addPath(d);
-                        }
-
-                        QString newDir = curSubdirs.size() == 1 ? curSubdirs.first() : "";
-                        foreach(const QString &curSubdir, curSubdirs)
-                            if (qFind(oldSubdirs, curSubdir) == oldSubdirs.end())
-                            {
-                                newDir = curSubdir;
-                                LogInfo("New dir's name is : " + newDir);
-                                if (storage->recursive)
-                                {
-                                    QStringList pathsToAdd = DirectorySearch(newDir, true, QDir::Files |QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
-                                    if (!pathsToAdd.isEmpty())
-                                    {
-                                        LogInfo("Adding paths to watch list: " + pathsToAdd.join("\n"));
-                                        LogInfo("******before " + QString::number(storage->changeWatcher->files().count()));
-                                        storage->changeWatcher->addPaths(pathsToAdd);
-                                        LogInfo("******after " + QString::number(storage->changeWatcher->files().count()));
-                                    }
-                                }
-                            }
-
-                        // Add parent dir back to watch list.
-                        if (!watchedDirs.contains(path), Qt::CaseInsensitive)
-                            storage->changeWatcher->addPath(path);
-                    }
-                    else
-                    {
-                        // We end up here after:
-                        // -removing subdir of a watched dir we get change notification for the watcher dir,
-                        // -Addition of new file to watched dir
-                        LogError("DIDN'T KNOW WHAT TO DO WITH CHANGED DIR");
-                        if (!watchedDirs.contains(path), Qt::CaseInsensitive)
-                            storage->changeWatcher->addPath(path);
-
-                        QStringList pathsToAdd = DirectorySearch(path, false, QDir::Files);
-                        if (!pathsToAdd.isEmpty())
-                        {
-                            LogInfo("Adding paths to watch list: " + pathsToAdd.join("\n"));
-                            foreach(const QString &p, pathsToAdd) // for some odd reason addPaths() fails, so have to call addPath() for individual paths instead.
-                                storage->changeWatcher->addPath(p);
-                        }
-*/
-                    }
-                }
+        QString fallbackReason = storage->changeWatcher->TakeFallbackReason();
+        if (!fallbackReason.isEmpty())
+            LogWarning("LocalAssetProvider: " + fallbackReason + " Polling storage " + storage->ToString() + " for changes instead.");
 
-                //LogInfo("Refreshing storage \"" + storage->Name() + "\".");
-                //storage->RefreshAssetRefs();
-            }
-        }
-        else
+        std::vector<DirectoryChangeWatcher::Change> changes = storage->changeWatcher->TakeChanges(cFileChangeDelayMsecs, cMaxFileChangesPerFrame - numChanges);
+        numChanges += changes.size();
+        for(size_t j = 0; j < changes.size(); ++j)
         {
-            LogError("LocalAssetProvider::CheckForPendingFileSystemChanges: Could not find storage for directory " + path);
+            const DirectoryChangeWatcher::Change &change = changes[j];
+            switch(change.type)
+            {
+            case DirectoryChangeWatcher::FileCreated:
+                LogInfo("New file " + change.path + " added to storage " + storage->ToString());
+                storage->EmitAssetChanged(change.path, IAssetStorage::AssetCreate);
+                break;
+            case DirectoryChangeWatcher::FileModified:
+                LogInfo("File " + change.path + " in storage " + storage->ToString() + " modified.");
+                storage->EmitAssetChanged(change.path, IAssetStorage::AssetModify);
+                break;
+            case DirectoryChangeWatcher::FileDeleted:
+                LogInfo("File " + change.path + " deleted from storage " + storage->ToString());
+                storage->EmitAssetChanged(change.path, IAssetStorage::AssetDelete);
+                break;
+            }
         }
     }
-
-    changedFiles.clear();
-    changedDirectories.clear();
-}
-
-void LocalAssetProvider::OnFileChanged(const QString &path)
-{
-    LogDebug("LocalAssetProvider: File " + path + " changed.");
-    changedFiles << path;
-}
-
-void LocalAssetProvider::OnDirectoryChanged(const QString &path)
-{
-    LogDebug("LocalAssetProvider: Directory " + path + " changed.");
-    changedDirectories << path;
+    if (!storages.empty())
+        nextStorageToCheck = (nextStorageToCheck + 1) % storages.size();
 }
@@ -7,8 +7,6 @@
 #include "IAssetProvider.h"
 #include "AssetFwd.h"
 
-#include <QSet>
-
 class LocalAssetStorage;
 
 typedef boost::shared_ptr<LocalAssetStorage> LocalAssetStoragePtr;
@@ -84,20 +82,18 @@ private:
     /// Takes all the pending file upload transfers and finishes them.
     void CompletePendingFileUploads();
 
-    /// Checks for pending file systems changes and updates 
+    /// Emits the file changes that the storages' watchers have detected as asset changes.
     void CheckForPendingFileSystemChanges();
 
     Framework *framework;
     std::vector<LocalAssetStoragePtr> storages; ///< Asset directories to search, may be recursive or not
     std::vector<AssetUploadTransferPtr> pendingUploads; ///< The following asset uploads are pending to be completed by this provider.
     std::vector<AssetTransferPtr> pendingDownloads; ///< The following asset downloads are pending to be completed by this provider.
-    QSet<QString> changedFiles; ///< Pending file changes.
-    QSet<QString> changedDirectories; ///< Pending directory changes.
+    size_t nextStorageToCheck; ///< Index of the storage whose file changes are taken first on the next frame.
 
     /// If true, assets outside any known local storages are allowed. Otherwise, requests to them will fail.
     bool enableRequestsOutsideStorages;
 
-private slots:
-    void OnFileChanged(const QString &path);
-    void OnDirectoryChanged(const QString &path);
+    /// If true, the storage directories are polled for changes even if they could be watched natively.
+    bool pollFileChanges;
 };
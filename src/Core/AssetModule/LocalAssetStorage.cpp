@@ -5,11 +5,11 @@
 
 #include "LocalAssetStorage.h"
 #include "LocalAssetProvider.h"
+#include "DirectoryChangeWatcher.h"
 #include "AssetAPI.h"
 #include "QtUtils.h"
 #include "Profiler.h"
 
-#include <QFileSystemWatcher>
 #include <QDir>
 #include <utility>
 
@@ -147,26 +147,19 @@ void LocalAssetStorage::EmitAssetChanged(QString absoluteFilename, IAssetStorage
     emit AssetChanged(localName, absoluteFilename, change);
 }
 
-void LocalAssetStorage::SetupWatcher()
+void LocalAssetStorage::SetupWatcher(bool forcePolling)
 {
     if (changeWatcher) // Remove the old watcher if one exists.
         RemoveWatcher();
 
-    changeWatcher = new QFileSystemWatcher();
+    // File changes are only acted on for auto-discoverable storages, so there is no need to watch the others.
+    if (!AutoDiscoverable())
+        return;
 
-    // Add directory contents to watch list.
-    if (recursive) // Make a visible log message - we may hang here for several seconds, since this step involves recursive iteration.
-        LogInfo("LocalAssetStorage::SetupWatcher: recursively adding " + directory + " to file change notification watcher. This may take a while.");
-    else
-        LogDebug("LocalAssetStorage::SetupWatcher: adding " + directory + " recursive=" + BoolToString(recursive));
-
-    QStringList paths = DirectorySearch(directory, recursive, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
-#ifndef Q_WS_MAC
-    changeWatcher->addPath(QDir::fromNativeSeparators(directory));
-    changeWatcher->addPaths(paths);
-#endif
-
-    LogDebug("Total of " + QString::number(paths.count()) + " dirs and files added to watch list.");
+    // The directory tree is walked on the watcher thread, so this does not block even for large storages.
+    changeWatcher = new DirectoryChangeWatcher(directory, recursive, forcePolling);
+    LogDebug("LocalAssetStorage::SetupWatcher: watching " + directory + " recursive=" + BoolToString(recursive) +
+        (changeWatcher->IsPolling() ? " by polling." : " natively."));
 }
 
 void LocalAssetStorage::RemoveWatcher()
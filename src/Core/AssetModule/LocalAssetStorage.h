@@ -8,7 +8,7 @@
 
 #include <QMap>
 
-class QFileSystemWatcher;
+class DirectoryChangeWatcher;
 class AssetAPI;
 
 /// Represents a single (possibly recursive) directory on the local file system.
@@ -31,7 +31,8 @@ public:
     bool recursive;
     
     /// Starts listening on the local directory this asset storage points to.
-    void SetupWatcher();
+    /** @param forcePolling If true, the directory is polled for changes even if it could be watched natively. */
+    void SetupWatcher(bool forcePolling = false);
 
     /// Stops and deallocates the directory change listener.
     void RemoveWatcher();
@@ -42,7 +43,8 @@ public:
     ///\todo Evaluate if could be removed. Now both AssetAPI and LocalAssetStorage manage list of asset refs.
     QStringList assetRefs;
 
-    QFileSystemWatcher *changeWatcher;
+    /// Watches the storage directory for file changes on a worker thread. Null if the storage is not auto-discoverable.
+    DirectoryChangeWatcher *changeWatcher;
 
 public slots:
     /// Local storages are always trusted.
@@ -19,6 +19,16 @@
 #include <alc.h>
 #endif
 
+namespace
+{
+/// PCM data of an audio asset, decoded on an asset load thread.
+class AudioDecodeData : public IAssetDecodeData
+{
+public:
+    SoundBuffer buffer;
+};
+}
+
 AudioAsset::AudioAsset(AssetAPI *owner, const QString &type_, const QString &name_)
 :IAsset(owner, type_, name_), handle(0)
 {
@@ -59,6 +69,30 @@ bool AudioAsset::DeserializeFromData(const u8 *data, size_t numBytes, bool allow
     return loadResult;
 }
 
+AssetDecodeDataPtr AudioAsset::DecodeData(const u8 *data, size_t numBytes) const
+{
+    boost::shared_ptr<AudioDecodeData> decoded(new AudioDecodeData);
+    bool success = false;
+    if (WavLoader::IdentifyWavFileInMemory(data, numBytes) && Name().endsWith(".wav", Qt::CaseInsensitive))
+        success = WavLoader::LoadWavFileToSoundBuffer(data, numBytes, decoded->buffer);
+    else if (Name().endsWith(".ogg", Qt::CaseInsensitive))
+        success = OggVorbisLoader::LoadOggVorbisFileToSoundBuffer(data, numBytes, decoded->buffer);
+
+    if (!success || decoded->buffer.data.size() == 0)
+        return AssetDecodeDataPtr();
+    return decoded;
+}
+
+bool AudioAsset::LoadFromDecodedData(const AssetDecodeDataPtr &decoded)
+{
+    const AudioDecodeData *audio = dynamic_cast<const AudioDecodeData *>(decoded.get());
+    if (!audio || !LoadFromSoundBuffer(audio->buffer))
+        return false;
+
+    assetAPI->AssetLoadCompleted(Name());
+    return true;
+}
+
 bool AudioAsset::LoadFromWavFileInMemory(const u8 *data, size_t numBytes)
 {
     SoundBuffer buf;
@@ -145,3 +179,12 @@ bool AudioAsset::IsLoaded() const
 {
     return handle != 0;
 }
+
+size_t AudioAsset::CpuMemoryUsage() const
+{
+    if (!handle)
+        return 0;
+    ALint size = 0;
+    alGetBufferi(handle, AL_SIZE, &size);
+    return size > 0 ? (size_t)size : 0;
+}
@@ -22,6 +22,18 @@ public:
 
     virtual bool DeserializeFromData(const u8 *data, size_t numBytes, bool allowAsynchronous);
 
+    /// Audio assets loaded from identical files can be shared between refs.
+    virtual bool IsContentShareable() const { return true; }
+
+    /// Wav and Ogg Vorbis data is decoded on the asset load threads. Only the OpenAL buffer is filled on the main thread.
+    virtual bool SupportsThreadedDecode() const { return true; }
+
+    /// Decodes Wav or Ogg Vorbis data into a SoundBuffer. Called on an asset load thread.
+    virtual AssetDecodeDataPtr DecodeData(const u8 *data, size_t numBytes) const;
+
+    /// Loads the SoundBuffer produced by DecodeData into the OpenAL buffer.
+    virtual bool LoadFromDecodedData(const AssetDecodeDataPtr &decoded);
+
     /// Loads this audio asset from the given .wav file in memory.
     bool LoadFromWavFileInMemory(const u8 *data, size_t numBytes);
 
@@ -48,6 +60,9 @@ public:
 
     bool IsLoaded() const;
 
+    /// Returns the size of the OpenAL buffer.
+    virtual size_t CpuMemoryUsage() const;
+
 private:
     /// The actual sound data is stored in an OpenAL internal audio buffer. This handle specifies the buffer.
     /// If == 0, then this AudioAsset is unloaded.
@@ -56,6 +56,8 @@ EC_Terrain::EC_Terrain(Scene* scene) :
 
     heightMapAsset = boost::make_shared<AssetRefListener>();
     connect(heightMapAsset.get(), SIGNAL(Loaded(AssetPtr)), this, SLOT(TerrainAssetLoaded(AssetPtr)));
+    materialAsset = boost::make_shared<AssetRefListener>();
+    connect(materialAsset.get(), SIGNAL(Loaded(AssetPtr)), this, SLOT(MaterialAssetLoaded(AssetPtr)));
 }
 
 EC_Terrain::~EC_Terrain()
@@ -63,6 +65,21 @@ EC_Terrain::~EC_Terrain()
     Destroy();
 }
 
+size_t EC_Terrain::ExternalMemoryUsage() const
+{
+    size_t usage = patches.capacity() * sizeof(Patch);
+    for(size_t i = 0; i < patches.size(); ++i)
+        usage += patches[i].heightData.capacity() * sizeof(float) + patches[i].meshGeometryName.capacity();
+    return usage;
+}
+
+void EC_Terrain::SharedResources(std::map<const void *, size_t> &resources) const
+{
+    for(size_t i = 0; i < patches.size(); ++i)
+        if (patches[i].entity)
+            resources[patches[i].entity->getMesh().get()] = patches[i].entity->getMesh()->getSize();
+}
+
 void EC_Terrain::UpdateSignals()
 {
     Entity *parent = ParentEntity();
@@ -171,11 +188,7 @@ void EC_Terrain::AttributesChanged()
     if (nodeTransformation.ValueChanged())
         UpdateRootNodeTransform();
     if (material.ValueChanged())
-    {
-        AssetTransferPtr transfer = GetFramework()->Asset()->RequestAsset(material.Get());
-        if (transfer)
-            connect(transfer.get(), SIGNAL(Succeeded(AssetPtr)), this, SLOT(MaterialAssetLoaded(AssetPtr)), Qt::UniqueConnection);
-    }
+        materialAsset->HandleAssetRefChange(&material, material.Get().type);
     if (heightMap.ValueChanged())
     {
         QString refBody;
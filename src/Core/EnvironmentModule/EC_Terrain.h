@@ -57,6 +57,12 @@ public:
     explicit EC_Terrain(Scene* scene);
     virtual ~EC_Terrain();
 
+    /// IComponent override. Returns the size of the patch height data.
+    virtual size_t ExternalMemoryUsage() const;
+
+    /// IComponent override. Adds the Ogre meshes generated for the patches.
+    virtual void SharedResources(std::map<const void *, size_t> &resources) const;
+
     Q_PROPERTY(Transform nodeTransformation READ getnodeTransformation WRITE setnodeTransformation);
     DEFINE_QPROPERTY_ATTRIBUTE(Transform, nodeTransformation);
 
@@ -396,6 +402,7 @@ private:
     void GenerateTerrainGeometryForOnePatch(int patchX, int patchY);
 
     boost::shared_ptr<AssetRefListener> heightMapAsset;
+    boost::shared_ptr<AssetRefListener> materialAsset;
 
     /// For all terrain patches, we maintain a global parent/root node to be able to transform the whole terrain at one go.
     Ogre::SceneNode *rootNode;
@@ -154,6 +154,12 @@ Framework::Framework(int argc_, char** argv_) :
     cmdLineDescs.commands["--run"] = "Runs script on startup"; // JavaScriptModule
     cmdLineDescs.commands["--file"] = "Specifies a startup scene file. Multiple files supported. Accepts absolute and relative paths, local:// and http:// are accepted and fetched via the AssetAPI."; // TundraLogicModule & AssetModule
     cmdLineDescs.commands["--storage"] = "Adds the given directory as a local storage directory on startup."; // AssetModule
+    cmdLineDescs.commands["--prefetchManifest"] = "Asset prefetch manifest to request the listed assets from on startup, f.ex. '--prefetchManifest local://scene.prefetch'. A server advertises the manifest to the connecting clients instead."; // AssetModule
+    cmdLineDescs.commands["--prefetchManifestOut"] = "Writes an asset prefetch manifest of the startup scene given with --file to this file and exits, f.ex. '--file scene.txml --prefetchManifestOut scene.prefetch'."; // TundraLogicModule
+    cmdLineDescs.commands["--httpMaxConnectionsPerHost"] = "Maximum number of simultaneous http asset requests to a single host. Default: 6."; // AssetModule
+    cmdLineDescs.commands["--httpMaxConnections"] = "Maximum number of simultaneous http asset requests in total. Default: 24."; // AssetModule
+    cmdLineDescs.commands["--httpCacheTtl"] = "Cached http assets downloaded or revalidated within this many seconds are used without an If-Modified-Since request. Default: 0, always revalidate."; // AssetModule
+    cmdLineDescs.commands["--pollFileChanges"] = "Polls the local asset storage directories for file changes instead of watching them natively, f.ex. for network file systems."; // AssetModule
     cmdLineDescs.commands["--config"] = "Specifies a startup configration file to use. Multiple config files are supported, f.ex. '--config plugins.xml --config MyCustomAddons.xml'."; // Framework & PluginAPI
     cmdLineDescs.commands["--connect"] = "Connects to a Tundra server automatically. Syntax: '--connect serverIp;port;protocol;name;password'. Password is optional."; // TundraLogicModule & AssetModule
     cmdLineDescs.commands["--login"] = "Automatically login to server using provided data. Url syntax: {tundra|http|https}://host[:port]/?username=x[&password=y&avatarurl=z&protocol={udp|tcp}]. Minimum information needed to try a connection in the url are host and username."; // TundraLogicModule & AssetModule
@@ -161,6 +167,12 @@ Framework::Framework(int argc_, char** argv_) :
     cmdLineDescs.commands["--noAssetCache"] = "Disable asset cache."; // Framework
     cmdLineDescs.commands["--assetCacheDir"] = "Specify asset cache directory to use."; // Framework
     cmdLineDescs.commands["--clear-asset-cache"] = "At the start of Tundra, remove all data and metadata files from asset cache."; // AssetCache
+    cmdLineDescs.commands["--assetCacheSize"] = "Maximum size of the asset cache in megabytes. When the cache grows larger, files are evicted. Default: 0, no limit."; // AssetCache
+    cmdLineDescs.commands["--contentAddressedCache"] = "Stores asset cache files by content hash, so that refs with identical content share one cache file and, for textures and audio, one loaded asset."; // AssetCache
+    cmdLineDescs.commands["--assetCacheEviction"] = "Which asset cache files are evicted first when the cache is full: 'lru' (least recently used) or 'lfu' (least frequently used). Default: lru."; // AssetCache
+    cmdLineDescs.commands["--assetLoadThreads"] = "Number of worker threads that read and decode asset data. 0 loads all assets on the main thread. Default: number of CPU cores - 1, at most 4."; // AssetAPI
+    cmdLineDescs.commands["--assetLoadBudget"] = "Time budget per frame in milliseconds for finishing asset loads on the main thread, f.ex. '--assetLoadBudget 4'. Default: 8."; // AssetAPI
+    cmdLineDescs.commands["--assetMemoryBudget"] = "Memory budget of the loaded assets in megabytes, f.ex. '--assetMemoryBudget 512'. When exceeded, the least recently used assets that are not in use are unloaded. Default: unlimited."; // AssetAPI
     cmdLineDescs.commands["--logLevel"] = "Sets the current log level: 'error', 'warning', 'info', 'debug'."; // ConsoleAPI
     cmdLineDescs.commands["--logFile"] = "Sets logging file. Usage example: '--logfile TundraLogFile.txt'."; // ConsoleAPI
     cmdLineDescs.commands["--physicsRate"] = "Specifies the number of physics simulation steps per second. Default: 60."; // PhysicsModule
@@ -175,6 +187,9 @@ Framework::Framework(int argc_, char** argv_) :
     cmdLineDescs.commands["--autoDxtCompress"] = "Compress uncompressed texture assets to DXT1/DXT5 format on load to save memory."; // OgreRenderingModule
     cmdLineDescs.commands["--maxTextureSize"] = "Resize texture assets that are larger than this. Default: no resizing."; // OgreRenderingModule
     cmdLineDescs.commands["--variablePhysicsStep"] = "Use variable physics timestep to avoid taking multiple physics substeps during one frame."; // PhysicsModule
+    cmdLineDescs.commands["--incrementalLoad"] = "Loads startup scenes incrementally over several frames. Optionally specifies the time budget per frame in milliseconds, f.ex. '--incrementalLoad 5'. Default: 10."; // TundraLogicModule
+    cmdLineDescs.commands["--journal"] = "Persists the scene incrementally to the given binary snapshot file and an append-only change journal next to it, f.ex. '--journal scene.tbin'. If the files exist, the scene is recovered from them on startup."; // TundraLogicModule
+    cmdLineDescs.commands["--batchAttributeChanges"] = "Batches attribute change signals per component and dispatches them once at the end of each frame."; // Scene
     
     apiVersionInfo = new VersionInfo(Application::Version());
     applicationVersionInfo = new VersionInfo(Application::Version());
@@ -203,6 +218,10 @@ Framework::Framework(int argc_, char** argv_) :
     // In headless mode, no main UI/rendering window is initialized.
     if (HasCommandLineParameter("--headless"))
         headless = true;
+#ifdef TUNDRA_NO_OGRE
+    // A build without Ogre has no renderer, so it always runs headless.
+    headless = true;
+#endif
 
 #ifdef PROFILING
     profiler = new Profiler();
@@ -4,6 +4,9 @@
 #include "Framework.h"
 #include "ConsoleAPI.h"
 
+#include <QCoreApplication>
+#include <QThread>
+
 #include "Win.h"
 
 void PrintLogMessage(u32 logChannel, const char *str)
@@ -13,6 +16,13 @@ void PrintLogMessage(u32 logChannel, const char *str)
 
     Framework *instance = Framework::Instance();
     ConsoleAPI *console = (instance ? instance->Console() : 0);
+    // The Console API is not thread-safe. Messages logged from worker threads, f.ex. the asset load threads, are queued
+    // to be printed on the main thread, so that they reach the console widget and the log file as well.
+    if (console && QCoreApplication::instance() && QThread::currentThread() != QCoreApplication::instance()->thread())
+    {
+        QMetaObject::invokeMethod(console, "Print", Qt::QueuedConnection, Q_ARG(QString, QString(str)));
+        return;
+    }
 
     // On Windows, highlight errors and warnings.
 #ifdef WIN32
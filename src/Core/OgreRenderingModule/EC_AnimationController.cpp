@@ -10,7 +10,9 @@
 #include "CoreStringUtils.h"
 #include "Profiler.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
+#endif
 
 #include "LoggingFunctions.h"
 
@@ -40,6 +42,7 @@ void EC_AnimationController::SetMeshEntity(EC_Mesh *new_mesh)
 
 QStringList EC_AnimationController::GetAvailableAnimations()
 {
+#ifndef TUNDRA_NO_OGRE
     QStringList availableList;
     Ogre::Entity* entity = GetEntity();
     if (!entity) 
@@ -54,6 +57,9 @@ QStringList EC_AnimationController::GetAvailableAnimations()
         availableList << QString(animstate->getAnimationName().c_str());
     }
     return availableList;
+#else
+    return QStringList();
+#endif
 }
 
 QStringList EC_AnimationController::GetActiveAnimations() const
@@ -70,6 +76,7 @@ QStringList EC_AnimationController::GetActiveAnimations() const
 
 void EC_AnimationController::Update(float frametime)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetEntity();
     if (!entity) 
         return;
@@ -276,8 +283,10 @@ void EC_AnimationController::Update(float frametime)
                 animstate->_setBlendMaskData(&lowpriority_mask_[0]);
         }
     }
+#endif
 }
 
+#ifndef TUNDRA_NO_OGRE
 Ogre::Entity* EC_AnimationController::GetEntity()
 {
     if (!mesh)
@@ -299,11 +308,14 @@ Ogre::Entity* EC_AnimationController::GetEntity()
     return entity;
 }
 
+#endif
+
 void EC_AnimationController::ResetState()
 {
     animations_.clear();
 }
 
+#ifndef TUNDRA_NO_OGRE
 /// Finds an animation state from Ogre::AnimationStateSet by name, performing a case-insensitive name search.
 /// @note This function is O(n), while normal set search would be O(logN) or O(1).
 Ogre::AnimationState *OgreAnimStateSetFindNoCase(Ogre::AnimationStateSet *set, const QString &animState)
@@ -329,6 +341,7 @@ Ogre::AnimationState* EC_AnimationController::GetAnimationState(Ogre::Entity* en
         
     return OgreAnimStateSetFindNoCase(entity->getAllAnimationStates(), name);
 }
+#endif
 
 bool EC_AnimationController::EnableExclusiveAnimation(const QString& name, bool looped, float fadein, float fadeout, bool high_priority)
 {
@@ -351,6 +364,7 @@ bool EC_AnimationController::EnableExclusiveAnimation(const QString& name, bool
 
 bool EC_AnimationController::EnableAnimation(const QString& name, bool looped, float fadein, bool high_priority)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetEntity();
     Ogre::AnimationState* animstate = GetAnimationState(entity, name);
     if (!animstate) 
@@ -387,10 +401,14 @@ bool EC_AnimationController::EnableAnimation(const QString& name, bool looped, f
     animations_[name] = newanim;
 
     return true;
+#else
+    return false;
+#endif
 }
 
 bool EC_AnimationController::HasAnimationFinished(const QString& name)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetEntity();
     Ogre::AnimationState* animstate = GetAnimationState(entity, name);
     if (!animstate) 
@@ -408,6 +426,9 @@ bool EC_AnimationController::HasAnimationFinished(const QString& name)
 
     // Animation not listed, must be finished
     return true;
+#else
+    return false;
+#endif
 }
 
 bool EC_AnimationController::IsAnimationActive(const QString& name, bool check_fadeout)
@@ -480,6 +501,7 @@ void EC_AnimationController::DisableAllAnimations(float fadeout)
 
 void EC_AnimationController::SetAnimationToEnd(const QString& name)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetEntity();
     Ogre::AnimationState* animstate = GetAnimationState(entity, name);
     if (!animstate)
@@ -489,6 +511,7 @@ void EC_AnimationController::SetAnimationToEnd(const QString& name)
     {
         SetAnimationTimePosition(name, animstate->getLength());
     }
+#endif
 }
 
 bool EC_AnimationController::SetAnimationSpeed(const QString& name, float speedfactor)
@@ -529,6 +552,7 @@ bool EC_AnimationController::SetAnimationPriority(const QString& name, bool high
 
 bool EC_AnimationController::SetAnimationTimePosition(const QString& name, float newPosition)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetEntity();
     Ogre::AnimationState* animstate = GetAnimationState(entity, name);
     if (!animstate) 
@@ -543,10 +567,14 @@ bool EC_AnimationController::SetAnimationTimePosition(const QString& name, float
     }
     // Animation not active
     return false;
+#else
+    return false;
+#endif
 }
 
 bool EC_AnimationController::SetAnimationRelativeTimePosition(const QString& name, float newPosition)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetEntity();
     Ogre::AnimationState* animstate = GetAnimationState(entity, name);
     if (!animstate) 
@@ -561,20 +589,28 @@ bool EC_AnimationController::SetAnimationRelativeTimePosition(const QString& nam
     }
     // Animation not active
     return false;
+#else
+    return false;
+#endif
 }
 
 float EC_AnimationController::GetAnimationLength(const QString& name)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetEntity();
     Ogre::AnimationState* animstate = GetAnimationState(entity, name);
     if (!animstate)
         return 0.0f;
     else
         return animstate->getLength();
+#else
+    return 0.0f;
+#endif
 }
 
 float EC_AnimationController::GetAnimationTimePosition(const QString& name)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetEntity();
     Ogre::AnimationState* animstate = GetAnimationState(entity, name);
     if (!animstate)
@@ -585,10 +621,14 @@ float EC_AnimationController::GetAnimationTimePosition(const QString& name)
     if (i != animations_.end())
         return animstate->getTimePosition();
     else return 0.0f;
+#else
+    return 0.0f;
+#endif
 }
 
 float EC_AnimationController::GetAnimationRelativeTimePosition(const QString& name)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetEntity();
     Ogre::AnimationState* animstate = GetAnimationState(entity, name);
     if (!animstate)
@@ -599,6 +639,9 @@ float EC_AnimationController::GetAnimationRelativeTimePosition(const QString& na
     if (i != animations_.end())
         return animstate->getTimePosition() / animstate->getLength();
     else return 0.0f;
+#else
+    return 0.0f;
+#endif
 }
 
 void EC_AnimationController::UpdateSignals()
@@ -7,7 +7,9 @@
 #include "OgreModuleFwd.h"
 #include "CoreStringUtils.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <OgreAnimationState.h>
+#endif
 
 /// Ogre-specific mesh entity animation controller
 /**
@@ -358,7 +360,7 @@ signals:
     void AnimationCycled(const QString& animationName);
     
 private:
-    
+#ifndef TUNDRA_NO_OGRE
     /// Gets Ogre entity from the mesh entity component and checks if it has changed; in that case resets internal state
     Ogre::Entity* GetEntity();
 
@@ -368,7 +370,8 @@ private:
         @return animationstate, or null if not found
      */
     Ogre::AnimationState* GetAnimationState(Ogre::Entity* entity, const QString& name);
-    
+#endif
+
     /// Resets internal state
     void ResetState();
     
@@ -381,10 +384,12 @@ private:
     /// Current animations
     AnimationMap animations_;
     
+#ifndef TUNDRA_NO_OGRE
     /// Bone blend mask of high-priority animations
     Ogre::AnimationState::BoneBlendMask highpriority_mask_;
 
     /// Bone blend mask of low-priority animations
     Ogre::AnimationState::BoneBlendMask lowpriority_mask_;
+#endif
 };
 
@@ -3,15 +3,19 @@
 #include "StableHeaders.h"
 #include "DebugOperatorNew.h"
 
+#ifndef TUNDRA_NO_OGRE
 #define MATH_OGRE_INTEROP
+#endif
 
 #include "EC_Camera.h"
 #include "EC_Mesh.h"
 #include "EC_Placeable.h"
 #include "OgreRenderingModule.h"
+#ifndef TUNDRA_NO_OGRE
 #include "OgreWorld.h"
 #include "TextureAsset.h"
 #include "Renderer.h"
+#endif
 
 #include "Entity.h"
 #include "FrameAPI.h"
@@ -22,7 +26,9 @@
 #include "UiAPI.h"
 #include "UiMainWindow.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
+#endif
 
 #include <QDir>
 #include <QDateTime>
@@ -44,8 +50,10 @@ EC_Camera::EC_Camera(Scene* scene) :
     queryFrameNumber_(-1),
     renderTextureName_("")
 {
+#ifndef TUNDRA_NO_OGRE
     if (scene)
         world_ = scene->GetWorld<OgreWorld>();
+#endif
     connect(this, SIGNAL(ParentEntitySet()), SLOT(UpdateSignals()));
     if (framework)
         connect(framework->Frame(), SIGNAL(Updated(float)), SLOT(OnUpdated(float)));
@@ -54,6 +62,7 @@ EC_Camera::EC_Camera(Scene* scene) :
 
 EC_Camera::~EC_Camera()
 {
+#ifndef TUNDRA_NO_OGRE
     if (world_.expired())
     {
         if (camera_)
@@ -87,6 +96,7 @@ EC_Camera::~EC_Camera()
         }
         catch(Ogre::Exception) {}
     }
+#endif
 }
 
 float3 EC_Camera::InitialRotation() const
@@ -158,6 +168,7 @@ void EC_Camera::SetVerticalFov(float fov)
 
 void EC_Camera::SetActive()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!ViewEnabled())
         return;
 
@@ -183,33 +194,46 @@ void EC_Camera::SetActive()
     // if its setAutoAspectRatio was set to true. Therefore, re-apply the aspect ratio when activating a new camera to the main viewport.
     camera_->setAspectRatio(AspectRatio());
     camera_->setAutoAspectRatio(aspectRatio.Get().trimmed().isEmpty()); ///\note If user inputs garbage into the aspectRatio field, this will incorrectly go true. (but above line prints an error to user, so should be ok). 
+#endif
 }
 
 float EC_Camera::NearClip() const
 {
+#ifndef TUNDRA_NO_OGRE
     LogWarning("EC_Camera::NearClip: this functions is deprecated and will be removed. Use attribute nearPlane direcly.");
     if (!camera_)
         return 0.0f;
 
     return camera_->getNearClipDistance();
+#else
+    return 0.0f;
+#endif
 }
 
 float EC_Camera::FarClip() const
 {
+#ifndef TUNDRA_NO_OGRE
     LogWarning("EC_Camera::FarClip: this functions is deprecated and will be removed. Use attribute farPlane direcly.");
     if (!camera_)
         return 0.0f;
 
     return camera_->getFarClipDistance();
+#else
+    return 0.0f;
+#endif
 }
 
 float EC_Camera::VerticalFov() const
 {
+#ifndef TUNDRA_NO_OGRE
     LogWarning("EC_Camera::VerticalFov: this functions is deprecated and will be removed. Use attribute verticalFov direcly.");
     if (!camera_)
         return 0.0f;
 
     return camera_->getFOVy().valueRadians();
+#else
+    return 0.0f;
+#endif
 }
 
 float EC_Camera::AspectRatio() const
@@ -238,16 +262,19 @@ float EC_Camera::AspectRatio() const
         LogError("Invalid format for the aspectRatio field: \"" + aspectRatio.Get() + "\"! Should be of form \"float\" or \"float:float\". Leave aspectRatio empty to match the current main viewport aspect ratio.");
     }
 
+#ifndef TUNDRA_NO_OGRE
     OgreWorldPtr world = world_.lock();
     Ogre::Viewport *viewport = world->Renderer()->MainViewport();
     if (viewport)
         return (float)viewport->getActualWidth() / viewport->getActualHeight();
+#endif
     LogWarning("EC_Camera::AspectRatio(): No viewport or aspectRatio attribute set! Don't have an aspect ratio for the camera!");
     return 1.f;
 }
 
 bool EC_Camera::IsActive() const
 {
+#ifndef TUNDRA_NO_OGRE
     if (!camera_)
         return false;
     if (world_.expired())
@@ -256,10 +283,14 @@ bool EC_Camera::IsActive() const
         return false;
 
     return world_.lock()->Renderer()->MainCamera() == ParentEntity();
+#else
+    return false;
+#endif
 }
 
 void EC_Camera::DetachCamera()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!attached_ || !camera_ || !placeable_)
         return;
 
@@ -268,10 +299,12 @@ void EC_Camera::DetachCamera()
     node->detachObject(camera_);
 
     attached_ = false;
+#endif
 }
 
 void EC_Camera::AttachCamera()
 {
+#ifndef TUNDRA_NO_OGRE
     if (attached_ || !camera_ || !placeable_)
         return;
 
@@ -280,10 +313,12 @@ void EC_Camera::AttachCamera()
     node->attachObject(camera_);
 
     attached_ = true;
+#endif
 }
 
 void EC_Camera::DestroyOgreCamera()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!camera_)
         return;
 
@@ -303,6 +338,7 @@ void EC_Camera::DestroyOgreCamera()
 
     sceneMgr->destroyCamera(camera_);
     camera_ = 0;
+#endif
 }
 
 Ray EC_Camera::GetMouseRay(float x, float y) const
@@ -311,10 +347,11 @@ Ray EC_Camera::GetMouseRay(float x, float y) const
     if (fabs(x) >= 10.f || fabs(y) >= 10.f || !isfinite(x) || !isfinite(y))
         LogError(QString("EC_Camera::GetMouseRay takes input (x,y) coordinates normalized in the range [0,1]! (You inputted x=%1, y=%2").arg(x).arg(y));
 
+#ifndef TUNDRA_NO_OGRE
     if (camera_)
         return camera_->getCameraToViewportRay(Clamp(x, 0.f, 1.f), Clamp(y, 0.f, 1.f));
-    else
-        return Ray();
+#endif
+    return Ray();
 }
 
 void EC_Camera::UpdateSignals()
@@ -330,6 +367,7 @@ void EC_Camera::UpdateSignals()
     if (!ViewEnabled())
         return;
     
+#ifndef TUNDRA_NO_OGRE
     // Create camera now if not yet created
     if (!camera_)
     {
@@ -349,6 +387,7 @@ void EC_Camera::UpdateSignals()
         Ogre::PlaneBoundedVolumeList dummy;
         query_ = sceneMgr->createPlaneBoundedVolumeQuery(dummy);
     }
+#endif
 
     // Make sure we attach to the EC_Placeable if exists.
     OnComponentStructureChanged();
@@ -371,11 +410,13 @@ void EC_Camera::OnAttributeUpdated(IAttribute *attribute)
         SetFarClipDistance(farPlane.Get());
     else if (attribute == &verticalFov)
         SetFovY(verticalFov.Get());
+#ifndef TUNDRA_NO_OGRE
     else if (attribute == &aspectRatio && camera_)
     {
         camera_->setAspectRatio(AspectRatio());
         camera_->setAutoAspectRatio(aspectRatio.Get().trimmed().isEmpty()); ///\note If user inputs garbage into the aspectRatio field, this will incorrectly go true. (but above line prints an error to user, so should be ok). 
     }
+#endif
 }
 
 bool EC_Camera::IsEntityVisible(Entity* entity)
@@ -497,6 +538,7 @@ void EC_Camera::OnUpdated(float timeStep)
 
 void EC_Camera::QueryVisibleEntities()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!camera_ || !query_)
         return;
     
@@ -538,15 +580,18 @@ void EC_Camera::QueryVisibleEntities()
     visibleEntities_.clear();
     LogWarning("EC_Camera::QueryVisibleEntities: Not supported on your Ogre version!"); ///\todo Check which exact version has the above getPlaneBoundedVolume(), 1.6.4 doesn't seem to, 1.7.1 does.
 #endif
+#endif
 }
 
 void EC_Camera::SetNearClipDistance(float distance)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!camera_)
         return;
     if (world_.expired())
         return;
     camera_->setNearClipDistance(distance);
+#endif
 }
 
 QString EC_Camera::SaveScreenshot(bool renderUi)
@@ -594,6 +639,7 @@ QString EC_Camera::SaveScreenshot(bool renderUi)
 
 QImage EC_Camera::ToQImage(bool renderUi)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!ViewEnabled() || !framework->Ui()->MainWindow())
     {
         LogError("EC_Camera::ToQImage() Cannot take screenshot in headless mode!");
@@ -620,8 +666,13 @@ QImage EC_Camera::ToQImage(bool renderUi)
         return QImage();
 
     return TextureAsset::ToQImage(texture.get());
+#else
+    LogError("EC_Camera::ToQImage() Cannot take screenshot in a build without Ogre!");
+    return QImage();
+#endif
 }
 
+#ifndef TUNDRA_NO_OGRE
 Ogre::Image EC_Camera::ToOgreImage(bool renderUi)
 {
     if (!ViewEnabled() || !framework->Ui()->MainWindow())
@@ -653,9 +704,11 @@ Ogre::Image EC_Camera::ToOgreImage(bool renderUi)
     texture->convertToImage(ogreImage);
     return ogreImage;
 }
+#endif
 
 bool EC_Camera::UpdateRenderTexture(QSize textureSize, bool renderUi)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!ViewEnabled() || !framework->Ui()->MainWindow())
         return false;
     OgreWorldPtr world = world_.lock();
@@ -712,9 +765,13 @@ bool EC_Camera::UpdateRenderTexture(QSize textureSize, bool renderUi)
     }
 
     return false;
+#else
+    return false;
+#endif
 }
 void EC_Camera::SetFarClipDistance(float distance)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!camera_)
         return;
     if (world_.expired())
@@ -730,13 +787,16 @@ void EC_Camera::SetFarClipDistance(float distance)
         farclip = renderer->ViewDistance();
     */
     camera_->setFarClipDistance(distance);
+#endif
 }
 
 void EC_Camera::SetFovY(float fov)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!camera_)
         return;
     if (world_.expired())
         return;
     camera_->setFOVy(Ogre::Radian(Ogre::Math::DegreesToRadians(fov)));
+#endif
 }
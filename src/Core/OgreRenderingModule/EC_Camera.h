@@ -12,7 +12,9 @@
 #include <QSize>
 #include <set>
 
+#ifndef TUNDRA_NO_OGRE
 #include <OgreImage.h>
+#endif
 
 namespace Ogre
 {
@@ -151,11 +153,13 @@ public slots:
         @return The render result image, null QImage if operation fails. */
     QImage ToQImage(bool renderUi = true);
    
+#ifndef TUNDRA_NO_OGRE
     /// Render current view to a Ogre::Image. Returns null Ogre::Image if operation fails.
     /** Tundra rendering viewport size is used as the image size.
         @param renderUi If the image should have the user interface included.
         @return The render result image. */
     Ogre::Image ToOgreImage(bool renderUi = true);
+#endif
 
     /// Returns a world space ray as cast from the camera through a viewport position.
     /** @param The x position at which the ray should intersect the viewport, in normalized screen coordinates [0,1].
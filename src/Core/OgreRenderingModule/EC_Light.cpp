@@ -1,11 +1,12 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include "StableHeaders.h"
+#ifndef TUNDRA_NO_OGRE
 #define MATH_OGRE_INTEROP
+#endif
 #include "DebugOperatorNew.h"
 
 #include "EC_Light.h"
-#include "Renderer.h"
 #include "EC_Placeable.h"
 
 #include "Entity.h"
@@ -13,14 +14,17 @@
 #include "AttributeMetadata.h"
 #include "LoggingFunctions.h"
 #include "OgreRenderingModule.h"
-#include "OgreWorld.h"
 
 #include <QDomDocument>
 #include <QList>
 #include <QVector>
 
+#ifndef TUNDRA_NO_OGRE
+#include "Renderer.h"
+#include "OgreWorld.h"
 #include <OgreSceneManager.h>
 #include <OgreSceneNode.h>
+#endif
 
 #include "MemoryLeakCheck.h"
 
@@ -53,6 +57,7 @@ EC_Light::EC_Light(Scene* scene) :
     }
     type.SetMetadata(&typeAttrData);
 
+#ifndef TUNDRA_NO_OGRE
     if (scene)
     {
         world_ = scene->GetWorld<OgreWorld>();
@@ -66,10 +71,12 @@ EC_Light::EC_Light(Scene* scene) :
             connect(this, SIGNAL(AttributeChanged(IAttribute*, AttributeChange::Type)), this, SLOT(UpdateOgreLight()));
         }
     }
+#endif
 }
 
 EC_Light::~EC_Light()
 {
+#ifndef TUNDRA_NO_OGRE
     if (world_.expired())
     {
         if (light_)
@@ -84,6 +91,7 @@ EC_Light::~EC_Light()
         sceneMgr->destroyLight(light_);
         light_ = 0;
     }
+#endif
 }
 
 void EC_Light::UpdateSignals()
@@ -144,6 +152,7 @@ void EC_Light::SetPlaceable(ComponentPtr placeable)
 
 void EC_Light::AttachLight()
 {
+#ifndef TUNDRA_NO_OGRE
     if ((light_) && (placeable_) && (!attached_))
     {
         EC_Placeable* placeable = checked_static_cast<EC_Placeable*>(placeable_.get());
@@ -151,10 +160,12 @@ void EC_Light::AttachLight()
         node->attachObject(light_);
         attached_ = true;
     }
+#endif
 }
 
 void EC_Light::DetachLight()
 {
+#ifndef TUNDRA_NO_OGRE
     if ((light_) && (placeable_) && (attached_))
     {
         EC_Placeable* placeable = checked_static_cast<EC_Placeable*>(placeable_.get());
@@ -162,10 +173,12 @@ void EC_Light::DetachLight()
         node->detachObject(light_);
         attached_ = false;
     }
+#endif
 }
 
 void EC_Light::UpdateOgreLight()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!light_)
         return;
     
@@ -212,5 +225,6 @@ void EC_Light::UpdateOgreLight()
     {
         LogError("Exception while setting EC_Light parameters to Ogre: " + std::string(e.what()));
     }
+#endif
 }
 
@@ -5,7 +5,9 @@
 
 #include "EC_Material.h"
 #include "EC_Mesh.h"
+#ifndef TUNDRA_NO_OGRE
 #include "OgreMaterialAsset.h"
+#endif
 #include "OgreRenderingModule.h"
 
 #include "FrameAPI.h"
@@ -63,6 +65,7 @@ void EC_Material::OnAttributeUpdated(IAttribute* attribute)
     if (attribute == &inputMat)
         CheckForInputMaterial();
     
+#ifndef TUNDRA_NO_OGRE
     if ((attribute == &outputMat) || (attribute == &parameters))
     {
         // If output material or parameters change, and input asset exists, can apply parameters
@@ -71,6 +74,7 @@ void EC_Material::OnAttributeUpdated(IAttribute* attribute)
         if (srcMatAsset && srcMatAsset->IsLoaded())
             ApplyParameters(srcMatAsset);
     }
+#endif
 }
 
 void EC_Material::OnMeshAttributeUpdated(IAttribute* attribute)
@@ -129,14 +133,17 @@ void EC_Material::CheckForInputMaterial()
 
 void EC_Material::OnMaterialAssetLoaded(AssetPtr material)
 {
+#ifndef TUNDRA_NO_OGRE
     OgreMaterialAsset* srcMatAsset = dynamic_cast<OgreMaterialAsset*>(material.get());
     // When input asset is loaded, can apply parameters
     if (srcMatAsset && srcMatAsset->IsLoaded())
         ApplyParameters(srcMatAsset);
+#endif
 }
 
 void EC_Material::ApplyParameters(OgreMaterialAsset* srcMatAsset)
 {
+#ifndef TUNDRA_NO_OGRE
     AssetAPI* assetAPI = framework->Asset();
     QString outputMatName = outputMat.Get();
     
@@ -180,4 +187,5 @@ void EC_Material::ApplyParameters(OgreMaterialAsset* srcMatAsset)
         if (parts.size() == 2)
             destMatAsset->SetAttribute(parts[0], parts[1]);
     }
+#endif
 }
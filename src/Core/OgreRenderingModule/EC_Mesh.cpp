@@ -1,18 +1,24 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include "StableHeaders.h"
+#ifndef TUNDRA_NO_OGRE
 #define MATH_OGRE_INTEROP
+#endif
 #include "DebugOperatorNew.h"
 #include "OgreRenderingModule.h"
+#ifndef TUNDRA_NO_OGRE
 #include "OgreWorld.h"
 #include "Renderer.h"
+#endif
 #include "Entity.h"
 #include "Scene.h"
 #include "EC_Placeable.h"
 #include "EC_Mesh.h"
-#include "OgreSkeletonAsset.h"
 #include "OgreMeshAsset.h"
+#ifndef TUNDRA_NO_OGRE
+#include "OgreSkeletonAsset.h"
 #include "OgreMaterialAsset.h"
+#endif
 #include "IAssetTransfer.h"
 #include "AssetAPI.h"
 #include "AttributeMetadata.h"
@@ -20,8 +26,10 @@
 #include "Math/float2.h"
 #include "Geometry/Ray.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
 #include <OgreTagPoint.h>
+#endif
 
 #include "LoggingFunctions.h"
 
@@ -40,8 +48,10 @@ EC_Mesh::EC_Mesh(Scene* scene) :
     entity_(0),
     attached_(false)
 {
+#ifndef TUNDRA_NO_OGRE
     if (scene)
         world_ = scene->GetWorld<OgreWorld>();
+#endif
 
     static AttributeMetadata drawDistanceData("", "0", "10000");
     drawDistance.SetMetadata(&drawDistanceData);
@@ -53,6 +63,12 @@ EC_Mesh::EC_Mesh(Scene* scene) :
     meshAsset = AssetRefListenerPtr(new AssetRefListener());
     skeletonAsset = AssetRefListenerPtr(new AssetRefListener());
     
+#ifdef TUNDRA_NO_OGRE
+    // Without a renderer, only the mesh asset is loaded, for the bounds and the geometry.
+    connect(this, SIGNAL(ParentEntitySet()), SLOT(UpdateSignals()));
+    connect(this, SIGNAL(AttributeChanged(IAttribute*, AttributeChange::Type)), SLOT(OnAttributeUpdated(IAttribute*)));
+    connect(meshAsset.get(), SIGNAL(Loaded(AssetPtr)), this, SLOT(OnMeshAssetLoaded(AssetPtr)), Qt::UniqueConnection);
+#else
     OgreWorldPtr world = world_.lock();
     if (world)
     {
@@ -64,10 +80,12 @@ EC_Mesh::EC_Mesh(Scene* scene) :
         connect(meshAsset.get(), SIGNAL(Loaded(AssetPtr)), this, SLOT(OnMeshAssetLoaded(AssetPtr)), Qt::UniqueConnection);
         connect(skeletonAsset.get(), SIGNAL(Loaded(AssetPtr)), this, SLOT(OnSkeletonAssetLoaded(AssetPtr)), Qt::UniqueConnection);
     }
+#endif
 }
 
 EC_Mesh::~EC_Mesh()
 {
+#ifndef TUNDRA_NO_OGRE
     if (world_.expired())
     {
         // Log error only if there was an Ogre object to be destroyed
@@ -85,6 +103,23 @@ EC_Mesh::~EC_Mesh()
         sceneMgr->destroySceneNode(adjustment_node_);
         adjustment_node_ = 0;
     }
+#endif
+}
+
+void EC_Mesh::SharedResources(std::map<const void *, size_t> &resources) const
+{
+#ifndef TUNDRA_NO_OGRE
+    // The skeleton instance of the entity is its own, but it shares the skeleton data with the other instances, so the skeleton resource is reported.
+    if (entity_)
+    {
+        resources[entity_->getMesh().get()] = entity_->getMesh()->getSize();
+        if (entity_->hasSkeleton() && !entity_->getMesh()->getSkeleton().isNull())
+            resources[entity_->getMesh()->getSkeleton().get()] = entity_->getMesh()->getSkeleton()->getSize();
+    }
+    for(size_t i = 0; i < attachment_entities_.size(); ++i)
+        if (attachment_entities_[i])
+            resources[attachment_entities_[i]->getMesh().get()] = attachment_entities_[i]->getMesh()->getSize();
+#endif
 }
 
 void EC_Mesh::SetPlaceable(ComponentPtr placeable)
@@ -139,26 +174,32 @@ void EC_Mesh::SetAdjustScale(const float3& scale)
 
 void EC_Mesh::SetAttachmentPosition(uint index, const float3& position)
 {
+#ifndef TUNDRA_NO_OGRE
     if (index >= attachment_nodes_.size() || attachment_nodes_[index] == 0)
         return;
     
     attachment_nodes_[index]->setPosition(position);
+#endif
 }
 
 void EC_Mesh::SetAttachmentOrientation(uint index, const Quat &orientation)
 {
+#ifndef TUNDRA_NO_OGRE
     if (index >= attachment_nodes_.size() || attachment_nodes_[index] == 0)
         return;
     
     attachment_nodes_[index]->setOrientation(orientation);
+#endif
 }
 
 void EC_Mesh::SetAttachmentScale(uint index, const float3& scale)
 {
+#ifndef TUNDRA_NO_OGRE
     if (index >= attachment_nodes_.size() || attachment_nodes_[index] == 0)
         return;
     
     attachment_nodes_[index]->setScale(scale);
+#endif
 }
 
 float3 EC_Mesh::GetAdjustPosition() const
@@ -181,30 +222,45 @@ float3 EC_Mesh::GetAdjustScale() const
 
 float3 EC_Mesh::GetAttachmentPosition(uint index) const
 {
+#ifndef TUNDRA_NO_OGRE
     if (index >= attachment_nodes_.size() || attachment_nodes_[index] == 0)
         return float3::nan;
 
     return attachment_nodes_[index]->getPosition();
+#else
+    return float3::nan;
+#endif
 }
 
 Quat EC_Mesh::GetAttachmentOrientation(uint index) const
 {
+#ifndef TUNDRA_NO_OGRE
     if (index >= attachment_nodes_.size() || attachment_nodes_[index] == 0)
         return Quat::nan;
         
     return attachment_nodes_[index]->getOrientation();
+#else
+    return Quat::nan;
+#endif
 }
 
 float3 EC_Mesh::GetAttachmentScale(uint index) const
 {
+#ifndef TUNDRA_NO_OGRE
     if (index >= attachment_nodes_.size() || attachment_nodes_[index] == 0)
         return float3::nan;
 
     return attachment_nodes_[index]->getScale();
+#else
+    return float3::nan;
+#endif
 }
 
 float3x4 EC_Mesh::LocalToParent() const
 {
+#ifdef TUNDRA_NO_OGRE
+    return nodeTransformation.Get().ToFloat3x4();
+#else
     if (!entity_)
     {
         LogError(QString("EC_Mesh::LocalToParent failed! No entity exists in mesh \"%1\" (entity: \"%2\")!").arg(meshRef.Get().ref).arg(ParentEntity() ? ParentEntity()->Name() : "(EC_Mesh with no parent entity)"));
@@ -219,10 +275,18 @@ float3x4 EC_Mesh::LocalToParent() const
     }
 
     return float3x4::FromTRS(node->getPosition(), node->getOrientation(), node->getScale());
+#endif
 }
 
 float3x4 EC_Mesh::LocalToWorld() const
 {
+#ifdef TUNDRA_NO_OGRE
+    // Without the Ogre scene nodes, concatenate the transform of the placeable and the adjustment transform.
+    EC_Placeable *placeable = checked_static_cast<EC_Placeable*>(placeable_.get());
+    if (!placeable && ParentEntity())
+        placeable = ParentEntity()->GetComponent<EC_Placeable>().get();
+    return placeable ? placeable->LocalToWorld() * LocalToParent() : LocalToParent();
+#else
     if (!entity_)
     {
         LogError(QString("EC_Mesh::LocalToParent failed! No entity exists in mesh \"%1\" (entity: \"%2\")!").arg(meshRef.Get().ref).arg(ParentEntity() ? ParentEntity()->Name() : "(EC_Mesh with no parent entity)"));
@@ -240,10 +304,12 @@ float3x4 EC_Mesh::LocalToWorld() const
     float3x4 tm = float3x4::FromTRS(node->_getDerivedPosition(), node->_getDerivedOrientation(), node->_getDerivedScale());
     assume(tm.IsColOrthogonal());
     return tm;
+#endif
 }
 
 bool EC_Mesh::SetMesh(QString meshResourceName, bool clone)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!ViewEnabled())
         return false;
     
@@ -323,10 +389,14 @@ bool EC_Mesh::SetMesh(QString meshResourceName, bool clone)
     emit MeshChanged();
     
     return true;
+#else
+    return false;
+#endif
 }
 
 bool EC_Mesh::SetMeshWithSkeleton(const std::string& mesh_name, const std::string& skeleton_name, bool clone)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!ViewEnabled())
         return false;
     OgreWorldPtr world = world_.lock();
@@ -392,10 +462,14 @@ bool EC_Mesh::SetMeshWithSkeleton(const std::string& mesh_name, const std::strin
     emit MeshChanged();
     
     return true;
+#else
+    return false;
+#endif
 }
 
 void EC_Mesh::RemoveMesh()
 {
+#ifndef TUNDRA_NO_OGRE
     OgreWorldPtr world = world_.lock();
 
     if (entity_)
@@ -424,10 +498,12 @@ void EC_Mesh::RemoveMesh()
         
         cloned_mesh_name_ = std::string();
     }
+#endif
 }
 
 Ogre::Bone* EC_Mesh::GetBone(const QString& boneName) const
 {
+#ifndef TUNDRA_NO_OGRE
     std::string boneNameStd = boneName.toStdString();
     if (!entity_)
         return 0;
@@ -436,10 +512,14 @@ Ogre::Bone* EC_Mesh::GetBone(const QString& boneName) const
         return skel->getBone(boneNameStd);
     else
         return 0;
+#else
+    return 0;
+#endif
 }
 
 bool EC_Mesh::SetAttachmentMesh(uint index, const std::string& mesh_name, const std::string& attach_point, bool share_skeleton)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!ViewEnabled())
         return false;
     OgreWorldPtr world = world_.lock();
@@ -542,10 +622,14 @@ bool EC_Mesh::SetAttachmentMesh(uint index, const std::string& mesh_name, const
         return false;
     }
     return true;
+#else
+    return false;
+#endif
 }
 
 void EC_Mesh::RemoveAttachmentMesh(uint index)
 {
+#ifndef TUNDRA_NO_OGRE
     OgreWorldPtr world = world_.lock();
     
     if (!entity_)
@@ -583,6 +667,7 @@ void EC_Mesh::RemoveAttachmentMesh(uint index)
         sceneMgr->destroyEntity(attachment_entities_[index]);
         attachment_entities_[index] = 0;
     }
+#endif
 }
 
 void EC_Mesh::RemoveAllAttachments()
@@ -603,6 +688,7 @@ bool EC_Mesh::SetMaterial(uint index, const QString& material_name)
         return false;
     }
     
+#ifndef TUNDRA_NO_OGRE
     if (index >= entity_->getNumSubEntities())
     {
         LogError("EC_Mesh::SetMaterial: Could not set material " + material_name + ": illegal submesh index " + QString::number(index) + 
@@ -622,10 +708,12 @@ bool EC_Mesh::SetMaterial(uint index, const QString& material_name)
     }
     
     return true;
+#endif
 }
 
 bool EC_Mesh::SetAttachmentMaterial(uint index, uint submesh_index, const std::string& material_name)
 {
+#ifndef TUNDRA_NO_OGRE
     if (index >= attachment_entities_.size() || attachment_entities_[index] == 0)
     {
         LogError("EC_Mesh::SetAttachmentMaterial: Could not set material " + material_name + " on attachment: no mesh");
@@ -649,26 +737,38 @@ bool EC_Mesh::SetAttachmentMaterial(uint index, uint submesh_index, const std::s
     }
     
     return true;
+#else
+    return false;
+#endif
 }
 
 uint EC_Mesh::GetNumMaterials() const
 {
+#ifndef TUNDRA_NO_OGRE
     if (!entity_)
         return 0;
         
     return entity_->getNumSubEntities();
+#else
+    return GetNumSubMeshes();
+#endif
 }
 
 uint EC_Mesh::GetAttachmentNumMaterials(uint index) const
 {
+#ifndef TUNDRA_NO_OGRE
     if (index >= attachment_entities_.size() || attachment_entities_[index] == 0)
         return 0;
         
     return attachment_entities_[index]->getNumSubEntities();
+#else
+    return 0;
+#endif
 }
 
 const std::string& EC_Mesh::GetMaterialName(uint index) const
 {
+#ifndef TUNDRA_NO_OGRE
     const static std::string empty;
     
     if (!entity_)
@@ -678,10 +778,15 @@ const std::string& EC_Mesh::GetMaterialName(uint index) const
         return empty;
     
     return entity_->getSubEntity(index)->getMaterialName();
+#else
+    const static std::string empty;
+    return empty;
+#endif
 }
 
 const std::string& EC_Mesh::GetAttachmentMaterialName(uint index, uint submesh_index) const
 {
+#ifndef TUNDRA_NO_OGRE
     const static std::string empty;
     
     if (index >= attachment_entities_.size() || attachment_entities_[index] == 0)
@@ -690,6 +795,10 @@ const std::string& EC_Mesh::GetAttachmentMaterialName(uint index, uint submesh_i
         return empty;
     
     return attachment_entities_[index]->getSubEntity(submesh_index)->getMaterialName();
+#else
+    const static std::string empty;
+    return empty;
+#endif
 }
 
 bool EC_Mesh::HasAttachmentMesh(uint index) const
@@ -702,32 +811,47 @@ bool EC_Mesh::HasAttachmentMesh(uint index) const
 
 Ogre::Entity* EC_Mesh::GetAttachmentEntity(uint index) const
 {
+#ifndef TUNDRA_NO_OGRE
     if (index >= attachment_entities_.size())
         return 0;
     return attachment_entities_[index];
+#else
+    return 0;
+#endif
 }
 
 uint EC_Mesh::GetNumSubMeshes() const
 {
+#ifndef TUNDRA_NO_OGRE
     uint count = 0;
     if (HasMesh())
         if (entity_->getMesh().get())
             count = entity_->getMesh()->getNumSubMeshes();
     return count;
+#else
+    OgreMeshAssetPtr mesh = MeshAsset();
+    return mesh ? (uint)mesh->geometry.submeshes.size() : 0;
+#endif
 }
 
 const std::string& EC_Mesh::GetMeshName() const
 {
+#ifndef TUNDRA_NO_OGRE
     static std::string empty_name;
     
     if (!entity_)
         return empty_name;
     else
         return entity_->getMesh()->getName();
+#else
+    static std::string empty_name;
+    return empty_name;
+#endif
 }
 
 const std::string& EC_Mesh::GetSkeletonName() const
 {
+#ifndef TUNDRA_NO_OGRE
     static std::string empty_name;
     
     if (!entity_)
@@ -742,10 +866,15 @@ const std::string& EC_Mesh::GetSkeletonName() const
             return empty_name;
         return skel->getName();
     }
+#else
+    static std::string empty_name;
+    return empty_name;
+#endif
 }
 
 void EC_Mesh::DetachEntity()
 {
+#ifndef TUNDRA_NO_OGRE
     if ((!attached_) || (!entity_) || (!placeable_))
         return;
     
@@ -754,10 +883,12 @@ void EC_Mesh::DetachEntity()
     adjustment_node_->detachObject(entity_);
     node->removeChild(adjustment_node_);
     attached_ = false;
+#endif
 }
 
 void EC_Mesh::AttachEntity()
 {
+#ifndef TUNDRA_NO_OGRE
     if ((attached_) || (!entity_) || (!placeable_))
         return;
     
@@ -770,10 +901,12 @@ void EC_Mesh::AttachEntity()
     adjustment_node_->setVisible(placeable->visible.Get());
 
     attached_ = true;
+#endif
 }
 
 Ogre::Mesh* EC_Mesh::PrepareMesh(const std::string& mesh_name, bool clone)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!ViewEnabled())
         return 0;
     OgreWorldPtr world = world_.lock();
@@ -829,6 +962,9 @@ Ogre::Mesh* EC_Mesh::PrepareMesh(const std::string& mesh_name, bool clone)
     }
     
     return mesh.get();
+#else
+    return 0;
+#endif
 }
 
 void EC_Mesh::UpdateSignals()
@@ -843,6 +979,7 @@ void EC_Mesh::UpdateSignals()
 
 void EC_Mesh::OnAttributeUpdated(IAttribute *attribute)
 {
+#ifndef TUNDRA_NO_OGRE
     if (attribute == &drawDistance)
     {
         if(entity_)
@@ -878,11 +1015,15 @@ void EC_Mesh::OnAttributeUpdated(IAttribute *attribute)
         
         adjustment_node_->setScale(newTransform.scale);
     }
-    else if (attribute == &meshRef)
+    else
+#endif
+    if (attribute == &meshRef)
     {
+#ifndef TUNDRA_NO_OGRE
         if (!ViewEnabled())
             return;
-            
+#endif
+
         if (meshRef.Get().ref.trimmed().isEmpty())
             LogDebug("Warning: Mesh \"" + this->parentEntity->Name() + "\" mesh ref was set to an empty reference!");
         meshAsset->HandleAssetRefChange(&meshRef);
@@ -938,6 +1079,11 @@ void EC_Mesh::OnMeshAssetLoaded(AssetPtr asset)
         return;
     }
 
+#ifdef TUNDRA_NO_OGRE
+    if (!placeable_)
+        AutoSetPlaceable();
+    emit MeshChanged();
+#else
     QString ogreMeshName = mesh->Name();
     if (mesh)
     {
@@ -961,10 +1107,12 @@ void EC_Mesh::OnMeshAssetLoaded(AssetPtr asset)
             SetMaterial(idx, pendingMaterialApplies[idx]);
         pendingMaterialApplies.clear();
     }
+#endif
 }
 
 void EC_Mesh::OnSkeletonAssetLoaded(AssetPtr asset)
 {
+#ifndef TUNDRA_NO_OGRE
     OgreSkeletonAsset *skeletonAsset = dynamic_cast<OgreSkeletonAsset*>(asset.get());
     if (!skeletonAsset)
     {
@@ -1005,10 +1153,12 @@ void EC_Mesh::OnSkeletonAssetLoaded(AssetPtr asset)
 
     // Now we have to recreate the entity to get proper animations etc.
     SetMesh(entity_->getMesh()->getName().c_str(), false);
+#endif
 }
 
 void EC_Mesh::OnMaterialAssetLoaded(AssetPtr asset)
 {
+#ifndef TUNDRA_NO_OGRE
     OgreMaterialAsset *ogreMaterial = dynamic_cast<OgreMaterialAsset*>(asset.get());
     if (!ogreMaterial)
     {
@@ -1039,6 +1189,7 @@ void EC_Mesh::OnMaterialAssetLoaded(AssetPtr asset)
             LogDebug(QString::number(i) + ": " + materialList[i].ref);
     }
     #endif
+#endif
 }
 
 void EC_Mesh::OnMaterialAssetFailed(IAssetTransfer* transfer, QString reason)
@@ -1072,6 +1223,7 @@ void EC_Mesh::ApplyMaterial()
 
 Ogre::Bone* EC_Mesh::GetBone(const QString& bone_name)
 {
+#ifndef TUNDRA_NO_OGRE
     std::string boneNameStd = bone_name.toStdString();
     
     if (!entity_)
@@ -1081,10 +1233,14 @@ Ogre::Bone* EC_Mesh::GetBone(const QString& bone_name)
         return skel->getBone(boneNameStd);
     else
         return 0;
+#else
+    return 0;
+#endif
 }
 
 QStringList EC_Mesh::GetAvailableBones() const
 {
+#ifndef TUNDRA_NO_OGRE
     QStringList ret;
     
     if (!entity_)
@@ -1100,10 +1256,14 @@ QStringList EC_Mesh::GetAvailableBones() const
     }
     
     return ret;
+#else
+    return QStringList();
+#endif
 }
 
 void EC_Mesh::ForceSkeletonUpdate()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!entity_)
         return;
     Ogre::Skeleton* skel = entity_->getSkeleton();
@@ -1111,42 +1271,59 @@ void EC_Mesh::ForceSkeletonUpdate()
         return;
     if (entity_->getAllAnimationStates())
         skel->setAnimationState(*entity_->getAllAnimationStates());
+#endif
 }
 
 float3 EC_Mesh::GetBonePosition(const QString& bone_name)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Bone* bone = GetBone(bone_name);
     if (bone)
         return bone->getPosition();
     else
         return float3::zero;
+#else
+    return float3::zero;
+#endif
 }
 
 float3 EC_Mesh::GetBoneDerivedPosition(const QString& bone_name)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Bone* bone = GetBone(bone_name);
     if (bone)
         return bone->_getDerivedPosition();
     else
         return float3::zero;
+#else
+    return float3::zero;
+#endif
 }
 
 Quat EC_Mesh::GetBoneOrientation(const QString& bone_name)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Bone* bone = GetBone(bone_name);
     if (bone)
         return bone->getOrientation();
     else
         return Quat::identity;
+#else
+    return Quat::identity;
+#endif
 }
 
 Quat EC_Mesh::GetBoneDerivedOrientation(const QString& bone_name)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Bone* bone = GetBone(bone_name);
     if (bone)
         return bone->_getDerivedOrientation();
     else
         return Quat::identity;
+#else
+    return Quat::identity;
+#endif
 }
 /*
 float3 EC_Mesh::GetBoneOrientationEuler(const QString& bone_name)
@@ -1182,6 +1359,7 @@ float3 EC_Mesh::GetBoneDerivedOrientationEuler(const QString& bone_name)
 
 void EC_Mesh::SetMorphWeight(const QString& morphName, float weight)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!entity_)
         return;
     Ogre::AnimationStateSet* anims = entity_->getAllAnimationStates();
@@ -1202,10 +1380,12 @@ void EC_Mesh::SetMorphWeight(const QString& morphName, float weight)
         anim->setTimePosition(weight);
         anim->setEnabled(weight > 0.0f);
     }
+#endif
 }
 
 float EC_Mesh::GetMorphWeight(const QString& morphName) const
 {
+#ifndef TUNDRA_NO_OGRE
     if (!entity_)
         return 0.0f;
     Ogre::AnimationStateSet* anims = entity_->getAllAnimationStates();
@@ -1220,10 +1400,14 @@ float EC_Mesh::GetMorphWeight(const QString& morphName) const
     }
     else
         return 0.0f;
+#else
+    return 0.0f;
+#endif
 }
 
 void EC_Mesh::SetAttachmentMorphWeight(unsigned index, const QString& morphName, float weight)
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetAttachmentEntity(index);
     Ogre::AnimationStateSet* anims = entity->getAllAnimationStates();
     if (!anims)
@@ -1243,10 +1427,12 @@ void EC_Mesh::SetAttachmentMorphWeight(unsigned index, const QString& morphName,
         anim->setTimePosition(weight);
         anim->setEnabled(weight > 0.0f);
     }
+#endif
 }
 
 float EC_Mesh::GetAttachmentMorphWeight(unsigned index, const QString& morphName) const
 {
+#ifndef TUNDRA_NO_OGRE
     Ogre::Entity* entity = GetAttachmentEntity(index);
     if (!entity)
         return 0.0f;
@@ -1262,6 +1448,9 @@ float EC_Mesh::GetAttachmentMorphWeight(unsigned index, const QString& morphName
     }
     else
         return 0.0f;
+#else
+    return 0.0f;
+#endif
 }
 
 OBB EC_Mesh::WorldOBB() const
@@ -1285,6 +1474,13 @@ AABB EC_Mesh::WorldAABB() const
 
 AABB EC_Mesh::LocalAABB() const
 {
+#ifdef TUNDRA_NO_OGRE
+    OgreMeshAssetPtr mesh = MeshAsset();
+    if (!mesh || !mesh->IsLoaded())
+        return AABB();
+
+    return mesh->geometry.bounds;
+#else
     if (!entity_)
         return AABB();
 
@@ -1293,6 +1489,7 @@ AABB EC_Mesh::LocalAABB() const
         return AABB();
 
     return AABB(mesh->getBounds());
+#endif
 }
 
 OgreMeshAssetPtr EC_Mesh::MeshAsset() const
@@ -1304,18 +1501,27 @@ OgreMeshAssetPtr EC_Mesh::MeshAsset() const
 
 OgreMaterialAssetPtr EC_Mesh::MaterialAsset(int materialIndex) const
 {
+#ifndef TUNDRA_NO_OGRE
     if (materialIndex < 0 || materialIndex >= (int)materialAssets.size())
         return OgreMaterialAssetPtr();
     return boost::dynamic_pointer_cast<OgreMaterialAsset>(materialAssets[materialIndex]->Asset());
+#else
+    return OgreMaterialAssetPtr();
+#endif
 }
 
 OgreSkeletonAssetPtr EC_Mesh::SkeletonAsset() const
 {
+#ifndef TUNDRA_NO_OGRE
     if (!skeletonAsset)
         return OgreSkeletonAssetPtr();
     return boost::dynamic_pointer_cast<OgreSkeletonAsset>(skeletonAsset->Asset());
+#else
+    return OgreSkeletonAssetPtr();
+#endif
 }
 
+#ifndef TUNDRA_NO_OGRE
 Ogre::Vector2 FindUVs(const Ogre::Vector3& hitPoint, const Ogre::Vector3& t1, const Ogre::Vector3& t2, const Ogre::Vector3& t3, const Ogre::Vector2& tex1, const Ogre::Vector2& tex2, const Ogre::Vector2& tex3)
 {
     Ogre::Vector3 v1 = hitPoint - t1;
@@ -1334,9 +1540,11 @@ Ogre::Vector2 FindUVs(const Ogre::Vector3& hitPoint, const Ogre::Vector3& t1, co
     
     return t;
 }
+#endif
 
 bool EC_Mesh::Raycast(Ogre::Entity* meshEntity, const Ray& ray, float* distance, unsigned* subMeshIndex, unsigned* triangleIndex, float3* hitPosition, float3* normal, float2* uv)
 {
+#ifndef TUNDRA_NO_OGRE
     PROFILE(EC_Mesh_Raycast);
     
     if (!meshEntity)
@@ -1485,4 +1693,7 @@ bool EC_Mesh::Raycast(Ogre::Entity* meshEntity, const Ray& ray, float* distance,
     }
     
     return closestDistance >= 0.0f;
+#else
+    return false;
+#endif
 }
@@ -146,6 +146,9 @@ public:
 
     virtual ~EC_Mesh();
 
+    /// IComponent override. Adds the Ogre mesh and skeleton resources used by the mesh entity and its attachments.
+    virtual void SharedResources(std::map<const void *, size_t> &resources) const;
+
     /// Transformation attribute is used to do some position, rotation and scale adjustments.
     Q_PROPERTY(Transform nodeTransformation READ getnodeTransformation WRITE setnodeTransformation);
     DEFINE_QPROPERTY_ATTRIBUTE(Transform, nodeTransformation);
@@ -4,10 +4,12 @@
 #include "DebugOperatorNew.h"
 
 #include "EC_OgreCompositor.h"
-#include "Renderer.h"
 #include "FrameAPI.h"
 #include "OgreRenderingModule.h"
+#ifndef TUNDRA_NO_OGRE
+#include "Renderer.h"
 #include "OgreCompositionHandler.h"
+#endif
 
 #include "LoggingFunctions.h"
 
@@ -22,6 +24,7 @@ EC_OgreCompositor::EC_OgreCompositor(Scene* scene) :
     previousPriority(-1),
     compositionHandler(0)
 {
+#ifndef TUNDRA_NO_OGRE
     OgreRenderer::OgreRenderingModule *owner = framework->GetModule<OgreRenderer::OgreRenderingModule>();
     assert(owner && "No OgrerenderingModule.");
     compositionHandler = owner->GetRenderer()->CompositionHandler();
@@ -30,32 +33,44 @@ EC_OgreCompositor::EC_OgreCompositor(Scene* scene) :
 
     // Ogre sucks. Enable a timed one-time refresh to overcome issue with black screen.
     framework->Frame()->DelayedExecute(0.01f, this, SLOT(OneTimeRefresh()));
+#endif
 }
 
 EC_OgreCompositor::~EC_OgreCompositor()
 {
+#ifndef TUNDRA_NO_OGRE
     if (compositionHandler && !previousRef.isEmpty())
         compositionHandler->RemoveCompositorFromViewport(previousRef.toStdString());
+#endif
 }
 
 QStringList EC_OgreCompositor::AvailableCompositors() const
 {
+#ifndef TUNDRA_NO_OGRE
     if (compositionHandler)
         return compositionHandler->AvailableCompositors();
     else
         return QStringList();
+#else
+    return QStringList();
+#endif
 }
 
 QStringList EC_OgreCompositor::ApplicableParameters() const
 {
+#ifndef TUNDRA_NO_OGRE
     if (compositionHandler)
         return compositionHandler->CompositorParameters(compositorName.Get().toStdString());
     else
         return QStringList();
+#else
+    return QStringList();
+#endif
 }
 
 void EC_OgreCompositor::OnAttributeUpdated(IAttribute* attribute)
 {
+#ifndef TUNDRA_NO_OGRE
     if (attribute == &enabled)
     {
         UpdateCompositor(compositorName.Get());
@@ -70,10 +85,12 @@ void EC_OgreCompositor::OnAttributeUpdated(IAttribute* attribute)
     {
         UpdateCompositorParams(compositorName.Get());
     }
+#endif
 }
 
 void EC_OgreCompositor::UpdateCompositor(const QString &compositor)
 {
+#ifndef TUNDRA_NO_OGRE
     if (ViewEnabled() && enabled.Get())
     {
         if (previousRef != compositorName.Get() || previousPriority != priority.Get())
@@ -93,10 +110,12 @@ void EC_OgreCompositor::UpdateCompositor(const QString &compositor)
             previousPriority = priority.Get();
         }
     }
+#endif
 }
 
 void EC_OgreCompositor::UpdateCompositorParams(const QString &compositor)
 {
+#ifndef TUNDRA_NO_OGRE
     if (ViewEnabled() && enabled.Get())
     {
         QList<std::pair<std::string, Ogre::Vector4> > programParams;
@@ -124,6 +143,7 @@ void EC_OgreCompositor::UpdateCompositorParams(const QString &compositor)
         compositionHandler->SetCompositorEnabled(compositorName.Get().toStdString(), false);
         compositionHandler->SetCompositorEnabled(compositorName.Get().toStdString(), true);
     }
+#endif
 }
 
 void EC_OgreCompositor::OneTimeRefresh()
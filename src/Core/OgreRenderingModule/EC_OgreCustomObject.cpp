@@ -3,14 +3,18 @@
 #include "StableHeaders.h"
 #include "DebugOperatorNew.h"
 #include "OgreRenderingModule.h"
+#ifndef TUNDRA_NO_OGRE
 #include "OgreWorld.h"
 #include "Renderer.h"
+#endif
 #include "Entity.h"
 #include "Scene.h"
 #include "EC_Placeable.h"
 #include "EC_OgreCustomObject.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
+#endif
 #include "MemoryLeakCheck.h"
 
 using namespace OgreRenderer;
@@ -22,8 +26,10 @@ EC_OgreCustomObject::EC_OgreCustomObject(Scene* scene) :
     cast_shadows_(false),
     draw_distance_(0.0f)
 {
+#ifndef TUNDRA_NO_OGRE
     if (scene)
         world_ = scene->GetWorld<OgreWorld>();
+#endif
 }
 
 EC_OgreCustomObject::~EC_OgreCustomObject()
@@ -38,6 +44,14 @@ EC_OgreCustomObject::~EC_OgreCustomObject()
     DestroyEntity();
 }
 
+void EC_OgreCustomObject::SharedResources(std::map<const void *, size_t> &resources) const
+{
+#ifndef TUNDRA_NO_OGRE
+    if (entity_)
+        resources[entity_->getMesh().get()] = entity_->getMesh()->getSize();
+#endif
+}
+
 void EC_OgreCustomObject::SetPlaceable(ComponentPtr placeable)
 {
     if (placeable && !dynamic_cast<EC_Placeable*>(placeable.get()))
@@ -53,6 +67,7 @@ void EC_OgreCustomObject::SetPlaceable(ComponentPtr placeable)
 
 bool EC_OgreCustomObject::CommitChanges(Ogre::ManualObject* object)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!object)
         return false;
     
@@ -109,24 +124,32 @@ bool EC_OgreCustomObject::CommitChanges(Ogre::ManualObject* object)
     }
     
     return true;
+#else
+    return false;
+#endif
 }
 
 void EC_OgreCustomObject::SetDrawDistance(float draw_distance)
 {
+#ifndef TUNDRA_NO_OGRE
     draw_distance_ = draw_distance;
     if (entity_)
         entity_->setRenderingDistance(draw_distance);
+#endif
 }
 
 void EC_OgreCustomObject::SetCastShadows(bool enabled)
 {
+#ifndef TUNDRA_NO_OGRE
     cast_shadows_ = enabled;
     if (entity_)
         entity_->setCastShadows(enabled);
+#endif
 }
 
 bool EC_OgreCustomObject::SetMaterial(uint index, const std::string& material_name)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!entity_)
         return false;
     
@@ -147,18 +170,26 @@ bool EC_OgreCustomObject::SetMaterial(uint index, const std::string& material_na
     }
     
     return true;
+#else
+    return false;
+#endif
 }
 
 uint EC_OgreCustomObject::GetNumMaterials() const
 {
+#ifndef TUNDRA_NO_OGRE
     if (!entity_)
         return 0;
         
     return entity_->getNumSubEntities();
+#else
+    return 0;
+#endif
 }
 
 const std::string& EC_OgreCustomObject::GetMaterialName(uint index) const
 {
+#ifndef TUNDRA_NO_OGRE
     const static std::string empty;
     
     if (!entity_)
@@ -168,10 +199,15 @@ const std::string& EC_OgreCustomObject::GetMaterialName(uint index) const
         return empty;
     
     return entity_->getSubEntity(index)->getMaterialName();
-}    
+#else
+    const static std::string empty;
+    return empty;
+#endif
+}
        
 void EC_OgreCustomObject::AttachEntity()
 {
+#ifndef TUNDRA_NO_OGRE
     if ((placeable_) && (!attached_) && (entity_))
     {
         EC_Placeable* placeable = checked_static_cast<EC_Placeable*>(placeable_.get());
@@ -179,10 +215,12 @@ void EC_OgreCustomObject::AttachEntity()
         node->attachObject(entity_);
         attached_ = true;
     }
+#endif
 }
 
 void EC_OgreCustomObject::DetachEntity()
 {
+#ifndef TUNDRA_NO_OGRE
     if ((placeable_) && (attached_) && (entity_))
     {
         EC_Placeable* placeable = checked_static_cast<EC_Placeable*>(placeable_.get());
@@ -190,10 +228,12 @@ void EC_OgreCustomObject::DetachEntity()
         node->detachObject(entity_);
         attached_ = false;
     }
+#endif
 }
 
 void EC_OgreCustomObject::DestroyEntity()
 {
+#ifndef TUNDRA_NO_OGRE
     if (world_.expired())
         return;
     OgreWorldPtr world = world_.lock();
@@ -212,10 +252,12 @@ void EC_OgreCustomObject::DestroyEntity()
         }
         catch(...) {}
     }
+#endif
 }
 
 void EC_OgreCustomObject::GetBoundingBox(float3& min, float3& max) const
 {
+#ifndef TUNDRA_NO_OGRE
     if (!entity_)
     {
         min = float3(0.0, 0.0, 0.0);
@@ -229,5 +271,9 @@ void EC_OgreCustomObject::GetBoundingBox(float3& min, float3& max) const
     
     min = float3(bboxmin.x, bboxmin.y, bboxmin.z);
     max = float3(bboxmax.x, bboxmax.y, bboxmax.z);
+#else
+    min = float3::zero;
+    max = float3::zero;
+#endif
 }
 
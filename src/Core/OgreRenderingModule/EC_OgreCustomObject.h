@@ -53,6 +53,9 @@ public:
 
     virtual ~EC_OgreCustomObject();
 
+    /// IComponent override. Adds the Ogre mesh resource created for the object.
+    virtual void SharedResources(std::map<const void *, size_t> &resources) const;
+
     /// gets placeable component
     ComponentPtr GetPlaceable() const { return placeable_; }
 
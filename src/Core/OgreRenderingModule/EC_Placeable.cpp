@@ -1,14 +1,18 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include "StableHeaders.h"
+#ifndef TUNDRA_NO_OGRE
 #define MATH_OGRE_INTEROP
+#endif
 #include "DebugOperatorNew.h"
 
 #include "EC_Mesh.h"
 #include "EC_Placeable.h"
+#ifndef TUNDRA_NO_OGRE
 #include "OgreRenderingModule.h"
 #include "OgreWorld.h"
 #include "Renderer.h"
+#endif
 
 #include "AttributeMetadata.h"
 #include "EC_Mesh.h"
@@ -19,14 +23,19 @@
 #include "Math/float3x4.h"
 #include "LoggingFunctions.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
 #include <OgreTagPoint.h>
+#endif
+
+#include <algorithm>
 
 #include "MemoryLeakCheck.h"
 
 using namespace OgreRenderer;
 
 /** @cond PRIVATE */
+#ifndef TUNDRA_NO_OGRE
 class CustomTagPoint : public Ogre::TagPoint
 {
 public:
@@ -163,6 +172,7 @@ void SetShowBoundingBoxRecursive(Ogre::SceneNode* node, bool enable)
             SetShowBoundingBoxRecursive(childNode, enable);
     }
 }
+#endif
 /** @endcond */
 
 EC_Placeable::EC_Placeable(Scene* scene) :
@@ -173,6 +183,10 @@ EC_Placeable::EC_Placeable(Scene* scene) :
     parentPlaceable_(0),
     parentMesh_(0),
     attached_(false),
+    worldTransform_(float3x4::identity),
+    worldTransformDirty_(true),
+    transformParent_(0),
+    transformParentResolved_(false),
     transform(this, "Transform"),
     drawDebug(this, "Show bounding box", false),
     visible(this, "Visible", true),
@@ -180,9 +194,6 @@ EC_Placeable::EC_Placeable(Scene* scene) :
     parentRef(this, "Parent entity ref", EntityReference()),
     parentBone(this, "Parent bone name", "")
 {
-    if (scene)
-        world_ = scene->GetWorld<OgreWorld>();
-    
     // Enable network interpolation for the transform
     static AttributeMetadata transAttrData;
     static AttributeMetadata nonDesignableAttrData;
@@ -195,6 +206,10 @@ EC_Placeable::EC_Placeable(Scene* scene) :
     }
     transform.SetMetadata(&transAttrData);
 
+#ifndef TUNDRA_NO_OGRE
+    if (scene)
+        world_ = scene->GetWorld<OgreWorld>();
+
     OgreWorldPtr world = world_.lock();
     if (world)
     {
@@ -211,10 +226,22 @@ EC_Placeable::EC_Placeable(Scene* scene) :
     
         AttachNode();
     }
+#endif
 }
 
 EC_Placeable::~EC_Placeable()
 {
+    // Leave the transform hierarchy. The children look up their transform parent again when needed.
+    ResetTransformParent();
+    for(size_t i = 0; i < transformChildren_.size(); ++i)
+    {
+        transformChildren_[i]->transformParent_ = 0;
+        transformChildren_[i]->transformParentResolved_ = false;
+        transformChildren_[i]->InvalidateWorldTransform();
+    }
+    transformChildren_.clear();
+
+#ifndef TUNDRA_NO_OGRE
     if (world_.expired())
     {
         if (sceneNode_)
@@ -241,10 +268,12 @@ EC_Placeable::~EC_Placeable()
         sceneMgr->destroySceneNode(boneAttachmentNode_);
         boneAttachmentNode_ = 0;
     }
+#endif
 }
 
 void EC_Placeable::AttachNode()
 {
+#ifndef TUNDRA_NO_OGRE
     if (world_.expired())
     {
         LogError("EC_Placeable::AttachNode: No OgreWorld available to call this function!");
@@ -384,10 +413,12 @@ void EC_Placeable::AttachNode()
         LogError("EC_Placeable::AttachNode: Ogre exception " + std::string(e.what()));
         return;
     }
+#endif
 }
 
 void EC_Placeable::DetachNode()
 {
+#ifndef TUNDRA_NO_OGRE
     if (world_.expired())
     {
         LogError("EC_Placeable::DetachNode: No OgreWorld available to call this function!");
@@ -430,30 +461,37 @@ void EC_Placeable::DetachNode()
     {
         LogError("EC_Placeable::DetachNode: Ogre exception " + std::string(e.what()));
     }
+#endif
 }
 
 void EC_Placeable::Show()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!sceneNode_)
         return;
 
     sceneNode_->setVisible(true);
+#endif
 }
 
 void EC_Placeable::Hide()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!sceneNode_)
         return;
 
     sceneNode_->setVisible(false);
+#endif
 }
 
 void EC_Placeable::ToggleVisibility()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!sceneNode_)
         return;
 
     sceneNode_->flipVisibility();
+#endif
 }
 
 void EC_Placeable::SetParent(Entity *parent, bool preserveWorldTransform)
@@ -511,6 +549,7 @@ void EC_Placeable::SetParent(Entity *parent, QString boneName, bool preserveWorl
             return;
         }
 
+#ifndef TUNDRA_NO_OGRE
         Ogre::Bone *parentBone = mesh->GetBone(boneName);
         if (!parentBone)
         {
@@ -519,6 +558,11 @@ void EC_Placeable::SetParent(Entity *parent, QString boneName, bool preserveWorl
         }
         if (preserveWorldTransform)
             desiredTransform = float4x4(parentBone->_getFullTransform()).Float3x4Part() * desiredTransform;
+#else
+        // Skeletons are not loaded without a renderer, so the bone is assumed to be at the origin of the parent.
+        if (preserveWorldTransform)
+            desiredTransform = parentPlaceable->WorldToLocal() * desiredTransform;
+#endif
         parentRef.Set(EntityReference(parent->Id()), AttributeChange::Default);
     }
     // Not attaching to a bone, clear any previous bone ref.
@@ -671,6 +715,7 @@ void EC_Placeable::RegisterActions()
 
 void EC_Placeable::HandleAttributeChanged(IAttribute* attribute, AttributeChange::Type change)
 {
+#ifndef TUNDRA_NO_OGRE
     // If parent ref or parent bone changed, reattach node to scene hierarchy
     if ((attribute == &parentRef) || (attribute == &parentBone))
         AttachNode();
@@ -705,6 +750,7 @@ void EC_Placeable::HandleAttributeChanged(IAttribute* attribute, AttributeChange
     }
     else if (attribute == &visible && sceneNode_)
         sceneNode_->setVisible(visible.Get());
+#endif
 }
 
 void EC_Placeable::OnParentMeshDestroyed()
@@ -833,7 +879,8 @@ void EC_Placeable::SetWorldTransform(const float3x4 &tm)
 {
     assume(tm.IsColOrthogonal());
     assume(!tm.HasNegativeScale());
-    if (!parentPlaceable_) // No parent, the local->parent transform equals the local->world transform.
+    EC_Placeable *parentPlaceable = TransformParent();
+    if (!parentBone_ && !parentPlaceable) // No parent, the local->parent transform equals the local->world transform.
     {
         SetTransform(tm);
         return;
@@ -841,10 +888,12 @@ void EC_Placeable::SetWorldTransform(const float3x4 &tm)
 
     float3x4 parentWorldTransform = float3x4::identity;
 
+#ifndef TUNDRA_NO_OGRE
     if (parentBone_)
         parentWorldTransform = float4x4(parentBone_->_getFullTransform()).Float3x4Part();
     else
-        parentWorldTransform = parentPlaceable_->LocalToWorld();
+#endif
+        parentWorldTransform = parentPlaceable->LocalToWorld();
 
     bool success = parentWorldTransform.Inverse();
     if (!success)
@@ -918,16 +967,22 @@ float3 EC_Placeable::Scale() const
 float3x4 EC_Placeable::LocalToWorld() const
 {
     // If we are parented to an Ogre bone, we can't (yet) compute the local-to-world matrix ourselves,
-    // so query Ogre for the world matrix.
+    // so query Ogre for the world matrix. The bone is animated outside the Tundra scene, so this is never cached,
+    // and the world transform stays dirty, which keeps also the children of this placeable from caching theirs.
+#ifndef TUNDRA_NO_OGRE
     if (!parentBone.Get().isEmpty() && sceneNode_)
         return float4x4(sceneNode_->_getFullTransform()).Float3x4Part();
+#endif
+
+    if (!worldTransformDirty_)
+        return worldTransform_;
 
     // Otherwise, compute the world matrix using our Tundra scene structures (not the Ogre scene structures, which can be out-of-date!)
-    EC_Placeable *parentPlaceable = ParentPlaceableComponent();
+    EC_Placeable *parentPlaceable = TransformParent();
     assert(parentPlaceable != this);
     float3x4 localToWorld = parentPlaceable ? (parentPlaceable->LocalToWorld() * LocalToParent()) : LocalToParent();
 
-#ifdef _DEBUG
+#if defined(_DEBUG) && !defined(TUNDRA_NO_OGRE)
     // But confirm to detect oddities when/if these two don't match.
     if (sceneNode_)
     {
@@ -941,6 +996,10 @@ float3x4 EC_Placeable::LocalToWorld() const
     }
 #endif
 
+    // The result can be cached only if the parent was found and its world transform was cacheable as well.
+    // Otherwise recompute on each call, like when the parent entity has not been created yet.
+    worldTransform_ = localToWorld;
+    worldTransformDirty_ = !transformParentResolved_ || (parentPlaceable && parentPlaceable->worldTransformDirty_);
     return localToWorld;
 }
 
@@ -964,3 +1023,75 @@ float3x4 EC_Placeable::ParentToLocal() const
     assume(success);
     return tm;
 }
+
+void EC_Placeable::AttributeValueSet(IAttribute *attribute)
+{
+    // Invalidate immediately instead of in HandleAttributeChanged, as the change signals are not emitted
+    // for disconnected changes, and are deferred to the end of the frame when attribute changes are batched.
+    if (attribute == &transform)
+        InvalidateWorldTransform();
+    else if (attribute == &parentRef || attribute == &parentBone)
+        ResetTransformParent();
+}
+
+EC_Placeable *EC_Placeable::TransformParent() const
+{
+    if (transformParentResolved_)
+        return transformParent_;
+
+    const EntityReference &parent = parentRef.Get();
+    if (parent.IsEmpty())
+    {
+        transformParentResolved_ = true;
+        return 0;
+    }
+
+    Entity *parentEntity = parent.Lookup(ParentScene()).get();
+    if (!parentEntity)
+        return 0; // The parent entity may not have been created yet. Try again on the next call.
+    if (parentEntity == ParentEntity())
+    {
+        // If we refer to self, we are in world space
+        transformParentResolved_ = true;
+        return 0;
+    }
+    EC_Placeable *parentPlaceable = parentEntity->GetComponent<EC_Placeable>().get();
+    if (!parentPlaceable)
+        return 0; // Wait for the parent placeable to be created
+
+    // If we have a cyclic parenting attempt, treat this placeable as being in world space. Follow only the resolved links,
+    // so that resolving does not recurse.
+    for(EC_Placeable *parentCheck = parentPlaceable; parentCheck; parentCheck = parentCheck->transformParentResolved_ ? parentCheck->transformParent_ : 0)
+        if (parentCheck == this)
+        {
+            transformParentResolved_ = true;
+            return 0;
+        }
+
+    transformParent_ = parentPlaceable;
+    transformParent_->transformChildren_.push_back(const_cast<EC_Placeable *>(this));
+    transformParentResolved_ = true;
+    return transformParent_;
+}
+
+void EC_Placeable::ResetTransformParent() const
+{
+    if (transformParent_)
+    {
+        std::vector<EC_Placeable*> &siblings = transformParent_->transformChildren_;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+        transformParent_ = 0;
+    }
+    transformParentResolved_ = false;
+    InvalidateWorldTransform();
+}
+
+void EC_Placeable::InvalidateWorldTransform() const
+{
+    // A placeable can cache its world transform only when its parent has cached one, so if this is dirty, all the children are as well.
+    if (worldTransformDirty_)
+        return;
+    worldTransformDirty_ = true;
+    for(size_t i = 0; i < transformChildren_.size(); ++i)
+        transformChildren_[i]->InvalidateWorldTransform();
+}
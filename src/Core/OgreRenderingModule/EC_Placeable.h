@@ -9,8 +9,11 @@
 #include "OgreModuleFwd.h"
 #include "Transform.h"
 #include "Math/float3.h"
+#include "Math/float3x4.h"
 #include "Math/MathFwd.h"
 
+#include <vector>
+
 namespace Ogre { class Bone; }
 
 /// Ogre placeable (scene node) component
@@ -184,6 +187,8 @@ public slots:
     float3 Scale() const;
 
     /// Returns the concatenated world transformation of this placeable.
+    /** The world transformation is cached, and recomputed only after the transform or the parenting of this placeable
+        or one of its parents has changed. This does not depend on the Ogre scene nodes, so it works also without a renderer. */
     float3x4 LocalToWorld() const;
     /// Returns the matrix that transforms objects from world space into the local coordinate space of this placeable.
     float3x4 WorldToLocal() const;
@@ -288,6 +293,19 @@ private slots:
     void OnComponentAdded(IComponent* component, AttributeChange::Type change);
 
 private:
+    /// IComponent override. Invalidates the cached world transform when the transform or the parenting changes.
+    virtual void AttributeValueSet(IAttribute *attribute);
+
+    /// Returns the placeable the world transform of this placeable is concatenated to, looking it up from parentRef if needed.
+    /** Unlike ParentPlaceableComponent(), this does not depend on the Ogre scene node hierarchy. */
+    EC_Placeable *TransformParent() const;
+
+    /// Unregisters from the current transform parent so that it is looked up again from parentRef, and invalidates the world transform.
+    void ResetTransformParent() const;
+
+    /// Marks the cached world transform of this placeable and of all its children dirty.
+    void InvalidateWorldTransform() const;
+
     /// attaches scenenode to parent
     void AttachNode();
     
@@ -315,6 +333,21 @@ private:
     /// attached to scene hierarchy-flag
     bool attached_;
 
+    /// Cached local-to-world transform
+    mutable float3x4 worldTransform_;
+
+    /// If true, worldTransform_ is out of date and is recomputed on the next LocalToWorld call
+    mutable bool worldTransformDirty_;
+
+    /// Placeable the world transform is concatenated to, looked up from parentRef
+    mutable EC_Placeable* transformParent_;
+
+    /// If false, transformParent_ needs to be looked up again
+    mutable bool transformParentResolved_;
+
+    /// Placeables that use this placeable as their transform parent
+    mutable std::vector<EC_Placeable*> transformChildren_;
+
     friend class BoneAttachmentListener;
     friend class CustomTagPoint;
 };
@@ -5,7 +5,9 @@
 
 #include "EC_RttTarget.h"
 #include "EC_Camera.h"
+#ifndef TUNDRA_NO_OGRE
 #include "OgreMaterialUtils.h"
+#endif
 
 #include "Scene.h"
 #include "FrameAPI.h"
@@ -31,6 +33,7 @@ EC_RttTarget::EC_RttTarget(Scene* scene) :
 
 EC_RttTarget::~EC_RttTarget()
 {
+#ifndef TUNDRA_NO_OGRE
     // Cannot use ViewEnabled() here, the parent entity is already null,
     // which means it will return true. After that we will crash below calling Ogre.
     if (framework->IsHeadless())
@@ -45,10 +48,12 @@ EC_RttTarget::~EC_RttTarget()
     //does this remove also the rendertarget with the viewports etc? seems so?
     
     Ogre::MaterialManager::getSingleton().remove(material_name_);
+#endif
 }
 
 void EC_RttTarget::PrepareRtt()
 {
+#ifndef TUNDRA_NO_OGRE
     if (!ViewEnabled())
         return;
 
@@ -97,10 +102,12 @@ void EC_RttTarget::PrepareRtt()
     Ogre::MaterialManager &material_manager = Ogre::MaterialManager::getSingleton();
     Ogre::MaterialPtr material = material_manager.getByName(material_name_);
     OgreRenderer::SetTextureUnitOnMaterial(material, textureName.Get().toStdString());
+#endif
 }
 
 void EC_RttTarget::SetAutoUpdated(bool val)
 {
+#ifndef TUNDRA_NO_OGRE
     if (!ViewEnabled())
         return;
 
@@ -119,6 +126,7 @@ void EC_RttTarget::SetAutoUpdated(bool val)
     }
 
     tex->getBuffer()->getRenderTarget()->setAutoUpdated(val);
+#endif
 }
 
 /*void EC_RttTarget::ScheduleRender()
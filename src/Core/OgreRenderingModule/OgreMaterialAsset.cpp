@@ -330,8 +330,7 @@ void OgreMaterialAsset::DependencyLoaded(AssetPtr dependee)
 
     CreateOgreMaterial(parsedOgreMaterialAsset);
     parsedOgreMaterialAsset = ""; // Save memory, this in-memory copy of the sanitated material is no longer used.
-
-    LoadCompleted();
+    // AssetAPI emits Loaded() once the material is ready.
 }
 
 AssetPtr OgreMaterialAsset::Clone(QString newAssetName) const
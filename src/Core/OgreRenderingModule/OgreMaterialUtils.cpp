@@ -11,13 +11,30 @@
 #include "AssetAPI.h"
 #include "QtUtils.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
+#endif
 
 #include "MemoryLeakCheck.h"
 
 namespace OgreRenderer
 {
 
+#ifdef TUNDRA_NO_OGRE
+/// Reads material script data line by line like Ogre::DataStream::getLine() does, for builds without Ogre.
+class ScriptLineStream
+{
+public:
+    ScriptLineStream(const char *data, int size) : lines(QString::fromUtf8(data, size).split('\n')), index(0) {}
+    bool eof() const { return index >= lines.size(); }
+    /// Returns the next line with leading and trailing whitespace removed.
+    std::string getLine() { return eof() ? std::string() : lines[index++].trimmed().toStdString(); }
+private:
+    QStringList lines;
+    int index;
+};
+#endif
+
 std::string AddDoubleQuotesIfNecessary(const std::string &str)
 {
     std::string ret = str;
@@ -57,6 +74,7 @@ void DesanitateAssetIds(std::string &script, const QStringList &keywords)
     script = lines.join("\n").toStdString();
 }
 
+#ifndef TUNDRA_NO_OGRE
 Ogre::MaterialPtr CloneMaterial(const std::string& sourceMaterialName, const std::string &newName)
 {
     Ogre::MaterialManager &mm = Ogre::MaterialManager::getSingleton();
@@ -235,6 +253,8 @@ void GetTextureNamesFromMaterial(Ogre::MaterialPtr material, StringVector& textu
     }
 }
 
+#endif
+
 bool ProcessBraces(const std::string& line, int& braceLevel)
 {
     if (line == "{")
@@ -275,7 +295,11 @@ QSet<QString> ProcessMaterialFileForTextures(const QString& matfilename, const Q
             bool skip_until_next = false;
             int skip_brace_level = 0;
 #include "DisableMemoryLeakCheck.h"
+#ifndef TUNDRA_NO_OGRE
             Ogre::DataStreamPtr data = Ogre::DataStreamPtr(new Ogre::MemoryDataStream(bytes.data(), bytes.size()));
+#else
+            boost::shared_ptr<ScriptLineStream> data(new ScriptLineStream(bytes.data(), bytes.size()));
+#endif
 #include "EnableMemoryLeakCheck.h"
             
             while(!data->eof())
@@ -367,7 +391,11 @@ QString LoadSingleMaterialFromFile(const QString &filename, const QString &mater
         int skip_brace_level = 0;
 
 #include "DisableMemoryLeakCheck.h"
+#ifndef TUNDRA_NO_OGRE
         Ogre::DataStreamPtr data = Ogre::DataStreamPtr(new Ogre::MemoryDataStream(bytes.data(), bytes.size()));
+#else
+        boost::shared_ptr<ScriptLineStream> data(new ScriptLineStream(bytes.data(), bytes.size()));
+#endif
 #include "EnableMemoryLeakCheck.h"
         while(!data->eof())
         {
@@ -459,7 +487,11 @@ std::set<MaterialInfo> LoadAllMaterialsFromFile(const QString &filename)
         material.source = filename;
 
 #include "DisableMemoryLeakCheck.h"
+#ifndef TUNDRA_NO_OGRE
         Ogre::DataStreamPtr data = Ogre::DataStreamPtr(new Ogre::MemoryDataStream(bytes.data(), bytes.size()));
+#else
+        boost::shared_ptr<ScriptLineStream> data(new ScriptLineStream(bytes.data(), bytes.size()));
+#endif
 #include "EnableMemoryLeakCheck.h"
         while(!data->eof())
         {
@@ -519,6 +551,7 @@ QStringList FindMaterialFiles(const QString &dir)
     return files;
 }
 
+#ifndef TUNDRA_NO_OGRE
 ShaderParameterMap GatherShaderParameters(const Ogre::MaterialPtr &material, bool includeTextureUnits)
 {
     ShaderParameterMap ret;
@@ -763,4 +796,6 @@ QString TextureTypeToString(Ogre::TextureType type)
     };
 }
 
+#endif
+
 }
@@ -6,9 +6,11 @@
 
 #pragma once
 
+#ifndef TUNDRA_NO_OGRE
 #include <OgreMaterial.h>
 #include <OgreTexture.h>
 #include <OgreGpuProgram.h>
+#endif
 
 #include "CoreTypes.h"
 #include "OgreModuleApi.h"
@@ -39,6 +41,7 @@ namespace OgreRenderer
         @param keywords List of keywords/IDs <b> appended with a space </b>, e.g. "material ", "texture " and "particle_system ". */
     void OGRE_MODULE_API DesanitateAssetIds(std::string &script, const QStringList &keywords);
 
+#ifndef TUNDRA_NO_OGRE
     /// Returns an Ogre material with the given name, or creates it if it doesn't exist.
     /** The material is derived from an UnlitTextured material, that's a simple one to use for debugging visualizations. */
     Ogre::MaterialPtr OGRE_MODULE_API GetOrCreateUnlitTexturedMaterial(const std::string& materialName);
@@ -61,6 +64,8 @@ namespace OgreRenderer
     /// Returns texture names used by a material's all techniques, passes & textureunits. Does not return duplicates.
     void OGRE_MODULE_API GetTextureNamesFromMaterial(Ogre::MaterialPtr material, StringVector& textures);
 
+#endif
+
     /// Counts indentation levels of brace blocks in a file.
     bool OGRE_MODULE_API ProcessBraces(const std::string& line, int& braceLevel);
 
@@ -94,6 +99,7 @@ namespace OgreRenderer
     typedef QMap<QString, QVariant> ShaderParameterMap;
     typedef QMapIterator<QString, QVariant> ShaderParameterMapIter;
 
+#ifndef TUNDRA_NO_OGRE
     /// Gathers name-value map of shader parameters of Ogre material.
     /** Vertex shader, fragment/pixel shader and texture unit names are appended with " VP", " FP" and " TU" respectively.
         @param material Material to be inspected.
@@ -105,4 +111,5 @@ namespace OgreRenderer
 
     /// Utility function for converting Ogre::GpuConstantType enum to type string.
     QString OGRE_MODULE_API TextureTypeToString(Ogre::TextureType type);
+#endif
 }
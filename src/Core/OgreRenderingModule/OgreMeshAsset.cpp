@@ -12,7 +12,9 @@
 
 #include <QFile>
 #include <QFileInfo>
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
+#endif
 
 #include "LoggingFunctions.h"
 #include "MemoryLeakCheck.h"
@@ -24,6 +26,9 @@ OgreMeshAsset::~OgreMeshAsset()
 
 bool OgreMeshAsset::LoadFromFile(QString filename)
 {
+#ifdef TUNDRA_NO_OGRE
+    return IAsset::LoadFromFile(filename);
+#else
     bool allowAsynchronous = true;
     if (assetAPI->GetFramework()->IsHeadless() || assetAPI->GetFramework()->HasCommandLineParameter("--no_async_asset_load") || !assetAPI->GetAssetCache() || (OGRE_THREAD_SUPPORT == 0))
         allowAsynchronous = false;
@@ -39,6 +44,7 @@ bool OgreMeshAsset::LoadFromFile(QString filename)
         return DeserializeFromData(0, 0, true);
     else
         return IAsset::LoadFromFile(filename);
+#endif
 }
 
 bool OgreMeshAsset::DeserializeFromData(const u8 *data_, size_t numBytes, bool allowAsynchronous)
@@ -48,6 +54,17 @@ bool OgreMeshAsset::DeserializeFromData(const u8 *data_, size_t numBytes, bool a
     /// Force an unload of this data first.
     Unload();
 
+#ifdef TUNDRA_NO_OGRE
+    QString error;
+    if (!OgreRenderer::ReadOgreMeshGeometry(data_, numBytes, geometry, &error))
+    {
+        LogError("OgreMeshAsset::DeserializeFromData: Failed to read mesh geometry of " + Name() + ": " + error);
+        return false;
+    }
+    loaded = true;
+    assetAPI->AssetLoadCompleted(Name());
+    return true;
+#else
     if (assetAPI->GetFramework()->IsHeadless() || assetAPI->GetFramework()->HasCommandLineParameter("--no_async_asset_load") || !assetAPI->GetAssetCache() || (OGRE_THREAD_SUPPORT == 0))
         allowAsynchronous = false;
     QString cacheDiskSource;
@@ -117,6 +134,7 @@ bool OgreMeshAsset::DeserializeFromData(const u8 *data_, size_t numBytes, bool a
     }
     else 
         return false;
+#endif
 }
 
 struct KdTreeRayQueryFirstHitVisitor
@@ -156,7 +174,7 @@ struct KdTreeRayQueryFirstHitVisitor
 
 RayQueryResult OgreMeshAsset::Raycast(const Ray &ray)
 {
-    if (!ogreMesh.get())
+    if (!IsLoaded())
         return RayQueryResult();
     if (meshData.NumObjects() == 0)
         CreateKdTree();
@@ -228,6 +246,31 @@ void OgreMeshAsset::CreateKdTree()
     normals.clear();
     uvs.clear();
     subMeshTriangleCounts.clear();
+#ifdef TUNDRA_NO_OGRE
+    for(size_t i = 0; i < geometry.submeshes.size(); ++i)
+    {
+        const OgreMeshGeometry::Submesh &submesh = geometry.submeshes[i];
+        const bool hasUvs = !submesh.uvs.empty();
+        for(size_t j = 0; j + 2 < submesh.indices.size(); j += 3)
+        {
+            const u32 i0 = submesh.indices[j], i1 = submesh.indices[j+1], i2 = submesh.indices[j+2];
+            Triangle t(submesh.positions[i0], submesh.positions[i1], submesh.positions[i2]);
+            meshData.AddObjects(&t, 1);
+
+            if (hasUvs)
+            {
+                uvs.push_back(submesh.uvs[i0]);
+                uvs.push_back(submesh.uvs[i1]);
+                uvs.push_back(submesh.uvs[i2]);
+            }
+
+            float3 normal = (t.b - t.a).Cross(t.c - t.a);
+            normal.Normalize();
+            normals.push_back(normal);
+        }
+        subMeshTriangleCounts.push_back((int)submesh.NumTriangles());
+    }
+#else
     for(unsigned short i = 0; i < ogreMesh->getNumSubMeshes(); ++i)
     {
         Ogre::SubMesh *submesh = ogreMesh->getSubMesh(i);
@@ -317,6 +360,7 @@ void OgreMeshAsset::CreateKdTree()
             vbufTex->unlock();
         ibuf->unlock();
     }
+#endif
 
     {
         PROFILE(OgreMeshAsset_KdTree_Build);
@@ -324,6 +368,7 @@ void OgreMeshAsset::CreateKdTree()
     }
 }
 
+#ifndef TUNDRA_NO_OGRE
 bool OgreMeshAsset::GenerateMeshdata()
 {
     /* NOTE: only the last error handler here returns false - first are ignored.
@@ -413,9 +458,18 @@ void OgreMeshAsset::operationCompleted(Ogre::BackgroundProcessTicket ticket, con
     DoUnload();
     assetAPI->AssetLoadFailed(assetRef);
 }
+#endif
 
 void OgreMeshAsset::DoUnload()
 {
+#ifdef TUNDRA_NO_OGRE
+    geometry.Clear();
+    loaded = false;
+    meshData.Clear();
+    normals.clear();
+    uvs.clear();
+    subMeshTriangleCounts.clear();
+#else
     // If a ongoing asynchronous asset load requested has been made to ogre, we need to abort it.
     // Otherwise Ogre will crash to our raw pointer that was passed if we get deleted. A ongoing ticket id cannot be 0.
     if (loadTicket_ != 0)
@@ -434,10 +488,12 @@ void OgreMeshAsset::DoUnload()
         Ogre::MeshManager::getSingleton().remove(meshName);
     }
     catch(...) {}
+#endif
 }
 
 void OgreMeshAsset::SetDefaultMaterial()
 {
+#ifndef TUNDRA_NO_OGRE
     if (ogreMesh.isNull())
         return;
 
@@ -451,15 +507,38 @@ void OgreMeshAsset::SetDefaultMaterial()
             submesh->setMaterialName("LitTextured");
         }
     }
+#endif
 }
 
 bool OgreMeshAsset::IsLoaded() const
 {
+#ifdef TUNDRA_NO_OGRE
+    return loaded;
+#else
     return ogreMesh.get() != 0;
+#endif
+}
+
+size_t OgreMeshAsset::GpuMemoryUsage() const
+{
+#ifdef TUNDRA_NO_OGRE
+    return 0;
+#else
+    return ogreMesh.get() ? ogreMesh->getSize() : 0;
+#endif
 }
 
 bool OgreMeshAsset::SerializeTo(std::vector<u8> &data, const QString &serializationParameters) const
 {
+#ifdef TUNDRA_NO_OGRE
+    // Without Ogre the mesh cannot be exported, but the original file can be returned as is.
+    if (!loaded || DiskSource().isEmpty() || !LoadFileToVector(DiskSource(), data))
+    {
+        ::LogWarning("Tried to export Ogre mesh " + Name() + " that has no source file on disk.");
+        return false;
+    }
+    return true;
+#else
     if (ogreMesh.isNull())
     {
         ::LogWarning("Tried to export non-existing Ogre mesh " + Name() + ".");
@@ -484,4 +563,5 @@ bool OgreMeshAsset::SerializeTo(std::vector<u8> &data, const QString &serializat
         return false;
     }
     return true;
+#endif
 }
@@ -7,21 +7,34 @@
 #include "IAsset.h"
 #include "OgreModuleApi.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <OgreMesh.h>
 #include <OgreResourceBackgroundQueue.h>
+#else
+#include "OgreMeshGeometry.h"
+#endif
 #include "Math/float2.h"
 #include "Geometry/KdTree.h"
 #include "Geometry/Triangle.h"
 #include "IRenderer.h"
 
 /// Represents an Ogre .mesh loaded to the GPU.
+/** In a build without Ogre (TUNDRA_NO_OGRE), only the triangle geometry of the mesh is loaded, using ReadOgreMeshGeometry. */
+#ifndef TUNDRA_NO_OGRE
 class OGRE_MODULE_API OgreMeshAsset : public IAsset, Ogre::ResourceBackgroundQueue::Listener
+#else
+class OGRE_MODULE_API OgreMeshAsset : public IAsset
+#endif
 {
     Q_OBJECT
 
 public:
     OgreMeshAsset(AssetAPI *owner, const QString &type_, const QString &name_) :
+#ifndef TUNDRA_NO_OGRE
         IAsset(owner, type_, name_), loadTicket_(0)
+#else
+        IAsset(owner, type_, name_), loaded(false)
+#endif
     {
     }
 
@@ -35,8 +48,10 @@ public:
     /// Load mesh into memory
     virtual bool SerializeTo(std::vector<u8> &data, const QString &serializationParameters) const;
 
+#ifndef TUNDRA_NO_OGRE
     /// Ogre threaded load listener. Ogre::ResourceBackgroundQueue::Listener override.
     virtual void operationCompleted(Ogre::BackgroundProcessTicket ticket, const Ogre::BackgroundProcessResult &result);
+#endif
 
     /// Unload mesh from ogre
     virtual void DoUnload();
@@ -48,11 +63,19 @@ public:
 
     bool IsLoaded() const;
 
+    /// Returns the size of the vertex and index buffers of the mesh.
+    virtual size_t GpuMemoryUsage() const;
+
+#ifndef TUNDRA_NO_OGRE
     /// This points to the loaded mesh asset, if it is present.
     Ogre::MeshPtr ogreMesh;
 
     /// Ticket for ogres threaded loading operation.
     Ogre::BackgroundProcessTicket loadTicket_;
+#else
+    /// Geometry of the loaded mesh.
+    OgreMeshGeometry geometry;
+#endif
 
     /// Specifies the unique mesh name Ogre uses in its asset pool for this mesh.
     //QString ogreAssetName;
@@ -73,8 +96,10 @@ private:
     /// Precomputes a kD-tree for the triangle data of this mesh.
     void CreateKdTree();
 
+#ifndef TUNDRA_NO_OGRE
     /// Process mesh data after loading to create tangents and such.
     bool GenerateMeshdata();
+#endif
 
     /// Stores a CPU-side version of the mesh geometry data (positions), for raycasting purposes.
     KdTree<Triangle> meshData;
@@ -82,4 +107,8 @@ private:
     std::vector<float3> normals; ///< Triangle normals. One per triangle (not per-vertex normals).
     std::vector<float2> uvs; 
     std::vector<int> subMeshTriangleCounts;
+
+#ifdef TUNDRA_NO_OGRE
+    bool loaded; ///< The geometry was read successfully.
+#endif
 };
@@ -0,0 +1,517 @@
+/**
+    For conditions of distribution and use, see copyright notice in LICENSE
+
+    @file   OgreMeshGeometry.cpp
+    @brief  Reads the geometry of Ogre binary .mesh files without Ogre. */
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+#include "OgreMeshGeometry.h"
+#include "Profiler.h"
+
+#include <map>
+#include <cstring>
+#include <algorithm>
+
+#include "MemoryLeakCheck.h"
+
+namespace
+{
+
+/// Chunk identifiers of the Ogre binary mesh format (OgreMeshFileFormat.h).
+enum MeshChunkId
+{
+    M_HEADER = 0x1000,
+    M_MESH = 0x3000,
+    M_SUBMESH = 0x4000,
+    M_SUBMESH_OPERATION = 0x4010,
+    M_SUBMESH_BONE_ASSIGNMENT = 0x4100,
+    M_SUBMESH_TEXTURE_ALIAS = 0x4200,
+    M_GEOMETRY = 0x5000,
+    M_GEOMETRY_VERTEX_DECLARATION = 0x5100,
+    M_GEOMETRY_VERTEX_ELEMENT = 0x5110,
+    M_GEOMETRY_VERTEX_BUFFER = 0x5200,
+    M_GEOMETRY_VERTEX_BUFFER_DATA = 0x5210,
+    M_MESH_SKELETON_LINK = 0x6000,
+    M_MESH_BONE_ASSIGNMENT = 0x7000,
+    M_MESH_LOD = 0x8000,
+    M_MESH_BOUNDS = 0x9000,
+    M_SUBMESH_NAME_TABLE = 0xA000,
+    M_EDGE_LISTS = 0xB000,
+    M_POSES = 0xC000,
+    M_ANIMATIONS = 0xD000,
+    M_TABLE_EXTREMES = 0xE000
+};
+
+const u16 cSwappedHeaderId = 0x0010; ///< M_HEADER read with the wrong byte order.
+const u32 cChunkHeaderSize = sizeof(u16) + sizeof(u32);
+
+// Ogre::VertexElementSemantic and Ogre::VertexElementType values.
+const u16 cSemanticPosition = 1;
+const u16 cSemanticTexCoord = 7;
+const u16 cTypeFloat2 = 1;
+const u16 cTypeFloat3 = 2;
+const u16 cTypeFloat4 = 3;
+
+// Ogre::RenderOperation::OperationType values.
+const u16 cTriangleList = 4;
+const u16 cTriangleStrip = 5;
+const u16 cTriangleFan = 6;
+
+struct VertexElement
+{
+    u16 source;
+    u16 type;
+    u16 semantic;
+    u16 offset;
+    u16 index;
+};
+
+struct VertexBuffer
+{
+    u16 vertexSize;
+    const u8 *data; ///< Points to the mesh file data.
+};
+
+struct VertexData
+{
+    VertexData() : vertexCount(0) {}
+    u32 vertexCount;
+    std::vector<VertexElement> elements;
+    std::map<u16, VertexBuffer> buffers; ///< Vertex buffers by bind index.
+};
+
+/// Reads the chunks of an Ogre mesh file in the order Ogre::MeshSerializer writes them.
+class MeshReader
+{
+public:
+    MeshReader(const u8 *data, size_t numBytes) : pos(data), end(data + numBytes), swap(false) {}
+
+    bool Read(OgreMeshGeometry &geometry)
+    {
+        u16 headerId;
+        if (!ReadValue(headerId))
+            return Fail("File is empty");
+        if (headerId == cSwappedHeaderId)
+        {
+            swap = true;
+            headerId = M_HEADER;
+        }
+        if (headerId != M_HEADER)
+            return Fail("File is not an Ogre binary mesh");
+        QString version;
+        if (!ReadString(version) || !version.startsWith("[MeshSerializer_v"))
+            return Fail("Unrecognized mesh version string");
+
+        while(pos < end)
+        {
+            u16 id;
+            u32 length;
+            if (!ReadChunkHeader(id, length))
+                return false;
+            if (id == M_MESH)
+                return ReadMesh(geometry);
+            if (!Skip(length))
+                return false;
+        }
+        return Fail("File contains no mesh");
+    }
+
+    QString error;
+
+private:
+    bool Fail(const QString &message)
+    {
+        if (error.isEmpty())
+            error = message;
+        return false;
+    }
+
+    template<typename T>
+    void SwapBytes(T &value) const
+    {
+        if (swap)
+        {
+            u8 *bytes = reinterpret_cast<u8*>(&value);
+            std::reverse(bytes, bytes + sizeof(T));
+        }
+    }
+
+    template<typename T>
+    bool ReadArray(T *dest, size_t count)
+    {
+        if (count > (size_t)(end - pos) / sizeof(T))
+            return Fail("Unexpected end of file");
+        memcpy(dest, pos, count * sizeof(T));
+        pos += count * sizeof(T);
+        for(size_t i = 0; i < count; ++i)
+            SwapBytes(dest[i]);
+        return true;
+    }
+
+    template<typename T>
+    bool ReadValue(T &value) { return ReadArray(&value, 1); }
+
+    bool ReadBool(bool &value)
+    {
+        u8 byte;
+        if (!ReadValue(byte))
+            return false;
+        value = (byte != 0);
+        return true;
+    }
+
+    /// Strings are stored newline-terminated.
+    bool ReadString(QString &str)
+    {
+        const u8 *newline = std::find(pos, end, (u8)'\n');
+        if (newline == end)
+            return Fail("Unterminated string");
+        str = QString::fromUtf8(reinterpret_cast<const char*>(pos), newline - pos);
+        pos = newline + 1;
+        return true;
+    }
+
+    bool ReadChunkHeader(u16 &id, u32 &length)
+    {
+        if (!ReadValue(id) || !ReadValue(length))
+            return false;
+        if (length < cChunkHeaderSize)
+            return Fail(QString("Invalid length in chunk 0x%1").arg(id, 0, 16));
+        return true;
+    }
+
+    /// Steps back over a chunk header that belongs to the parent chunk.
+    void Rewind() { pos -= cChunkHeaderSize; }
+
+    /// Skips the rest of a chunk whose header has been read.
+    bool Skip(u32 length)
+    {
+        if (length - cChunkHeaderSize > (size_t)(end - pos))
+            return Fail("Chunk extends beyond the end of file");
+        pos += length - cChunkHeaderSize;
+        return true;
+    }
+
+    float ReadFloat(const u8 *src) const
+    {
+        float value;
+        memcpy(&value, src, sizeof(float));
+        SwapBytes(value);
+        return value;
+    }
+
+    bool ReadMesh(OgreMeshGeometry &geometry)
+    {
+        bool skeletallyAnimated;
+        if (!ReadBool(skeletallyAnimated))
+            return false;
+
+        VertexData sharedVertices;
+        bool hasBounds = false;
+        bool endOfMesh = false;
+        while(pos < end && !endOfMesh)
+        {
+            u16 id;
+            u32 length;
+            if (!ReadChunkHeader(id, length))
+                return false;
+            switch(id)
+            {
+            case M_GEOMETRY:
+                if (!ReadGeometry(sharedVertices))
+                    return false;
+                break;
+            case M_SUBMESH:
+                if (!ReadSubmesh(geometry, sharedVertices))
+                    return false;
+                break;
+            case M_MESH_BOUNDS:
+            {
+                float bounds[7]; // Min and max corners, and the bounding sphere radius.
+                if (!ReadArray(bounds, 7))
+                    return false;
+                geometry.bounds = AABB(float3(bounds[0], bounds[1], bounds[2]), float3(bounds[3], bounds[4], bounds[5]));
+                hasBounds = true;
+                break;
+            }
+            case M_MESH_SKELETON_LINK:
+                if (!ReadString(geometry.skeletonName))
+                    return false;
+                break;
+            case M_MESH_BONE_ASSIGNMENT:
+            case M_MESH_LOD:
+            case M_SUBMESH_NAME_TABLE:
+            case M_EDGE_LISTS:
+            case M_POSES:
+            case M_ANIMATIONS:
+            case M_TABLE_EXTREMES:
+                if (!Skip(length))
+                    return false;
+                break;
+            default:
+                Rewind();
+                endOfMesh = true; // Not a child of the mesh.
+                break;
+            }
+        }
+
+        if (!hasBounds)
+        {
+            geometry.bounds.SetNegativeInfinity();
+            for(size_t i = 0; i < geometry.submeshes.size(); ++i)
+                for(size_t j = 0; j < geometry.submeshes[i].positions.size(); ++j)
+                    geometry.bounds.Enclose(geometry.submeshes[i].positions[j]);
+        }
+        return true;
+    }
+
+    bool ReadGeometry(VertexData &vertexData)
+    {
+        if (!ReadValue(vertexData.vertexCount))
+            return false;
+
+        while(pos < end)
+        {
+            u16 id;
+            u32 length;
+            if (!ReadChunkHeader(id, length))
+                return false;
+            if (id == M_GEOMETRY_VERTEX_DECLARATION)
+            {
+                while(pos < end)
+                {
+                    if (!ReadChunkHeader(id, length))
+                        return false;
+                    if (id != M_GEOMETRY_VERTEX_ELEMENT)
+                    {
+                        Rewind();
+                        break;
+                    }
+                    VertexElement elem;
+                    if (!ReadValue(elem.source) || !ReadValue(elem.type) || !ReadValue(elem.semantic) || !ReadValue(elem.offset) || !ReadValue(elem.index))
+                        return false;
+                    vertexData.elements.push_back(elem);
+                }
+            }
+            else if (id == M_GEOMETRY_VERTEX_BUFFER)
+            {
+                u16 bindIndex;
+                VertexBuffer buffer;
+                if (!ReadValue(bindIndex) || !ReadValue(buffer.vertexSize))
+                    return false;
+                if (!ReadChunkHeader(id, length))
+                    return false;
+                if (id != M_GEOMETRY_VERTEX_BUFFER_DATA)
+                    return Fail("Vertex buffer has no data");
+                const size_t bufferSize = (size_t)vertexData.vertexCount * buffer.vertexSize;
+                if (bufferSize > (size_t)(end - pos))
+                    return Fail("Vertex buffer extends beyond the end of file");
+                buffer.data = pos;
+                pos += bufferSize;
+                vertexData.buffers[bindIndex] = buffer;
+            }
+            else
+            {
+                Rewind();
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool ReadSubmesh(OgreMeshGeometry &geometry, const VertexData &sharedVertices)
+    {
+        OgreMeshGeometry::Submesh submesh;
+        bool useSharedVertices;
+        u32 indexCount;
+        bool indexes32Bit;
+        if (!ReadString(submesh.materialName) || !ReadBool(useSharedVertices) || !ReadValue(indexCount) || !ReadBool(indexes32Bit))
+            return false;
+
+        std::vector<u32> indices(indexCount);
+        if (indexCount > 0)
+        {
+            if (indexes32Bit)
+            {
+                if (!ReadArray(&indices[0], indexCount))
+                    return false;
+            }
+            else
+            {
+                std::vector<u16> shortIndices(indexCount);
+                if (!ReadArray(&shortIndices[0], indexCount))
+                    return false;
+                std::copy(shortIndices.begin(), shortIndices.end(), indices.begin());
+            }
+        }
+
+        VertexData ownVertices;
+        if (!useSharedVertices)
+        {
+            u16 id;
+            u32 length;
+            if (!ReadChunkHeader(id, length))
+                return false;
+            if (id != M_GEOMETRY)
+                return Fail("Submesh has no geometry");
+            if (!ReadGeometry(ownVertices))
+                return false;
+        }
+
+        u16 operation = cTriangleList;
+        while(pos < end)
+        {
+            u16 id;
+            u32 length;
+            if (!ReadChunkHeader(id, length))
+                return false;
+            if (id == M_SUBMESH_OPERATION)
+            {
+                if (!ReadValue(operation))
+                    return false;
+            }
+            else if (id == M_SUBMESH_BONE_ASSIGNMENT || id == M_SUBMESH_TEXTURE_ALIAS)
+            {
+                if (!Skip(length))
+                    return false;
+            }
+            else
+            {
+                Rewind();
+                break;
+            }
+        }
+
+        ReadVertices(useSharedVertices ? sharedVertices : ownVertices, submesh);
+        BuildTriangleList(indices, operation, submesh);
+        // Empty submeshes are kept, so that submesh indices match the indices Ogre uses.
+        geometry.submeshes.push_back(submesh);
+        return true;
+    }
+
+    const VertexElement *FindElement(const VertexData &vertexData, u16 semantic) const
+    {
+        for(size_t i = 0; i < vertexData.elements.size(); ++i)
+            if (vertexData.elements[i].semantic == semantic && vertexData.elements[i].index == 0)
+                return &vertexData.elements[i];
+        return 0;
+    }
+
+    /// Returns the buffer of a vertex element, or null if the buffer does not exist or the element does not fit in it.
+    const VertexBuffer *ElementBuffer(const VertexData &vertexData, const VertexElement *elem, size_t elemSize) const
+    {
+        if (!elem)
+            return 0;
+        std::map<u16, VertexBuffer>::const_iterator iter = vertexData.buffers.find(elem->source);
+        if (iter == vertexData.buffers.end() || elem->offset + elemSize > iter->second.vertexSize)
+            return 0;
+        return &iter->second;
+    }
+
+    void ReadVertices(const VertexData &vertexData, OgreMeshGeometry::Submesh &submesh) const
+    {
+        const VertexElement *posElem = FindElement(vertexData, cSemanticPosition);
+        if (posElem && posElem->type != cTypeFloat3 && posElem->type != cTypeFloat4)
+            posElem = 0;
+        const VertexBuffer *posBuffer = ElementBuffer(vertexData, posElem, 3 * sizeof(float));
+        if (!posBuffer)
+            return; // No position element, so no triangles.
+
+        submesh.positions.resize(vertexData.vertexCount);
+        for(u32 i = 0; i < vertexData.vertexCount; ++i)
+        {
+            const u8 *src = posBuffer->data + (size_t)i * posBuffer->vertexSize + posElem->offset;
+            submesh.positions[i] = float3(ReadFloat(src), ReadFloat(src + 4), ReadFloat(src + 8));
+        }
+
+        const VertexElement *texElem = FindElement(vertexData, cSemanticTexCoord);
+        if (texElem && texElem->type != cTypeFloat2)
+            texElem = 0;
+        const VertexBuffer *texBuffer = ElementBuffer(vertexData, texElem, 2 * sizeof(float));
+        if (texBuffer)
+        {
+            submesh.uvs.resize(vertexData.vertexCount);
+            for(u32 i = 0; i < vertexData.vertexCount; ++i)
+            {
+                const u8 *src = texBuffer->data + (size_t)i * texBuffer->vertexSize + texElem->offset;
+                submesh.uvs[i] = float2(ReadFloat(src), ReadFloat(src + 4));
+            }
+        }
+    }
+
+    /// Converts the indices of a render operation to a triangle list, dropping triangles that refer to nonexisting vertices.
+    void BuildTriangleList(const std::vector<u32> &indices, u16 operation, OgreMeshGeometry::Submesh &submesh) const
+    {
+        const u32 numVertices = (u32)submesh.positions.size();
+        if (numVertices == 0 || indices.size() < 3)
+            return;
+
+        submesh.indices.reserve(operation == cTriangleList ? indices.size() : (indices.size() - 2) * 3);
+        for(size_t i = 2; i < indices.size(); )
+        {
+            u32 a, b, c;
+            if (operation == cTriangleList)
+            {
+                a = indices[i-2]; b = indices[i-1]; c = indices[i];
+                i += 3;
+            }
+            else if (operation == cTriangleStrip)
+            {
+                // Every other triangle of a strip has reversed winding.
+                a = indices[i-2]; b = indices[i-1]; c = indices[i];
+                if ((i & 1) != 0)
+                    std::swap(a, b);
+                ++i;
+            }
+            else if (operation == cTriangleFan)
+            {
+                a = indices[0]; b = indices[i-1]; c = indices[i];
+                ++i;
+            }
+            else
+                return; // Points and lines have no triangles.
+
+            if (a < numVertices && b < numVertices && c < numVertices)
+            {
+                submesh.indices.push_back(a);
+                submesh.indices.push_back(b);
+                submesh.indices.push_back(c);
+            }
+        }
+    }
+
+    const u8 *pos;
+    const u8 *end;
+    bool swap; ///< The file has the opposite byte order.
+};
+
+}
+
+namespace OgreRenderer
+{
+
+bool ReadOgreMeshGeometry(const u8 *data, size_t numBytes, OgreMeshGeometry &geometry, QString *errorMessage)
+{
+    PROFILE(ReadOgreMeshGeometry);
+
+    geometry.Clear();
+    if (!data || numBytes == 0)
+    {
+        if (errorMessage)
+            *errorMessage = "No input data";
+        return false;
+    }
+
+    MeshReader reader(data, numBytes);
+    if (!reader.Read(geometry))
+    {
+        geometry.Clear();
+        if (errorMessage)
+            *errorMessage = reader.error;
+        return false;
+    }
+    return true;
+}
+
+}
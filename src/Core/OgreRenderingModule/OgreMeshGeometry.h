@@ -0,0 +1,57 @@
+/**
+    For conditions of distribution and use, see copyright notice in LICENSE
+
+    @file   OgreMeshGeometry.h
+    @brief  Reads the geometry of Ogre binary .mesh files without Ogre. */
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "OgreModuleApi.h"
+#include "Math/float2.h"
+#include "Math/float3.h"
+#include "Geometry/AABB.h"
+
+#include <QString>
+#include <vector>
+
+/// CPU-side triangle geometry of an Ogre mesh.
+/** Only the data needed for bounds, raycasts and collision shapes is stored: positions, the first texture coordinate set
+    and the triangle indices of each submesh. Points and lines are dropped, and triangle strips and fans are converted to lists. */
+struct OGRE_MODULE_API OgreMeshGeometry
+{
+    /// Geometry of a submesh.
+    struct Submesh
+    {
+        QString materialName; ///< Name of the material the submesh was exported with.
+        std::vector<float3> positions; ///< Vertex positions. For submeshes that use the shared vertices of the mesh, a copy of them.
+        std::vector<float2> uvs; ///< Texture coordinates of the vertices, or empty if the submesh has none.
+        std::vector<u32> indices; ///< Triangle list, three indices to positions per triangle.
+
+        size_t NumTriangles() const { return indices.size() / 3; }
+    };
+
+    OgreMeshGeometry() { bounds.SetNegativeInfinity(); }
+
+    std::vector<Submesh> submeshes;
+
+    /// Bounding box of the mesh, as stored in the mesh file, or computed from the positions if the file has none.
+    AABB bounds;
+
+    /// Name of the skeleton the mesh is linked to, or empty if none.
+    QString skeletonName;
+
+    void Clear() { submeshes.clear(); bounds.SetNegativeInfinity(); skeletonName.clear(); }
+};
+
+namespace OgreRenderer
+{
+    /// Reads the geometry of an Ogre binary .mesh file (MeshSerializer versions 1.40 and newer, either byte order).
+    /** Bone assignments, animations, poses, LOD levels and edge lists are skipped; of the skeleton, only the linked name is read.
+        @param data Contents of the .mesh file.
+        @param numBytes Size of the data.
+        @param[out] geometry Receives the geometry.
+        @param[out] errorMessage If non-null, receives a description of the error on failure.
+        @return True on success. */
+    bool OGRE_MODULE_API ReadOgreMeshGeometry(const u8 *data, size_t numBytes, OgreMeshGeometry &geometry, QString *errorMessage = 0);
+}
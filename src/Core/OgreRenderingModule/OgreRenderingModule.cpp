@@ -4,7 +4,9 @@
 #include "DebugOperatorNew.h"
 
 #include "OgreRenderingModule.h"
+#ifndef TUNDRA_NO_OGRE
 #include "Renderer.h"
+#endif
 #include "EC_Placeable.h"
 #include "EC_Mesh.h"
 #include "EC_OgreCustomObject.h"
@@ -14,8 +16,9 @@
 #include "EC_OgreCompositor.h"
 #include "EC_RttTarget.h"
 #include "EC_Material.h"
-#include "OgreWorld.h"
 #include "OgreMeshAsset.h"
+#ifndef TUNDRA_NO_OGRE
+#include "OgreWorld.h"
 #include "OgreParticleAsset.h"
 #include "OgreSkeletonAsset.h"
 #include "OgreMaterialAsset.h"
@@ -24,6 +27,7 @@
 #include "OgreProfilerHook.h"
 #endif
 #include "TextureAsset.h"
+#endif
 
 #include "Application.h"
 #include "Entity.h"
@@ -113,6 +117,7 @@ void OgreRenderingModule::Load()
     framework_->Asset()->RegisterAssetTypeFactory(AssetTypeFactoryPtr(new GenericAssetFactory<OgreMeshAsset>("OgreMesh")));
 
     // Loading materials crashes Ogre in headless mode because we don't have Ogre Renderer running, so only register the Ogre material asset type if not in headless mode.
+#ifndef TUNDRA_NO_OGRE
     if (!framework_->IsHeadless())
     {
         framework_->Asset()->RegisterAssetTypeFactory(AssetTypeFactoryPtr(new GenericAssetFactory<OgreMaterialAsset>("OgreMaterial")));
@@ -121,6 +126,7 @@ void OgreRenderingModule::Load()
         framework_->Asset()->RegisterAssetTypeFactory(AssetTypeFactoryPtr(new GenericAssetFactory<OgreSkeletonAsset>("OgreSkeleton")));
     }
     else
+#endif
     {
         framework_->Asset()->RegisterAssetTypeFactory(AssetTypeFactoryPtr(new NullAssetFactory("OgreMaterial")));
         framework_->Asset()->RegisterAssetTypeFactory(AssetTypeFactoryPtr(new NullAssetFactory("Texture")));
@@ -131,6 +137,10 @@ void OgreRenderingModule::Load()
 
 void OgreRenderingModule::Initialize()
 {
+#ifdef TUNDRA_NO_OGRE
+    // Built without Ogre: only the components and the mesh geometry are provided, there is no renderer to initialize.
+    LogInfo("OgreRenderingModule: Built without Ogre, running without a renderer.");
+#else
     std::string ogreConfigFilename = Application::InstallationDirectory().toStdString() + "ogre.cfg"; ///\todo Unicode support!
 #if defined (_WINDOWS) && (_DEBUG)
     std::string pluginsFilename = "pluginsd.cfg";
@@ -185,6 +195,7 @@ void OgreRenderingModule::Initialize()
 #endif
     framework_->Console()->RegisterCommand("setMaterialAttribute", "Sets an attribute on a material asset",
         this, SLOT(SetMaterialAttribute(const QStringList &)));
+#endif
 }
 
 void OgreRenderingModule::Uninitialize()
@@ -201,6 +212,7 @@ void OgreRenderingModule::ConsoleStats()
 {
     if (framework_->IsHeadless())
         return;
+#ifndef TUNDRA_NO_OGRE
     if (renderer)
     {
         const Ogre::RenderTarget::FrameStats& stats = renderer->GetCurrentRenderWindow()->getStatistics();
@@ -214,6 +226,7 @@ void OgreRenderingModule::ConsoleStats()
     }
     else
         LogError("No renderer found!");
+#endif
 }
 
 void OgreRenderingModule::ToggleOgreProfilerOverlay()
@@ -231,6 +244,7 @@ void OgreRenderingModule::ToggleOgreProfilerOverlay()
 
 void OgreRenderingModule::OnSceneAdded(const QString& name)
 {
+#ifndef TUNDRA_NO_OGRE
     ScenePtr scene = GetFramework()->Scene()->GetScene(name);
     if (!scene)
     {
@@ -242,10 +256,12 @@ void OgreRenderingModule::OnSceneAdded(const QString& name)
     OgreWorldPtr newWorld = boost::make_shared<OgreWorld>(renderer.get(), scene);
     renderer->ogreWorlds[scene.get()] = newWorld;
     scene->setProperty(OgreWorld::PropertyName(), QVariant::fromValue<QObject*>(newWorld.get()));
+#endif
 }
 
 void OgreRenderingModule::OnSceneRemoved(const QString& name)
 {
+#ifndef TUNDRA_NO_OGRE
     // Remove the OgreWorld from the scene
     ScenePtr scene = GetFramework()->Scene()->GetScene(name);
     if (!scene)
@@ -260,6 +276,7 @@ void OgreRenderingModule::OnSceneRemoved(const QString& name)
         scene->setProperty(OgreWorld::PropertyName(), QVariant());
         renderer->ogreWorlds.erase(scene.get());
     }
+#endif
 }
 
 void OgreRenderingModule::SetMaterialAttribute(const QStringList &params)
@@ -269,6 +286,9 @@ void OgreRenderingModule::SetMaterialAttribute(const QStringList &params)
         LogError("OgreRenderingModule::SetMaterialAttribute: Usage: SetMaterialAttribute(asset,attribute,value)");
         return;
     }
+#ifdef TUNDRA_NO_OGRE
+    LogError("OgreRenderingModule::SetMaterialAttribute: Materials are not supported in a build without Ogre");
+#else
     AssetPtr assetPtr = framework_->Asset()->GetAsset(framework_->Asset()->ResolveAssetRef("", params[0]));
     if (!assetPtr || !assetPtr->IsLoaded())
     {
@@ -282,6 +302,7 @@ void OgreRenderingModule::SetMaterialAttribute(const QStringList &params)
         return;
     }
     matAsset->SetAttribute(params[1], params[2]);
+#endif
 }
 
 } // ~namespace OgreRenderer
@@ -16,6 +16,7 @@
 #include <QtCore>
 #include <QtGui>
 
+#ifndef TUNDRA_NO_OGRE
 // The following file is a 'include-it-all' convenience utility. Perfect for including it here in the PCH.
 #include <Ogre.h>
 
@@ -33,5 +34,6 @@
 #include <OgreViewport.h>
 #include <OgreTexture.h>
 #include <OgreOverlay.h>
+#endif
 
 #endif
@@ -36,6 +36,16 @@
 
 #include "MemoryLeakCheck.h"
 
+namespace
+{
+/// Texture image decoded on an asset load thread.
+class TextureDecodeData : public IAssetDecodeData
+{
+public:
+    Ogre::Image image;
+};
+}
+
 TextureAsset::TextureAsset(AssetAPI *owner, const QString &type_, const QString &name_) :
     IAsset(owner, type_, name_), loadTicket_(0)
 {
@@ -128,72 +138,117 @@ bool TextureAsset::DeserializeFromData(const u8 *data, size_t numBytes, bool all
         // Load up the image as an Ogre CPU image object.
         Ogre::Image image;
         image.load(stream);
+        return LoadFromImage(image);
+    }
+    catch(Ogre::Exception &e)
+    {
+        LogError("TextureAsset::DeserializeFromData: Failed to create texture " + this->Name().toStdString() + ": " + std::string(e.what()));
+        return false;
+    }
+}
 
-        // If we are submitting a .dds file which did not contain mip maps, don't have Ogre generating them either.
-        // Reasons:
-        // 1. Not all textures need mipmaps, i.e. if the texture is always shown with 1:1 texel-to-pixel ratio, then the mip levels are never needed.
-        // 2. Ogre has a bug on Apple, that it fails to generate mipmaps for .dds files which contain only one mip level and are DXT1-compressed (it tries to autogenerate, but always results in black texture data)
-        // 3. If the texture is updated dynamically, we might not afford to regenerate mips at each update.
-        int numMipmapsInImage = image.getNumMipmaps(); // Note: This is actually numMipmaps - 1: Ogre doesn't think the first level is a mipmap.
-        int numMipmapsToUseOnGPU = Ogre::MIP_DEFAULT;
-        if (numMipmapsInImage == 0 && this->Name().endsWith(".dds", Qt::CaseInsensitive))
-            numMipmapsToUseOnGPU = 0;
-
-        if (ogreTexture.isNull()) // If we are creating this texture for the first time, create a new Ogre::Texture object.
-        {
-            ogreAssetName = AssetAPI::SanitateAssetRef(this->Name().toStdString()).c_str();
-            
-            // Optionally load textures to default pool for memory use debugging. Do not use in production use due to possible crashes on device loss & missing mipmaps!
-            // Note: this does not affect async loading path, so specify additionally --no_async_asset_load to be sure textures are loaded through this path
-            // Furthermore, it may still allocate virtual memory address space due to using AGP memory mapping (we would not actually need a dynamic texture, but there's no way to tell Ogre that)
-            if (assetAPI->GetFramework()->HasCommandLineParameter("--d3ddefaultpool"))
-            {
-                ogreTexture = Ogre::TextureManager::getSingleton().createManual(ogreAssetName.toStdString(), Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, Ogre::TEX_TYPE_2D,image.getWidth(), 
-                    image.getHeight(), numMipmapsToUseOnGPU, image.getFormat(), Ogre::TU_DYNAMIC_WRITE_ONLY_DISCARDABLE);
-                ogreTexture->loadImage(image);
-            }
-            else
-            {
-                ogreTexture = Ogre::TextureManager::getSingleton().loadImage(ogreAssetName.toStdString(), Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, image, Ogre::TEX_TYPE_2D, 
-                    numMipmapsToUseOnGPU);
-            }
-        }
-        else // If we're loading on top of an Ogre::Texture we've created before, don't lose the old Ogre::Texture object, but reuse the old.
-        {    // This will allow all existing materials to keep referring to this texture, and they'll get the updated texture image immediately.
-            ogreTexture->freeInternalResources(); 
-
-            if (image.getWidth() != ogreTexture->getWidth() || image.getHeight() != ogreTexture->getHeight() || image.getFormat() != ogreTexture->getFormat())
-            {
-                ogreTexture->setWidth(image.getWidth());
-                ogreTexture->setHeight(image.getHeight());
-                ogreTexture->setFormat(image.getFormat());
-            }
+bool TextureAsset::SupportsThreadedDecode() const
+{
+    return !assetAPI->IsHeadless() && !assetAPI->GetFramework()->HasCommandLineParameter("--notextures");
+}
 
-            if (ogreTexture->getBuffer().isNull())
-            {
-                LogError("DeserializeFromData: Failed to create texture " + this->Name() + ": OgreTexture::getBuffer() was null!");
-                return false;
-            }
+AssetDecodeDataPtr TextureAsset::DecodeData(const u8 *data, size_t numBytes) const
+{
+    boost::shared_ptr<TextureDecodeData> decoded(new TextureDecodeData);
+    try
+    {
+        std::vector<u8> tempData(data, data + numBytes);
+#include "DisableMemoryLeakCheck.h"
+        Ogre::DataStreamPtr stream(new Ogre::MemoryDataStream(&tempData[0], tempData.size(), false));
+#include "EnableMemoryLeakCheck.h"
+        decoded->image.load(stream);
+    }
+    catch(Ogre::Exception &)
+    {
+        return AssetDecodeDataPtr();
+    }
+    return decoded;
+}
 
-            Ogre::PixelBox pixelBox(Ogre::Box(0,0, image.getWidth(), image.getHeight()), image.getFormat(), (void*)image.getData());
-            ogreTexture->getBuffer()->blitFromMemory(pixelBox);
+bool TextureAsset::LoadFromDecodedData(const AssetDecodeDataPtr &decoded)
+{
+    PROFILE(TextureAsset_LoadFromDecodedData);
+    TextureDecodeData *texture = dynamic_cast<TextureDecodeData *>(decoded.get());
+    if (!texture)
+        return false;
 
-            ogreTexture->createInternalResources();
-        }
-        
-        PostProcessTexture();
-        
-        // We did a synchronous load, must call AssetLoadCompleted here.
-        assetAPI->AssetLoadCompleted(Name());
-        return true;
+    try
+    {
+        return LoadFromImage(texture->image);
     }
     catch(Ogre::Exception &e)
     {
-        LogError("TextureAsset::DeserializeFromData: Failed to create texture " + this->Name().toStdString() + ": " + std::string(e.what()));
+        LogError("TextureAsset::LoadFromDecodedData: Failed to create texture " + this->Name().toStdString() + ": " + std::string(e.what()));
         return false;
     }
 }
 
+bool TextureAsset::LoadFromImage(Ogre::Image &image)
+{
+    // If we are submitting a .dds file which did not contain mip maps, don't have Ogre generating them either.
+    // Reasons:
+    // 1. Not all textures need mipmaps, i.e. if the texture is always shown with 1:1 texel-to-pixel ratio, then the mip levels are never needed.
+    // 2. Ogre has a bug on Apple, that it fails to generate mipmaps for .dds files which contain only one mip level and are DXT1-compressed (it tries to autogenerate, but always results in black texture data)
+    // 3. If the texture is updated dynamically, we might not afford to regenerate mips at each update.
+    int numMipmapsInImage = image.getNumMipmaps(); // Note: This is actually numMipmaps - 1: Ogre doesn't think the first level is a mipmap.
+    int numMipmapsToUseOnGPU = Ogre::MIP_DEFAULT;
+    if (numMipmapsInImage == 0 && this->Name().endsWith(".dds", Qt::CaseInsensitive))
+        numMipmapsToUseOnGPU = 0;
+
+    if (ogreTexture.isNull()) // If we are creating this texture for the first time, create a new Ogre::Texture object.
+    {
+        ogreAssetName = AssetAPI::SanitateAssetRef(this->Name().toStdString()).c_str();
+        
+        // Optionally load textures to default pool for memory use debugging. Do not use in production use due to possible crashes on device loss & missing mipmaps!
+        // Note: this does not affect async loading path, so specify additionally --no_async_asset_load to be sure textures are loaded through this path
+        // Furthermore, it may still allocate virtual memory address space due to using AGP memory mapping (we would not actually need a dynamic texture, but there's no way to tell Ogre that)
+        if (assetAPI->GetFramework()->HasCommandLineParameter("--d3ddefaultpool"))
+        {
+            ogreTexture = Ogre::TextureManager::getSingleton().createManual(ogreAssetName.toStdString(), Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, Ogre::TEX_TYPE_2D,image.getWidth(), 
+                image.getHeight(), numMipmapsToUseOnGPU, image.getFormat(), Ogre::TU_DYNAMIC_WRITE_ONLY_DISCARDABLE);
+            ogreTexture->loadImage(image);
+        }
+        else
+        {
+            ogreTexture = Ogre::TextureManager::getSingleton().loadImage(ogreAssetName.toStdString(), Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, image, Ogre::TEX_TYPE_2D, 
+                numMipmapsToUseOnGPU);
+        }
+    }
+    else // If we're loading on top of an Ogre::Texture we've created before, don't lose the old Ogre::Texture object, but reuse the old.
+    {    // This will allow all existing materials to keep referring to this texture, and they'll get the updated texture image immediately.
+        ogreTexture->freeInternalResources(); 
+
+        if (image.getWidth() != ogreTexture->getWidth() || image.getHeight() != ogreTexture->getHeight() || image.getFormat() != ogreTexture->getFormat())
+        {
+            ogreTexture->setWidth(image.getWidth());
+            ogreTexture->setHeight(image.getHeight());
+            ogreTexture->setFormat(image.getFormat());
+        }
+
+        if (ogreTexture->getBuffer().isNull())
+        {
+            LogError("DeserializeFromData: Failed to create texture " + this->Name() + ": OgreTexture::getBuffer() was null!");
+            return false;
+        }
+
+        Ogre::PixelBox pixelBox(Ogre::Box(0,0, image.getWidth(), image.getHeight()), image.getFormat(), (void*)image.getData());
+        ogreTexture->getBuffer()->blitFromMemory(pixelBox);
+
+        ogreTexture->createInternalResources();
+    }
+    
+    PostProcessTexture();
+    
+    // We did a synchronous load, must call AssetLoadCompleted here.
+    assetAPI->AssetLoadCompleted(Name());
+    return true;
+}
+
 void TextureAsset::operationCompleted(Ogre::BackgroundProcessTicket ticket, const Ogre::BackgroundProcessResult &result)
 {
     if (ticket != loadTicket_)
@@ -305,6 +360,17 @@ bool TextureAsset::IsLoaded() const
     return ogreTexture.get() != 0;
 }
 
+size_t TextureAsset::GpuMemoryUsage() const
+{
+    if (!ogreTexture.get())
+        return 0;
+    // Ogre reports the size of the top mip level only. A full mip chain adds a third to it.
+    size_t size = ogreTexture->getSize();
+    if (ogreTexture->getNumMipmaps() > 0)
+        size += size / 3;
+    return size;
+}
+
 QImage TextureAsset::ToQImage(Ogre::Texture* tex, size_t faceIndex, size_t mipmapLevel)
 {
     PROFILE(TextureAsset_ToQImage);
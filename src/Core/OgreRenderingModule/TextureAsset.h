@@ -28,6 +28,18 @@ public:
     /// Load texture into memory
     virtual bool SerializeTo(std::vector<u8> &data, const QString &serializationParameters) const;
 
+    /// Textures loaded from identical image files can be shared between refs.
+    virtual bool IsContentShareable() const { return true; }
+
+    /// Image files are decoded on the asset load threads, unless textures are disabled with --notextures.
+    virtual bool SupportsThreadedDecode() const;
+
+    /// Decodes the image file into an Ogre::Image. Called on an asset load thread.
+    virtual AssetDecodeDataPtr DecodeData(const u8 *data, size_t numBytes) const;
+
+    /// Uploads the Ogre::Image produced by DecodeData to the GPU.
+    virtual bool LoadFromDecodedData(const AssetDecodeDataPtr &decoded);
+
     /// Ogre threaded load listener. Ogre::ResourceBackgroundQueue::Listener override.
     virtual void operationCompleted(Ogre::BackgroundProcessTicket ticket, const Ogre::BackgroundProcessResult &result);
 
@@ -39,6 +51,9 @@ public:
 
     bool IsLoaded() const;
 
+    /// Returns the size of the texture surfaces on the GPU, including the mipmaps.
+    virtual size_t GpuMemoryUsage() const;
+
     /// Sets the contents of this texture asset from raw pixel data.
     /** @param newWidth The desired pixel width for this texture.
         @param newHeight The desired pixel height for this texture. If newWidth or newHeight do not match with the current texture size on the GPU side,
@@ -87,4 +102,8 @@ public:
     
     /// Convert texture to QImage, static version.
     static QImage ToQImage(Ogre::Texture* tex, size_t faceIndex = 0, size_t mipmapLevel = 0);
+
+private:
+    /// Creates or updates the GPU texture from a decoded image, and signals the load completion.
+    bool LoadFromImage(Ogre::Image &image);
 };
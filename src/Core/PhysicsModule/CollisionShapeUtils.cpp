@@ -9,13 +9,16 @@
 #include "btBulletDynamicsCommon.h"
 #include "LoggingFunctions.h"
 #include "hull.h"
+#include "OgreMeshAsset.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
+#endif
 
 namespace Physics
 {
 
-void GenerateTriangleMesh(Ogre::Mesh* mesh, btTriangleMesh* ptr)
+void GenerateTriangleMesh(OgreMeshAsset* mesh, btTriangleMesh* ptr)
 {
     std::vector<float3> triangles;
     GetTrianglesFromMesh(mesh, triangles);
@@ -24,7 +27,7 @@ void GenerateTriangleMesh(Ogre::Mesh* mesh, btTriangleMesh* ptr)
         ptr->addTriangle(triangles[i], triangles[i+1], triangles[i+2]);
 }
 
-void GenerateConvexHullSet(Ogre::Mesh* mesh, ConvexHullSet* ptr)
+void GenerateConvexHullSet(OgreMeshAsset* mesh, ConvexHullSet* ptr)
 {
     std::vector<float3> vertices;
     GetTrianglesFromMesh(mesh, vertices);
@@ -60,10 +63,27 @@ void GenerateConvexHullSet(Ogre::Mesh* mesh, ConvexHullSet* ptr)
     lib.ReleaseResult(result);
 }
 
-void GetTrianglesFromMesh(Ogre::Mesh* mesh, std::vector<float3>& dest)
+void GetTrianglesFromMesh(OgreMeshAsset* meshAsset, std::vector<float3>& dest)
 {
     dest.clear();
-    
+
+#ifdef TUNDRA_NO_OGRE
+    // Without Ogre, the triangle lists are read from the mesh file by the asset itself.
+    for(size_t i = 0; i < meshAsset->geometry.submeshes.size(); ++i)
+    {
+        const OgreMeshGeometry::Submesh &submesh = meshAsset->geometry.submeshes[i];
+        for(size_t k = 0; k + 2 < submesh.indices.size(); k += 3)
+        {
+            dest.push_back(submesh.positions[submesh.indices[k]]);
+            dest.push_back(submesh.positions[submesh.indices[k+1]]);
+            dest.push_back(submesh.positions[submesh.indices[k+2]]);
+        }
+    }
+#else
+    Ogre::Mesh* mesh = meshAsset->ogreMesh.get();
+    if (!mesh)
+        return;
+
     try
     {
 
@@ -134,6 +154,7 @@ void GetTrianglesFromMesh(Ogre::Mesh* mesh, std::vector<float3>& dest)
         LogError("GetTrianglesFromMesh failed for mesh! Ogre threw an exception: " + QString(e.what()));
         dest.clear();
     }
+#endif
 }
 
 }
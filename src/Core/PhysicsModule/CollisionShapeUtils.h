@@ -7,16 +7,13 @@
 #include "PhysicsModuleFwd.h"
 #include "Math/float3.h"
 
-namespace Ogre
-{
-    class Mesh;
-};
+class OgreMeshAsset;
 
 namespace Physics
 {
-    void GenerateTriangleMesh(Ogre::Mesh* mesh, btTriangleMesh* ptr);
-    void GetTrianglesFromMesh(Ogre::Mesh* mesh, std::vector<float3>& dest);
-    void GenerateConvexHullSet(Ogre::Mesh* mesh, ConvexHullSet* ptr);
+    void GenerateTriangleMesh(OgreMeshAsset* mesh, btTriangleMesh* ptr);
+    void GetTrianglesFromMesh(OgreMeshAsset* mesh, std::vector<float3>& dest);
+    void GenerateConvexHullSet(OgreMeshAsset* mesh, ConvexHullSet* ptr);
 }
 
 
@@ -17,7 +17,9 @@
 #include "Scene.h"
 #include "EC_Mesh.h"
 #include "EC_Placeable.h"
+#ifndef TUNDRA_NO_OGRE
 #include "EC_Terrain.h"
+#endif
 #include "AssetAPI.h"
 #include "IAssetTransfer.h"
 #include "AttributeMetadata.h"
@@ -29,8 +31,6 @@
 #include <BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h>
 #include <set>
 
-#include <OgreSceneNode.h>
-
 using namespace Physics;
 
 static const float cForceThreshold = 0.0005f;
@@ -254,6 +254,8 @@ void EC_RigidBody::UpdateSignals()
         return;
     
     connect(parent, SIGNAL(ComponentAdded(IComponent*, AttributeChange::Type)), this, SLOT(CheckForPlaceableAndTerrain()));
+    connect(parent, SIGNAL(Deactivated(Entity*, AttributeChange::Type)), this, SLOT(OnEntityDeactivated()));
+    connect(parent, SIGNAL(Reactivated(Entity*, AttributeChange::Type)), this, SLOT(OnEntityReactivated()));
     
     Scene* scene = parent->ParentScene();
     world_ = scene->GetWorld<PhysicsWorld>().get();
@@ -276,6 +278,7 @@ void EC_RigidBody::CheckForPlaceableAndTerrain()
             connect(placeable.get(), SIGNAL(AttributeChanged(IAttribute*, AttributeChange::Type)), this, SLOT(PlaceableUpdated(IAttribute*)));
         }
     }
+#ifndef TUNDRA_NO_OGRE
     if (!terrain_.lock())
     {
         boost::shared_ptr<EC_Terrain> terrain = parent->GetComponent<EC_Terrain>();
@@ -286,6 +289,7 @@ void EC_RigidBody::CheckForPlaceableAndTerrain()
             connect(terrain.get(), SIGNAL(AttributeChanged(IAttribute*, AttributeChange::Type)), this, SLOT(TerrainUpdated(IAttribute*)));
         }
     }
+#endif
 }
 
 void EC_RigidBody::CreateCollisionShape()
@@ -361,7 +365,7 @@ void EC_RigidBody::RemoveCollisionShape()
 
 void EC_RigidBody::CreateBody()
 {
-    if ((!world_) || (!ParentEntity()) || (body_))
+    if ((!world_) || (!ParentEntity()) || (body_) || (!ParentEntity()->IsActive()))
         return;
     
     CheckForPlaceableAndTerrain();
@@ -510,29 +514,27 @@ void EC_RigidBody::OnTerrainRegenerated()
 
 void EC_RigidBody::OnCollisionMeshAssetLoaded(AssetPtr asset)
 {
-    OgreMeshAsset *meshAsset = dynamic_cast<OgreMeshAsset*>(asset.get());
-    if (!meshAsset || !meshAsset->ogreMesh.get())
+    OgreMeshAsset *mesh = dynamic_cast<OgreMeshAsset*>(asset.get());
+    if (!mesh || !mesh->IsLoaded())
+    {
         LogError("EC_RigidBody::OnCollisionMeshAssetLoaded: Mesh asset load finished for asset \"" +
-            asset->Name() + "\", but Ogre::Mesh pointer was null!");
-
-    Ogre::Mesh *mesh = meshAsset->ogreMesh.get();
+            asset->Name() + "\", but the mesh was not loaded!");
+        return;
+    }
 
-    if (mesh)
+    if (shapeType.Get() == Shape_TriMesh)
     {
-        if (shapeType.Get() == Shape_TriMesh)
-        {
-            triangleMesh_ = owner_->GetTriangleMeshFromOgreMesh(mesh);
-            CreateCollisionShape();
-        }
-        if (shapeType.Get() == Shape_ConvexHull)
-        {
-            convexHullSet_ = owner_->GetConvexHullSetFromOgreMesh(mesh);
-            CreateCollisionShape();
-        }
-
-        cachedShapeType_ = shapeType.Get();
-        cachedSize_ = size.Get();
+        triangleMesh_ = owner_->GetTriangleMeshFromOgreMesh(mesh);
+        CreateCollisionShape();
     }
+    if (shapeType.Get() == Shape_ConvexHull)
+    {
+        convexHullSet_ = owner_->GetConvexHullSetFromOgreMesh(mesh);
+        CreateCollisionShape();
+    }
+
+    cachedShapeType_ = shapeType.Get();
+    cachedSize_ = size.Get();
 }
 
 void EC_RigidBody::OnAttributeUpdated(IAttribute* attribute)
@@ -664,6 +666,16 @@ void EC_RigidBody::OnAboutToUpdate()
         UpdatePosRotFromPlaceable();
 }
 
+void EC_RigidBody::OnEntityDeactivated()
+{
+    RemoveBody();
+}
+
+void EC_RigidBody::OnEntityReactivated()
+{
+    CreateBody();
+}
+
 void EC_RigidBody::SetRotation(const float3& rotation)
 {
     // Cannot modify server-authoritative physics object
@@ -761,12 +773,14 @@ AABB EC_RigidBody::ShapeAABB() const
 
 void EC_RigidBody::TerrainUpdated(IAttribute* attribute)
 {
+#ifndef TUNDRA_NO_OGRE
     EC_Terrain* terrain = terrain_.lock().get();
     if (!terrain)
         return;
     /// \todo It is suboptimal to regenerate the whole heightfield when just the terrain's transform changes
     if ((attribute == &terrain->nodeTransformation) && (shapeType.Get() == Shape_HeightField))
         CreateCollisionShape();
+#endif
 }
 
 void EC_RigidBody::RequestMesh()
@@ -820,6 +834,7 @@ void EC_RigidBody::UpdateScale()
 
 void EC_RigidBody::CreateHeightFieldFromTerrain()
 {
+#ifndef TUNDRA_NO_OGRE
     CheckForPlaceableAndTerrain();
     
     EC_Terrain* terrain = terrain_.lock().get();
@@ -869,6 +884,9 @@ void EC_RigidBody::CreateHeightFieldFromTerrain()
     btCompoundShape* compound = new btCompoundShape();
     shape_ = compound;
     compound->addChildShape(btTransform(btQuaternion(0,0,0,1), positionAdjust), heightField_);
+#else
+    LogWarning("EC_RigidBody: Heightfield shapes require EC_Terrain, which is not available in a build without Ogre.");
+#endif
 }
 
 void EC_RigidBody::CreateConvexHullSetShape()
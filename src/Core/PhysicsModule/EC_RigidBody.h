@@ -302,6 +302,12 @@ private slots:
     
     /// Called when the simulation is about to be stepped
     void OnAboutToUpdate();
+
+    /// Called when the parent entity has been moved to the entity pool. Removes the body from the physics world.
+    void OnEntityDeactivated();
+
+    /// Called when the parent entity has been taken from the entity pool. Recreates the body.
+    void OnEntityReactivated();
     
     /// Called when some of the attributes has been changed.
     void OnAttributeUpdated(IAttribute *attribute);
@@ -334,7 +340,7 @@ private:
     /// Create a convex hull set collisionshape
     void CreateConvexHullSetShape();
     
-    /// Create the body. No-op if the scene is not associated with a physics world.
+    /// Create the body. No-op if the scene is not associated with a physics world, or if the parent entity is inactive.
     void CreateBody();
     
     /// Destroy the body
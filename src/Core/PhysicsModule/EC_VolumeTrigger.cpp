@@ -13,8 +13,8 @@
 #include "PhysicsUtils.h"
 #include "LoggingFunctions.h"
 #include "Profiler.h"
+#include "Geometry/AABB.h"
 
-#include <OgreAxisAlignedBox.h>
 #include <QMap>
 #include <btBulletDynamicsCommon.h>
 
@@ -86,10 +86,12 @@ float EC_VolumeTrigger::GetEntityInsidePercent(const Entity *entity) const
             float3 otherBoxMin, otherBoxMax;
             otherRigidbody->GetAabbox(otherBoxMin, otherBoxMax);
 
-            Ogre::AxisAlignedBox thisBox(thisBoxMin.x, thisBoxMin.y, thisBoxMin.z, thisBoxMax.x, thisBoxMax.y, thisBoxMax.z);
-            Ogre::AxisAlignedBox otherBox(otherBoxMin.x, otherBoxMin.y, otherBoxMin.z, otherBoxMax.x, otherBoxMax.y, otherBoxMax.z);
+            AABB thisBox(thisBoxMin, thisBoxMax);
+            AABB otherBox(otherBoxMin, otherBoxMax);
+            if (!thisBox.Intersects(otherBox))
+                return 0.0f;
 
-            return (thisBox.intersection(otherBox).volume() / otherBox.volume());
+            return (thisBox.Intersection(otherBox).Volume() / otherBox.Volume());
         } else
             LogWarning("EC_VolumeTrigger: no EC_RigidBody for entity or volume.");
     }
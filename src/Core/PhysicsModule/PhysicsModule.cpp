@@ -11,15 +11,17 @@
 #include "EC_VolumeTrigger.h"
 #include "EC_PhysicsMotor.h"
 #include "OgreRenderingModule.h"
+#include "OgreMeshAsset.h"
 #include "EC_Mesh.h"
 #include "EC_Placeable.h"
+#ifndef TUNDRA_NO_OGRE
 #include "EC_Terrain.h"
+#endif
 #include "Entity.h"
 #include "SceneAPI.h"
 #include "Framework.h"
 #include "Scene.h"
 #include "Profiler.h"
-#include "Renderer.h"
 #include "ConsoleAPI.h"
 #include "IComponentFactory.h"
 #include "QScriptEngineHelpers.h"
@@ -30,8 +32,6 @@
 #include <QtScript>
 #include <QTreeWidgetItem>
 
-#include <Ogre.h>
-
 #include "MemoryLeakCheck.h"
 
 Q_DECLARE_METATYPE(Physics::PhysicsModule*);
@@ -151,12 +151,14 @@ void PhysicsModule::AutoCollisionMesh()
             EC_RigidBody* body = checked_static_cast<EC_RigidBody*>(entity->GetOrCreateComponent(EC_RigidBody::TypeNameStatic(), "", AttributeChange::Default).get());
             body->SetShapeFromVisibleMesh();
         }
+#ifndef TUNDRA_NO_OGRE
         // Terrain mode: assign if no rigid body, but there is a terrain component
         if ((!entity->GetComponent<EC_RigidBody>()) && (entity->GetComponent<EC_Terrain>()))
         {
             EC_RigidBody* body = checked_static_cast<EC_RigidBody*>(entity->GetOrCreateComponent(EC_RigidBody::TypeNameStatic(), "", AttributeChange::Default).get());
             body->shapeType.Set(EC_RigidBody::Shape_HeightField, AttributeChange::Default);
         }
+#endif
     }
 }
 
@@ -220,14 +222,14 @@ void PhysicsModule::OnScriptEngineCreated(QScriptEngine* engine)
     qScriptRegisterQObjectMetaType<PhysicsRaycastResult*>(engine);
 }
 
-boost::shared_ptr<btTriangleMesh> PhysicsModule::GetTriangleMeshFromOgreMesh(Ogre::Mesh* mesh)
+boost::shared_ptr<btTriangleMesh> PhysicsModule::GetTriangleMeshFromOgreMesh(OgreMeshAsset* mesh)
 {
     boost::shared_ptr<btTriangleMesh> ptr;
     if (!mesh)
         return ptr;
     
     // Check if has already been converted
-    TriangleMeshMap::const_iterator iter = triangleMeshes_.find(mesh->getName());
+    TriangleMeshMap::const_iterator iter = triangleMeshes_.find(mesh->Name().toStdString());
     if (iter != triangleMeshes_.end())
         return iter->second;
     
@@ -237,19 +239,19 @@ boost::shared_ptr<btTriangleMesh> PhysicsModule::GetTriangleMeshFromOgreMesh(Ogr
 #include "EnableMemoryLeakCheck.h"
     GenerateTriangleMesh(mesh, ptr.get());
     
-    triangleMeshes_[mesh->getName()] = ptr;
+    triangleMeshes_[mesh->Name().toStdString()] = ptr;
     
     return ptr;
 }
 
-boost::shared_ptr<ConvexHullSet> PhysicsModule::GetConvexHullSetFromOgreMesh(Ogre::Mesh* mesh)
+boost::shared_ptr<ConvexHullSet> PhysicsModule::GetConvexHullSetFromOgreMesh(OgreMeshAsset* mesh)
 {
     boost::shared_ptr<ConvexHullSet> ptr;
     if (!mesh)
         return ptr;
     
     // Check if has already been converted
-    ConvexHullSetMap::const_iterator iter = convexHullSets_.find(mesh->getName());
+    ConvexHullSetMap::const_iterator iter = convexHullSets_.find(mesh->Name().toStdString());
     if (iter != convexHullSets_.end())
         return iter->second;
     
@@ -257,7 +259,7 @@ boost::shared_ptr<ConvexHullSet> PhysicsModule::GetConvexHullSetFromOgreMesh(Ogr
     ptr = boost::shared_ptr<ConvexHullSet>(new ConvexHullSet());
     GenerateConvexHullSet(mesh, ptr.get());
 
-    convexHullSets_[mesh->getName()] = ptr;
+    convexHullSets_[mesh->Name().toStdString()] = ptr;
     
     return ptr;
 }
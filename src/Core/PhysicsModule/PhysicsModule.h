@@ -10,10 +10,7 @@
 #include <set>
 #include <QObject>
 
-namespace Ogre
-{
-    class Mesh;
-}
+class OgreMeshAsset;
 
 class QScriptEngine;
 
@@ -41,11 +38,11 @@ public:
    
     /// Get a Bullet triangle mesh corresponding to an Ogre mesh.
     /** If already has been generated, returns the previously created one */
-    boost::shared_ptr<btTriangleMesh> GetTriangleMeshFromOgreMesh(Ogre::Mesh* mesh);
+    boost::shared_ptr<btTriangleMesh> GetTriangleMeshFromOgreMesh(OgreMeshAsset* mesh);
 
     /// Get a Bullet convex hull set (using minimum recursion, not very accurate but fast) corresponding to an Ogre mesh.
     /** If already has been generated, returns the previously created one */
-    boost::shared_ptr<ConvexHullSet> GetConvexHullSetFromOgreMesh(Ogre::Mesh* mesh);
+    boost::shared_ptr<ConvexHullSet> GetConvexHullSetFromOgreMesh(OgreMeshAsset* mesh);
 
     /// Set default physics update rate for new physics worlds
     void SetDefaultPhysicsUpdatePeriod(float updatePeriod);
@@ -9,7 +9,9 @@
 #include "PhysicsUtils.h"
 #include "Profiler.h"
 #include "Scene.h"
+#ifndef TUNDRA_NO_OGRE
 #include "OgreWorld.h"
+#endif
 #include "EC_RigidBody.h"
 #include "LoggingFunctions.h"
 #include "Geometry/LineSegment.h"
@@ -20,7 +22,9 @@
 
 #include <btBulletDynamicsCommon.h>
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
+#endif
 
 #include "MemoryLeakCheck.h"
 
@@ -351,6 +355,7 @@ void PhysicsWorld::DrawDebugGeometry()
 
     PROFILE(PhysicsModule_DrawDebugGeometry);
     
+#ifndef TUNDRA_NO_OGRE
     // Draw debug only for the active (visible) scene
     OgreWorldPtr ogreWorld = scene_.lock()->GetWorld<OgreWorld>();
     cachedOgreWorld_ = ogreWorld.get();
@@ -361,6 +366,7 @@ void PhysicsWorld::DrawDebugGeometry()
     
     // Get all lines of the physics world
     world_->debugDrawWorld();
+#endif
 }
 
 void PhysicsWorld::reportErrorWarning(const char* warningString)
@@ -370,8 +376,10 @@ void PhysicsWorld::reportErrorWarning(const char* warningString)
 
 void PhysicsWorld::drawLine(const btVector3& from, const btVector3& to, const btVector3& color)
 {
+#ifndef TUNDRA_NO_OGRE
     if (IsDebugGeometryEnabled() && cachedOgreWorld_)
         cachedOgreWorld_->DebugDrawLine(from, to, color.x(), color.y(), color.z());
+#endif
 }
 
 } // ~Physics
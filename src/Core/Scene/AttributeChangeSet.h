@@ -0,0 +1,45 @@
+/**
+    For conditions of distribution and use, see copyright notice in LICENSE
+
+    @file   AttributeChangeSet.h
+    @brief  Coalesced set of changed attributes of a single component. */
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "AttributeChangeType.h"
+
+#include <cstring>
+
+/// Coalesced set of changed attributes of a single component, used by the batched attribute change dispatch of Scene.
+/** The changed attributes are stored as a bitmask indexed by IAttribute::Index(). A maximum of 256 attributes are supported,
+    which is the same limit as the network sync uses, so the mask can be consumed directly as a dirty bitfield.
+    @sa Scene::SetAttributeChangeBatching, Scene::AttributesChanged */
+struct AttributeChangeSet
+{
+    AttributeChangeSet() : change(AttributeChange::Default)
+    {
+        Clear();
+    }
+
+    /// Marks the attribute at the given index changed.
+    void MarkDirty(u8 attrIndex) { dirty[attrIndex >> 3] |= (1 << (attrIndex & 7)); }
+
+    /// Returns whether the attribute at the given index has changed.
+    bool IsDirty(u8 attrIndex) const { return (dirty[attrIndex >> 3] & (1 << (attrIndex & 7))) != 0; }
+
+    /// Returns true if no attributes are marked changed.
+    bool IsEmpty() const
+    {
+        for (unsigned i = 0; i < 32; ++i)
+            if (dirty[i])
+                return false;
+        return true;
+    }
+
+    /// Clears all the change bits.
+    void Clear() { memset(dirty, 0, sizeof(dirty)); }
+
+    u8 dirty[32]; ///< Changed attributes bitfield.
+    AttributeChange::Type change; ///< Change type that applies to all the attributes in this set.
+};
@@ -0,0 +1,167 @@
+/**
+    For conditions of distribution and use, see copyright notice in LICENSE
+
+    @file   AttributeInterpolationTrack.h
+    @brief  Structure-of-arrays storage and stepping of running attribute interpolations of a single attribute type. */
+
+#pragma once
+
+#include "SceneFwd.h"
+#include "IAttribute.h"
+#include "AttributeChangeType.h"
+#include "Transform.h"
+#include "Math/float3.h"
+#include "Math/Quat.h"
+
+#include <vector>
+#include <map>
+
+/// Returns the value between two interpolation endpoints. Specialized for the attribute types interpolated by AttributeInterpolationTrack.
+inline float3 InterpolateValue(const float3 &start, const float3 &end, float t) { return Lerp(start, end, t); }
+inline Quat InterpolateValue(const Quat &start, const Quat &end, float t) { return Slerp(start, end, t); } ///< @overload
+
+/// @overload
+inline Transform InterpolateValue(const Transform &start, const Transform &end, float t)
+{
+    Transform ret;
+    ret.pos = Lerp(start.pos, end.pos, t);
+    ret.SetOrientation(Slerp(start.Orientation(), end.Orientation(), t));
+    ret.scale = Lerp(start.scale, end.scale, t);
+    return ret;
+}
+
+/// Running interpolations of attributes of type T, stored as a structure of arrays.
+/** The endpoints are stored by value in contiguous arrays instead of heap-allocated attribute clones, all the interpolations
+    are stepped in one loop without virtual calls, and finished interpolations are removed by swapping the last one in their place.
+    The interpolation semantics are the same as with IAttribute::Interpolate: the value is interpolated for the length of
+    the interpolation, after which the interpolation is kept alive, without setting the value, for another length so that
+    continuous updates can be detected.
+    @sa Scene::StartAttributeInterpolation */
+template<typename T>
+class AttributeInterpolationTrack
+{
+public:
+    /// Adds an interpolation. There must not be a running interpolation for the attribute in this track already.
+    /** @param dest Attribute to interpolate.
+        @param comp Owner component of the attribute. The interpolation is ended when the component expires.
+        @param start Start value.
+        @param end End value.
+        @param length Length of the interpolation in seconds. */
+    void Add(Attribute<T> *dest, const ComponentWeakPtr &comp, const T &start, const T &end, float length)
+    {
+        indices_[dest] = dests_.size();
+        dests_.push_back(dest);
+        comps_.push_back(comp);
+        starts_.push_back(start);
+        ends_.push_back(end);
+        times_.push_back(0.0f);
+        lengths_.push_back(length);
+    }
+
+    /// Removes the interpolation of an attribute. Returns true if the interpolation existed.
+    bool Remove(IAttribute *dest)
+    {
+        typename std::map<IAttribute *, size_t>::iterator iter = indices_.find(dest);
+        if (iter == indices_.end())
+            return false;
+        RemoveAt(iter->second);
+        return true;
+    }
+
+    /// Removes all interpolations.
+    void Clear()
+    {
+        indices_.clear();
+        dests_.clear();
+        comps_.clear();
+        starts_.clear();
+        ends_.clear();
+        times_.clear();
+        lengths_.clear();
+    }
+
+    /// Returns number of running interpolations.
+    size_t Size() const { return dests_.size(); }
+
+    /// Advances all interpolations and sets the interpolated values to the attributes.
+    /** @param frametime Time step in seconds.
+        @param change Change type used when setting the values. */
+    void Update(float frametime, AttributeChange::Type change)
+    {
+        const size_t count = dests_.size();
+        values_.resize(count);
+        states_.resize(count);
+
+        // Step all the interpolations in one pass over the contiguous arrays.
+        for(size_t i = 0; i < count; ++i)
+        {
+            const bool interpolating = times_[i] <= lengths_[i];
+            times_[i] += frametime;
+            if (interpolating)
+            {
+                float t = times_[i] / lengths_[i];
+                if (t > 1.0f)
+                    t = 1.0f;
+                values_[i] = InterpolateValue(starts_[i], ends_[i], t);
+                states_[i] = Apply;
+            }
+            else
+                states_[i] = times_[i] >= lengths_[i] * 2.0f ? Finished : Hold;
+        }
+
+        // Apply the values and remove the finished interpolations. Iterate backwards so that swap-and-pop only moves processed entries.
+        for(size_t i = count - 1; i < count; --i)
+        {
+            if (i >= dests_.size())
+                continue; // Interpolations were ended by the change signals
+            // Check that the component still exists ie. it's safe to access the attribute
+            if (states_[i] == Finished || comps_[i].expired())
+                RemoveAt(i);
+            else if (states_[i] == Apply)
+                dests_[i]->Set(values_[i], change);
+        }
+    }
+
+private:
+    enum State { Apply, Hold, Finished };
+
+    void RemoveAt(size_t i)
+    {
+        indices_.erase(dests_[i]);
+        const size_t last = dests_.size() - 1;
+        if (i != last)
+        {
+            dests_[i] = dests_[last];
+            comps_[i] = comps_[last];
+            starts_[i] = starts_[last];
+            ends_[i] = ends_[last];
+            times_[i] = times_[last];
+            lengths_[i] = lengths_[last];
+            // Keep the state of the current update with the moved entry. Entries added during the update are not applied.
+            if (last < states_.size())
+            {
+                states_[i] = states_[last];
+                values_[i] = values_[last];
+            }
+            else if (i < states_.size())
+                states_[i] = Hold;
+            indices_[dests_[i]] = i;
+        }
+        dests_.pop_back();
+        comps_.pop_back();
+        starts_.pop_back();
+        ends_.pop_back();
+        times_.pop_back();
+        lengths_.pop_back();
+    }
+
+    std::vector<Attribute<T> *> dests_; ///< Interpolated attributes.
+    std::vector<ComponentWeakPtr> comps_; ///< Owner components of the attributes.
+    std::vector<T> starts_; ///< Start values.
+    std::vector<T> ends_; ///< End values.
+    std::vector<float> times_; ///< Elapsed times.
+    std::vector<float> lengths_; ///< Interpolation lengths.
+    std::vector<T> values_; ///< Interpolated values of the current update.
+    std::vector<State> states_; ///< States of the current update.
+    std::map<IAttribute *, size_t> indices_; ///< Maps attributes to their array index.
+};
@@ -9,11 +9,21 @@
 #include "Entity.h"
 #include "LoggingFunctions.h"
 #include "Scene.h"
+#include "AttributeChangeSet.h"
+#include "AssetReference.h"
+#include "EntityReference.h"
+#include "Transform.h"
+#include "Color.h"
+#include "Math/float2.h"
+#include "Math/float3.h"
+#include "Math/float4.h"
+#include "Math/Quat.h"
 
 #include <QScriptEngine>
 #include <QScriptValueIterator>
 
 #include <kNet.h>
+#include <algorithm>
 
 #include <QDomDocument>
 
@@ -52,6 +62,40 @@ bool CmpAttributeDataByName(const DeserializeData &a, const DeserializeData &b)
     return a.name_ < b.name_;
 }
 
+/// Returns the attribute type name that best matches the type of a value.
+static QString AttributeTypeNameForValue(const QVariant &value)
+{
+    switch(value.type())
+    {
+    case QVariant::Bool: return "bool";
+    case QVariant::Int: case QVariant::LongLong: return "int";
+    case QVariant::UInt: case QVariant::ULongLong: return "uint";
+    case QVariant::Double: return "real";
+    case QVariant::String: return "string";
+    case QVariant::List: return "qvariantlist";
+    case QVariant::Color: return "color";
+    default: break;
+    }
+    const int type = value.userType();
+    if (type == QMetaType::Float) return "real";
+    if (type == qMetaTypeId<Color>()) return "color";
+    if (type == qMetaTypeId<float2>()) return "float2";
+    if (type == qMetaTypeId<float3>()) return "float3";
+    if (type == qMetaTypeId<float4>()) return "float4";
+    if (type == qMetaTypeId<Quat>()) return "quat";
+    if (type == qMetaTypeId<Transform>()) return "transform";
+    if (type == qMetaTypeId<AssetReference>()) return "assetreference";
+    if (type == qMetaTypeId<AssetReferenceList>()) return "assetreferencelist";
+    if (type == qMetaTypeId<EntityReference>()) return "entityreference";
+    return "qvariant";
+}
+
+/// Binary format marker and version of the type table format, which lists the attribute type names once, and refers to them by index.
+/** The legacy format starts with the attribute count, followed by the name of the first attribute. A legacy component would have to
+    have 255 attributes, the first of them with an empty name, to start with the same bytes. The count is now written as an u16. */
+static const u8 cTypeTableMarker = 0xFF;
+static const u8 cTypeTableVersion = 0;
+
 /** @endcond */
 
 EC_DynamicComponent::EC_DynamicComponent(Scene* scene):
@@ -130,10 +174,7 @@ void EC_DynamicComponent::DeserializeCommon(std::vector<DeserializeData>& deseri
         // Attribute has already created and we only need to update it's value.
         if((*iter1)->Name() == (*iter2).name_)
         {
-            //SetAttribute(QString::fromStdString(iter2->name_), QString::fromStdString(iter2->value_), change);
-            for(AttributeVector::const_iterator attr_iter = attributes.begin(); attr_iter != attributes.end(); ++attr_iter)
-                if((*attr_iter)->Name() == iter2->name_)
-                    (*attr_iter)->FromString(iter2->value_.toStdString(), change);
+            (*iter1)->FromString(iter2->value_.toStdString(), change);
 
             ++iter2;
             ++iter1;
@@ -170,8 +211,9 @@ void EC_DynamicComponent::DeserializeCommon(std::vector<DeserializeData>& deseri
 
 IAttribute *EC_DynamicComponent::CreateAttribute(const QString &typeName, const QString &name, AttributeChange::Type change)
 {
-    if(ContainsAttribute(name))
-        return IComponent::GetAttribute(name);
+    IAttribute *existing = FindAttribute(name);
+    if (existing)
+        return existing;
 
     IAttribute *attribute = SceneAPI::CreateAttribute(typeName, name);
     if(!attribute)
@@ -195,22 +237,21 @@ IAttribute *EC_DynamicComponent::CreateAttribute(const QString &typeName, const
 
 void EC_DynamicComponent::RemoveAttribute(const QString &name, AttributeChange::Type change)
 {
-    for(AttributeVector::iterator iter = attributes.begin(); iter != attributes.end(); iter++)
-    {
-        if((*iter) && (*iter)->Name() == name)
-        {
-            // Trigger scenemanager signal
-            Scene* scene = ParentScene();
-            if (scene)
-                scene->EmitAttributeRemoved(this, *iter, change);
-            
-            // Trigger internal signal(s)
-            emit AttributeAboutToBeRemoved(*iter);
-            // Leave a hole in the array, which will be filled when new attributes are created
-            SAFE_DELETE(*iter);
-            break;
-        }
-    }
+    IAttribute *attribute = FindAttribute(name);
+    if (!attribute)
+        return;
+
+    // Trigger scenemanager signal
+    Scene* scene = ParentScene();
+    if (scene)
+        scene->EmitAttributeRemoved(this, attribute, change);
+
+    // Trigger internal signal(s)
+    emit AttributeAboutToBeRemoved(attribute);
+    // Leave a hole in the array, which will be filled when new attributes are created
+    AttributeErased(attribute);
+    SAFE_DELETE(attributes[attribute->Index()]);
+    ++revision;
 }
 
 void EC_DynamicComponent::RemoveAllAttributes(AttributeChange::Type change)
@@ -232,7 +273,93 @@ void EC_DynamicComponent::RemoveAllAttributes(AttributeChange::Type change)
             attributes[i] = 0;
         }
         attributes.clear();
+        ++revision;
+    }
+    attributeIndex.clear();
+}
+
+void EC_DynamicComponent::SetAttributes(const QVariantMap &values, AttributeChange::Type change)
+{
+    if (change == AttributeChange::Default)
+        change = updateMode;
+
+    Scene* scene = ParentScene();
+    AttributeChangeSet changes;
+    changes.change = change;
+    std::vector<IAttribute *> unbatched;
+    for(QVariantMap::const_iterator iter = values.begin(); iter != values.end(); ++iter)
+    {
+        IAttribute *attribute = FindAttribute(iter.key());
+        if (!attribute)
+        {
+            attribute = SceneAPI::CreateAttribute(AttributeTypeNameForValue(iter.value()), iter.key());
+            if (!attribute)
+            {
+                LogError("Failed to create new attribute:" + iter.key() + " in dynamic component:" + Name());
+                continue;
+            }
+            IComponent::AddAttribute(attribute);
+            // The additions are signalled before the values so that the network sync knows the attributes when the changes arrive.
+            if (scene)
+                scene->EmitAttributeAdded(this, attribute, change);
+            emit AttributeAdded(attribute);
+        }
+
+        // Set the values silently, and signal all the changes at once below. Color attributes take Color, not QColor.
+        if (iter.value().type() == QVariant::Color)
+            attribute->FromQVariant(QVariant::fromValue(Color(iter.value().value<QColor>())), AttributeChange::Disconnected);
+        else
+            attribute->FromQVariant(iter.value(), AttributeChange::Disconnected);
+        // The change set holds the first 256 attributes, the rest are signalled one by one.
+        if (attribute->Index() < 256)
+            changes.MarkDirty((u8)attribute->Index());
+        else
+            unbatched.push_back(attribute);
     }
+
+    if (change == AttributeChange::Disconnected)
+        return;
+    if (scene)
+        scene->DispatchAttributeChanges(this, changes);
+    else if (!changes.IsEmpty())
+        EmitAttributeChanges(changes);
+    for(size_t i = 0; i < unbatched.size(); ++i)
+        EmitAttributeChanged(unbatched[i], change);
+}
+
+IAttribute *EC_DynamicComponent::FindAttribute(const QString &name) const
+{
+    return attributeIndex.value(name, 0);
+}
+
+void EC_DynamicComponent::AttributeInserted(IAttribute *attribute)
+{
+    // If attributes created by index share a name, the name refers to the first of them, like in a linear search.
+    IAttribute *&indexed = attributeIndex[attribute->Name()];
+    if (!indexed || attribute->Index() < indexed->Index())
+        indexed = attribute;
+}
+
+void EC_DynamicComponent::AttributeErased(IAttribute *attribute)
+{
+    QHash<QString, IAttribute *>::iterator iter = attributeIndex.find(attribute->Name());
+    if (iter == attributeIndex.end() || iter.value() != attribute)
+        return;
+    attributeIndex.erase(iter);
+    // Let the name refer to the next attribute with the same name, if any.
+    for(size_t i = 0; i < attributes.size(); ++i)
+        if (attributes[i] && attributes[i] != attribute && attributes[i]->Name() == attribute->Name())
+        {
+            attributeIndex[attribute->Name()] = attributes[i];
+            break;
+        }
+}
+
+size_t EC_DynamicComponent::ExternalMemoryUsage() const
+{
+    // Hash nodes hold the next pointer, the hash value, the key and the value. The key strings share their data with the attribute names.
+    const size_t nodeSize = sizeof(void*) + sizeof(uint) + sizeof(QString) + sizeof(IAttribute *);
+    return attributeIndex.capacity() * sizeof(void*) + attributeIndex.size() * nodeSize;
 }
 
 int EC_DynamicComponent::GetInternalAttributeIndex(int index) const
@@ -276,7 +403,8 @@ QVariant EC_DynamicComponent::GetAttribute(int index) const
 
 QVariant EC_DynamicComponent::GetAttribute(const QString &name) const
 {
-    return IComponent::GetAttributeQVariant(name);
+    IAttribute *attribute = FindAttribute(name);
+    return attribute ? attribute->ToQVariant() : QVariant();
 }
 
 void EC_DynamicComponent::SetAttribute(int index, const QVariant &value, AttributeChange::Type change)
@@ -294,22 +422,16 @@ void EC_DynamicComponent::SetAttribute(int index, const QVariant &value, Attribu
 void EC_DynamicComponent::SetAttributeQScript(const QString &name, const QScriptValue &value, AttributeChange::Type change)
 {
     LogWarning("EC_DynamicComponent::SetAttributeQScript is deprecated and will be removed. Use SetAttribute instead.");
-    for(AttributeVector::const_iterator iter = attributes.begin(); iter != attributes.end(); ++iter)
-        if((*iter) && (*iter)->Name() == name)
-        {
-            (*iter)->FromScriptValue(value, change);
-            break; 
-        }
+    IAttribute *attribute = FindAttribute(name);
+    if (attribute)
+        attribute->FromScriptValue(value, change);
 }
 
 void EC_DynamicComponent::SetAttribute(const QString &name, const QVariant &value, AttributeChange::Type change)
 {
-    for(AttributeVector::const_iterator iter = attributes.begin(); iter != attributes.end(); ++iter)
-        if((*iter) && (*iter)->Name() == name)
-        {
-            (*iter)->FromQVariant(value, change);
-            break;
-        }
+    IAttribute *attribute = FindAttribute(name);
+    if (attribute)
+        attribute->FromQVariant(value, change);
 }
 
 QString EC_DynamicComponent::GetAttributeName(int index) const
@@ -376,46 +498,98 @@ bool EC_DynamicComponent::ContainSameAttributes(const EC_DynamicComponent &comp)
 
 bool EC_DynamicComponent::ContainsAttribute(const QString &name) const
 {
-    AttributeVector::const_iterator iter = attributes.begin();
-    while(iter != attributes.end())
-    {
-        if((*iter) && (*iter)->Name() == name)
-            return true;
-        ++iter;
-    }
-
-    return false;
+    return attributeIndex.contains(name);
 }
 
 void EC_DynamicComponent::SerializeToBinary(kNet::DataSerializer& dest) const
 {
-    dest.Add<u8>(attributes.size());
+    SerializeAttributesToBinary(attributes, dest);
+}
+
+void EC_DynamicComponent::SerializeAttributesToBinary(const AttributeVector &attributes, kNet::DataSerializer& dest)
+{
+    // Holes in the attribute vector are not written, so count only the attributes that are. The type names are collected
+    // to a table, so that each attribute refers to its type with an index instead of repeating the name.
+    std::vector<QString> typeNames;
+    std::vector<u8> typeIndices;
+    for(size_t i = 0; i < attributes.size(); ++i)
+    {
+        if (!attributes[i])
+            continue;
+        const QString &typeName = attributes[i]->TypeName();
+        size_t typeIndex = std::find(typeNames.begin(), typeNames.end(), typeName) - typeNames.begin();
+        if (typeIndex == typeNames.size())
+            typeNames.push_back(typeName);
+        typeIndices.push_back((u8)typeIndex);
+    }
+
+    dest.Add<u8>(cTypeTableMarker);
+    dest.Add<u8>(cTypeTableVersion);
+    dest.Add<u8>((u8)typeNames.size());
+    for(size_t i = 0; i < typeNames.size(); ++i)
+        dest.AddString(typeNames[i].toStdString());
+    dest.Add<u16>((u16)typeIndices.size());
     // For now, transmit all values as strings
-    AttributeVector::const_iterator iter = attributes.begin();
-    while(iter != attributes.end())
+    size_t written = 0;
+    for(size_t i = 0; i < attributes.size() && written < typeIndices.size(); ++i)
     {
-        if (*iter)
-        {
-            dest.AddString((*iter)->Name().toStdString());
-            dest.AddString((*iter)->TypeName().toStdString());
-            dest.AddString((*iter)->ToString());
-        }
-        ++iter;
+        if (!attributes[i])
+            continue;
+        dest.AddString(attributes[i]->Name().toStdString());
+        dest.Add<u8>(typeIndices[written++]);
+        dest.AddString(attributes[i]->ToString());
     }
 }
 
 void EC_DynamicComponent::DeserializeFromBinary(kNet::DataDeserializer& source, AttributeChange::Type change)
 {
-    u8 num_attributes = source.Read<u8>();
     std::vector<DeserializeData> deserializedAttributes;
-    for(uint i = 0; i < num_attributes; ++i)
+    u8 num_attributes = source.Read<u8>();
+    // If the first byte is the marker, the second is either the version, or the length of the first attribute name of a legacy component.
+    int firstNameLength = -1;
+    if (num_attributes == cTypeTableMarker && source.BytesLeft() > 0)
+        firstNameLength = source.Read<u8>();
+    if (firstNameLength == cTypeTableVersion)
     {
-        std::string name = source.ReadString();
-        std::string typeName = source.ReadString();
-        std::string value = source.ReadString();
-        
-        DeserializeData attrData(name.c_str(), typeName.c_str(), value.c_str());
-        deserializedAttributes.push_back(attrData);
+        std::vector<std::string> typeNames(source.Read<u8>());
+        for(size_t i = 0; i < typeNames.size(); ++i)
+            typeNames[i] = source.ReadString();
+        u16 numAttributes = source.Read<u16>();
+        for(uint i = 0; i < numAttributes; ++i)
+        {
+            std::string name = source.ReadString();
+            u8 typeIndex = source.Read<u8>();
+            std::string value = source.ReadString();
+            if (typeIndex >= typeNames.size())
+            {
+                LogError("EC_DynamicComponent::DeserializeFromBinary: Attribute \"" + QString::fromStdString(name) + "\" refers to a type that is not in the type table.");
+                return;
+            }
+
+            DeserializeData attrData(name.c_str(), typeNames[typeIndex].c_str(), value.c_str());
+            deserializedAttributes.push_back(attrData);
+        }
+    }
+    else
+    {
+        // The legacy format repeats the type name for each attribute.
+        for(uint i = 0; i < num_attributes; ++i)
+        {
+            std::string name;
+            if (i == 0 && firstNameLength >= 0)
+            {
+                name.resize(firstNameLength);
+                for(int j = 0; j < firstNameLength; ++j)
+                    name[j] = (char)source.Read<u8>();
+            }
+            else
+                name = source.ReadString();
+            std::string typeName = source.ReadString();
+            std::string value = source.ReadString();
+
+            DeserializeData attrData(name.c_str(), typeName.c_str(), value.c_str());
+            deserializedAttributes.push_back(attrData);
+        }
     }
 
     DeserializeCommon(deserializedAttributes, change);
@@ -12,6 +12,7 @@ namespace kNet
 }
 
 #include <QVariant>
+#include <QHash>
 
 struct DeserializeData;
 
@@ -28,7 +29,9 @@ Component for which user can add and delete attributes at runtime.
 It's recommend to use attribute names when you set or get your attribute values because
 indices can change while the dynamic component's attributes are added or removed.
 
-Use CreateAttribute for creating new attributes.
+Use CreateAttribute for creating new attributes, or SetAttributes for creating and setting many attributes at once
+with a single change notification. Attributes are looked up by name through a hash index, so name-based access
+does not depend on the number of attributes.
 
 When component is deserialized it will compare old and a new attribute values and will get difference
 between those two and use that information to remove attributes that are not in the new list and add those
@@ -95,11 +98,20 @@ public:
     }
 
     /// IComponent override
+    /** The attribute type names are written once to a table, and the attributes refer to them by index. */
     virtual void SerializeToBinary(kNet::DataSerializer& dest) const;
 
+    /// Writes the attributes in the format of SerializeToBinary. Null attributes are skipped.
+    /** Used also by SceneSnapshot, which serializes copies of the attributes outside the main thread. */
+    static void SerializeAttributesToBinary(const AttributeVector &attributes, kNet::DataSerializer& dest);
+
     /// IComponent override
+    /** Reads also the legacy format, which repeats the type name for each attribute. */
     virtual void DeserializeFromBinary(kNet::DataDeserializer& source, AttributeChange::Type change);
 
+    /// IComponent override. Returns the size of the attribute name index.
+    virtual size_t ExternalMemoryUsage() const;
+
 public slots:
     /// A factory method that constructs a new attribute of a given the type name.
     /** @param typeName Type name of the attribute.
@@ -148,10 +160,31 @@ public slots:
     /// Removes all attributes from the component
     void RemoveAllAttributes(AttributeChange::Type change = AttributeChange::Default);
 
+    /// Creates and sets multiple attributes with a single change notification.
+    /** Attributes that do not exist are created, with the attribute type deduced from the type of the value. The values are then set,
+        and the changes are signalled at once: the derived-class AttributesChanged() is called once, and when the scene batches
+        attribute changes, Scene::AttributesChanged is emitted once for the whole set, instead of once per attribute. Attributes beyond the first 256 do not fit in the change set,
+        and are signalled one by one.
+        @param values Attribute values by attribute name.
+        @param change Change type. */
+    void SetAttributes(const QVariantMap &values, AttributeChange::Type change = AttributeChange::Default);
+
     void AddQVariantAttribute(const QString &name, AttributeChange::Type change = AttributeChange::Default); /**< @deprecated Use CreateAttribute('qvariant') @todo Remove */
     void SetAttributeQScript(const QString &name, const QScriptValue &value, AttributeChange::Type change = AttributeChange::Default); /**< @deprecated Use SetAttribute @todo Remove */
 
 private:
     /// Convert attribute index without holes (used by client) into actual attribute index. Returns below zero if not found. Requires a linear search.
     int GetInternalAttributeIndex(int index) const;
+
+    /// Returns attribute by name using the name index, or null if not found.
+    IAttribute *FindAttribute(const QString &name) const;
+
+    /// IComponent override. Adds the attribute to the name index.
+    void AttributeInserted(IAttribute *attribute);
+
+    /// IComponent override. Removes the attribute from the name index.
+    void AttributeErased(IAttribute *attribute);
+
+    /// Attributes by name.
+    QHash<QString, IAttribute *> attributeIndex;
 };
@@ -24,7 +24,8 @@
 Entity::Entity(Framework* framework, Scene* scene) :
     framework_(framework),
     scene_(scene),
-    temporary_(false)
+    temporary_(false),
+    active_(true)
 {
 }
 
@@ -32,7 +33,8 @@ Entity::Entity(Framework* framework, entity_id_t id, Scene* scene) :
     framework_(framework),
     id_(id),
     scene_(scene),
-    temporary_(false)
+    temporary_(false),
+    active_(true)
 {
 }
 
@@ -323,6 +325,18 @@ ComponentPtr Entity::CreateLocalComponent(const QString &type_name, const QStrin
     return CreateComponent(type_name, name, AttributeChange::LocalOnly, false);
 }
 
+size_t Entity::MemoryUsage(bool includeComponents) const
+{
+    const size_t mapNodeOverhead = 4 * sizeof(void*); // Color, parent and child links of a std::map node.
+    size_t usage = sizeof(Entity) + components_.size() * (sizeof(ComponentMap::value_type) + mapNodeOverhead);
+    for(ActionMap::const_iterator iter = actions_.begin(); iter != actions_.end(); ++iter)
+        usage += sizeof(QString) + sizeof(EntityAction *) + mapNodeOverhead + HeapMemoryUsage(iter.key()) + sizeof(EntityAction);
+    if (includeComponents)
+        for(ComponentMap::const_iterator iter = components_.begin(); iter != components_.end(); ++iter)
+            usage += iter->second->MemoryUsage();
+    return usage;
+}
+
 ComponentPtr Entity::GetComponentById(entity_id_t id) const
 {
     ComponentMap::const_iterator i = components_.find(id);
@@ -492,24 +506,82 @@ AttributeVector Entity::GetAttributes(const QString &name) const
 
 EntityPtr Entity::Clone(bool local, bool temporary) const
 {
-    QDomDocument doc("Scene");
-    QDomElement sceneElem = doc.createElement("scene");
-    QDomElement entityElem = doc.createElement("entity");
-    entityElem.setAttribute("sync", QString::fromStdString(::ToString<bool>(!local)));
-    entityElem.setAttribute("id", local ? scene_->NextFreeIdLocal() : scene_->NextFreeId());
+    PROFILE(Entity_Clone);
+
+    EntityPtr entity = scene_->CreateEntity(0, QStringList(), AttributeChange::Default, !local);
+    if (!entity)
+        return EntityPtr();
+
+    // Trigger no signals yet while the clone is in an incoherent state
+    CopyComponentsTo(entity.get());
+    entity->SetTemporary(temporary);
+
+    // Now that the clone is complete, trigger the EntityCreated/ComponentChanged signals.
+    EntityWeakPtr weakEntity = entity;
+    scene_->EmitEntityCreated(entity.get(), AttributeChange::Default);
+    if (weakEntity.expired())
+        return EntityPtr();
+    const ComponentMap components = entity->Components();
+    for (ComponentMap::const_iterator i = components.begin(); i != components.end(); ++i)
+        i->second->ComponentChanged(AttributeChange::Default);
+
+    // The above signals may have caused scripts to remove the entity.
+    return weakEntity.lock();
+}
+
+void Entity::CopyComponentsTo(Entity *target) const
+{
     for (ComponentMap::const_iterator i = components_.begin(); i != components_.end(); ++i)
-        i->second->SerializeTo(doc, entityElem);
-    sceneElem.appendChild(entityElem);
-    doc.appendChild(sceneElem);
+    {
+        IComponent *source = i->second.get();
+        ComponentPtr comp = target->GetOrCreateComponent(source->TypeName(), source->Name(), AttributeChange::Default, source->IsReplicated());
+        if (!comp)
+            continue;
+
+        // Static-structure components have identical attribute layouts, so the values can be copied attribute by attribute.
+        const AttributeVector &sourceAttrs = source->Attributes();
+        const AttributeVector &destAttrs = comp->Attributes();
+        bool sameLayout = sourceAttrs.size() == destAttrs.size();
+        for (size_t j = 0; sameLayout && j < sourceAttrs.size(); ++j)
+            if ((sourceAttrs[j] == 0) != (destAttrs[j] == 0) || (sourceAttrs[j] && sourceAttrs[j]->TypeId() != destAttrs[j]->TypeId()))
+                sameLayout = false;
+
+        if (sameLayout)
+        {
+            for (size_t j = 0; j < sourceAttrs.size(); ++j)
+                if (sourceAttrs[j])
+                    destAttrs[j]->CopyValue(sourceAttrs[j], AttributeChange::Disconnected);
+        }
+        else
+        {
+            // Dynamic-structure components (f.ex. EC_DynamicComponent) create their attributes on deserialization.
+            QByteArray comp_bytes;
+            // Assume 64KB max per component for now
+            comp_bytes.resize(64 * 1024);
+            kNet::DataSerializer comp_dest(comp_bytes.data(), comp_bytes.size());
+            source->SerializeToBinary(comp_dest);
+            kNet::DataDeserializer comp_source(comp_bytes.data(), comp_dest.BytesFilled());
+            comp->DeserializeFromBinary(comp_source, AttributeChange::Disconnected);
+        }
+    }
+}
 
-    QList<Entity *> entities = scene_->CreateContentFromXml(doc, true, AttributeChange::Default);
-    if (entities.size() && entities.first())
+void Entity::CopyChangedAttributesTo(Entity *target, AttributeChange::Type change) const
+{
+    for (ComponentMap::const_iterator i = components_.begin(); i != components_.end(); ++i)
     {
-        entities.first()->SetTemporary(temporary);
-        return entities.first()->shared_from_this();
+        IComponent *source = i->second.get();
+        ComponentPtr comp = target->GetComponent(source->TypeName(), source->Name());
+        if (!comp)
+            continue;
+
+        const AttributeVector &sourceAttrs = source->Attributes();
+        const AttributeVector &destAttrs = comp->Attributes();
+        for (size_t j = 0; j < sourceAttrs.size() && j < destAttrs.size(); ++j)
+            if (sourceAttrs[j] && destAttrs[j] && sourceAttrs[j]->TypeId() == destAttrs[j]->TypeId() &&
+                !sourceAttrs[j]->Equals(destAttrs[j]))
+                destAttrs[j]->CopyValue(sourceAttrs[j], change);
     }
-    else
-        return EntityPtr();
 }
 
 void Entity::SetName(const QString &name)
@@ -615,6 +687,14 @@ void Entity::EmitEntityRemoved(AttributeChange::Type change)
     emit EntityRemoved(this, change);
 }
 
+void Entity::EmitActiveChanged(AttributeChange::Type change)
+{
+    if (active_)
+        emit Reactivated(this, change);
+    else
+        emit Deactivated(this, change);
+}
+
 void Entity::EmitEnterView(IComponent* camera)
 {
     emit EnterView(camera);
@@ -128,6 +128,10 @@ public:
     /// introspection for the entity, returns all components
     const ComponentMap &Components() const { return components_; }
 
+    /// Returns the approximate number of bytes used by this entity.
+    /** @param includeComponents If true, the IComponent::MemoryUsage of the components is included, otherwise only the entity itself and its containers. */
+    size_t MemoryUsage(bool includeComponents = true) const;
+
 public slots:
     /// Returns a component by ID. This is the fastest way to query, as the components are stored in a map by id.
     ComponentPtr GetComponentById(component_id_t id) const;
@@ -235,7 +239,9 @@ public slots:
     AttributeVector GetAttributes(const QString &name) const;
 
     /// Creates clone of the entity.
-    /** @param local If true, the new entity will be local entity. If false, the entity will be replicated.
+    /** The attribute values are copied directly from component to component. The EntityCreated and component change
+        signals are emitted once the clone is complete.
+        @param local If true, the new entity will be local entity. If false, the entity will be replicated.
         @param temporary Will the new entity be temporary.
         @return Pointer to the new entity, or null pointer if the cloning fails. */
     EntityPtr Clone(bool local, bool temporary) const;
@@ -319,6 +325,10 @@ public slots:
     ///\todo Doesn't need to be slot, exposed as Q_PROPERTY
     bool IsTemporary() const { return temporary_; }
 
+    /// Returns whether entity is active. Inactive entities are deactivated entities held in the entity pool of the scene.
+    /** Inactive entities are not saved when the scene is saved. @sa Scene::ReleaseEntity, Scene::AcquireEntity */
+    bool IsActive() const { return active_; }
+
     /// Returns if this entity's changes will NOT be sent over the network.
     /// An Entity is always either local or replicated, but not both.
     ///\todo Doesn't need to be slot, exposed as Q_PROPERTY
@@ -376,6 +386,15 @@ signals:
     /// The entity has left a camera's view. Triggered by the rendering subsystem.
     void LeaveView(IComponent* camera);
 
+    /// The entity has been deactivated and moved to the entity pool of the scene.
+    /** Components that simulate or run something, f.ex. physics and scripts, should suspend themselves until the entity is reactivated.
+        @sa Scene::ReleaseEntity */
+    void Deactivated(Entity* entity, AttributeChange::Type change);
+
+    /// The entity has been taken from the entity pool and activated again.
+    /** @sa Scene::AcquireEntity */
+    void Reactivated(Entity* entity, AttributeChange::Type change);
+
 private:
     friend class Scene;
 
@@ -396,9 +415,22 @@ private:
     /// Set new scene
     void SetScene(Scene* scene) { scene_ = scene; }
 
+    /// Set active-flag. Called by Scene when the entity is moved to or taken from the entity pool.
+    void SetActive(bool enable) { active_ = enable; }
+
     /// Emit a entity deletion signal. Called from Scene
     void EmitEntityRemoved(AttributeChange::Type change);
 
+    /// Emit the Deactivated or Reactivated signal, according to the active-flag. Called from Scene
+    void EmitActiveChanged(AttributeChange::Type change);
+
+    /// Creates copies of the components of this entity to the target entity, without signalling the attribute changes. Used by Clone and Scene::Instantiate.
+    void CopyComponentsTo(Entity *target) const;
+
+    /// Copies the attribute values of this entity that differ from those of the target entity, which must have the same components.
+    /** Used by Scene::AcquireEntity to re-activate a pooled entity with only the changed attributes signalled. */
+    void CopyChangedAttributesTo(Entity *target, AttributeChange::Type change) const;
+
     UniqueIdGenerator idGenerator_; ///< Component ID generator
     ComponentMap components_; ///< a list of all components
     entity_id_t id_; ///< Unique id for this entity
@@ -406,6 +438,7 @@ private:
     Scene* scene_; ///< Pointer to scene
     ActionMap actions_; ///< Map of registered entity actions.
     bool temporary_; ///< Temporary-flag
+    bool active_; ///< Active-flag, false while the entity is held in the entity pool of the scene
 };
 
 #include "Entity.inl"
@@ -51,7 +51,73 @@ IAttribute::IAttribute(IComponent* owner_, const char* name_) :
 void IAttribute::Changed(AttributeChange::Type change)
 {
     if (owner)
+    {
+        ++owner->revision;
+        owner->AttributeValueSet(this);
         owner->EmitAttributeChanged(this, change);
+    }
+}
+
+namespace
+{
+/// Approximate size of the reference-counted header of implicitly shared Qt data.
+const size_t cQtSharedDataHeaderSize = 4 * sizeof(int) + sizeof(void*);
+}
+
+size_t HeapMemoryUsage(const QString &value)
+{
+    return value.isNull() ? 0 : cQtSharedDataHeaderSize + value.capacity() * sizeof(QChar);
+}
+
+size_t HeapMemoryUsage(const QVariant &value)
+{
+    switch(value.type())
+    {
+    case QVariant::String:
+        return HeapMemoryUsage(value.toString());
+    case QVariant::List:
+        return HeapMemoryUsage(value.toList());
+    case QVariant::StringList:
+    {
+        QStringList strings = value.toStringList();
+        size_t usage = cQtSharedDataHeaderSize + strings.size() * sizeof(void*);
+        foreach(const QString &str, strings)
+            usage += sizeof(QString) + HeapMemoryUsage(str);
+        return usage;
+    }
+    default:
+        // Custom types are stored in the heap by QVariant.
+        if (value.userType() == qMetaTypeId<AssetReference>())
+            return sizeof(AssetReference) + HeapMemoryUsage(value.value<AssetReference>());
+        if (value.userType() == qMetaTypeId<AssetReferenceList>())
+            return sizeof(AssetReferenceList) + HeapMemoryUsage(value.value<AssetReferenceList>());
+        if (value.userType() == qMetaTypeId<EntityReference>())
+            return sizeof(EntityReference) + HeapMemoryUsage(value.value<EntityReference>());
+        return 0;
+    }
+}
+
+size_t HeapMemoryUsage(const QList<QVariant> &value)
+{
+    size_t usage = cQtSharedDataHeaderSize + value.size() * sizeof(void*);
+    foreach(const QVariant &variant, value)
+        usage += sizeof(QVariant) + HeapMemoryUsage(variant);
+    return usage;
+}
+
+size_t HeapMemoryUsage(const AssetReference &value)
+{
+    return HeapMemoryUsage(value.ref) + HeapMemoryUsage(value.type);
+}
+
+size_t HeapMemoryUsage(const AssetReferenceList &value)
+{
+    return HeapMemoryUsage(value.refs) + HeapMemoryUsage(value.type);
+}
+
+size_t HeapMemoryUsage(const EntityReference &value)
+{
+    return HeapMemoryUsage(value.ref);
 }
 
 // Hide all template implementations from being included to public documentation
@@ -921,6 +987,116 @@ template<> void Attribute<QPoint>::FromBinary(kNet::DataDeserializer& source, At
     Set(value, change);
 }
 
+// EQUALS TEMPLATE IMPLEMENTATIONS
+
+template<> bool Attribute<QString>::Equals(const IAttribute* other) const
+{
+    const Attribute<QString>* otherAttr = dynamic_cast<const Attribute<QString>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<int>::Equals(const IAttribute* other) const
+{
+    const Attribute<int>* otherAttr = dynamic_cast<const Attribute<int>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<uint>::Equals(const IAttribute* other) const
+{
+    const Attribute<uint>* otherAttr = dynamic_cast<const Attribute<uint>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<float>::Equals(const IAttribute* other) const
+{
+    const Attribute<float>* otherAttr = dynamic_cast<const Attribute<float>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<bool>::Equals(const IAttribute* other) const
+{
+    const Attribute<bool>* otherAttr = dynamic_cast<const Attribute<bool>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<Color>::Equals(const IAttribute* other) const
+{
+    const Attribute<Color>* otherAttr = dynamic_cast<const Attribute<Color>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<float2>::Equals(const IAttribute* other) const
+{
+    const Attribute<float2>* otherAttr = dynamic_cast<const Attribute<float2>*>(other);
+    return otherAttr && Get().x == otherAttr->Get().x && Get().y == otherAttr->Get().y;
+}
+
+template<> bool Attribute<float3>::Equals(const IAttribute* other) const
+{
+    const Attribute<float3>* otherAttr = dynamic_cast<const Attribute<float3>*>(other);
+    return otherAttr && Get().x == otherAttr->Get().x && Get().y == otherAttr->Get().y && Get().z == otherAttr->Get().z;
+}
+
+template<> bool Attribute<float4>::Equals(const IAttribute* other) const
+{
+    const Attribute<float4>* otherAttr = dynamic_cast<const Attribute<float4>*>(other);
+    return otherAttr && Get().x == otherAttr->Get().x && Get().y == otherAttr->Get().y && Get().z == otherAttr->Get().z && Get().w == otherAttr->Get().w;
+}
+
+template<> bool Attribute<Quat>::Equals(const IAttribute* other) const
+{
+    const Attribute<Quat>* otherAttr = dynamic_cast<const Attribute<Quat>*>(other);
+    return otherAttr && Get().x == otherAttr->Get().x && Get().y == otherAttr->Get().y && Get().z == otherAttr->Get().z && Get().w == otherAttr->Get().w;
+}
+
+template<> bool Attribute<AssetReference>::Equals(const IAttribute* other) const
+{
+    const Attribute<AssetReference>* otherAttr = dynamic_cast<const Attribute<AssetReference>*>(other);
+    return otherAttr && Get().ref == otherAttr->Get().ref && Get().type == otherAttr->Get().type;
+}
+
+template<> bool Attribute<AssetReferenceList>::Equals(const IAttribute* other) const
+{
+    const Attribute<AssetReferenceList>* otherAttr = dynamic_cast<const Attribute<AssetReferenceList>*>(other);
+    return otherAttr && Get() == otherAttr->Get() && Get().type == otherAttr->Get().type;
+}
+
+template<> bool Attribute<EntityReference>::Equals(const IAttribute* other) const
+{
+    const Attribute<EntityReference>* otherAttr = dynamic_cast<const Attribute<EntityReference>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<QVariant>::Equals(const IAttribute* other) const
+{
+    const Attribute<QVariant>* otherAttr = dynamic_cast<const Attribute<QVariant>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<QVariantList>::Equals(const IAttribute* other) const
+{
+    const Attribute<QVariantList>* otherAttr = dynamic_cast<const Attribute<QVariantList>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<QPoint>::Equals(const IAttribute* other) const
+{
+    const Attribute<QPoint>* otherAttr = dynamic_cast<const Attribute<QPoint>*>(other);
+    return otherAttr && Get() == otherAttr->Get();
+}
+
+template<> bool Attribute<Transform>::Equals(const IAttribute* other) const
+{
+    // Transform::operator == compares with an epsilon, so compare the components exactly instead.
+    const Attribute<Transform>* otherAttr = dynamic_cast<const Attribute<Transform>*>(other);
+    if (!otherAttr)
+        return false;
+    const Transform &a = Get();
+    const Transform &b = otherAttr->Get();
+    return a.pos.x == b.pos.x && a.pos.y == b.pos.y && a.pos.z == b.pos.z && a.rot.x == b.rot.x && a.rot.y == b.rot.y &&
+        a.rot.z == b.rot.z && a.scale.x == b.scale.x && a.scale.y == b.scale.y && a.scale.z == b.scale.z;
+}
+
 // INTERPOLATE TEMPLATE IMPLEMENTATIONS
 
 template<> void Attribute<QString>::Interpolate(IAttribute* start, IAttribute* end, float t, AttributeChange::Type change)
@@ -21,6 +21,20 @@ namespace kNet
 
 class QScriptValue;
 class QVariant;
+template<typename T> class QList;
+struct AssetReference;
+struct AssetReferenceList;
+
+/// Returns the approximate amount of heap memory owned by an attribute value, not including the size of the value object itself.
+/** Overloaded for the attribute types that own heap memory, the rest own none. Implicitly shared Qt data is counted in full for each reference. */
+template<typename T>
+size_t HeapMemoryUsage(const T &) { return 0; }
+size_t HeapMemoryUsage(const QString &value); ///< @overload
+size_t HeapMemoryUsage(const QVariant &value); ///< @overload
+size_t HeapMemoryUsage(const QList<QVariant> &value); ///< @overload
+size_t HeapMemoryUsage(const AssetReference &value); ///< @overload
+size_t HeapMemoryUsage(const AssetReferenceList &value); ///< @overload
+size_t HeapMemoryUsage(const EntityReference &value); ///< @overload
 
 /// Abstract base class for entity-component attributes.
 /** Concrete attribute classes will be subclassed out of this. */
@@ -69,6 +83,10 @@ public:
     /// /todo Remove when if possible.
     virtual void FromScriptValue(const QScriptValue &value, AttributeChange::Type change) = 0;
 
+    /// Returns the approximate number of bytes used by this attribute, including the heap memory owned by its name and value.
+    /** Metadata is shared between the attributes of a component type, and is not included. */
+    virtual size_t MemoryUsage() const = 0;
+
     /// Sets attribute's metadata.
     /** @param meta Metadata. */
     void SetMetadata(AttributeMetadata *meta) { metadata = meta; }
@@ -96,6 +114,10 @@ public:
     /// Copies the value from another attribute of the same type.
     virtual void CopyValue(IAttribute* source, AttributeChange::Type change) = 0;
 
+    /// Returns true if the other attribute is of the same type and has exactly the same value.
+    /** Unlike comparing the ToString() representations, no precision is lost and no strings are allocated. */
+    virtual bool Equals(const IAttribute* other) const = 0;
+
     /// Interpolates the value of this attribute based on two values, and a lerp factor between 0 and 1
     /** The attributes given must be of the same type for the result to be defined.
         Is a no-op if the attribute (for example string) does not support interpolation.
@@ -203,6 +225,12 @@ public:
 
     /// IAttribute override
     virtual void Interpolate(IAttribute* start, IAttribute* end, float t, AttributeChange::Type change);
+
+    /// IAttribute override
+    virtual bool Equals(const IAttribute* other) const;
+
+    /// IAttribute override.
+    virtual size_t MemoryUsage() const { return sizeof(*this) + HeapMemoryUsage(name) + HeapMemoryUsage(value); }
     
     /// Returns the type of the data stored in this attribute.
     virtual QString TypeName() const;
@@ -28,7 +28,8 @@ IComponent::IComponent(Scene* scene) :
     updateMode(AttributeChange::Replicate),
     replicated(true),
     temporary(false),
-    id(0)
+    id(0),
+    revision(0)
 {
 }
 
@@ -120,6 +121,15 @@ AttributeVector IComponent::NonEmptyAttributes() const
     return ret;
 }
 
+size_t IComponent::MemoryUsage() const
+{
+    size_t usage = sizeof(IComponent) + HeapMemoryUsage(name) + attributes.capacity() * sizeof(IAttribute*);
+    for(size_t i = 0; i < attributes.size(); ++i)
+        if (attributes[i])
+            usage += attributes[i]->MemoryUsage();
+    return usage + ExternalMemoryUsage();
+}
+
 QVariant IComponent::GetAttributeQVariant(const QString &name) const
 {
     for(AttributeVector::const_iterator iter = attributes.begin(); iter != attributes.end(); ++iter)
@@ -222,7 +232,9 @@ void IComponent::RemoveAttribute(u8 index, AttributeChange::Type change)
         
         // Trigger internal signal(s)
         emit AttributeAboutToBeRemoved(attr);
+        AttributeErased(attr);
         SAFE_DELETE(attributes[index]);
+        ++revision;
     }
     else
         LogError("Can not remove nonexisting attribute at index " + QString::number(index));
@@ -232,6 +244,7 @@ void IComponent::AddAttribute(IAttribute* attr)
 {
     if (!attr)
         return;
+    ++revision;
     // If attribute is static (member variable attributes), we can just push_back it.
     if (!attr->IsDynamic())
     {
@@ -249,6 +262,7 @@ void IComponent::AddAttribute(IAttribute* attr)
                 attr->index = i;
                 attr->owner = this;
                 attributes[i] = attr;
+                AttributeInserted(attr);
                 return;
             }
         }
@@ -256,12 +270,14 @@ void IComponent::AddAttribute(IAttribute* attr)
         attr->owner = this;
         attributes.push_back(attr);
     }
+    AttributeInserted(attr);
 }
 
 bool IComponent::AddAttribute(IAttribute* attr, u8 index)
 {
     if (!attr)
         return false;
+    ++revision;
     if (index < attributes.size())
     {
         IAttribute* existing = attributes[index];
@@ -275,6 +291,7 @@ bool IComponent::AddAttribute(IAttribute* attr, u8 index)
             else
             {
                 LogWarning("Removing existing attribute at index " + QString::number(index) + " to make room for new attribute");
+                AttributeErased(existing);
                 delete existing;
                 attributes[index] = 0;
             }
@@ -290,6 +307,7 @@ bool IComponent::AddAttribute(IAttribute* attr, u8 index)
     attr->index = index;
     attr->owner = this;
     attributes[index] = attr;
+    AttributeInserted(attr);
     return true;
 }
 
@@ -380,7 +398,15 @@ void IComponent::EmitAttributeChanged(IAttribute* attribute, AttributeChange::Ty
     // Trigger scenemanager signal
     Scene* scene = ParentScene();
     if (scene)
+    {
+        // If the scene is batching attribute changes, defer all the signalling to the end of the frame
+        if (scene->AttributeChangeBatching())
+        {
+            scene->QueueAttributeChange(this, attribute, change);
+            return;
+        }
         scene->EmitAttributeChanged(this, attribute, change);
+    }
     
     // Trigger internal signal
     emit AttributeChanged(attribute, change);
@@ -394,6 +420,25 @@ void IComponent::EmitAttributeChanged(IAttribute* attribute, AttributeChange::Ty
             attributes[i]->ClearChangedFlag();
 }
 
+void IComponent::EmitAttributeChanges(const AttributeChangeSet &changes)
+{
+    Scene* scene = ParentScene();
+    for(size_t i = 0; i < attributes.size() && i < 256; ++i)
+    {
+        if (!attributes[i] || !changes.IsDirty((u8)i))
+            continue;
+        if (scene)
+            scene->EmitAttributeChanged(this, attributes[i], changes.change);
+        emit AttributeChanged(attributes[i], changes.change);
+    }
+
+    // Tell the derived class once that some attributes have changed, then clear all the change bits.
+    AttributesChanged();
+    for(size_t i = 0; i < attributes.size(); ++i)
+        if (attributes[i])
+            attributes[i]->ClearChangedFlag();
+}
+
 void IComponent::EmitAttributeChanged(const QString& attributeName, AttributeChange::Type change)
 {
     // If this message should be sent with the default attribute change mode specified in the IComponent,
@@ -9,12 +9,15 @@
 #include "SceneFwd.h"
 #include "AttributeChangeType.h"
 #include "IAttribute.h"
+#include "AttributeChangeSet.h"
 
 #include <boost/enable_shared_from_this.hpp>
 
 #include <QObject>
 #include <QVariant>
 
+#include <map>
+
 class QDomDocument;
 class QDomElement;
 
@@ -128,6 +131,11 @@ public:
 
     /// Returns a list of all attributes with null attributes sanitated away. This is slower than Attributes().
     AttributeVector NonEmptyAttributes() const;
+
+    /// Returns the revision of the attribute data of this component.
+    /** The revision is incremented every time an attribute value is set, regardless of the change type, and when attributes are added or removed.
+        It can be used to detect whether data cached from the attributes is still up to date. */
+    u32 Revision() const { return revision; }
     
     /// Finds and returns an attribute of type 'Attribute<T>' and given name.
     /** @param T The Attribute type to look for.
@@ -181,6 +189,21 @@ public:
     /// Remove an attribute at the specified index. Called by network sync.
     void RemoveAttribute(u8 index, AttributeChange::Type change);
     
+    /// Returns the approximate number of bytes used by this component.
+    /** Includes the component base object, its attributes and ExternalMemoryUsage(). Members of the derived classes other than attributes are not included,
+        and neither are the resources reported by SharedResources(). */
+    size_t MemoryUsage() const;
+
+    /// Returns the approximate number of bytes of memory held by this component outside its attributes.
+    /** Components override this to report their internal data structures. Resources that may be shared with other components
+        are reported with SharedResources() instead. */
+    virtual size_t ExternalMemoryUsage() const { return 0; }
+
+    /// Adds the resources this component uses that may be shared with other components to the map, with their sizes in bytes.
+    /** Rendering components override this to report the Ogre meshes and skeletons they use. The resources are keyed by their address,
+        so that Scene::MemoryUsage counts each of them once, however many components use it. */
+    virtual void SharedResources(std::map<const void *, size_t> &resources) const {}
+
     /// Enables or disables network synchronization of changes that occur in the attributes of this component.
     /** True by default. Can only be changed before the component is added to an entity, because the replication determines the ID range to use. */
     void SetReplicated(bool enable);
@@ -358,9 +381,17 @@ protected:
     /// Temporary-flag
     bool temporary;
 
+    /// Revision of the attribute data. @see Revision
+    u32 revision;
+
+    /// Emits the per-attribute change signals for a coalesced set of changes and notifies the derived class once.
+    /** Called by Scene when dispatching batched attribute changes, and by components that set many attributes at once. */
+    void EmitAttributeChanges(const AttributeChangeSet &changes);
+
 private:
     friend class ::IAttribute;
     friend class Entity;
+    friend class Scene;
     
     /// This function is called by the base class (IComponent) to signal to the derived class that one or more
     /// of its attributes have changed, and it should update its internal state accordingly.
@@ -368,6 +399,19 @@ private:
     /// and after reacting to the change, call IAttribute::ClearChangedFlag().
     virtual void AttributesChanged() {}
 
+    /// This function is called by IAttribute whenever the value of an attribute of this component is set.
+    /** Unlike AttributesChanged(), this is called immediately for all change types, including AttributeChange::Disconnected
+        and changes deferred by attribute change batching, so the derived class can invalidate state it caches from attribute values.
+        @param attribute Attribute whose value was set. */
+    virtual void AttributeValueSet(IAttribute *attribute) {}
+
+    /// This function is called when an attribute has been inserted to the attribute vector of this component.
+    /** Called for both static and dynamic attributes, so the derived class can maintain lookup structures over its attributes. */
+    virtual void AttributeInserted(IAttribute *attribute) {}
+
+    /// This function is called when an attribute is about to be removed from the attribute vector of this component and deleted.
+    virtual void AttributeErased(IAttribute *attribute) {}
+
     /// Set component id. Called by Entity
     void SetNewId(component_id_t newId);
 };
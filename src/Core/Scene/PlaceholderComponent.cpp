@@ -0,0 +1,55 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "PlaceholderComponent.h"
+#include "SceneAPI.h"
+#include "IAttribute.h"
+#include "LoggingFunctions.h"
+
+#include "MemoryLeakCheck.h"
+
+PlaceholderComponent::PlaceholderComponent(Scene *scene, const QString &typeName, u32 typeId) :
+    IComponent(scene),
+    typeName_(typeName),
+    typeId_(typeId)
+{
+}
+
+PlaceholderComponentFactory::PlaceholderComponentFactory(const QString &typeName, u32 typeId) :
+    typeName_(typeName),
+    typeId_(typeId)
+{
+}
+
+PlaceholderComponentFactory &PlaceholderComponentFactory::AddAttribute(const QString &typeName, const QString &name, const QString &defaultValue)
+{
+    AttributeDesc desc;
+    desc.typeName = typeName;
+    desc.name = name;
+    desc.defaultValue = defaultValue;
+    attributes_.push_back(desc);
+    return *this;
+}
+
+boost::shared_ptr<IComponent> PlaceholderComponentFactory::Create(Scene* scene, const QString &newComponentName)
+{
+    boost::shared_ptr<PlaceholderComponent> component = boost::make_shared<PlaceholderComponent>(scene, typeName_, typeId_);
+    component->SetName(newComponentName);
+    for(size_t i = 0; i < attributes_.size(); ++i)
+    {
+        IAttribute *attribute = SceneAPI::CreateAttribute(attributes_[i].typeName, attributes_[i].name);
+        if (!attribute)
+        {
+            // The indices of the rest of the attributes would not match the original component.
+            LogError("PlaceholderComponentFactory: Failed to create attribute " + attributes_[i].name + " of type " + attributes_[i].typeName +
+                " for " + typeName_ + ".");
+            return boost::shared_ptr<IComponent>();
+        }
+        if (!attributes_[i].defaultValue.isEmpty())
+            attribute->FromString(attributes_[i].defaultValue.toStdString(), AttributeChange::Disconnected);
+        component->AddAttribute(attribute);
+    }
+    return component;
+}
@@ -0,0 +1,74 @@
+/**
+    For conditions of distribution and use, see copyright notice in LICENSE
+
+    @file   PlaceholderComponent.h
+    @brief  Attribute-only stand-in for a component type that is not available in the build. */
+
+#pragma once
+
+#include "IComponent.h"
+#include "IComponentFactory.h"
+
+#include <QString>
+
+#include <vector>
+
+/// Attribute-only stand-in for a component type that is not available in the build.
+/** Has the type name, type id and attributes of the original component, but none of its functionality. Used f.ex. in the headless
+    server build, which does not build the components that need Ogre, so that scenes containing them can still be loaded, saved and
+    replicated without losing their data. Create placeholders with PlaceholderComponentFactory. */
+class PlaceholderComponent : public IComponent
+{
+public:
+    /// Do not directly allocate new components using operator new, but use the factory-based SceneAPI::CreateComponent functions instead.
+    PlaceholderComponent(Scene *scene, const QString &typeName, u32 typeId);
+
+    /// IComponent override.
+    virtual const QString &TypeName() const { return typeName_; }
+
+    /// IComponent override.
+    virtual u32 TypeId() const { return typeId_; }
+
+private:
+    friend class PlaceholderComponentFactory;
+
+    QString typeName_;
+    u32 typeId_;
+};
+
+/// A factory for placeholders of a component type, see PlaceholderComponent.
+/** The attributes must be declared in the same order as in the original component, as the binary serialization and the network sync
+    refer to the attributes by index.
+    @code
+    boost::shared_ptr<PlaceholderComponentFactory> fog(new PlaceholderComponentFactory("EC_Fog", 9));
+    fog->AddAttribute("int", "Mode", "3").AddAttribute("color", "Color", "0.707792 0.770537 0.831373 1");
+    framework->Scene()->RegisterComponentFactory(fog);
+    @endcode */
+class PlaceholderComponentFactory : public IComponentFactory
+{
+public:
+    PlaceholderComponentFactory(const QString &typeName, u32 typeId);
+
+    /// Declares the next attribute of the component.
+    /** @param typeName Attribute type name, see SceneAPI::AttributeTypes.
+        @param name Name of the attribute.
+        @param defaultValue Default value in the format of IAttribute::FromString, or empty for the default value of the attribute type.
+        @return This factory, so that the attributes can be declared in a chain. */
+    PlaceholderComponentFactory &AddAttribute(const QString &typeName, const QString &name, const QString &defaultValue = QString());
+
+    QString TypeName() { return typeName_; }
+    u32 TypeId() { return typeId_; }
+    boost::shared_ptr<IComponent> Create(Scene* scene, const QString &newComponentName);
+
+private:
+    struct AttributeDesc
+    {
+        QString typeName;
+        QString name;
+        QString defaultValue;
+    };
+
+    QString typeName_;
+    u32 typeId_;
+    std::vector<AttributeDesc> attributes_;
+};
@@ -13,16 +13,24 @@
 #include "AttributeMetadata.h"
 #include "ChangeRequest.h"
 #include "EntityReference.h"
+#include "Color.h"
+#include "Math/float2.h"
+#include "SceneBinaryIndex.h"
 
 #include "Framework.h"
 #include "Application.h"
 #include "AssetAPI.h"
+#include "AssetPrefetchManifest.h"
+#include "IAsset.h"
 #include "FrameAPI.h"
 #include "Profiler.h"
 #include "LoggingFunctions.h"
+#include "HighPerfClock.h"
+#include "IRenderer.h"
 
 #include <QString>
 #include <QDomDocument>
+#include <QXmlStreamReader>
 #include <QFile>
 #include <QDir>
 #include <QTextStream>
@@ -32,8 +40,15 @@
 #include <kNet/DataSerializer.h>
 
 #include <boost/regex.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 #include <utility>
+#include <set>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
 #include "MemoryLeakCheck.h"
 
 using namespace kNet;
@@ -42,17 +57,31 @@ Scene::Scene(const QString &name, Framework *framework, bool viewEnabled, bool a
     name_(name),
     framework_(framework),
     interpolating_(false),
-    authority_(authority)
+    authority_(authority),
+    batchAttributeChanges_(false),
+    dispatchingAttributeChanges_(false),
+    incrementalLoadFocus_(float3::zero),
+    hasIncrementalLoadFocus_(false),
+    entityPoolCapacity_(256)
 {
     // In headless mode only view disabled-scenes can be created
     viewEnabled_ = framework->IsHeadless() ? false : viewEnabled;
 
+    if (framework->HasCommandLineParameter("--batchAttributeChanges"))
+        batchAttributeChanges_ = true;
+
     // Connect to frame update to handle signalling entities created on this frame
     connect(framework->Frame(), SIGNAL(Updated(float)), this, SLOT(OnUpdated(float)));
+    // Connect to end of frame to dispatch batched attribute changes
+    connect(framework->Frame(), SIGNAL(PostFrameUpdate(float)), this, SLOT(OnPostFrameUpdate(float)));
 }
 
 Scene::~Scene()
 {
+    // Let an ongoing background save finish writing the file
+    if (backgroundSave_)
+        backgroundSave_->thread.join();
+
     EndAllAttributeInterpolations();
     
     // Do not send entity removal or scene cleared events on destruction
@@ -206,6 +235,7 @@ void Scene::RemoveAllEntities(bool signal, AttributeChange::Type change)
         ++it;
     }
     entities_.clear();
+    entityPool_.clear();
     if (signal)
         emit SceneCleared(this);
     
@@ -281,6 +311,91 @@ void Scene::EmitAttributeChanged(IComponent* comp, IAttribute* attribute, Attrib
     emit AttributeChanged(comp, attribute, change);
 }
 
+void Scene::QueueAttributeChange(IComponent* comp, IAttribute* attribute, AttributeChange::Type change)
+{
+    if (!comp || !attribute || change == AttributeChange::Disconnected)
+        return;
+    if (change == AttributeChange::Default)
+        change = comp->UpdateMode();
+
+    std::pair<IComponent*, AttributeChange::Type> key = std::make_pair(comp, change);
+    PendingAttributeChangeIndexMap::iterator iter = pendingAttributeChangeIndices_.find(key);
+    if (iter != pendingAttributeChangeIndices_.end())
+    {
+        PendingAttributeChanges &pending = pendingAttributeChanges_[iter->second];
+        // A new component may have been allocated to the address of an expired one during this frame
+        if (pending.comp.lock().get() == comp)
+        {
+            pending.changes.MarkDirty(attribute->Index());
+            return;
+        }
+        pending.comp.reset();
+    }
+
+    PendingAttributeChanges pending;
+    pending.comp = comp->shared_from_this();
+    pending.changes.change = change;
+    pending.changes.MarkDirty(attribute->Index());
+    pendingAttributeChangeIndices_[key] = pendingAttributeChanges_.size();
+    pendingAttributeChanges_.push_back(pending);
+}
+
+void Scene::DispatchAttributeChanges(IComponent* comp, const AttributeChangeSet &changes)
+{
+    if (!comp || changes.IsEmpty() || changes.change == AttributeChange::Disconnected)
+        return;
+
+    AttributeChangeSet dispatched = changes;
+    if (dispatched.change == AttributeChange::Default)
+        dispatched.change = comp->UpdateMode();
+
+    if (batchAttributeChanges_)
+    {
+        const AttributeVector &attributes = comp->Attributes();
+        for(size_t i = 0; i < attributes.size() && i < 256; ++i)
+            if (attributes[i] && dispatched.IsDirty((u8)i))
+                QueueAttributeChange(comp, attributes[i], dispatched.change);
+        return;
+    }
+
+    // Without batching the changes go out as the per-attribute signals only, so that the listeners do not see them twice.
+    comp->EmitAttributeChanges(dispatched);
+}
+
+void Scene::SetAttributeChangeBatching(bool enable)
+{
+    if (enable == batchAttributeChanges_)
+        return;
+    batchAttributeChanges_ = enable;
+    if (!enable)
+        FlushAttributeChanges();
+}
+
+void Scene::FlushAttributeChanges()
+{
+    if (pendingAttributeChanges_.empty() || dispatchingAttributeChanges_)
+        return;
+
+    PROFILE(Scene_FlushAttributeChanges);
+
+    // Take the pending changes out first: the listeners may change attributes, which will be queued for the next dispatch.
+    std::vector<PendingAttributeChanges> changes;
+    changes.swap(pendingAttributeChanges_);
+    pendingAttributeChangeIndices_.clear();
+
+    dispatchingAttributeChanges_ = true;
+    for(size_t i = 0; i < changes.size(); ++i)
+    {
+        ComponentPtr comp = changes[i].comp.lock();
+        if (!comp || comp->ParentScene() != this)
+            continue;
+
+        emit AttributesChanged(comp.get(), changes[i].changes);
+        comp->EmitAttributeChanges(changes[i].changes);
+    }
+    dispatchingAttributeChanges_ = false;
+}
+
 void Scene::EmitAttributeAdded(IComponent* comp, IAttribute* attribute, AttributeChange::Type change)
 {
     // "Stealth" addition (disconnected changetype) is not supported. Always signal.
@@ -337,6 +452,196 @@ void Scene::EmitActionTriggered(Entity *entity, const QString &action, const QSt
     emit ActionTriggered(entity, action, params, type);
 }
 
+QList<Entity *> Scene::Instantiate(Entity *prototype, uint count, const QList<Transform> &transforms, bool local, bool temporary, AttributeChange::Type change)
+{
+    if (!prototype || prototype->ParentScene() != this)
+    {
+        LogError("Scene::Instantiate: Null prototype entity or prototype does not belong to this scene!");
+        return QList<Entity*>();
+    }
+
+    PROFILE(Scene_Instantiate);
+
+    std::vector<EntityWeakPtr> entities;
+    entities.reserve(count);
+    std::set<Entity*> instances;
+    const size_t firstQueued = entitiesCreatedThisFrame_.size();
+
+    for(uint i = 0; i < count; ++i)
+    {
+        EntityPtr entity = CreateEntity(0, QStringList(), AttributeChange::Default, !local);
+        if (!entity)
+        {
+            LogError("Scene::Instantiate: Failed to create instance " + QString::number(i) + " of " + prototype->ToString() + "!");
+            continue;
+        }
+
+        // Trigger no signal yet when scene is in incoherent state
+        prototype->CopyComponentsTo(entity.get());
+        entity->SetTemporary(temporary);
+
+        if ((int)i < transforms.size())
+        {
+            ComponentPtr placeable = entity->GetComponent("EC_Placeable");
+            Attribute<Transform> *transform = placeable ? dynamic_cast<Attribute<Transform> *>(placeable->GetAttribute("Transform")) : 0;
+            if (transform)
+                transform->Set(transforms[i], AttributeChange::Disconnected);
+        }
+
+        entities.push_back(entity);
+        instances.insert(entity.get());
+    }
+
+    // The instances are signalled below, so remove them from the end-of-frame creation queue in one go.
+    std::vector<std::pair<EntityWeakPtr, AttributeChange::Type> >::iterator queueEnd = entitiesCreatedThisFrame_.begin() + firstQueued;
+    for(std::vector<std::pair<EntityWeakPtr, AttributeChange::Type> >::iterator iter = queueEnd; iter != entitiesCreatedThisFrame_.end(); ++iter)
+        if (instances.find(iter->first.lock().get()) == instances.end())
+            *queueEnd++ = *iter;
+    entitiesCreatedThisFrame_.erase(queueEnd, entitiesCreatedThisFrame_.end());
+
+    // Now that each instance is spawned to the scene, trigger all the signals for EntityCreated/ComponentChanged messages.
+    AttributeChange::Type createChange = (change == AttributeChange::Default ? AttributeChange::Replicate : change);
+    for(unsigned i = 0; i < entities.size(); ++i)
+    {
+        if (change != AttributeChange::Disconnected && !entities[i].expired())
+            emit EntityCreated(entities[i].lock().get(), createChange);
+        if (!entities[i].expired())
+        {
+            EntityPtr entityShared = entities[i].lock();
+            const Entity::ComponentMap components = entityShared->Components();
+            for (Entity::ComponentMap::const_iterator j = components.begin(); j != components.end(); ++j)
+                j->second->ComponentChanged(change);
+        }
+    }
+
+    // The above signals may have caused scripts to remove entities. Return those that still exist.
+    QList<Entity *> ret;
+    for(unsigned i = 0; i < entities.size(); ++i)
+        if (!entities[i].expired())
+            ret.append(entities[i].lock().get());
+
+    return ret;
+}
+
+bool Scene::ReleaseEntity(entity_id_t id, AttributeChange::Type change)
+{
+    EntityPtr entity = EntityById(id);
+    if (!entity || !entity->IsActive())
+        return false;
+
+    std::vector<EntityWeakPtr> &pool = entityPool_[PoolSignature(entity.get(), entity->IsReplicated())];
+    // Forget the pooled entities that have been removed from the scene meanwhile
+    for(size_t i = 0; i < pool.size();)
+    {
+        EntityPtr pooled = pool[i].lock();
+        if (!pooled || pooled->ParentScene() != this || pooled->IsActive())
+            pool.erase(pool.begin() + i);
+        else
+            ++i;
+    }
+
+    if (pool.size() >= entityPoolCapacity_)
+    {
+        RemoveEntity(id, change);
+        return false;
+    }
+
+    // Hide the entity instead of removing it. This is done before the deactivation, so that the hiding is still replicated.
+    ComponentPtr placeable = entity->GetComponent("EC_Placeable");
+    Attribute<bool> *visible = placeable ? dynamic_cast<Attribute<bool> *>(placeable->GetAttribute("Visible")) : 0;
+    if (visible)
+        visible->Set(false, change);
+
+    entity->SetActive(false);
+    pool.push_back(entity);
+    // Let the components suspend themselves, f.ex. EC_RigidBody removes its body from the physics world and EC_Script unloads its script.
+    entity->EmitActiveChanged(change);
+
+    if (change != AttributeChange::Disconnected)
+        emit EntityDeactivated(entity.get(), change == AttributeChange::Default ? AttributeChange::Replicate : change);
+    return true;
+}
+
+EntityPtr Scene::AcquireEntity(Entity *prototype, bool local, bool temporary, AttributeChange::Type change)
+{
+    if (!prototype || prototype->ParentScene() != this)
+    {
+        LogError("Scene::AcquireEntity: Null prototype entity or prototype does not belong to this scene!");
+        return EntityPtr();
+    }
+
+    PROFILE(Scene_AcquireEntity);
+
+    EntityPoolMap::iterator iter = entityPool_.find(PoolSignature(prototype, !local));
+    while(iter != entityPool_.end() && !iter->second.empty())
+    {
+        EntityPtr entity = iter->second.back().lock();
+        iter->second.pop_back();
+        if (!entity || entity->ParentScene() != this || entity->IsActive())
+            continue;
+
+        entity->SetActive(true);
+        entity->SetTemporary(temporary);
+        // Signal only the attributes that differ from the prototype. This also restores the EC_Placeable visibility.
+        prototype->CopyChangedAttributesTo(entity.get(), change);
+        entity->EmitActiveChanged(change);
+
+        if (change != AttributeChange::Disconnected)
+            emit EntityReactivated(entity.get(), change == AttributeChange::Default ? AttributeChange::Replicate : change);
+        return entity;
+    }
+
+    QList<Entity *> created = Instantiate(prototype, 1, QList<Transform>(), local, temporary, change);
+    return !created.isEmpty() ? created.first()->shared_from_this() : EntityPtr();
+}
+
+void Scene::ClearEntityPool(AttributeChange::Type change)
+{
+    std::vector<entity_id_t> ids;
+    for(EntityPoolMap::const_iterator iter = entityPool_.begin(); iter != entityPool_.end(); ++iter)
+        for(size_t i = 0; i < iter->second.size(); ++i)
+        {
+            EntityPtr pooled = iter->second[i].lock();
+            if (pooled && pooled->ParentScene() == this && !pooled->IsActive())
+                ids.push_back(pooled->Id());
+        }
+    entityPool_.clear();
+
+    for(size_t i = 0; i < ids.size(); ++i)
+        RemoveEntity(ids[i], change);
+}
+
+uint Scene::PooledEntityCount() const
+{
+    uint count = 0;
+    for(EntityPoolMap::const_iterator iter = entityPool_.begin(); iter != entityPool_.end(); ++iter)
+        for(size_t i = 0; i < iter->second.size(); ++i)
+        {
+            EntityPtr pooled = iter->second[i].lock();
+            if (pooled && pooled->ParentScene() == this && !pooled->IsActive())
+                ++count;
+        }
+    return count;
+}
+
+QString Scene::PoolSignature(const Entity *entity, bool replicated) const
+{
+    QStringList components;
+    const Entity::ComponentMap &comps = entity->Components();
+    for(Entity::ComponentMap::const_iterator i = comps.begin(); i != comps.end(); ++i)
+    {
+        QString component = i->second->TypeName() + ":" + i->second->Name() + (i->second->IsReplicated() ? ":1" : ":0");
+        // Components with dynamic attributes, f.ex. EC_DynamicComponent, can only be recycled for the same attribute layout.
+        const AttributeVector &attrs = i->second->Attributes();
+        for(size_t j = 0; j < attrs.size(); ++j)
+            if (attrs[j] && attrs[j]->IsDynamic())
+                component += ":" + QString::number(j) + "=" + attrs[j]->Name() + "/" + QString::number(attrs[j]->TypeId());
+        components << component;
+    }
+    components.sort();
+    return QString(replicated ? "1;" : "0;") + components.join(";");
+}
+
 //before-the-fact counterparts for the modification signals above, for permission checks
 bool Scene::AllowModifyEntity(UserConnection* user, Entity *entity)
 {
@@ -377,62 +682,45 @@ QList<Entity *> Scene::LoadSceneXML(const QString& filename, bool clearScene, bo
         return ret;
     }
 
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
-    QDomDocument scene_doc("Scene");
-    QString errorMsg;
-    int errorLine, errorColumn;
-    if (!scene_doc.setContent(stream.readAll(), &errorMsg, &errorLine, &errorColumn))
+    // Check that the whole file is well-formed before touching the scene, so that a malformed file does not wipe the scene.
+    // This only tokenizes the file, without building a document in memory.
     {
-        LogError(QString("Parsing scene XML from %1 failed when loading Scene XML: %2 at line %3 column %4.").arg(filename).arg(errorMsg).arg(errorLine).arg(errorColumn));
-        file.close();
-        return ret;
+        PROFILE(Scene_ValidateSceneXML);
+        QXmlStreamReader validator(&file);
+        if (!validator.readNextStartElement() || validator.name() != "scene")
+        {
+            if (validator.hasError())
+                LogError(QString("Parsing scene XML from %1 failed when loading Scene XML: %2 at line %3 column %4.").arg(filename).arg(validator.errorString()).arg(validator.lineNumber()).arg(validator.columnNumber()));
+            else
+                LogError("Could not find 'scene' element from " + filename + " when loading Scene XML.");
+            return ret;
+        }
+        while(!validator.atEnd())
+            validator.readNext();
+        if (validator.hasError())
+        {
+            LogError(QString("Parsing scene XML from %1 failed when loading Scene XML: %2 at line %3 column %4.").arg(filename).arg(validator.errorString()).arg(validator.lineNumber()).arg(validator.columnNumber()));
+            return ret;
+        }
     }
+    file.seek(0);
 
     // Purge all old entities. Send events for the removal
     if (clearScene)
         RemoveAllEntities(true, change);
 
-    return CreateContentFromXml(scene_doc, useEntityIDsFromFile, change);
+    // Stream the content directly from the file instead of reading the whole document into memory first.
+    QXmlStreamReader reader(&file);
+    ret = CreateContentFromXml(reader, useEntityIDsFromFile, change);
+    if (reader.hasError())
+        LogError(QString("Parsing scene XML from %1 failed when loading Scene XML: %2 at line %3 column %4.").arg(filename).arg(reader.errorString()).arg(reader.lineNumber()).arg(reader.columnNumber()));
+    file.close();
+    return ret;
 }
 
 QByteArray Scene::GetSceneXML(bool gettemporary, bool getlocal) const
 {
-    QDomDocument scene_doc("Scene");
-    QDomElement scene_elem = scene_doc.createElement("scene");
-
-    for(EntityMap::const_iterator iter = entities_.begin(); iter != entities_.end(); ++iter) 
-    {
-        bool serialize = true;
-        if (iter->second->IsLocal() && !getlocal)
-            serialize = false;
-        if (iter->second->IsTemporary() && !gettemporary)
-            serialize = false;
-        if (serialize) 
-        {
-            /* copied from GetEntityXML so that we can get local and temporary components also.
-            ugly hack! */
-            EntityPtr entity = iter->second;
-            QDomElement entity_elem = scene_doc.createElement("entity");
-
-            QString id_str;
-            id_str.setNum((int)entity->Id());
-            entity_elem.setAttribute("id", id_str);
-            entity_elem.setAttribute("sync", QString::fromStdString(::ToString<bool>(entity->IsReplicated())));
-            
-            const Entity::ComponentMap &components = entity->Components();
-            for (Entity::ComponentMap::const_iterator i = components.begin(); i != components.end(); ++i)
-            {
-                if ((!i->second->IsTemporary()) || (gettemporary))
-                    i->second->SerializeTo(scene_doc, entity_elem);
-            }
-            
-            scene_elem.appendChild(entity_elem);
-        }
-    }
-    scene_doc.appendChild(scene_elem);
-
-    return scene_doc.toByteArray();
+    return TakeSnapshot(gettemporary, getlocal)->ToXml();
 }
 
 bool Scene::SaveSceneXML(const QString& filename, bool saveTemporary, bool saveLocal)
@@ -452,93 +740,246 @@ bool Scene::SaveSceneXML(const QString& filename, bool saveTemporary, bool saveL
     }
 }
 
+/// Maps a file to memory for reading, or reads it to the fallback buffer if mapping is not possible.
+/** @param size Receives the size of the file data.
+    @return Pointer to the file data, or null if the file could not be opened, is empty or does not fit in the address space.
+    The data is valid as long as the file is open. */
+static const char *MapFile(QFile &file, QByteArray &fallback, size_t &size)
+{
+    size = 0;
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0 || (quint64)file.size() > (quint64)std::numeric_limits<size_t>::max())
+        return 0;
+    uchar *mapped = file.map(0, file.size());
+    if (mapped)
+    {
+        size = (size_t)file.size();
+        return (const char *)mapped;
+    }
+    // QByteArray is limited to 2 GB
+    if (file.size() >= std::numeric_limits<int>::max())
+        return 0;
+    fallback = file.readAll();
+    size = (size_t)fallback.size();
+    return fallback.size() ? fallback.data() : 0;
+}
+
 QList<Entity *> Scene::LoadSceneBinary(const QString& filename, bool clearScene, bool useEntityIDsFromFile, AttributeChange::Type change)
 {
     QList<Entity *> ret;
     QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly))
+    QByteArray bytes;
+    size_t size = 0;
+    const char *data = MapFile(file, bytes, size);
+    if (!data)
     {
-        LogError("Failed to open file " + filename + " when loading scene binary.");
+        LogError("Failed to open file " + filename + " or file was empty when loading scene binary.");
         return ret;
     }
 
-    ///\todo Use Latin 1?
-    QByteArray bytes = file.readAll();
-    file.close();
+    if (clearScene)
+        RemoveAllEntities(true, change);
+
+    return CreateContentFromBinary(data, size, useEntityIDsFromFile, change);
+}
 
-    if (!bytes.size())
+bool Scene::SaveSceneBinary(const QString& filename, bool getTemporary, bool getLocal, float regionSize)
+{
+    PROFILE(Scene_SaveSceneBinary);
+
+    QByteArray bytes = TakeSnapshot(getTemporary, getLocal)->ToBinary(regionSize);
+    if (bytes.isEmpty())
     {
-        LogError("File " + filename + " contained 0 bytes when loading scene binary.");
-        return ret;
+        LogError("Scene is too large to be saved to " + filename + " in the binary format");
+        return false;
     }
+    if (SceneSnapshot::WriteFile(filename, bytes))
+        return true;
+    LogError("Could not open file " + filename + " for writing when saving scene binary");
+    return false;
+}
 
-    if (clearScene)
-        RemoveAllEntities(true, change);
+static bool LargerEntityMemoryUsage(const std::pair<entity_id_t, size_t> &a, const std::pair<entity_id_t, size_t> &b)
+{
+    return a.second > b.second;
+}
+
+SceneMemoryUsage Scene::MemoryUsage() const
+{
+    PROFILE(Scene_MemoryUsage);
+
+    const size_t mapNodeOverhead = 4 * sizeof(void*); // Color, parent and child links of a std::map node.
+    SceneMemoryUsage usage;
+    usage.sceneBytes = sizeof(Scene) + HeapMemoryUsage(name_) + entities_.size() * (sizeof(EntityMap::value_type) + mapNodeOverhead);
+    usage.entities.reserve(entities_.size());
+    // The resources shared by the components, f.ex. the Ogre meshes of identical objects, are collected by address to count each once.
+    std::map<const void *, size_t> sharedResources;
+
+    for(EntityMap::const_iterator iter = entities_.begin(); iter != entities_.end(); ++iter)
+    {
+        const Entity *entity = iter->second.get();
+        const Entity::ComponentMap &components = entity->Components();
+        for(Entity::ComponentMap::const_iterator compIter = components.begin(); compIter != components.end(); ++compIter)
+            compIter->second->SharedResources(sharedResources);
+
+        if (!entity->IsActive())
+        {
+            ++usage.numPooledEntities;
+            usage.pooledEntityBytes += entity->MemoryUsage();
+            continue;
+        }
+
+        size_t entityBytes = entity->MemoryUsage(false);
+        size_t componentBytes = 0;
+        for(Entity::ComponentMap::const_iterator compIter = components.begin(); compIter != components.end(); ++compIter)
+        {
+            size_t bytes = compIter->second->MemoryUsage();
+            ComponentTypeMemoryUsage &typeUsage = usage.componentTypes[compIter->second->TypeName()];
+            ++typeUsage.numComponents;
+            typeUsage.numBytes += bytes;
+            componentBytes += bytes;
+        }
 
-    return CreateContentFromBinary(bytes.data(), bytes.size(), useEntityIDsFromFile, change);
+        ++usage.numEntities;
+        usage.entityBytes += entityBytes;
+        usage.componentBytes += componentBytes;
+        usage.entities.push_back(std::make_pair(iter->first, entityBytes + componentBytes));
+    }
+
+    for(EntityPoolMap::const_iterator iter = entityPool_.begin(); iter != entityPool_.end(); ++iter)
+    {
+        usage.sceneBytes += sizeof(EntityPoolMap::value_type) + mapNodeOverhead + HeapMemoryUsage(iter->first) + iter->second.capacity() * sizeof(EntityWeakPtr);
+    }
+
+    usage.numSharedResources = (uint)sharedResources.size();
+    for(std::map<const void *, size_t>::const_iterator iter = sharedResources.begin(); iter != sharedResources.end(); ++iter)
+        usage.sharedResourceBytes += iter->second;
+
+    std::sort(usage.entities.begin(), usage.entities.end(), LargerEntityMemoryUsage);
+    return usage;
 }
 
-bool Scene::SaveSceneBinary(const QString& filename, bool getTemporary, bool getLocal)
+SceneSnapshotPtr Scene::TakeSnapshot(bool getTemporary, bool getLocal) const
 {
-    QByteArray bytes;
-    // Assume 4MB max for now
-    bytes.resize(4 * 1024 * 1024);
-    DataSerializer dest(bytes.data(), bytes.size());
-    
-    // Count number of entities we accept
-    uint num_entities = 0;
-    for(EntityMap::iterator iter = entities_.begin(); iter != entities_.end(); ++iter)
-    {
-        bool serialize = true;
-        if (iter->second->IsLocal() && !getLocal)
-            serialize = false;
-        if (iter->second->IsTemporary() && !getTemporary)
-            serialize = false;
-        if (serialize)
-            ++num_entities;
+    PROFILE(Scene_TakeSnapshot);
+
+    boost::shared_ptr<SceneSnapshot> snapshot(new SceneSnapshot());
+    snapshot->entities.reserve(entities_.size());
+    for(EntityMap::const_iterator iter = entities_.begin(); iter != entities_.end(); ++iter)
+    {
+        const EntityPtr &entity = iter->second;
+        if ((entity->IsLocal() && !getLocal) || (entity->IsTemporary() && !getTemporary) || !entity->IsActive())
+            continue;
+
+        snapshot->entities.push_back(EntitySnapshot());
+        EntitySnapshot &entitySnapshot = snapshot->entities.back();
+        entitySnapshot.id = entity->Id();
+        entitySnapshot.replicated = entity->IsReplicated();
+        ComponentPtr placeable = entity->GetComponent("EC_Placeable");
+        Attribute<Transform> *transform = placeable ? dynamic_cast<Attribute<Transform> *>(placeable->GetAttribute("Transform")) : 0;
+        entitySnapshot.hasPosition = (transform != 0);
+        entitySnapshot.position = transform ? transform->Get().pos : float3(0.f, 0.f, 0.f);
+        const Entity::ComponentMap &components = entity->Components();
+        entitySnapshot.components.reserve(components.size());
+        for(Entity::ComponentMap::const_iterator i = components.begin(); i != components.end(); ++i)
+            if (!i->second->IsTemporary() || getTemporary)
+                entitySnapshot.components.push_back(snapshotCache_.Capture(i->second));
     }
-    
-    dest.Add<u32>(num_entities);
+    snapshotCache_.Prune();
+
+    return snapshot;
+}
 
-    for(EntityMap::iterator iter = entities_.begin(); iter != entities_.end(); ++iter)
+/// @cond PRIVATE
+struct Scene::BackgroundSave
+{
+    QString filename;
+    SceneSnapshotPtr snapshot;
+    bool binary;
+    float regionSize;
+    bool success;
+    boost::thread thread;
+
+    /// Worker thread entry point.
+    void Run()
     {
-        bool serialize = true;
-        if (iter->second->IsLocal() && !getLocal)
-            serialize = false;
-        if (iter->second->IsTemporary() && !getTemporary)
-            serialize = false;
-        if (serialize)
-            iter->second->SerializeToBinary(dest);
+        // An empty binary means that the scene did not fit in the binary format.
+        const QByteArray bytes = binary ? snapshot->ToBinary(regionSize) : snapshot->ToXml();
+        success = !bytes.isEmpty() && SceneSnapshot::WriteFile(filename, bytes);
+        // Release the snapshot in the worker thread, as it may hold the last references to large component data.
+        snapshot.reset();
     }
-    
-    bytes.resize(dest.BytesFilled());
-    QFile scenefile(filename);
-    if (scenefile.open(QFile::WriteOnly))
+};
+/// @endcond
+
+bool Scene::SaveSceneXMLInBackground(const QString& filename, bool saveTemporary, bool saveLocal)
+{
+    if (IsSavingInBackground())
     {
-        scenefile.write(bytes);
-        scenefile.close();
-        return true;
+        LogError("Scene::SaveSceneXMLInBackground: Can not save " + filename + ", a background save to " + backgroundSave_->filename + " is already in progress.");
+        return false;
     }
-    else
+    return StartBackgroundSave(filename, TakeSnapshot(saveTemporary, saveLocal), false, 0.f);
+}
+
+bool Scene::SaveSceneBinaryInBackground(const QString& filename, bool saveTemporary, bool saveLocal, float regionSize)
+{
+    if (IsSavingInBackground())
     {
-        LogError("Could not open file " + filename + " for writing when saving scene binary");
+        LogError("Scene::SaveSceneBinaryInBackground: Can not save " + filename + ", a background save to " + backgroundSave_->filename + " is already in progress.");
         return false;
     }
+    return StartBackgroundSave(filename, TakeSnapshot(saveTemporary, saveLocal), true, regionSize);
 }
 
-QList<Entity *> Scene::CreateContentFromXml(const QString &xml,  bool useEntityIDsFromFile, AttributeChange::Type change)
+bool Scene::StartBackgroundSave(const QString &filename, const SceneSnapshotPtr &snapshot, bool binary, float regionSize)
 {
-    QList<Entity *> ret;
-    QString errorMsg;
-    QDomDocument scene_doc("Scene");
-    int errorLine, errorColumn;
-    if (!scene_doc.setContent(xml, false, &errorMsg, &errorLine, &errorColumn))
+    boost::shared_ptr<BackgroundSave> save(new BackgroundSave());
+    save->filename = filename;
+    save->snapshot = snapshot;
+    save->binary = binary;
+    save->regionSize = regionSize;
+    save->success = false;
+    try
     {
-        LogError(QString("Parsing scene XML from text failed when loading Scene XML: %1 at line %2 column %3.").arg(errorMsg).arg(errorLine).arg(errorColumn));
-        return ret;
+        save->thread = boost::thread(boost::bind(&BackgroundSave::Run, save.get()));
     }
+    catch(const boost::thread_resource_error &)
+    {
+        LogError("Scene: Failed to start the background save thread for " + filename + ".");
+        return false;
+    }
+    backgroundSave_ = save;
+    return true;
+}
+
+void Scene::WaitForBackgroundSave()
+{
+    FinishBackgroundSave(true);
+}
+
+void Scene::FinishBackgroundSave(bool wait)
+{
+    if (!backgroundSave_)
+        return;
+    if (wait)
+        backgroundSave_->thread.join();
+    else if (!backgroundSave_->thread.timed_join(boost::posix_time::milliseconds(0)))
+        return;
 
-    return CreateContentFromXml(scene_doc, useEntityIDsFromFile, change);
+    boost::shared_ptr<BackgroundSave> save = backgroundSave_;
+    backgroundSave_.reset();
+    if (!save->success)
+        LogError("Scene: Failed to write the background save to " + save->filename + ".");
+    emit BackgroundSaveFinished(save->filename, save->success);
+}
+
+QList<Entity *> Scene::CreateContentFromXml(const QString &xml,  bool useEntityIDsFromFile, AttributeChange::Type change)
+{
+    QXmlStreamReader reader(xml);
+    QList<Entity *> ret = CreateContentFromXml(reader, useEntityIDsFromFile, change);
+    if (reader.hasError())
+        LogError(QString("Parsing scene XML from text failed when loading Scene XML: %1 at line %2 column %3.").arg(reader.errorString()).arg(reader.lineNumber()).arg(reader.columnNumber()));
+    return ret;
 }
 
 QList<Entity *> Scene::CreateContentFromXml(const QDomDocument &xml, bool useEntityIDsFromFile, AttributeChange::Type change)
@@ -567,66 +1008,77 @@ QList<Entity *> Scene::CreateContentFromXml(const QDomDocument &xml, bool useEnt
     QDomElement ent_elem = scene_elem.firstChildElement("entity");
     while(!ent_elem.isNull())
     {
-        QString replicatedStr = ent_elem.attribute("sync");
-        bool replicated = true;
-        if (!replicatedStr.isEmpty())
-            replicated = ParseBool(replicatedStr);
-
-        QString id_str = ent_elem.attribute("id");
-        entity_id_t id = !id_str.isEmpty() ? static_cast<entity_id_t>(id_str.toInt()) : 0;
-        if (!useEntityIDsFromFile || id == 0) // If we don't want to use entity IDs from file, or if file doesn't contain one, generate a new one.
-        {
-            entity_id_t originaId = id;
-            id = replicated ? NextFreeId() : NextFreeIdLocal();
-            if (originaId != 0 && !oldToNewIds.contains(originaId))
-                oldToNewIds[originaId] = id;
-        }
-
-        if (HasEntity(id)) // If the entity we are about to add conflicts in ID with an existing entity in the scene, delete the old entity.
-        {
-            LogDebug("Scene::CreateContentFromXml: Destroying previous entity with id " + QString::number(id) + " to avoid conflict with new created entity with the same id.");
-            LogError("Warning: Invoking buggy behavior: Object with id " + QString::number(id) +"might not replicate properly!");
-            RemoveEntity(id, AttributeChange::Replicate); ///<@todo Consider do we want to always use Replicate
-        }
-
-        EntityPtr entity = CreateEntity(id);
+        EntityPtr entity = CreateEntityFromXml(ent_elem.attribute("id"), ent_elem.attribute("sync"), useEntityIDsFromFile, oldToNewIds);
         if (entity)
         {
             QDomElement comp_elem = ent_elem.firstChildElement("component");
             while(!comp_elem.isNull())
             {
-                /// \todo Read component id's from file
-                
-                QString type_name = comp_elem.attribute("type");
-                QString name = comp_elem.attribute("name");
-                QString compReplicatedStr = comp_elem.attribute("sync");
-                bool compReplicated = true;
-                if (!compReplicatedStr.isEmpty())
-                    compReplicated = ParseBool(compReplicatedStr);
-                
-                ComponentPtr new_comp = entity->GetOrCreateComponent(type_name, name, AttributeChange::Default, compReplicated);
-                if (new_comp)
-                {
-                    // Trigger no signal yet when scene is in incoherent state
-                    new_comp->DeserializeFrom(comp_elem, AttributeChange::Disconnected);
-                }
-                
+                CreateComponentFromXml(entity.get(), comp_elem);
                 comp_elem = comp_elem.nextSiblingElement("component");
             }
             entities.push_back(entity);
         }
-        else
-        {
-            LogError("Scene::CreateContentFromXml: Failed to create entity with id " + QString::number(id) + "!");
-        }
 
         ent_elem = ent_elem.nextSiblingElement("entity");
     }
 
-    // Now that we have each entity spawned to the scene, trigger all the signals for EntityCreated/ComponentChanged messages.
-    for(unsigned i = 0; i < entities.size(); ++i)
-    {
-        if (!entities[i].expired())
+    return EmitContentCreatedFromXml(entities, useEntityIDsFromFile, oldToNewIds, change);
+}
+
+EntityPtr Scene::CreateEntityFromXml(const QString &idStr, const QString &replicatedStr, bool useEntityIDsFromFile, QHash<entity_id_t, entity_id_t> &oldToNewIds)
+{
+    bool replicated = true;
+    if (!replicatedStr.isEmpty())
+        replicated = ParseBool(replicatedStr);
+
+    entity_id_t id = !idStr.isEmpty() ? static_cast<entity_id_t>(idStr.toInt()) : 0;
+    if (!useEntityIDsFromFile || id == 0) // If we don't want to use entity IDs from file, or if file doesn't contain one, generate a new one.
+    {
+        entity_id_t originaId = id;
+        id = replicated ? NextFreeId() : NextFreeIdLocal();
+        if (originaId != 0 && !oldToNewIds.contains(originaId))
+            oldToNewIds[originaId] = id;
+    }
+
+    if (HasEntity(id)) // If the entity we are about to add conflicts in ID with an existing entity in the scene, delete the old entity.
+    {
+        LogDebug("Scene::CreateContentFromXml: Destroying previous entity with id " + QString::number(id) + " to avoid conflict with new created entity with the same id.");
+        LogError("Warning: Invoking buggy behavior: Object with id " + QString::number(id) +"might not replicate properly!");
+        RemoveEntity(id, AttributeChange::Replicate); ///<@todo Consider do we want to always use Replicate
+    }
+
+    EntityPtr entity = CreateEntity(id);
+    if (!entity)
+        LogError("Scene::CreateContentFromXml: Failed to create entity with id " + QString::number(id) + "!");
+    return entity;
+}
+
+void Scene::CreateComponentFromXml(Entity *entity, const QDomElement &comp_elem)
+{
+    /// \todo Read component id's from file
+    
+    QString type_name = comp_elem.attribute("type");
+    QString name = comp_elem.attribute("name");
+    QString compReplicatedStr = comp_elem.attribute("sync");
+    bool compReplicated = true;
+    if (!compReplicatedStr.isEmpty())
+        compReplicated = ParseBool(compReplicatedStr);
+    
+    ComponentPtr new_comp = entity->GetOrCreateComponent(type_name, name, AttributeChange::Default, compReplicated);
+    if (new_comp)
+    {
+        // Trigger no signal yet when scene is in incoherent state
+        new_comp->DeserializeFrom(comp_elem, AttributeChange::Disconnected);
+    }
+}
+
+QList<Entity *> Scene::EmitContentCreatedFromXml(const std::vector<EntityWeakPtr> &entities, bool useEntityIDsFromFile, const QHash<entity_id_t, entity_id_t> &oldToNewIds, AttributeChange::Type change)
+{
+    // Now that we have each entity spawned to the scene, trigger all the signals for EntityCreated/ComponentChanged messages.
+    for(unsigned i = 0; i < entities.size(); ++i)
+    {
+        if (!entities[i].expired())
             EmitEntityCreated(entities[i].lock().get(), change);
         if (!entities[i].expired())
         {
@@ -667,29 +1119,254 @@ QList<Entity *> Scene::CreateContentFromXml(const QDomDocument &xml, bool useEnt
     return ret;
 }
 
+/// Reads the current element of an XML stream and its children into a DOM element of the given document.
+/** Used to hand out single component elements to IComponent::DeserializeFrom while streaming. */
+static QDomElement ReadDomElement(QXmlStreamReader &reader, QDomDocument &doc)
+{
+    QDomElement elem = doc.createElement(reader.name().toString());
+    foreach(const QXmlStreamAttribute &attr, reader.attributes())
+        elem.setAttribute(attr.name().toString(), attr.value().toString());
+
+    while(!reader.atEnd())
+    {
+        reader.readNext();
+        if (reader.isStartElement())
+            elem.appendChild(ReadDomElement(reader, doc));
+        else if (reader.isCharacters() && !reader.isWhitespace())
+            elem.appendChild(doc.createTextNode(reader.text().toString()));
+        else if (reader.isEndElement())
+            break;
+    }
+    return elem;
+}
+
+QList<Entity *> Scene::CreateContentFromXml(QXmlStreamReader &reader, bool useEntityIDsFromFile, AttributeChange::Type change)
+{
+    PROFILE(Scene_CreateContentFromXmlStream);
+
+    std::vector<EntityWeakPtr> entities;
+
+    // Check for existence of the scene element before we begin
+    if (!reader.readNextStartElement() || reader.name() != "scene")
+    {
+        if (!reader.hasError())
+            LogError("Could not find 'scene' element from XML.");
+        return QList<Entity*>();
+    }
+
+    QHash<entity_id_t, entity_id_t> oldToNewIds;
+
+    while(reader.readNextStartElement())
+    {
+        if (reader.name() == "storage")
+        {
+            framework_->Asset()->DeserializeAssetStorageFromString(Application::ParseWildCardFilename(reader.attributes().value("specifier").toString()), false);
+            reader.skipCurrentElement();
+            continue;
+        }
+        if (reader.name() != "entity")
+        {
+            reader.skipCurrentElement();
+            continue;
+        }
+
+        QXmlStreamAttributes entAttrs = reader.attributes();
+        EntityPtr entity = CreateEntityFromXml(entAttrs.value("id").toString(), entAttrs.value("sync").toString(), useEntityIDsFromFile, oldToNewIds);
+        if (!entity)
+        {
+            reader.skipCurrentElement();
+            continue;
+        }
+
+        while(reader.readNextStartElement())
+        {
+            if (reader.name() != "component")
+            {
+                reader.skipCurrentElement();
+                continue;
+            }
+
+            // Components deserialize themselves from DOM, so read each component element into a document of its own.
+            QDomDocument compDoc;
+            QDomElement comp_elem = ReadDomElement(reader, compDoc);
+            compDoc.appendChild(comp_elem);
+            CreateComponentFromXml(entity.get(), comp_elem);
+        }
+        entities.push_back(entity);
+    }
+
+    return EmitContentCreatedFromXml(entities, useEntityIDsFromFile, oldToNewIds, change);
+}
+
 QList<Entity *> Scene::CreateContentFromBinary(const QString &filename, bool useEntityIDsFromFile, AttributeChange::Type change)
 {
     QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly))
+    QByteArray bytes;
+    size_t size = 0;
+    const char *data = MapFile(file, bytes, size);
+    if (!data)
     {
-        LogError("Failed to open file " + filename + " when loading scene binary.");
+        LogError("Failed to open file " + filename + " or file was empty when loading scene binary.");
         return QList<Entity*>();
     }
 
-    QByteArray bytes = file.readAll();
-    file.close();
-    
-    if (!bytes.size())
+    return CreateContentFromBinary(data, size, useEntityIDsFromFile, change);
+}
+
+QList<Entity *> Scene::LoadSceneBinaryEntities(const QString &filename, const QList<entity_id_t> &ids, bool useEntityIDsFromFile, AttributeChange::Type change)
+{
+    QFile file(filename);
+    QByteArray bytes;
+    size_t size = 0;
+    const char *data = MapFile(file, bytes, size);
+    SceneBinaryIndex index(data, size);
+    if (!index.IsValid())
+    {
+        LogError("Scene::LoadSceneBinaryEntities: " + filename + " is not an indexed binary scene file.");
+        return QList<Entity*>();
+    }
+
+    std::vector<u32> entries;
+    foreach(entity_id_t id, ids)
+    {
+        int entry = index.FindEntry(id);
+        if (entry >= 0)
+            entries.push_back((u32)entry);
+        else
+            LogWarning("Scene::LoadSceneBinaryEntities: Entity " + QString::number(id) + " not found from " + filename + ".");
+    }
+
+    return CreateContentFromBinaryIndex(index, entries, useEntityIDsFromFile, change);
+}
+
+QList<Entity *> Scene::LoadSceneBinaryRegion(const QString &filename, const float3 &minPos, const float3 &maxPos, bool useEntityIDsFromFile, AttributeChange::Type change)
+{
+    QFile file(filename);
+    QByteArray bytes;
+    size_t size = 0;
+    const char *data = MapFile(file, bytes, size);
+    SceneBinaryIndex index(data, size);
+    if (!index.IsValid())
     {
-        LogError("File " + filename + "contained 0 bytes when loading scene binary.");
+        LogError("Scene::LoadSceneBinaryRegion: " + filename + " is not an indexed binary scene file.");
         return QList<Entity*>();
     }
+    if (index.RegionSize() <= 0.f)
+        LogWarning("Scene::LoadSceneBinaryRegion: " + filename + " has not been saved with regions.");
+
+    return CreateContentFromBinaryIndex(index, index.EntriesInBox(minPos, maxPos), useEntityIDsFromFile, change);
+}
+
+QList<Entity *> Scene::CreateContentFromBinaryIndex(const SceneBinaryIndex &index, const std::vector<u32> &entries, bool useEntityIDsFromFile, AttributeChange::Type change)
+{
+    PROFILE(Scene_CreateContentFromBinaryIndex);
+
+    std::vector<EntityWeakPtr> entities;
+    entities.reserve(entries.size());
+    for(size_t i = 0; i < entries.size(); ++i)
+    {
+        const SceneBinaryIndex::Entry &entry = index.EntryAt(entries[i]);
+        try
+        {
+            DataDeserializer source(index.Record(entry), entry.size);
+            entity_id_t id = source.Read<u32>();
+            bool replicated = source.Read<u8>() ? true : false;
+            if (!useEntityIDsFromFile || id == 0)
+                id = replicated ? NextFreeId() : NextFreeIdLocal();
+
+            if (HasEntity(id)) // If the entity we are about to add conflicts in ID with an existing entity in the scene.
+            {
+                LogDebug("Scene::CreateContentFromBinary: Destroying previous entity with id " + QString::number(id) + " to avoid conflict with new created entity with the same id.");
+                LogError("Warning: Invoking buggy behavior: Object with id " + QString::number(id) + "might not replicate properly!");
+                RemoveEntity(id, AttributeChange::Replicate); ///<@todo Consider do we want to always use Replicate
+            }
+
+            // Each entity has a record of its own, so a failure does not desync the rest of the file.
+            EntityPtr entity = CreateEntity(id);
+            if (!entity)
+            {
+                LogError("Scene::CreateContentFromBinary: Failed to create entity with id " + QString::number(id) + "!");
+                continue;
+            }
+            entities.push_back(entity);
+
+            uint num_components = source.Read<u32>();
+            for(uint j = 0; j < num_components; ++j)
+            {
+                QString typeName = index.String(source.Read<u32>());
+                QString name = index.String(source.Read<u32>());
+                bool compReplicated = source.Read<u8>() ? true : false;
+                uint data_size = source.Read<u32>();
+
+                QByteArray comp_bytes;
+                comp_bytes.resize(data_size);
+                if (data_size)
+                    source.ReadArray<u8>((u8*)comp_bytes.data(), comp_bytes.size());
+
+                try
+                {
+                    ComponentPtr new_comp = entity->GetOrCreateComponent(typeName, name, AttributeChange::Default, compReplicated);
+                    if (new_comp)
+                    {
+                        if (data_size)
+                        {
+                            DataDeserializer comp_source(comp_bytes.data(), comp_bytes.size());
+                            // Trigger no signal yet when scene is in incoherent state
+                            new_comp->DeserializeFromBinary(comp_source, AttributeChange::Disconnected);
+                        }
+                    }
+                    else
+                        LogError("Failed to load component \"" + typeName + "\"!");
+                }
+                catch(...)
+                {
+                    LogError("Failed to load component \"" + typeName + "\"!");
+                }
+            }
+        }
+        catch(...)
+        {
+            LogError("Scene::CreateContentFromBinary: Failed to read entity record of entity " + QString::number(entry.id) + ".");
+        }
+    }
+
+    // Now that we have each entity spawned to the scene, trigger all the signals for EntityCreated/ComponentChanged messages.
+    for(unsigned i = 0; i < entities.size(); ++i)
+    {
+        if (!entities[i].expired())
+            EmitEntityCreated(entities[i].lock().get(), change);
+        if (!entities[i].expired())
+        {
+            EntityPtr entityShared = entities[i].lock();
+            const Entity::ComponentMap &components = entityShared->Components();
+            for (Entity::ComponentMap::const_iterator i = components.begin(); i != components.end(); ++i)
+                i->second->ComponentChanged(change);
+        }
+    }
+
+    // The above signals may have caused scripts to remove entities. Return those that still exist.
+    QList<Entity *> ret;
+    for(unsigned i = 0; i < entities.size(); ++i)
+        if (!entities[i].expired())
+            ret.append(entities[i].lock().get());
 
-    return CreateContentFromBinary(bytes.data(), bytes.size(), useEntityIDsFromFile, change);
+    return ret;
 }
 
-QList<Entity *> Scene::CreateContentFromBinary(const char *data, int numBytes, bool useEntityIDsFromFile, AttributeChange::Type change)
+QList<Entity *> Scene::CreateContentFromBinary(const char *data, size_t numBytes, bool useEntityIDsFromFile, AttributeChange::Type change)
 {
+    if (SceneBinaryIndex::IsIndexed(data, numBytes))
+    {
+        SceneBinaryIndex index(data, numBytes);
+        if (!index.IsValid())
+            return QList<Entity *>();
+        std::vector<u32> entries(index.NumEntities());
+        for(u32 i = 0; i < entries.size(); ++i)
+            entries[i] = i;
+        return CreateContentFromBinaryIndex(index, entries, useEntityIDsFromFile, change);
+    }
+
+    // Sequential version 1 format
     std::vector<EntityWeakPtr> entities;
     assert(data);
     assert(numBytes > 0);
@@ -805,69 +1482,293 @@ QList<Entity *> Scene::CreateContentFromSceneDesc(const SceneDesc &desc, bool us
         else
             id =  static_cast<entity_id_t>(e.id.toInt());
 
-        if (HasEntity(id)) // If the entity we are about to add conflicts in ID with an existing entity in the scene.
+        EntityPtr entity = CreateEntityFromDesc(e, id);
+        if (entity)
+            ret.append(entity.get());
+    }
+
+    // All entities & components have been loaded. Trigger change for them now.
+    foreach(Entity *entity, ret)
+    {
+        EmitEntityCreated(entity, change);
+        const Entity::ComponentMap &components = entity->Components();
+        for(Entity::ComponentMap::const_iterator i = components.begin(); i != components.end(); ++i)
+            i->second->ComponentChanged(change);
+    }
+
+    return ret;
+}
+
+EntityPtr Scene::CreateEntityFromDesc(const EntityDesc &e, entity_id_t id)
+{
+    if (HasEntity(id)) // If the entity we are about to add conflicts in ID with an existing entity in the scene.
+    {
+        LogDebug("Scene::CreateContentFromSceneDescription: Destroying previous entity with id " + QString::number(id) + " to avoid conflict with new created entity with the same id.");
+        LogError("Warning: Invoking buggy behavior: Object with id " + QString::number(id) + " might not replicate properly!");
+        RemoveEntity(id, AttributeChange::Replicate); ///<@todo Consider do we want to always use Replicate
+    }
+
+    EntityPtr entity = CreateEntity(id);
+    assert(entity);
+    if (!entity)
+        return entity;
+
+    foreach(const ComponentDesc &c, e.components)
+    {
+        if (c.typeName.isNull())
+            continue;
+        const bool replicated = c.sync.isEmpty() || ParseBool(c.sync);
+        ComponentPtr comp = entity->GetOrCreateComponent(c.typeName, c.name, AttributeChange::Default, replicated);
+        assert(comp);
+        if (!comp)
         {
-            LogDebug("Scene::CreateContentFromSceneDescription: Destroying previous entity with id " + QString::number(id) + " to avoid conflict with new created entity with the same id.");
-            LogError("Warning: Invoking buggy behavior: Object with id " + QString::number(id) + " might not replicate properly!");
-            RemoveEntity(id, AttributeChange::Replicate); ///<@todo Consider do we want to always use Replicate
+            LogError(QString("Scene::CreateContentFromSceneDesc: failed to create component %1 %2 .").arg(c.typeName).arg(c.name));
+            continue;
         }
-
-        EntityPtr entity = CreateEntity(id);
-        assert(entity);
-        if (entity)
+        if (comp->TypeName() == "EC_DynamicComponent")
         {
-            foreach(const ComponentDesc &c, e.components)
+            QDomDocument temp_doc;
+            QDomElement root_elem = temp_doc.createElement("component");
+            root_elem.setAttribute("type", c.typeName);
+            root_elem.setAttribute("name", c.name);
+            root_elem.setAttribute("sync", c.sync);
+            foreach(AttributeDesc a, c.attributes)
             {
-                if (c.typeName.isNull())
-                    continue;
-                ComponentPtr comp = entity->GetOrCreateComponent(c.typeName, c.name);
-                assert(comp);
-                if (!comp)
-                {
-                    LogError(QString("Scene::CreateContentFromSceneDesc: failed to create component %1 %2 .").arg(c.typeName).arg(c.name));
-                    continue;
-                }
-                if (comp->TypeName() == "EC_DynamicComponent")
+                QDomElement child_elem = temp_doc.createElement("attribute");
+                child_elem.setAttribute("value", a.value);
+                child_elem.setAttribute("type", a.typeName);
+                child_elem.setAttribute("name", a.name);
+                root_elem.appendChild(child_elem);
+            }
+            comp->DeserializeFrom(root_elem, AttributeChange::Default);
+        }
+        else
+        {
+            foreach(IAttribute *attr, comp->Attributes())
+                if (attr)
+                    foreach(const AttributeDesc &a, c.attributes)
+                        if (attr->TypeName() == a.typeName && attr->Name() == a.name)
+                            attr->FromString(a.value.toStdString(), AttributeChange::Disconnected); // Trigger no signal yet when scene is in incoherent state
+        }
+    }
+
+    return entity;
+}
+
+/// Returns the position of the EC_Placeable of an entity description, or false if the entity has no placeable.
+static bool EntityDescPosition(const EntityDesc &e, float3 &pos)
+{
+    foreach(const ComponentDesc &c, e.components)
+        if (c.typeName == "EC_Placeable")
+            foreach(const AttributeDesc &a, c.attributes)
+                if (a.name == "Transform")
                 {
-                    QDomDocument temp_doc;
-                    QDomElement root_elem = temp_doc.createElement("component");
-                    root_elem.setAttribute("type", c.typeName);
-                    root_elem.setAttribute("name", c.name);
-                    root_elem.setAttribute("sync", c.sync);
-                    foreach(AttributeDesc a, c.attributes)
-                    {
-                        QDomElement child_elem = temp_doc.createElement("attribute");
-                        child_elem.setAttribute("value", a.value);
-                        child_elem.setAttribute("type", a.typeName);
-                        child_elem.setAttribute("name", a.name);
-                        root_elem.appendChild(child_elem);
-                    }
-                    comp->DeserializeFrom(root_elem, AttributeChange::Default);
+                    pos = Transform::FromString(a.value).pos;
+                    return true;
                 }
-                else
+    return false;
+}
+
+/// Orders incremental load entities by their squared distance to the load focus.
+static bool IncrementalLoadOrderLess(const std::pair<float, std::pair<int, entity_id_t> > &a, const std::pair<float, std::pair<int, entity_id_t> > &b)
+{
+    return a.first < b.first;
+}
+
+bool Scene::LoadSceneIncremental(const QString &filename, bool clearScene, bool useEntityIDsFromFile, AttributeChange::Type change, float msPerFrame)
+{
+    CancelIncrementalLoad();
+
+    PROFILE(Scene_LoadSceneIncremental);
+
+    IncrementalLoad &load = incrementalLoad_;
+    if (filename.endsWith(".tbin", Qt::CaseInsensitive))
+        load.desc = CreateSceneDescFromBinary(filename);
+    else
+        load.desc = CreateSceneDescFromXml(filename);
+    if (load.desc.entities.isEmpty())
+    {
+        LogError("Scene::LoadSceneIncremental: No entities to load from " + filename + ".");
+        load = IncrementalLoad();
+        return false;
+    }
+
+    // Purge all old entities. Send events for the removal
+    if (clearScene)
+        RemoveAllEntities(true, change);
+
+    load.filename = filename;
+    load.useEntityIDsFromFile = useEntityIDsFromFile;
+    load.change = change;
+    load.msPerFrame = msPerFrame;
+
+    // Resolve the focus position: explicitly set focus, main camera, or the origin.
+    float3 focus = float3::zero;
+    if (hasIncrementalLoadFocus_)
+        focus = incrementalLoadFocus_;
+    else if (framework_->Renderer() && framework_->Renderer()->MainCameraScene() == this && framework_->Renderer()->MainCamera())
+    {
+        ComponentPtr placeable = framework_->Renderer()->MainCamera()->GetComponent("EC_Placeable");
+        Attribute<Transform> *transform = placeable ? dynamic_cast<Attribute<Transform> *>(placeable->GetAttribute("Transform")) : 0;
+        if (transform)
+            focus = transform->Get().pos;
+    }
+
+    // Allocate the ids up front, so that parent references can be remapped regardless of the creation order.
+    // Entities without a placeable (scripts, environment) are created first, then the rest by distance to the focus.
+    std::vector<std::pair<float, std::pair<int, entity_id_t> > > sorted;
+    sorted.reserve(load.desc.entities.size());
+    for(int i = 0; i < load.desc.entities.size(); ++i)
+    {
+        const EntityDesc &e = load.desc.entities[i];
+        entity_id_t id = static_cast<entity_id_t>(e.id.toInt());
+        if (e.id.isEmpty() || !useEntityIDsFromFile)
+        {
+            entity_id_t originalId = id;
+            id = e.local ? NextFreeIdLocal() : NextFreeId();
+            if (originalId != 0 && !load.oldToNewIds.contains(originalId))
+                load.oldToNewIds[originalId] = id;
+        }
+
+        float3 pos;
+        float distance = EntityDescPosition(e, pos) ? pos.DistanceSq(focus) : -1.f;
+        sorted.push_back(std::make_pair(distance, std::make_pair(i, id)));
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), IncrementalLoadOrderLess);
+    for(size_t i = 0; i < sorted.size(); ++i)
+        load.order.push_back(sorted[i].second);
+
+    load.active = true;
+    LogInfo(QString("Scene::LoadSceneIncremental: Loading %1 entities from %2 with a budget of %3 msecs per frame.").arg(load.order.size()).arg(filename).arg(msPerFrame));
+    return true;
+}
+
+void Scene::CancelIncrementalLoad()
+{
+    if (incrementalLoad_.active)
+        LogInfo(QString("Scene::CancelIncrementalLoad: Cancelled loading of %1 after %2 entities.").arg(incrementalLoad_.filename).arg(incrementalLoad_.created));
+    incrementalLoad_ = IncrementalLoad();
+}
+
+void Scene::SetIncrementalLoadFocus(const float3 &pos)
+{
+    incrementalLoadFocus_ = pos;
+    hasIncrementalLoadFocus_ = true;
+}
+
+void Scene::ProcessIncrementalLoad()
+{
+    if (!incrementalLoad_.active)
+        return;
+
+    PROFILE(Scene_ProcessIncrementalLoad);
+
+    IncrementalLoad &load = incrementalLoad_;
+    const tick_t start = GetCurrentClockTime();
+    const double budgetTicks = (double)load.msPerFrame * GetCurrentClockFreq() / 1000.0;
+
+    while(load.next < load.order.size())
+    {
+        const EntityDesc &e = load.desc.entities[load.order[load.next].first];
+        EntityPtr entity = CreateEntityFromDesc(e, load.order[load.next].second);
+        ++load.next;
+
+        if (entity)
+        {
+            ++load.created;
+            if (!load.useEntityIDsFromFile)
+            {
+                // Go and fix parent ref of EC_Placeable, as new entity IDs were generated
+                ComponentPtr placeable = entity->GetComponent("EC_Placeable");
+                Attribute<EntityReference> *parentRef = placeable ? dynamic_cast<Attribute<EntityReference> *>(placeable->GetAttribute("Parent entity ref")) : 0;
+                if (parentRef && !parentRef->Get().IsEmpty())
                 {
-                    foreach(IAttribute *attr, comp->Attributes())
-                        if (attr)
-                            foreach(const AttributeDesc &a, c.attributes)
-                                if (attr->TypeName() == a.typeName && attr->Name() == a.name)
-                                    attr->FromString(a.value.toStdString(), AttributeChange::Disconnected); // Trigger no signal yet when scene is in incoherent state
+                    bool isNumber = false;
+                    entity_id_t refId = parentRef->Get().ref.toUInt(&isNumber);
+                    if (isNumber && refId > 0 && load.oldToNewIds.contains(refId))
+                        parentRef->Set(EntityReference(load.oldToNewIds[refId]), AttributeChange::Disconnected);
                 }
             }
 
-            ret.append(entity.get());
+            EntityWeakPtr weakEntity = entity;
+            EmitEntityCreated(entity.get(), load.change);
+            if (!weakEntity.expired())
+            {
+                const Entity::ComponentMap components = entity->Components();
+                for(Entity::ComponentMap::const_iterator i = components.begin(); i != components.end(); ++i)
+                    i->second->ComponentChanged(load.change);
+            }
         }
+
+        // The signals above may have cancelled the load.
+        if (!load.active)
+            return;
+        if ((double)(GetCurrentClockTime() - start) >= budgetTicks)
+            break;
     }
 
-    // All entities & components have been loaded. Trigger change for them now.
-    foreach(Entity *entity, ret)
+    const QString filename = load.filename;
+    const uint created = load.created;
+    const uint total = load.order.size();
+    const bool finished = load.next >= load.order.size();
+    if (finished)
+        incrementalLoad_ = IncrementalLoad();
+
+    emit IncrementalLoadProgress(filename, created, total);
+    if (finished)
     {
-        EmitEntityCreated(entity, change);
-        const Entity::ComponentMap &components = entity->Components();
-        for(Entity::ComponentMap::const_iterator i = components.begin(); i != components.end(); ++i)
-            i->second->ComponentChanged(change);
+        LogInfo(QString("Scene::LoadSceneIncremental: Loading of %1 finished. %2 entities created.").arg(filename).arg(created));
+        emit IncrementalLoadFinished(filename, created);
     }
+}
 
-    return ret;
+/// Returns the value of an attribute as a string for an attribute description.
+/** The vector types are serialized with %f by their ToString(), which loses precision. As the entities of an incremental
+    load are created from the descriptions with FromString, these are written with enough digits to restore the exact values. */
+static QString AttributeDescValue(const IAttribute *a)
+{
+    char str[256];
+    switch(a->TypeId())
+    {
+    case cAttributeFloat2:
+    {
+        const float2 &v = static_cast<const Attribute<float2> *>(a)->Get();
+        sprintf(str, "%.9g %.9g", v.x, v.y);
+        return str;
+    }
+    case cAttributeFloat3:
+    {
+        const float3 &v = static_cast<const Attribute<float3> *>(a)->Get();
+        sprintf(str, "%.9g %.9g %.9g", v.x, v.y, v.z);
+        return str;
+    }
+    case cAttributeFloat4:
+    {
+        const float4 &v = static_cast<const Attribute<float4> *>(a)->Get();
+        sprintf(str, "%.9g %.9g %.9g %.9g", v.x, v.y, v.z, v.w);
+        return str;
+    }
+    case cAttributeQuat:
+    {
+        const Quat &v = static_cast<const Attribute<Quat> *>(a)->Get();
+        sprintf(str, "%.9g %.9g %.9g %.9g", v.x, v.y, v.z, v.w);
+        return str;
+    }
+    case cAttributeColor:
+    {
+        const Color &v = static_cast<const Attribute<Color> *>(a)->Get();
+        sprintf(str, "%.9g %.9g %.9g %.9g", v.r, v.g, v.b, v.a);
+        return str;
+    }
+    case cAttributeTransform:
+    {
+        const Transform &v = static_cast<const Attribute<Transform> *>(a)->Get();
+        sprintf(str, "%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g", v.pos.x, v.pos.y, v.pos.z, v.rot.x, v.rot.y, v.rot.z, v.scale.x, v.scale.y, v.scale.z);
+        return str;
+    }
+    default:
+        return a->ToString().c_str();
+    }
 }
 
 SceneDesc Scene::CreateSceneDescFromXml(const QString &filename) const
@@ -891,122 +1792,162 @@ SceneDesc Scene::CreateSceneDescFromXml(const QString &filename) const
         return sceneDesc;
     }
 
-    QByteArray data = file.readAll();
+    QXmlStreamReader reader(&file);
+    CreateSceneDescFromXml(reader, sceneDesc);
     file.close();
-
-    return CreateSceneDescFromXml(data, sceneDesc);
+    return sceneDesc;
 }
 
 SceneDesc Scene::CreateSceneDescFromXml(QByteArray &data, SceneDesc &sceneDesc) const
 {
-    QTextStream stream(&data);
-    stream.setCodec("UTF-8");
-    QDomDocument scene_doc("Scene");
-    QString errorMsg;
-    int errorLine, errorColumn;
-    if (!scene_doc.setContent(stream.readAll(), &errorMsg, &errorLine, &errorColumn))
-    {
-        LogError(QString("Parsing scene XML from %1 failed when loading Scene XML: %2 at line %3 column %4.").arg(sceneDesc.filename).arg(errorMsg).arg(errorLine).arg(errorColumn));
-        return sceneDesc;
-    }
+    QXmlStreamReader reader(data);
+    return CreateSceneDescFromXml(reader, sceneDesc);
+}
+
+SceneDesc Scene::CreateSceneDescFromXml(QXmlStreamReader &reader, SceneDesc &sceneDesc) const
+{
+    PROFILE(Scene_CreateSceneDescFromXml);
 
     // Check for existence of the scene element before we begin
-    QDomElement scene_elem = scene_doc.firstChildElement("scene");
-    if (scene_elem.isNull())
+    if (!reader.readNextStartElement() || reader.name() != "scene")
     {
-        LogError("Could not find 'scene' element from XML.");
+        if (reader.hasError())
+            LogError(QString("Parsing scene XML from %1 failed when loading Scene XML: %2 at line %3 column %4.").arg(sceneDesc.filename).arg(reader.errorString()).arg(reader.lineNumber()).arg(reader.columnNumber()));
+        else
+            LogError("Could not find 'scene' element from XML.");
         return sceneDesc;
     }
 
-    QDomElement ent_elem = scene_elem.firstChildElement("entity");
-    while(!ent_elem.isNull())
+    const QString basePath = QFileInfo(sceneDesc.filename).dir().path();
+
+    while(reader.readNextStartElement())
     {
-        QString id_str = ent_elem.attribute("id");
-        if (!id_str.isEmpty())
+        if (reader.name() != "entity")
         {
-            EntityDesc entityDesc;
-            entityDesc.id = id_str;
+            reader.skipCurrentElement();
+            continue;
+        }
 
-            QDomElement comp_elem = ent_elem.firstChildElement("component");
-            while(!comp_elem.isNull())
+        // Entities without an id are kept: they are given a new id when created, as in CreateContentFromXml.
+        EntityDesc entityDesc;
+        entityDesc.id = reader.attributes().value("id").toString();
+        const QString replicatedStr = reader.attributes().value("sync").toString();
+        entityDesc.local = !replicatedStr.isEmpty() && !ParseBool(replicatedStr);
+
+        while(reader.readNextStartElement())
+        {
+            if (reader.name() != "component")
             {
-                QString type_name = comp_elem.attribute("type");
-                QString name = comp_elem.attribute("name");
-                QString sync = comp_elem.attribute("sync");
-                ComponentDesc compDesc;
-                compDesc.typeName = type_name;
-                compDesc.name = name;
-                compDesc.sync = sync;
+                reader.skipCurrentElement();
+                continue;
+            }
 
-                // A bit of a hack to get the name from EC_Name.
-                if (entityDesc.name.isEmpty() && type_name == EC_Name::TypeNameStatic())
-                {
-                    ComponentPtr comp = framework_->Scene()->CreateComponentByName(const_cast<Scene*>(this), type_name, name);
-                    EC_Name *ecName = checked_static_cast<EC_Name*>(comp.get());
-                    ecName->DeserializeFrom(comp_elem, AttributeChange::Disconnected);
-                    entityDesc.name = ecName->name.Get();
-                }
+            QXmlStreamAttributes compAttrs = reader.attributes();
+            QString type_name = compAttrs.value("type").toString();
+            QString name = compAttrs.value("name").toString();
+            ComponentDesc compDesc;
+            compDesc.typeName = type_name;
+            compDesc.name = name;
+            compDesc.sync = compAttrs.value("sync").toString();
 
-                // Find asset references.
-                ComponentPtr comp = framework_->Scene()->CreateComponentByName(const_cast<Scene*>(this), type_name, name);
-                if (!comp.get()) // Move to next element if component creation fails.
-                {
-                    comp_elem = comp_elem.nextSiblingElement("component");
-                    continue;
-                }
+            // Components deserialize themselves from DOM, so read each component element into a document of its own.
+            QDomDocument compDoc;
+            QDomElement comp_elem = ReadDomElement(reader, compDoc);
+            compDoc.appendChild(comp_elem);
 
-                comp->DeserializeFrom(comp_elem, AttributeChange::Disconnected);
-                foreach(IAttribute *a,comp->Attributes())
+            // Find asset references.
+            ComponentPtr comp = framework_->Scene()->CreateComponentByName(const_cast<Scene*>(this), type_name, name);
+            if (!comp.get()) // Move to next element if component creation fails.
+                continue;
+
+            comp->DeserializeFrom(comp_elem, AttributeChange::Disconnected);
+
+            // A bit of a hack to get the name from EC_Name.
+            if (entityDesc.name.isEmpty() && type_name == EC_Name::TypeNameStatic())
+                entityDesc.name = checked_static_cast<EC_Name*>(comp.get())->name.Get();
+
+            foreach(IAttribute *a,comp->Attributes())
+            {
+                if (!a)
+                    continue;
+                
+                QString typeName = a->TypeName();
+                AttributeDesc attrDesc = { typeName, a->Name(), AttributeDescValue(a) };
+                compDesc.attributes.append(attrDesc);
+
+                QString attrValue = QString(a->ToString().c_str()).trimmed();
+                if ((typeName == "assetreference" || typeName == "assetreferencelist" || 
+                    (a->Metadata() && a->Metadata()->elementType == "assetreference")) &&
+                    !attrValue.isEmpty())
                 {
-                    if (!a)
-                        continue;
-                    
-                    QString typeName = a->TypeName();
-                    AttributeDesc attrDesc = { typeName, a->Name(), a->ToString().c_str() };
-                    compDesc.attributes.append(attrDesc);
-
-                    QString attrValue = QString(a->ToString().c_str()).trimmed();
-                    if ((typeName == "assetreference" || typeName == "assetreferencelist" || 
-                        (a->Metadata() && a->Metadata()->elementType == "assetreference")) &&
-                        !attrValue.isEmpty())
+                    // We might have multiple references, ";" used as a separator.
+                    QStringList values = attrValue.split(";");
+                    foreach(QString value, values)
                     {
-                        // We might have multiple references, ";" used as a separator.
-                        QStringList values = attrValue.split(";");
-                        foreach(QString value, values)
-                        {
-                            AssetDesc ad;
-                            ad.typeName = a->Name();
-                            ad.dataInMemory = false;
+                        AssetDesc ad;
+                        ad.typeName = a->Name();
+                        ad.dataInMemory = false;
 
-                            // Rewrite source refs for asset descs, if necessary.
-                            QString basePath = QFileInfo(sceneDesc.filename).dir().path();
-                            framework_->Asset()->ResolveLocalAssetPath(value, basePath, ad.source);
-                            ad.destinationName = AssetAPI::ExtractFilenameFromAssetRef(ad.source);
+                        // Rewrite source refs for asset descs, if necessary.
+                        framework_->Asset()->ResolveLocalAssetPath(value, basePath, ad.source);
+                        ad.destinationName = AssetAPI::ExtractFilenameFromAssetRef(ad.source);
 
-                            sceneDesc.assets[qMakePair(ad.source, ad.subname)] = ad;
+                        sceneDesc.assets[qMakePair(ad.source, ad.subname)] = ad;
 
-                            // If this is a script, look for dependecies
-                            if (ad.source.toLower().endsWith(".js"))
-                                SearchScriptAssetDependencies(ad.source, sceneDesc);
-                        }
+                        // If this is a script, look for dependecies
+                        if (ad.source.toLower().endsWith(".js"))
+                            SearchScriptAssetDependencies(ad.source, sceneDesc);
                     }
                 }
-
-                entityDesc.components.append(compDesc);
-
-                comp_elem = comp_elem.nextSiblingElement("component");
             }
 
-            sceneDesc.entities.append(entityDesc);
+            entityDesc.components.append(compDesc);
         }
 
-        // Process siblings.
-        ent_elem = ent_elem.nextSiblingElement("entity");
+        sceneDesc.entities.append(entityDesc);
     }
 
+    if (reader.hasError())
+        LogError(QString("Parsing scene XML from %1 failed when loading Scene XML: %2 at line %3 column %4.").arg(sceneDesc.filename).arg(reader.errorString()).arg(reader.lineNumber()).arg(reader.columnNumber()));
+
     return sceneDesc;
 }
 
+void Scene::FillComponentDesc(IComponent *comp, ComponentDesc &compDesc, SceneDesc &sceneDesc) const
+{
+    foreach(IAttribute *a, comp->Attributes())
+    {
+        if (!a)
+            continue;
+        
+        QString typeName = a->TypeName();
+        AttributeDesc attrDesc = { typeName, a->Name(), AttributeDescValue(a) };
+        compDesc.attributes.append(attrDesc);
+
+        QString attrValue = QString(a->ToString().c_str()).trimmed();
+        if ((typeName == "assetreference" || typeName == "assetreferencelist" || 
+            (a->Metadata() && a->Metadata()->elementType == "assetreference")) &&
+            !attrValue.isEmpty())
+        {
+            // We might have multiple references, ";" used as a separator.
+            QStringList values = attrValue.split(";");
+            foreach(QString value, values)
+            {
+                AssetDesc ad;
+                ad.typeName = a->Name();
+                ad.dataInMemory = false;
+
+                // Rewrite source refs for asset descs, if necessary.
+                QString basePath = QFileInfo(sceneDesc.filename).dir().path();
+                framework_->Asset()->ResolveLocalAssetPath(value, basePath, ad.source);
+                ad.destinationName = AssetAPI::ExtractFilenameFromAssetRef(ad.source);
+
+                sceneDesc.assets[qMakePair(ad.source, ad.subname)] = ad;
+            }
+        }
+    }
+}
+
 ///\todo This function is a redundant duplicate copy of void ScriptAsset::ParseReferences(). Delete this code. -jj.
 void Scene::SearchScriptAssetDependencies(const QString &filePath, SceneDesc &sceneDesc) const
 {
@@ -1066,6 +2007,103 @@ void Scene::SearchScriptAssetDependencies(const QString &filePath, SceneDesc &sc
     }
 }
 
+AssetPrefetchManifest Scene::CreatePrefetchManifest(const SceneDesc &desc, const float3 &origin) const
+{
+    PROFILE(Scene_CreatePrefetchManifest);
+
+    AssetPrefetchManifest manifest;
+    manifest.SetSceneName(QFileInfo(desc.filename).fileName());
+    const QString basePath = QFileInfo(desc.filename).dir().path();
+
+    // The descriptions do not carry the attribute metadata, so look it up from one prototype component of each type.
+    std::map<QString, ComponentPtr> prototypes;
+
+    foreach(const EntityDesc &entityDesc, desc.entities)
+    {
+        // Use the placeable position for a rough spatial ordering. Parented placeables are treated as if they were in world space.
+        float distance = 0.f;
+        foreach(const ComponentDesc &compDesc, entityDesc.components)
+            if (compDesc.typeName == "EC_Placeable")
+                foreach(const AttributeDesc &attrDesc, compDesc.attributes)
+                    if (attrDesc.name == "Transform")
+                        distance = Transform::FromString(attrDesc.value).pos.Distance(origin);
+
+        foreach(const ComponentDesc &compDesc, entityDesc.components)
+        {
+            std::map<QString, ComponentPtr>::iterator prototype = prototypes.find(compDesc.typeName);
+            if (prototype == prototypes.end())
+                prototype = prototypes.insert(std::make_pair(compDesc.typeName,
+                    framework_->Scene()->CreateComponentByName(const_cast<Scene*>(this), compDesc.typeName))).first;
+
+            foreach(const AttributeDesc &attrDesc, compDesc.attributes)
+            {
+                IAttribute *a = prototype->second ? prototype->second->GetAttribute(attrDesc.name) : 0;
+                if (attrDesc.typeName != "assetreference" && attrDesc.typeName != "assetreferencelist" &&
+                    !(a && a->Metadata() && a->Metadata()->elementType == "assetreference"))
+                    continue;
+
+                // We might have multiple references, ";" used as a separator.
+                foreach(QString value, attrDesc.value.split(";", QString::SkipEmptyParts))
+                {
+                    value = value.trimmed();
+                    QString path;
+                    qint64 size = -1;
+                    if (framework_->Asset()->ResolveLocalAssetPath(value, basePath, path) == AssetAPI::FileQueryLocalFileFound)
+                        size = QFileInfo(path).size();
+                    manifest.Add(value, AssetAPI::GetResourceTypeFromAssetRef(value), size, distance);
+                }
+            }
+        }
+    }
+
+    manifest.Sort();
+    return manifest;
+}
+
+AssetPrefetchManifest Scene::CreatePrefetchManifest(const float3 &origin) const
+{
+    PROFILE(Scene_CreatePrefetchManifest);
+
+    AssetPrefetchManifest manifest;
+    manifest.SetSceneName(name_);
+    AssetAPI *assetApi = framework_->Asset();
+
+    for(const_iterator iter = begin(); iter != end(); ++iter)
+    {
+        const Entity *entity = iter->second.get();
+        float distance = 0.f;
+        ComponentPtr placeable = entity->GetComponent("EC_Placeable");
+        Attribute<Transform> *transform = placeable ? dynamic_cast<Attribute<Transform> *>(placeable->GetAttribute("Transform")) : 0;
+        if (transform)
+            distance = transform->Get().pos.Distance(origin);
+
+        const Entity::ComponentMap &components = entity->Components();
+        for(Entity::ComponentMap::const_iterator compIter = components.begin(); compIter != components.end(); ++compIter)
+            foreach(IAttribute *a, compIter->second->Attributes())
+            {
+                if (!a)
+                    continue;
+                QString typeName = a->TypeName();
+                if (typeName != "assetreference" && typeName != "assetreferencelist" && !(a->Metadata() && a->Metadata()->elementType == "assetreference"))
+                    continue;
+
+                foreach(QString value, QString(a->ToString().c_str()).split(";", QString::SkipEmptyParts))
+                {
+                    value = value.trimmed();
+                    // The size is known for the assets that have been loaded from a file or from the asset cache.
+                    qint64 size = -1;
+                    AssetPtr asset = assetApi->GetAsset(value);
+                    if (asset && !asset->DiskSource().isEmpty() && QFileInfo(asset->DiskSource()).exists())
+                        size = QFileInfo(asset->DiskSource()).size();
+                    manifest.Add(value, asset ? asset->Type() : AssetAPI::GetResourceTypeFromAssetRef(value), size, distance);
+                }
+            }
+    }
+
+    manifest.Sort();
+    return manifest;
+}
+
 SceneDesc Scene::CreateSceneDescFromBinary(const QString &filename) const
 {
     SceneDesc sceneDesc;
@@ -1082,30 +2120,90 @@ SceneDesc Scene::CreateSceneDescFromBinary(const QString &filename) const
     sceneDesc.filename = filename;
 
     QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly))
+    QByteArray bytes;
+    size_t size = 0;
+    const char *data = MapFile(file, bytes, size);
+    if (!file.isOpen())
     {
         LogError("Failed to open file " + filename + " when trying to create scene description.");
         return sceneDesc;
     }
 
-    QByteArray bytes = file.readAll();
-    file.close();
-
-    return CreateSceneDescFromBinary(bytes, sceneDesc);
+    return CreateSceneDescFromBinary(data, size, sceneDesc);
 }
 
 SceneDesc Scene::CreateSceneDescFromBinary(QByteArray &data, SceneDesc &sceneDesc) const
 {
-    QByteArray bytes = data;
-    if (!bytes.size())
+    return CreateSceneDescFromBinary(data.data(), (size_t)data.size(), sceneDesc);
+}
+
+SceneDesc Scene::CreateSceneDescFromBinary(const char *data, size_t numBytes, SceneDesc &sceneDesc) const
+{
+    if (!data || !numBytes)
     {
         LogError("File " + sceneDesc.filename + " contained 0 bytes when trying to create scene description.");
         return sceneDesc;
     }
 
+    if (SceneBinaryIndex::IsIndexed(data, numBytes))
+    {
+        SceneBinaryIndex index(data, numBytes);
+        if (!index.IsValid())
+            return SceneDesc();
+
+        SceneAPI *sceneAPI = framework_->Scene();
+        for(u32 i = 0; i < index.NumEntities(); ++i)
+        {
+            const SceneBinaryIndex::Entry &entry = index.EntryAt(i);
+            try
+            {
+                DataDeserializer source(index.Record(entry), entry.size);
+                EntityDesc entityDesc;
+                entityDesc.id = QString::number((int)source.Read<u32>());
+                entityDesc.local = source.Read<u8>() ? false : true;
+
+                uint num_components = source.Read<u32>();
+                for(uint j = 0; j < num_components; ++j)
+                {
+                    ComponentDesc compDesc;
+                    compDesc.typeName = index.String(source.Read<u32>());
+                    compDesc.name = index.String(source.Read<u32>());
+                    compDesc.sync = source.Read<u8>() ? "true" : "false";
+                    uint data_size = source.Read<u32>();
+
+                    QByteArray comp_bytes;
+                    comp_bytes.resize(data_size);
+                    if (data_size)
+                        source.ReadArray<u8>((u8*)comp_bytes.data(), comp_bytes.size());
+
+                    ComponentPtr comp = sceneAPI->CreateComponentByName(const_cast<Scene*>(this), compDesc.typeName, compDesc.name);
+                    if (!comp)
+                    {
+                        LogError("Failed to load component " + compDesc.typeName);
+                        continue;
+                    }
+                    if (data_size)
+                    {
+                        DataDeserializer comp_source(comp_bytes.data(), comp_bytes.size());
+                        comp->DeserializeFromBinary(comp_source, AttributeChange::Disconnected);
+                        FillComponentDesc(comp.get(), compDesc, sceneDesc);
+                    }
+                    entityDesc.components.append(compDesc);
+                }
+
+                sceneDesc.entities.append(entityDesc);
+            }
+            catch(...)
+            {
+                LogError("Failed to read entity record of entity " + QString::number(entry.id) + " when trying to create scene description.");
+            }
+        }
+        return sceneDesc;
+    }
+
     try
     {
-        DataDeserializer source(bytes.data(), bytes.size());
+        DataDeserializer source(data, numBytes);
         
         uint num_entities = source.Read<u32>();
         for(uint i = 0; i < num_entities; ++i)
@@ -1113,6 +2211,7 @@ SceneDesc Scene::CreateSceneDescFromBinary(QByteArray &data, SceneDesc &sceneDes
             EntityDesc entityDesc;
             entity_id_t id = source.Read<u32>();
             entityDesc.id = QString::number((int)id);
+            entityDesc.local = source.Read<u8>() ? false : true;
 
             uint num_components = source.Read<u32>();
             for(uint i = 0; i < num_components; ++i)
@@ -1123,7 +2222,7 @@ SceneDesc Scene::CreateSceneDescFromBinary(QByteArray &data, SceneDesc &sceneDes
                 u32 typeId = source.Read<u32>(); ///\todo VLE this!
                 compDesc.typeName = sceneAPI->GetComponentTypeName(typeId);
                 compDesc.name = QString::fromStdString(source.ReadString());
-                compDesc.sync = source.Read<u8>() ? true : false;
+                compDesc.sync = source.Read<u8>() ? "true" : "false";
                 uint data_size = source.Read<u32>();
 
                 // Read the component data into a separate byte array, then deserialize from there.
@@ -1143,37 +2242,7 @@ SceneDesc Scene::CreateSceneDescFromBinary(QByteArray &data, SceneDesc &sceneDes
                             DataDeserializer comp_source(comp_bytes.data(), comp_bytes.size());
                             // Trigger no signal yet when scene is in incoherent state
                             comp->DeserializeFromBinary(comp_source, AttributeChange::Disconnected);
-                            foreach(IAttribute *a, comp->Attributes())
-                            {
-                                if (!a)
-                                    continue;
-                                
-                                QString typeName = a->TypeName();
-                                AttributeDesc attrDesc = { typeName, a->Name(), a->ToString().c_str() };
-                                compDesc.attributes.append(attrDesc);
-
-                                QString attrValue = QString(a->ToString().c_str()).trimmed();
-                                if ((typeName == "assetreference" || typeName == "assetreferencelist" || 
-                                    (a->Metadata() && a->Metadata()->elementType == "assetreference")) &&
-                                    !attrValue.isEmpty())
-                                {
-                                    // We might have multiple references, ";" used as a separator.
-                                    QStringList values = attrValue.split(";");
-                                    foreach(QString value, values)
-                                    {
-                                        AssetDesc ad;
-                                        ad.typeName = a->Name();
-                                        ad.dataInMemory = false;
-
-                                        // Rewrite source refs for asset descs, if necessary.
-                                        QString basePath = QFileInfo(sceneDesc.filename).dir().path();
-                                        framework_->Asset()->ResolveLocalAssetPath(value, basePath, ad.source);
-                                        ad.destinationName = AssetAPI::ExtractFilenameFromAssetRef(ad.source);
-
-                                        sceneDesc.assets[qMakePair(ad.source, ad.subname)] = ad;
-                                    }
-                                }
-                            }
+                            FillComponentDesc(comp.get(), compDesc, sceneDesc);
                         }
 
                         entityDesc.components.append(compDesc);
@@ -1257,6 +2326,28 @@ bool Scene::StartAttributeInterpolation(IAttribute* attr, IAttribute* endvalue,
     if (!previous)
         attr->CopyValue(endvalue, AttributeChange::LocalOnly);
     
+    // The common spatial types are interpolated by value in typed tracks, without keeping attribute clones.
+    switch(endvalue->TypeId() == attr->TypeId() ? attr->TypeId() : 0)
+    {
+    case cAttributeFloat3:
+        float3Interpolations_.Add(static_cast<Attribute<float3> *>(attr), comp->shared_from_this(),
+            static_cast<Attribute<float3> *>(attr)->Get(), static_cast<Attribute<float3> *>(endvalue)->Get(), length);
+        delete endvalue;
+        return true;
+    case cAttributeQuat:
+        quatInterpolations_.Add(static_cast<Attribute<Quat> *>(attr), comp->shared_from_this(),
+            static_cast<Attribute<Quat> *>(attr)->Get(), static_cast<Attribute<Quat> *>(endvalue)->Get(), length);
+        delete endvalue;
+        return true;
+    case cAttributeTransform:
+        transformInterpolations_.Add(static_cast<Attribute<Transform> *>(attr), comp->shared_from_this(),
+            static_cast<Attribute<Transform> *>(attr)->Get(), static_cast<Attribute<Transform> *>(endvalue)->Get(), length);
+        delete endvalue;
+        return true;
+    default:
+        break;
+    }
+
     AttributeInterpolation newInterp;
     newInterp.comp = comp->shared_from_this();
     newInterp.dest = attr;
@@ -1270,6 +2361,9 @@ bool Scene::StartAttributeInterpolation(IAttribute* attr, IAttribute* endvalue,
 
 bool Scene::EndAttributeInterpolation(IAttribute* attr)
 {
+    if (float3Interpolations_.Remove(attr) || quatInterpolations_.Remove(attr) || transformInterpolations_.Remove(attr))
+        return true;
+
     for(uint i = 0; i < interpolations_.size(); ++i)
     {
         AttributeInterpolation& interp = interpolations_[i];
@@ -1294,6 +2388,9 @@ void Scene::EndAllAttributeInterpolations()
     }
     
     interpolations_.clear();
+    float3Interpolations_.Clear();
+    quatInterpolations_.Clear();
+    transformInterpolations_.Clear();
 }
 
 void Scene::UpdateAttributeInterpolations(float frametime)
@@ -1302,6 +2399,10 @@ void Scene::UpdateAttributeInterpolations(float frametime)
     
     interpolating_ = true;
     
+    float3Interpolations_.Update(frametime, AttributeChange::LocalOnly);
+    quatInterpolations_.Update(frametime, AttributeChange::LocalOnly);
+    transformInterpolations_.Update(frametime, AttributeChange::LocalOnly);
+
     for(uint i = interpolations_.size() - 1; i < interpolations_.size(); --i)
     {
         AttributeInterpolation& interp = interpolations_[i];
@@ -1336,7 +2437,8 @@ void Scene::UpdateAttributeInterpolations(float frametime)
         {
             delete interp.start;
             delete interp.end;
-            interpolations_.erase(interpolations_.begin() + i);
+            interpolations_[i] = interpolations_.back();
+            interpolations_.pop_back();
         }
     }
 
@@ -1345,6 +2447,9 @@ void Scene::UpdateAttributeInterpolations(float frametime)
 
 void Scene::OnUpdated(float frameTime)
 {
+    ProcessIncrementalLoad();
+    FinishBackgroundSave(false);
+
     // Signal queued entity creations now
     for (unsigned i = 0; i < entitiesCreatedThisFrame_.size(); ++i)
     {
@@ -1363,3 +2468,8 @@ void Scene::OnUpdated(float frameTime)
     
     entitiesCreatedThisFrame_.clear();
 }
+
+void Scene::OnPostFrameUpdate(float frameTime)
+{
+    FlushAttributeChanges();
+}
@@ -8,10 +8,15 @@
 #include "EntityAction.h"
 #include "UniqueIdGenerator.h"
 #include "Math/float3.h"
+#include "Transform.h"
 #include "SceneDesc.h"
+#include "AttributeChangeSet.h"
+#include "AttributeInterpolationTrack.h"
+#include "SceneSnapshot.h"
 
 #include <QObject>
 #include <QVariant>
+#include <QHash>
 
 #include <boost/enable_shared_from_this.hpp>
 
@@ -20,6 +25,40 @@ class Framework;
 /// Maybe have some kind of UserConnection interface class defined in Framework and use that instead.
 class UserConnection;
 class QDomDocument;
+class QDomElement;
+class QXmlStreamReader;
+class SceneBinaryIndex;
+class AssetPrefetchManifest;
+
+/// Approximate memory usage of the components of one type in a scene. @see Scene::MemoryUsage
+struct ComponentTypeMemoryUsage
+{
+    ComponentTypeMemoryUsage() : numComponents(0), numBytes(0) {}
+
+    uint numComponents; ///< Number of components of the type.
+    size_t numBytes; ///< Total IComponent::MemoryUsage of the components.
+};
+
+/// Approximate memory usage of a scene, aggregated per entity and per component type. @see Scene::MemoryUsage
+struct SceneMemoryUsage
+{
+    SceneMemoryUsage() : numEntities(0), entityBytes(0), componentBytes(0), numPooledEntities(0), pooledEntityBytes(0), sceneBytes(0),
+        numSharedResources(0), sharedResourceBytes(0) {}
+
+    uint numEntities; ///< Number of active entities in the scene.
+    size_t entityBytes; ///< Memory used by the active entities themselves, not including their components.
+    size_t componentBytes; ///< Memory used by the components of the active entities.
+    uint numPooledEntities; ///< Number of deactivated entities waiting in the entity pool.
+    size_t pooledEntityBytes; ///< Memory used by the pooled entities and their components.
+    size_t sceneBytes; ///< Memory used by the scene object and its entity containers.
+    uint numSharedResources; ///< Number of resources, f.ex. Ogre meshes, used by the components of the entities. @see IComponent::SharedResources
+    size_t sharedResourceBytes; ///< Memory used by the resources used by the components, each resource counted once. Not included in the other sizes.
+    std::map<QString, ComponentTypeMemoryUsage> componentTypes; ///< Memory usage of the components of the active entities by component type name.
+    std::vector<std::pair<entity_id_t, size_t> > entities; ///< Memory usage of each active entity including its components, largest first.
+
+    /// Returns the total memory usage of the scene.
+    size_t Total() const { return sceneBytes + entityBytes + componentBytes + pooledEntityBytes + sharedResourceBytes; }
+};
 
 /// A collection of entities which form an observable world.
 /** Acts as a factory for all entities.
@@ -116,6 +155,43 @@ public:
     /** @param data XML data to be processed.
         @param sceneDesc Initialized SceneDesc with filename prepared. */
     SceneDesc CreateSceneDescFromXml(QByteArray &data, SceneDesc &sceneDesc) const;
+    /// @overload
+    /** Fills the scene description while reading the XML stream, without building a document of the whole scene.
+        @param reader XML stream reader positioned before the scene element.
+        @param sceneDesc Initialized SceneDesc with filename prepared. */
+    SceneDesc CreateSceneDescFromXml(QXmlStreamReader &reader, SceneDesc &sceneDesc) const;
+
+    /// Loads the entities with the given ids from an indexed binary scene file, decoding only the records of those entities.
+    /** @param filename File name
+        @param ids Ids of the entities in the file.
+        @param useEntityIDsFromFile If true, the created entities will use the Entity IDs from the original file.
+                  If the scene contains any previous entities with conflicting IDs, those are removed. If false, new IDs are generated.
+        @param change Change type that will be used
+        @return List of created entities. */
+    QList<Entity *> LoadSceneBinaryEntities(const QString &filename, const QList<entity_id_t> &ids, bool useEntityIDsFromFile, AttributeChange::Type change);
+
+    /// Loads the entities of the regions intersecting an axis-aligned box from an indexed binary scene file.
+    /** Only files saved with a region size contain regions. @sa SaveSceneBinary
+        @param filename File name
+        @param minPos Minimum corner of the box.
+        @param maxPos Maximum corner of the box.
+        @param useEntityIDsFromFile If true, the created entities will use the Entity IDs from the original file.
+                  If the scene contains any previous entities with conflicting IDs, those are removed. If false, new IDs are generated.
+        @param change Change type that will be used
+        @return List of created entities. */
+    QList<Entity *> LoadSceneBinaryRegion(const QString &filename, const float3 &minPos, const float3 &maxPos, bool useEntityIDsFromFile, AttributeChange::Type change);
+
+    /// Creates scene content from an XML stream.
+    /** Entities are created as the stream is read, so memory use is bounded by the size of a single component element
+        instead of the whole document. The EntityCreated/ComponentChanged signals are emitted after the stream has been read.
+        If the stream contains an error, the entities read before the error are kept.
+        @param reader XML stream reader positioned before the scene element.
+        @param useEntityIDsFromFile If true, the created entities will use the Entity IDs from the original file.
+                  If the scene contains any previous entities with conflicting IDs, those are removed. If false, the entity IDs from the files are ignored,
+                  and new IDs are generated for the created entities.
+        @param change Change type that will be used
+        @return List of created entities. */
+    QList<Entity *> CreateContentFromXml(QXmlStreamReader &reader, bool useEntityIDsFromFile, AttributeChange::Type change);
 
     /// Inspects file and returns a scene description structure from the contents of binary file.
     /** @param filename File name. */
@@ -124,6 +200,16 @@ public:
     /** @param data Binary data to be processed. */
     SceneDesc CreateSceneDescFromBinary(QByteArray &data, SceneDesc &sceneDesc) const;
 
+    /// Creates an asset prefetch manifest of the assets the scene description refers to.
+    /** The assets are ordered by the distance of the entities that refer to them from origin. Sizes are filled in for the assets
+        that are found on the local file system, relative to the scene file.
+        @note The components of the scene description need to be registered, as with CreateSceneDescFromXml. */
+    AssetPrefetchManifest CreatePrefetchManifest(const SceneDesc &desc, const float3 &origin = float3::zero) const;
+
+    /// Creates an asset prefetch manifest of the assets the entities of this scene currently refer to.
+    /** Use this to record a manifest from a running scene. Sizes are filled in for the assets that have been loaded from a file. */
+    AssetPrefetchManifest CreatePrefetchManifest(const float3 &origin = float3::zero) const;
+
     /// Inspects .js file content for dependencies and adds them to sceneDesc.assets
     ///@todo This function is a duplicate copy of void ScriptAsset::ParseReferences(). Delete this code. -jj.
     /** @param filePath. Path to the file that is opened for inspection.
@@ -159,6 +245,23 @@ public:
         @param change Change signalling mode */
      void EmitAttributeRemoved(IComponent* comp, IAttribute* attribute, AttributeChange::Type change);
 
+    /// Records an attribute change to be dispatched at the end of the frame. Called by IComponent when attribute change batching is enabled.
+    /** Repeated changes to the same attribute during a frame are coalesced into one.
+        @param comp Component pointer
+        @param attribute Attribute pointer
+        @param change Change signalling mode */
+    void QueueAttributeChange(IComponent* comp, IAttribute* attribute, AttributeChange::Type change);
+
+    /// Signals a set of attribute changes of a component at once. Called by components that set many attributes at once.
+    /** If the attribute change batching is enabled, the changes are queued like with QueueAttributeChange, and signalled with AttributesChanged()
+        at the end of the frame. Otherwise the per-attribute AttributeChanged() signals are emitted immediately.
+        @param comp Component pointer
+        @param changes Indices of the changed attributes and the change signalling mode */
+    void DispatchAttributeChanges(IComponent* comp, const AttributeChangeSet &changes);
+
+    /// Returns whether the scene is currently dispatching batched attribute changes.
+    bool IsDispatchingAttributeChanges() const { return dispatchingAttributeChanges_; }
+
     /// Emits a notification of a component being added to entity. Called by the entity
     /** @param entity Entity pointer
         @param comp Component pointer
@@ -216,6 +319,21 @@ public slots:
     EntityPtr CreateLocalEntity(const QStringList &components = QStringList(),
         AttributeChange::Type change = AttributeChange::Default, bool componentsReplicated = true);
 
+    /// Enables or disables the batched attribute change dispatch.
+    /** When enabled, attribute changes are not signalled immediately. Instead the changes are accumulated per component
+        and dispatched once at the end of the frame: AttributesChanged() is emitted with the coalesced change set,
+        followed by the per-attribute AttributeChanged() signals of the scene and the component for each changed attribute.
+        Disabling the batching dispatches the pending changes immediately.
+        @note Changes made by the listeners during the dispatch are delivered on the next dispatch. */
+    void SetAttributeChangeBatching(bool enable);
+
+    /// Returns whether the batched attribute change dispatch is enabled.
+    bool AttributeChangeBatching() const { return batchAttributeChanges_; }
+
+    /// Dispatches the attribute changes accumulated by the batched attribute change dispatch.
+    /** Called automatically at the end of each frame. */
+    void FlushAttributeChanges();
+
     /// Returns scene up vector. For now it is a compile-time constant
     float3 UpVector() const;
 
@@ -316,7 +434,8 @@ public slots:
     bool SaveSceneXML(const QString& filename, bool saveTemporary, bool saveLocal);
 
     /// Loads the scene from a binary file.
-    /** @param filename File name
+    /** Both the indexed (version 2) and the original sequential binary format are supported. The file is memory-mapped when possible.
+        @param filename File name
         @param clearScene Do we want to clear the existing scene.
         @param useEntityIDsFromFile If true, the created entities will use the Entity IDs from the original file. 
                   If the scene contains any previous entities with conflicting IDs, those are removed. If false, the entity IDs from the files are ignored,
@@ -326,11 +445,45 @@ public slots:
     QList<Entity *> LoadSceneBinary(const QString& filename, bool clearScene, bool useEntityIDsFromFile, AttributeChange::Type change);
 
     /// Save the scene to binary
-    /** @param filename File name
+    /** The scene is saved in the indexed binary format (version 2), see SceneBinaryIndex.
+        @param filename File name
         @param saveTemporary Are temporary entities wanted to be included.
         @param saveLocal Are local entities wanted to be included.
+        @param regionSize If positive, entities are grouped to cubic regions of this size by the position of their EC_Placeable,
+                  so that the entities of an area can be loaded with LoadSceneBinaryRegion.
         @return true if successful */
-    bool SaveSceneBinary(const QString& filename, bool saveTemporary, bool saveLocal);
+    bool SaveSceneBinary(const QString& filename, bool saveTemporary, bool saveLocal, float regionSize = 0.f);
+
+    /// Returns the approximate memory usage of the scene, its entities and components.
+    /** Walks through all entities and components of the scene, so this is meant for diagnostics and should not be called every frame. */
+    SceneMemoryUsage MemoryUsage() const;
+
+    /// Takes a snapshot of the entity and attribute data of the scene.
+    /** Only the attributes of the components that have changed since the previous snapshot are copied, the rest are shared with the previous
+        snapshot. The snapshot is immutable, and can be serialized on any thread while the scene keeps changing. Inactive pooled entities are not included.
+        @param getTemporary Are temporary entities and components wanted to be included.
+        @param getLocal Are local entities wanted to be included. */
+    SceneSnapshotPtr TakeSnapshot(bool getTemporary, bool getLocal) const;
+
+    /// Saves the scene to XML on a worker thread.
+    /** The scene is captured with TakeSnapshot, after which the snapshot is serialized and written to the file on a worker thread.
+        BackgroundSaveFinished is emitted on completion. Only one background save can be in progress at a time.
+        @param filename File name
+        @param saveTemporary Are temporary entities wanted to be included.
+        @param saveLocal Are local entities wanted to be included.
+        @return true if the save was started */
+    bool SaveSceneXMLInBackground(const QString& filename, bool saveTemporary, bool saveLocal);
+
+    /// Saves the scene to the indexed binary format on a worker thread.
+    /** @param regionSize Size of the region cells the entities are grouped in by position, or 0 for no regions.
+        @sa SaveSceneXMLInBackground, SaveSceneBinary */
+    bool SaveSceneBinaryInBackground(const QString& filename, bool saveTemporary, bool saveLocal, float regionSize = 0.f);
+
+    /// Returns whether a background save is in progress.
+    bool IsSavingInBackground() const { return backgroundSave_.get() != 0; }
+
+    /// Blocks until the background save in progress, if any, has been written, and emits BackgroundSaveFinished.
+    void WaitForBackgroundSave();
 
     /// Creates scene content from XML.
     /** @param xml XML document as string.
@@ -350,7 +503,80 @@ public slots:
         @param change Change type that will be used, when removing the old scene, and deserializing the new
         @return List of created entities. */
     QList<Entity *> CreateContentFromBinary(const QString &filename, bool useEntityIDsFromFile, AttributeChange::Type change);
-    QList<Entity *> CreateContentFromBinary(const char *data, int numBytes, bool useEntityIDsFromFile, AttributeChange::Type change); /**< @overload @param data Data buffer @param numBytes Data size. */
+    QList<Entity *> CreateContentFromBinary(const char *data, size_t numBytes, bool useEntityIDsFromFile, AttributeChange::Type change); /**< @overload @param data Data buffer @param numBytes Data size. */
+
+    /// Starts loading a scene file incrementally, instantiating its entities over several frames under a time budget.
+    /** The scene description is read first, after which entities are created for at most msPerFrame milliseconds each frame,
+        starting from the entities closest to the load focus (see SetIncrementalLoadFocus). Each entity is signalled as created
+        as soon as it is instantiated, so the scene is usable, and the main loop keeps running, while the rest is being loaded.
+        Progress is reported with IncrementalLoadProgress and completion with IncrementalLoadFinished.
+        Starting a new incremental load cancels the ongoing one.
+        @param filename File name, either .txml or .tbin.
+        @param clearScene Do we want to clear the existing scene.
+        @param useEntityIDsFromFile If true, the created entities will use the Entity IDs from the original file.
+                  If the scene contains any previous entities with conflicting IDs, those are removed. If false, the entity IDs from the files are ignored,
+                  and new IDs are generated for the created entities.
+        @param change Change type that will be used, when removing the old scene, and creating the new entities
+        @param msPerFrame Time budget for instantiating entities per frame, in milliseconds. At least one entity is created each frame.
+        @return True if the load was started. */
+    bool LoadSceneIncremental(const QString &filename, bool clearScene, bool useEntityIDsFromFile, AttributeChange::Type change, float msPerFrame = 10.f);
+
+    /// Cancels the ongoing incremental scene load. The entities created so far are kept.
+    void CancelIncrementalLoad();
+
+    /// Returns whether an incremental scene load is in progress.
+    bool IsLoadingIncrementally() const { return incrementalLoad_.active; }
+
+    /// Sets the position, f.ex. the spawn point, around which the entities of incremental scene loads are instantiated first.
+    /** If no focus is set, the position of the main camera is used if the camera is in this scene, otherwise the origin. */
+    void SetIncrementalLoadFocus(const float3 &pos);
+
+    /// Creates multiple instances of a prototype entity.
+    /** The components of the prototype are copied directly attribute by attribute to each instance, and the EntityCreated
+        and component change signals are emitted in one batch after all the instances have been created.
+        @param prototype Entity to instantiate.
+        @param count Number of instances to create.
+        @param transforms Per-instance transforms applied to the EC_Placeable of each instance. If the list has fewer items
+                  than count, the remaining instances keep the transform of the prototype.
+        @param local If true, the instances will be local entities. If false, the instances will be replicated.
+        @param temporary Will the instances be temporary.
+        @param change Change signalling mode
+        @return List of created entities. */
+    QList<Entity *> Instantiate(Entity *prototype, uint count, const QList<Transform> &transforms = QList<Transform>(),
+        bool local = false, bool temporary = false, AttributeChange::Type change = AttributeChange::Default);
+
+    /// Deactivates an entity and moves it to the entity pool, to be recycled by AcquireEntity.
+    /** The entity is not removed from the scene, so it is not replicated as a removal: its EC_Placeable is hidden instead,
+        which replicates as an attribute change. The components of the entity are notified with Entity::Deactivated, so that
+        f.ex. physics and scripts are suspended, and the attribute changes of the inactive entity are not replicated.
+        If the pool for the component signature of the entity is full, the entity is removed.
+        @param id Id of the entity.
+        @param change Change signalling mode
+        @return True if the entity was moved to the pool, false if it was removed or not found. */
+    bool ReleaseEntity(entity_id_t id, AttributeChange::Type change = AttributeChange::Default);
+
+    /// Returns an entity with the components and attribute values of a prototype entity, recycling a pooled entity if available.
+    /** A pooled entity with the same component signature is re-activated by copying only the attribute values that differ
+        from the prototype, so the re-activation replicates as changed attributes instead of an entity creation.
+        If there is no such pooled entity, a new instance is created as with Instantiate.
+        @param prototype Entity to instantiate.
+        @param local If true, the entity will be local entity. If false, the entity will be replicated.
+        @param temporary Will the entity be temporary.
+        @param change Change signalling mode
+        @return Pointer to the entity, or null pointer if the prototype is invalid. */
+    EntityPtr AcquireEntity(Entity *prototype, bool local = false, bool temporary = false, AttributeChange::Type change = AttributeChange::Default);
+
+    /// Removes all the entities held in the entity pool.
+    void ClearEntityPool(AttributeChange::Type change = AttributeChange::Default);
+
+    /// Sets the maximum number of pooled entities per component signature. The default is 256.
+    void SetEntityPoolCapacity(uint capacity) { entityPoolCapacity_ = capacity; }
+
+    /// Returns the maximum number of pooled entities per component signature.
+    uint EntityPoolCapacity() const { return entityPoolCapacity_; }
+
+    /// Returns the number of entities held in the entity pool.
+    uint PooledEntityCount() const;
 
     /// Checks whether editing an entity is allowed.
     /** Emits AboutToModifyEntity.
@@ -379,6 +605,13 @@ signals:
     /** Network synchronization managers should connect to this. */
     void AttributeChanged(IComponent* comp, IAttribute* attribute, AttributeChange::Type change);
 
+    /// Signal when one or more attributes of a component have changed during a frame.
+    /** Emitted only when the batched attribute change dispatch is enabled, once per component and change type per frame.
+        When it is disabled, the changes are signalled with AttributeChanged only.
+        Network synchronization managers should connect to this.
+        @sa SetAttributeChangeBatching */
+    void AttributesChanged(IComponent* comp, const AttributeChangeSet &changes);
+
     /// Signal when an attribute of a component has been added (dynamic structure components only)
     /** Network synchronization managers should connect to this. */
     void AttributeAdded(IComponent* comp, IAttribute* attribute, AttributeChange::Type change);
@@ -402,6 +635,32 @@ signals:
     /// Signal when an entity deleted
     void EntityRemoved(Entity* entity, AttributeChange::Type change);
 
+    /// Signal when entities of an incremental scene load have been instantiated during a frame.
+    /** @param filename File being loaded.
+        @param created Number of entities created so far.
+        @param total Total number of entities in the file.
+        @sa LoadSceneIncremental */
+    void IncrementalLoadProgress(const QString &filename, uint created, uint total);
+
+    /// Signal when an incremental scene load has finished.
+    /** @param filename File that was loaded.
+        @param created Number of entities created. */
+    void IncrementalLoadFinished(const QString &filename, uint created);
+
+    /// Signal when a background save has been written.
+    /** @param filename File that was saved.
+        @param success Whether the file was written successfully.
+        @sa SaveSceneXMLInBackground, SaveSceneBinaryInBackground */
+    void BackgroundSaveFinished(const QString &filename, bool success);
+
+    /// Signal when an entity has been deactivated and moved to the entity pool.
+    /** @sa ReleaseEntity */
+    void EntityDeactivated(Entity* entity, AttributeChange::Type change);
+
+    /// Signal when a pooled entity has been re-activated.
+    /** @sa AcquireEntity */
+    void EntityReactivated(Entity* entity, AttributeChange::Type change);
+
     /// A entity creation has been acked by the server and assigned a proper replicated ID
     void EntityAcked(Entity* entity, entity_id_t oldId);
 
@@ -430,6 +689,9 @@ private slots:
     /// Handle frame update. Signal this frame's entity creations.
     void OnUpdated(float frameTime);
 
+    /// Handle end of frame. Dispatch this frame's batched attribute changes.
+    void OnPostFrameUpdate(float frameTime);
+
 private:
     Q_DISABLE_COPY(Scene);
     friend class ::SceneAPI;
@@ -454,6 +716,75 @@ private:
         float length;
     };
 
+    /// Attribute changes of a component accumulated during a frame, when attribute change batching is enabled
+    struct PendingAttributeChanges
+    {
+        ComponentWeakPtr comp;
+        AttributeChangeSet changes;
+    };
+    typedef std::map<std::pair<IComponent*, AttributeChange::Type>, size_t> PendingAttributeChangeIndexMap;
+
+    /// State of an ongoing incremental scene load
+    struct IncrementalLoad
+    {
+        IncrementalLoad() : active(false), useEntityIDsFromFile(false), change(AttributeChange::Default), msPerFrame(10.f), next(0), created(0) {}
+
+        bool active;
+        QString filename;
+        SceneDesc desc;
+        std::vector<std::pair<int, entity_id_t> > order; ///< Index to desc.entities and the id to create the entity with, in creation order.
+        QHash<entity_id_t, entity_id_t> oldToNewIds; ///< Entity ids of the file mapped to the generated ids, if entity ids from the file are not used.
+        bool useEntityIDsFromFile;
+        AttributeChange::Type change;
+        float msPerFrame;
+        size_t next; ///< Index to order of the next entity to create.
+        uint created;
+    };
+
+    /// State of a background save. Defined in Scene.cpp.
+    struct BackgroundSave;
+
+    /// Starts writing a snapshot on a worker thread.
+    bool StartBackgroundSave(const QString &filename, const SceneSnapshotPtr &snapshot, bool binary, float regionSize);
+
+    /// Emits BackgroundSaveFinished if the background save has completed.
+    /** @param wait If true, waits for the save to complete. */
+    void FinishBackgroundSave(bool wait);
+
+    /// Creates the entities of the given entity index entries of an indexed binary scene, and signals them.
+    QList<Entity *> CreateContentFromBinaryIndex(const SceneBinaryIndex &index, const std::vector<u32> &entries, bool useEntityIDsFromFile, AttributeChange::Type change);
+
+    /// Creates an entity for an entity element of scene XML, given the id and sync attributes of the element. Emits no signals.
+    /** Used by both the DOM and the streaming variant of CreateContentFromXml.
+        @param oldToNewIds Receives the mapping from the id in the file to the new id, if a new id is generated. */
+    EntityPtr CreateEntityFromXml(const QString &idStr, const QString &replicatedStr, bool useEntityIDsFromFile, QHash<entity_id_t, entity_id_t> &oldToNewIds);
+
+    /// Creates a component of a component element of scene XML to the entity. Emits no signals.
+    void CreateComponentFromXml(Entity *entity, const QDomElement &compElement);
+
+    /// Signals the entities created from scene XML, fixing the EC_Placeable parent refs if new entity ids were generated.
+    /** @return The entities that still exist after the signals. */
+    QList<Entity *> EmitContentCreatedFromXml(const std::vector<EntityWeakPtr> &entities, bool useEntityIDsFromFile,
+        const QHash<entity_id_t, entity_id_t> &oldToNewIds, AttributeChange::Type change);
+
+    /// Creates scene description from binary scene data, f.ex. a memory-mapped file.
+    SceneDesc CreateSceneDescFromBinary(const char *data, size_t numBytes, SceneDesc &sceneDesc) const;
+
+    /// Fills the attributes of a component description and adds the asset references of the component to the scene description.
+    void FillComponentDesc(IComponent *comp, ComponentDesc &compDesc, SceneDesc &sceneDesc) const;
+
+    /// Creates an entity and its components from an entity description. Emits no signals.
+    EntityPtr CreateEntityFromDesc(const EntityDesc &desc, entity_id_t id);
+
+    /// Instantiates entities of the ongoing incremental load until the per-frame time budget is used.
+    void ProcessIncrementalLoad();
+
+    /// Pooled entities keyed by component signature
+    typedef std::map<QString, std::vector<EntityWeakPtr> > EntityPoolMap;
+
+    /// Returns the entity pool key of an entity: its replication mode and the types, names and replication modes of its components.
+    QString PoolSignature(const Entity *entity, bool replicated) const;
+
     UniqueIdGenerator idGenerator_; ///< Entity ID generator
     EntityMap entities_; ///< All entities in the scene.
     Framework *framework_; ///< Parent framework.
@@ -461,6 +792,20 @@ private:
     bool viewEnabled_; ///< View enabled -flag.
     bool interpolating_; ///< Currently doing interpolation-flag.
     bool authority_; ///< Authority -flag
-    std::vector<AttributeInterpolation> interpolations_; ///< Running attribute interpolations.
+    std::vector<AttributeInterpolation> interpolations_; ///< Running attribute interpolations of types that have no typed track.
+    AttributeInterpolationTrack<float3> float3Interpolations_; ///< Running float3 attribute interpolations.
+    AttributeInterpolationTrack<Quat> quatInterpolations_; ///< Running Quat attribute interpolations.
+    AttributeInterpolationTrack<Transform> transformInterpolations_; ///< Running Transform attribute interpolations.
     std::vector<std::pair<EntityWeakPtr, AttributeChange::Type> > entitiesCreatedThisFrame_; ///< Entities to signal for creation at frame end.
+    bool batchAttributeChanges_; ///< Batched attribute change dispatch -flag.
+    bool dispatchingAttributeChanges_; ///< Currently dispatching batched attribute changes -flag.
+    std::vector<PendingAttributeChanges> pendingAttributeChanges_; ///< Attribute changes to dispatch at frame end.
+    PendingAttributeChangeIndexMap pendingAttributeChangeIndices_; ///< Maps (component, change type) to an index in pendingAttributeChanges_.
+    EntityPoolMap entityPool_; ///< Deactivated entities waiting to be recycled.
+    IncrementalLoad incrementalLoad_; ///< Ongoing incremental scene load.
+    float3 incrementalLoadFocus_; ///< Position around which entities are instantiated first in incremental loads.
+    bool hasIncrementalLoadFocus_; ///< Has the incremental load focus been set -flag.
+    uint entityPoolCapacity_; ///< Maximum number of pooled entities per component signature.
+    mutable SceneSnapshotCache snapshotCache_; ///< Component snapshots shared between consecutive scene snapshots.
+    boost::shared_ptr<BackgroundSave> backgroundSave_; ///< Background save in progress.
 };
@@ -19,10 +19,13 @@
 #include "Math/float3.h"
 #include "Math/float4.h"
 #include "Transform.h"
+
+#include <QPoint>
+
 #include "MemoryLeakCheck.h"
 
 QStringList SceneAPI::attributeTypeNames(QStringList() << "string" << "int" << "real" << "color" << "float2" << "float3" << "float4" << "bool" << "uint" << "quat" <<
-        "assetreference" << "assetreferencelist" << "entityreference" << "qvariant" << "qvariantlist" << "transform");
+        "assetreference" << "assetreferencelist" << "entityreference" << "qvariant" << "qvariantlist" << "transform" << "qpoint");
 
 SceneAPI::SceneAPI(Framework *owner) :
     QObject(owner),
@@ -253,6 +256,8 @@ IAttribute* SceneAPI::CreateAttribute(u32 attributeTypeid, const QString& newAtt
         attribute = new Attribute<QVariantList>(0, newAttributeName.toStdString().c_str());
     else if (attributeTypeid == cAttributeTransform)
         attribute = new Attribute<Transform>(0, newAttributeName.toStdString().c_str());
+    else if (attributeTypeid == cAttributeQPoint)
+        attribute = new Attribute<QPoint>(0, newAttributeName.toStdString().c_str());
     else
         LogError("Cannot create attribute of type \"" + QString::number(attributeTypeid) + "\"! This type is not known to SceneAPI::CreateAttribute!");
     if (attribute)
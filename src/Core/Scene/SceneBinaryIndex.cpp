@@ -0,0 +1,162 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "SceneBinaryIndex.h"
+#include "IComponent.h"
+#include "LoggingFunctions.h"
+
+#include <kNet/DataDeserializer.h>
+#include <kNet/DataSerializer.h>
+
+#include <cmath>
+#include <algorithm>
+
+#include "MemoryLeakCheck.h"
+
+using namespace kNet;
+
+SceneBinaryIndex::SceneBinaryIndex(const char *data, size_t size) :
+    data_(data),
+    size_(size),
+    valid_(false),
+    regionSize_(0.f)
+{
+    if (!IsIndexed(data, size))
+        return;
+
+    try
+    {
+        DataDeserializer header(data, cHeaderSize);
+        header.Read<u32>(); // Magic
+        u32 version = header.Read<u32>();
+        if (version != cVersion)
+        {
+            LogError("SceneBinaryIndex: Unsupported binary scene version " + QString::number(version) + ".");
+            return;
+        }
+        u32 numEntities = header.Read<u32>();
+        u32 stringTableOffset = header.Read<u32>();
+        u32 indexOffset = header.Read<u32>();
+        u32 regionTableOffset = header.Read<u32>();
+        u32 numRegions = header.Read<u32>();
+        regionSize_ = header.Read<float>();
+
+        if (stringTableOffset >= size || indexOffset + (u64)numEntities * cIndexEntrySize > size ||
+            regionTableOffset + (u64)numRegions * cRegionEntrySize > size)
+        {
+            LogError("SceneBinaryIndex: Binary scene header refers past the end of the data.");
+            return;
+        }
+
+        DataDeserializer strings(data + stringTableOffset, size - stringTableOffset);
+        u32 numStrings = strings.Read<u32>();
+        strings_.reserve(numStrings);
+        for(u32 i = 0; i < numStrings; ++i)
+            strings_.push_back(ReadString(strings));
+
+        DataDeserializer index(data + indexOffset, numEntities * cIndexEntrySize);
+        entries_.resize(numEntities);
+        for(u32 i = 0; i < numEntities; ++i)
+        {
+            entries_[i].id = index.Read<u32>();
+            entries_[i].offset = index.Read<u32>();
+            entries_[i].size = index.Read<u32>();
+            if ((u64)entries_[i].offset + entries_[i].size > size)
+            {
+                LogError("SceneBinaryIndex: Entity record " + QString::number(entries_[i].id) + " extends past the end of the data.");
+                return;
+            }
+        }
+
+        sortedIds_.resize(numEntities);
+        for(u32 i = 0; i < numEntities; ++i)
+            sortedIds_[i] = std::make_pair(entries_[i].id, i);
+        std::sort(sortedIds_.begin(), sortedIds_.end());
+
+        DataDeserializer regionTable(data + regionTableOffset, numRegions * cRegionEntrySize);
+        regions_.resize(numRegions);
+        for(u32 i = 0; i < numRegions; ++i)
+        {
+            regions_[i].x = regionTable.Read<s32>();
+            regions_[i].y = regionTable.Read<s32>();
+            regions_[i].z = regionTable.Read<s32>();
+            regions_[i].firstEntry = regionTable.Read<u32>();
+            regions_[i].numEntries = regionTable.Read<u32>();
+            if ((u64)regions_[i].firstEntry + regions_[i].numEntries > numEntities)
+            {
+                LogError("SceneBinaryIndex: Region table refers to nonexistent entities.");
+                return;
+            }
+        }
+    }
+    catch(...)
+    {
+        LogError("SceneBinaryIndex: Failed to read binary scene index.");
+        return;
+    }
+
+    valid_ = true;
+}
+
+bool SceneBinaryIndex::IsIndexed(const char *data, size_t size)
+{
+    if (!data || size < cHeaderSize)
+        return false;
+    DataDeserializer header(data, cHeaderSize);
+    return header.Read<u32>() == cMagic;
+}
+
+void SceneBinaryIndex::AppendString(QByteArray &bytes, const QString &str)
+{
+    QByteArray utf8 = str.toUtf8().left(0xFFFF);
+    AppendValue<u16>(bytes, (u16)utf8.size());
+    bytes.append(utf8);
+}
+
+QString SceneBinaryIndex::ReadString(DataDeserializer &source)
+{
+    u16 length = source.Read<u16>();
+    QByteArray utf8(length, 0);
+    if (length)
+        source.ReadArray<u8>((u8*)utf8.data(), length);
+    return QString::fromUtf8(utf8.data(), utf8.size());
+}
+
+QByteArray SceneBinaryIndex::ComponentData(const IComponent &comp)
+{
+    // Assume 64KB max per component for now
+    QByteArray bytes(64 * 1024, 0);
+    DataSerializer dest(bytes.data(), bytes.size());
+    comp.SerializeToBinary(dest);
+    return bytes.left((int)dest.BytesFilled());
+}
+
+int SceneBinaryIndex::FindEntry(entity_id_t id) const
+{
+    std::vector<std::pair<entity_id_t, u32> >::const_iterator iter = std::lower_bound(sortedIds_.begin(), sortedIds_.end(), std::make_pair(id, (u32)0));
+    if (iter != sortedIds_.end() && iter->first == id)
+        return (int)iter->second;
+    return -1;
+}
+
+std::vector<u32> SceneBinaryIndex::EntriesInBox(const float3 &minPos, const float3 &maxPos) const
+{
+    std::vector<u32> ret;
+    if (regionSize_ <= 0.f)
+        return ret;
+
+    const int minX = (int)floor(minPos.x / regionSize_), maxX = (int)floor(maxPos.x / regionSize_);
+    const int minY = (int)floor(minPos.y / regionSize_), maxY = (int)floor(maxPos.y / regionSize_);
+    const int minZ = (int)floor(minPos.z / regionSize_), maxZ = (int)floor(maxPos.z / regionSize_);
+    for(size_t i = 0; i < regions_.size(); ++i)
+    {
+        const Region &r = regions_[i];
+        if (r.x < minX || r.x > maxX || r.y < minY || r.y > maxY || r.z < minZ || r.z > maxZ)
+            continue;
+        for(u32 j = 0; j < r.numEntries; ++j)
+            ret.push_back(r.firstEntry + j);
+    }
+    return ret;
+}
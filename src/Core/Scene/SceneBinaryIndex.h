@@ -0,0 +1,123 @@
+/**
+    For conditions of distribution and use, see copyright notice in LICENSE
+
+    @file   SceneBinaryIndex.h
+    @brief  Read-only view of the indexed binary scene format (.tbin version 2). */
+
+#pragma once
+
+#include "SceneFwd.h"
+#include "CoreTypes.h"
+#include "Math/float3.h"
+
+#include <QString>
+#include <QByteArray>
+
+#include <vector>
+
+namespace kNet { class DataDeserializer; }
+
+/// Read-only view of a scene stored in the indexed binary scene format (.tbin version 2).
+/** The view does not copy the scene data, so it can be used directly on a memory-mapped file. Single entities can be
+    decoded from their offsets in the entity index without reading the rest of the file.
+
+    File layout, all values in the byte order of the host that wrote the file, as written by kNet::DataSerializer.
+    All the supported platforms are little-endian. A file written on a host of the other byte order is rejected,
+    as its magic number does not match.
+    - Header: u32 magic, u32 version, u32 entity count, u32 string table offset, u32 entity index offset,
+      u32 region table offset, u32 region count and f32 region size.
+    - String table: u32 string count, followed by the strings, each an u16 byte length followed by the UTF-8 bytes.
+      Component type names and component names are stored in the string table only once.
+    - Entity records: u32 entity id, u8 replicated, u32 component count, and for each component u32 type name string index,
+      u32 name string index, u8 replicated, u32 data size and the binary data of the component.
+    - Entity index: for each entity u32 entity id, u32 record offset and u32 record size.
+    - Region table: for each region i32 cell x, y and z, u32 index of the first entity index entry and u32 entity count.
+      The entities of a region are stored contiguously. Entities without a position are not in any region,
+      and are stored before the regions.
+
+    Version 1 files have no header and consist of the entity count followed by the entities as written by Entity::SerializeToBinary. */
+class SceneBinaryIndex
+{
+public:
+    static const u32 cMagic = 0x324E4254; ///< "TBN2"
+    static const u32 cVersion = 2;
+    static const u32 cHeaderSize = 32;
+    static const u32 cIndexEntrySize = 12;
+    static const u32 cRegionEntrySize = 20;
+
+    /// Entry of the entity index
+    struct Entry
+    {
+        entity_id_t id;
+        u32 offset; ///< Offset of the entity record from the beginning of the data.
+        u32 size; ///< Size of the entity record in bytes.
+    };
+
+    /// Entry of the region table
+    struct Region
+    {
+        int x, y, z; ///< Region cell coordinates: the region spans [x, x+1) * RegionSize() on the x axis etc.
+        u32 firstEntry; ///< Index of the first entity index entry of the region.
+        u32 numEntries; ///< Number of entities in the region.
+    };
+
+    /// Parses the header, string table, entity index and region table of the data. The data must outlive this object.
+    /** @param data Scene data, f.ex. a memory-mapped file.
+        @param size Size of the data in bytes. */
+    SceneBinaryIndex(const char *data, size_t size);
+
+    /// Returns whether the data begins with the header of the indexed format.
+    static bool IsIndexed(const char *data, size_t size);
+
+    /// Appends a value to a byte array in the byte order of the host, like kNet::DataSerializer does.
+    template<typename T>
+    static void AppendValue(QByteArray &bytes, T value) { bytes.append(reinterpret_cast<const char *>(&value), sizeof(T)); }
+
+    /// Appends a string as an u16 byte length and the UTF-8 bytes, like the strings of the string table are stored.
+    static void AppendString(QByteArray &bytes, const QString &str);
+
+    /// Reads a string written by AppendString.
+    static QString ReadString(kNet::DataDeserializer &source);
+
+    /// Returns the data written by IComponent::SerializeToBinary of a component, as stored in the entity records.
+    static QByteArray ComponentData(const IComponent &comp);
+
+    /// Returns whether the data was parsed successfully.
+    bool IsValid() const { return valid_; }
+
+    /// Returns number of entities.
+    u32 NumEntities() const { return (u32)entries_.size(); }
+
+    /// Returns entity index entry.
+    /** @param index Index of the entry, [0, NumEntities()-1]. */
+    const Entry &EntryAt(u32 index) const { return entries_[index]; }
+
+    /// Returns index of the entity index entry of an entity, or -1 if not found.
+    /** Binary search in the entity ids, which are sorted when the index is parsed. */
+    int FindEntry(entity_id_t id) const;
+
+    /// Returns the entity record of an index entry.
+    const char *Record(const Entry &entry) const { return data_ + entry.offset; }
+
+    /// Returns string from the string table, or empty string if the index is out of range.
+    QString String(u32 index) const { return index < strings_.size() ? strings_[index] : QString(); }
+
+    /// Returns size of a region cell edge, or 0 if the scene is not divided into regions.
+    float RegionSize() const { return regionSize_; }
+
+    /// Returns the regions.
+    const std::vector<Region> &Regions() const { return regions_; }
+
+    /// Returns indices of the entity index entries of the entities in the regions that intersect an axis-aligned box.
+    std::vector<u32> EntriesInBox(const float3 &minPos, const float3 &maxPos) const;
+
+private:
+    const char *data_;
+    size_t size_;
+    bool valid_;
+    float regionSize_;
+    std::vector<QString> strings_;
+    std::vector<Entry> entries_;
+    std::vector<std::pair<entity_id_t, u32> > sortedIds_; ///< Entity ids and their entry indices, sorted by id.
+    std::vector<Region> regions_;
+};
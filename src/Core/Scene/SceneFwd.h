@@ -20,6 +20,7 @@ class IComponentFactory;
 class IAttribute;
 class AttributeMetadata;
 class ChangeRequest;
+class SceneSnapshot;
 
 struct SceneDesc;
 struct EntityDesc;
@@ -38,3 +39,4 @@ typedef boost::weak_ptr<IComponent> ComponentWeakPtr;
 typedef boost::shared_ptr<IComponentFactory> ComponentFactoryPtr;
 typedef std::vector<IAttribute*> AttributeVector;
 typedef std::map<QString, ScenePtr> SceneMap;
+typedef boost::shared_ptr<const SceneSnapshot> SceneSnapshotPtr;
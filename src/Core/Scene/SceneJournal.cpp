@@ -0,0 +1,498 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "SceneJournal.h"
+#include "Scene.h"
+#include "SceneBinaryIndex.h"
+#include "Entity.h"
+#include "IComponent.h"
+#include "AttributeChangeSet.h"
+#include "Framework.h"
+#include "FrameAPI.h"
+#include "Profiler.h"
+#include "LoggingFunctions.h"
+
+#include <kNet/DataDeserializer.h>
+
+#include "MemoryLeakCheck.h"
+
+using namespace kNet;
+
+/// Appends the type name, name, replication mode and binary data of a component.
+static void AppendComponent(QByteArray &bytes, IComponent *comp)
+{
+    SceneBinaryIndex::AppendString(bytes, comp->TypeName());
+    SceneBinaryIndex::AppendString(bytes, comp->Name());
+    SceneBinaryIndex::AppendValue<u8>(bytes, comp->IsReplicated() ? 1 : 0);
+    QByteArray data = SceneBinaryIndex::ComponentData(*comp);
+    SceneBinaryIndex::AppendValue<u32>(bytes, (u32)data.size());
+    bytes.append(data);
+}
+
+/// Appends a record with the given type and payload.
+static void AppendRecord(QByteArray &bytes, SceneJournal::RecordType type, const QByteArray &payload)
+{
+    SceneBinaryIndex::AppendValue<u8>(bytes, (u8)type);
+    SceneBinaryIndex::AppendValue<u32>(bytes, (u32)payload.size());
+    bytes.append(payload);
+}
+
+/// Returns whether an entity is persisted.
+static bool IsPersisted(const Entity *entity)
+{
+    return entity && entity->IsActive() && !entity->IsLocal() && !entity->IsTemporary();
+}
+
+/// Reads a component written by AppendComponent and applies it to an entity, creating the component if necessary.
+/** @return Type name and name of the component. */
+static std::pair<QString, QString> ReadComponent(DataDeserializer &source, Entity *entity, AttributeChange::Type change)
+{
+    QString typeName = SceneBinaryIndex::ReadString(source);
+    QString name = SceneBinaryIndex::ReadString(source);
+    bool replicated = source.Read<u8>() != 0;
+    u32 size = source.Read<u32>();
+    QByteArray data(size, 0);
+    if (size)
+        source.ReadArray<u8>((u8*)data.data(), size);
+
+    ComponentPtr comp = entity->GetOrCreateComponent(typeName, name, change, replicated);
+    if (comp)
+    {
+        DataDeserializer compSource(data.data(), data.size());
+        comp->DeserializeFromBinary(compSource, change);
+    }
+    else
+        LogError("SceneJournal: Failed to create component " + typeName + " for entity " + QString::number(entity->Id()) + ".");
+    return std::make_pair(typeName, name);
+}
+
+SceneJournal::SceneJournal(const ScenePtr &scene, const QString &snapshotFile) :
+    scene_(scene),
+    snapshotFile_(snapshotFile),
+    compactionThreshold_(16 * 1024 * 1024),
+    compacting_(false),
+    compactPending_(false),
+    replaying_(false)
+{
+    Scene *s = scene.get();
+    connect(s, SIGNAL(EntityCreated(Entity *, AttributeChange::Type)), SLOT(OnEntityChanged(Entity *, AttributeChange::Type)));
+    connect(s, SIGNAL(EntityRemoved(Entity *, AttributeChange::Type)), SLOT(OnEntityChanged(Entity *, AttributeChange::Type)));
+    connect(s, SIGNAL(EntityDeactivated(Entity *, AttributeChange::Type)), SLOT(OnEntityChanged(Entity *, AttributeChange::Type)));
+    connect(s, SIGNAL(EntityReactivated(Entity *, AttributeChange::Type)), SLOT(OnEntityChanged(Entity *, AttributeChange::Type)));
+    connect(s, SIGNAL(ComponentAdded(Entity *, IComponent *, AttributeChange::Type)), SLOT(OnComponentChanged(Entity *, IComponent *, AttributeChange::Type)));
+    connect(s, SIGNAL(ComponentRemoved(Entity *, IComponent *, AttributeChange::Type)), SLOT(OnComponentChanged(Entity *, IComponent *, AttributeChange::Type)));
+    connect(s, SIGNAL(AttributeChanged(IComponent *, IAttribute *, AttributeChange::Type)), SLOT(OnAttributeChanged(IComponent *, IAttribute *, AttributeChange::Type)));
+    connect(s, SIGNAL(AttributeAdded(IComponent *, IAttribute *, AttributeChange::Type)), SLOT(OnAttributeChanged(IComponent *, IAttribute *, AttributeChange::Type)));
+    connect(s, SIGNAL(AttributeRemoved(IComponent *, IAttribute *, AttributeChange::Type)), SLOT(OnAttributeChanged(IComponent *, IAttribute *, AttributeChange::Type)));
+    connect(s, SIGNAL(AttributesChanged(IComponent *, const AttributeChangeSet &)), SLOT(OnAttributesChanged(IComponent *, const AttributeChangeSet &)));
+    connect(s, SIGNAL(BackgroundSaveFinished(const QString &, bool)), SLOT(OnBackgroundSaveFinished(const QString &, bool)));
+    // Connected after the scene, so that the batched attribute changes of the frame have been dispatched when flushing
+    connect(s->GetFramework()->Frame(), SIGNAL(PostFrameUpdate(float)), SLOT(OnPostFrameUpdate(float)));
+
+    journal_.setFileName(JournalFile());
+}
+
+SceneJournal::~SceneJournal()
+{
+    Flush();
+    // Let an ongoing compaction finish, so that its result is not left half-applied
+    ScenePtr scene = scene_.lock();
+    if (scene && compacting_)
+        scene->WaitForBackgroundSave();
+    journal_.close();
+}
+
+bool SceneJournal::HasPersistedState(const QString &snapshotFile)
+{
+    return QFile::exists(snapshotFile) || QFile::exists(snapshotFile + ".tmp") || QFile::exists(snapshotFile + ".journal") ||
+        QFile::exists(snapshotFile + ".journal.old");
+}
+
+int SceneJournal::Recover()
+{
+    PROFILE(SceneJournal_Recover);
+
+    ScenePtr scene = scene_.lock();
+    if (!scene)
+        return -1;
+    if (compacting_)
+        scene->WaitForBackgroundSave();
+    journal_.close();
+    pending_.clear();
+
+    // If a compaction was interrupted after removing the old snapshot, the temporary snapshot is complete. Otherwise it may be partial.
+    QString snapshotFile = snapshotFile_;
+    if (!QFile::exists(snapshotFile_) && QFile::exists(TempSnapshotFile()))
+        snapshotFile = TempSnapshotFile();
+
+    // The snapshot and the journal are applied locally, and the recovered state is synced once afterwards, instead of replicating
+    // every intermediate state of the entities in the journal.
+    replaying_ = true;
+    scene->RemoveAllEntities(true, AttributeChange::Replicate);
+    if (QFile::exists(snapshotFile))
+        scene->LoadSceneBinary(snapshotFile, false, true, AttributeChange::LocalOnly);
+    // The changes made before an interrupted compaction are older than the ones in the current journal
+    int records = Replay(OldJournalFile()) + Replay(JournalFile());
+    scene->FlushAttributeChanges();
+    persisted_.clear();
+    Scene::EntityMap entities = scene->Entities(); // Copy, as the handlers of the signals may modify the scene
+    for(Scene::EntityMap::const_iterator iter = entities.begin(); iter != entities.end(); ++iter)
+    {
+        if (IsPersisted(iter->second.get()))
+            persisted_.insert(iter->first);
+        if (!iter->second->IsLocal())
+            scene->EmitEntityCreated(iter->second.get(), AttributeChange::Replicate);
+    }
+    replaying_ = false;
+    pending_.clear();
+
+    // Fold the recovered state into a new snapshot
+    if (!scene->SaveSceneBinary(TempSnapshotFile(), false, false))
+    {
+        LogError("SceneJournal::Recover: Failed to write the recovered scene to " + TempSnapshotFile() + ".");
+        OpenJournal(false);
+        return -1;
+    }
+    QFile::remove(snapshotFile_);
+    if (!QFile::rename(TempSnapshotFile(), snapshotFile_))
+    {
+        LogError("SceneJournal::Recover: Failed to rename " + TempSnapshotFile() + " to " + snapshotFile_ + ".");
+        OpenJournal(false);
+        return -1;
+    }
+    QFile::remove(OldJournalFile());
+    OpenJournal(true);
+
+    LogInfo("SceneJournal: Recovered scene from " + snapshotFile + " and " + QString::number(records) + " journal records.");
+    return records;
+}
+
+void SceneJournal::Flush()
+{
+    if (pending_.empty())
+        return;
+
+    PROFILE(SceneJournal_Flush);
+
+    ScenePtr scene = scene_.lock();
+    if (!scene)
+    {
+        pending_.clear();
+        return;
+    }
+
+    // Write the current state of everything that changed, so the order of the changes during the frame does not matter.
+    QByteArray bytes;
+    for(std::map<entity_id_t, PendingEntity>::const_iterator iter = pending_.begin(); iter != pending_.end(); ++iter)
+    {
+        EntityPtr entity = scene->EntityById(iter->first);
+        QByteArray payload;
+        SceneBinaryIndex::AppendValue<u32>(payload, iter->first);
+        if (!IsPersisted(entity.get()))
+        {
+            // Local and temporary entities are never persisted, so only record the removal of an entity that was.
+            if (persisted_.erase(iter->first))
+                AppendRecord(bytes, EntityRemove, payload);
+            continue;
+        }
+        persisted_.insert(iter->first);
+
+        if (iter->second.full)
+        {
+            std::vector<IComponent *> components;
+            const Entity::ComponentMap &comps = entity->Components();
+            for(Entity::ComponentMap::const_iterator i = comps.begin(); i != comps.end(); ++i)
+                if (!i->second->IsTemporary())
+                    components.push_back(i->second.get());
+
+            SceneBinaryIndex::AppendValue<u8>(payload, entity->IsReplicated() ? 1 : 0);
+            SceneBinaryIndex::AppendValue<u32>(payload, (u32)components.size());
+            for(size_t i = 0; i < components.size(); ++i)
+                AppendComponent(payload, components[i]);
+            AppendRecord(bytes, EntityUpsert, payload);
+            continue;
+        }
+
+        for(std::set<std::pair<QString, QString> >::const_iterator i = iter->second.components.begin(); i != iter->second.components.end(); ++i)
+        {
+            QByteArray compPayload = payload;
+            ComponentPtr comp = entity->GetComponent(i->first, i->second);
+            if (comp && !comp->IsTemporary())
+            {
+                SceneBinaryIndex::AppendValue<u8>(compPayload, entity->IsReplicated() ? 1 : 0);
+                AppendComponent(compPayload, comp.get());
+                AppendRecord(bytes, ComponentUpsert, compPayload);
+            }
+            else
+            {
+                SceneBinaryIndex::AppendString(compPayload, i->first);
+                SceneBinaryIndex::AppendString(compPayload, i->second);
+                AppendRecord(bytes, ComponentRemove, compPayload);
+            }
+        }
+    }
+    pending_.clear();
+
+    if (bytes.isEmpty() || (!journal_.isOpen() && !OpenJournal(false)))
+        return;
+    // The records must be on the disk before the frame ends, or a crash of the machine would lose them.
+    if (journal_.write(bytes) != bytes.size() || !SceneSnapshot::FlushToDisk(journal_))
+        LogError("SceneJournal: Failed to write to " + JournalFile() + ".");
+
+    if (compactionThreshold_ > 0 && !compacting_ && journal_.size() > compactionThreshold_)
+        Compact();
+}
+
+bool SceneJournal::Compact()
+{
+    ScenePtr scene = scene_.lock();
+    if (!scene || compacting_)
+        return false;
+    // A snapshot taken during an incremental load would miss most of the scene, and only one background save can be in progress.
+    // Compact when the scene is idle again.
+    if (scene->IsLoadingIncrementally() || scene->IsSavingInBackground())
+    {
+        compactPending_ = true;
+        return false;
+    }
+    compactPending_ = false;
+
+    Flush();
+
+    // Keep the journal until the new snapshot has replaced the old one. Changes made from now on go to a new journal.
+    journal_.close();
+    if (QFile::exists(JournalFile()))
+    {
+        QFile::remove(OldJournalFile());
+        if (!QFile::rename(JournalFile(), OldJournalFile()))
+        {
+            LogError("SceneJournal::Compact: Failed to rename " + JournalFile() + " to " + OldJournalFile() + ".");
+            OpenJournal(false);
+            return false;
+        }
+    }
+    OpenJournal(true);
+
+    compacting_ = scene->SaveSceneBinaryInBackground(TempSnapshotFile(), false, false);
+    if (!compacting_)
+    {
+        RestoreOldJournal();
+        return false;
+    }
+
+    // The snapshot has all the persisted entities, so the journal needs to record the removal of any of them.
+    persisted_.clear();
+    for(Scene::const_iterator iter = scene->begin(); iter != scene->end(); ++iter)
+        if (IsPersisted(iter->second.get()))
+            persisted_.insert(iter->first);
+    return true;
+}
+
+void SceneJournal::OnBackgroundSaveFinished(const QString &filename, bool success)
+{
+    if (!compacting_ || filename != TempSnapshotFile())
+        return;
+    compacting_ = false;
+
+    if (success)
+    {
+        QFile::remove(snapshotFile_);
+        if (QFile::rename(TempSnapshotFile(), snapshotFile_))
+        {
+            QFile::remove(OldJournalFile());
+            emit Compacted(snapshotFile_);
+            return;
+        }
+        LogError("SceneJournal: Failed to rename " + TempSnapshotFile() + " to " + snapshotFile_ + ".");
+    }
+    else
+        LogError("SceneJournal: Failed to write snapshot " + TempSnapshotFile() + ".");
+    RestoreOldJournal();
+}
+
+bool SceneJournal::OpenJournal(bool truncate)
+{
+    journal_.close();
+    QIODevice::OpenMode mode = QIODevice::WriteOnly | (truncate ? QIODevice::Truncate : QIODevice::Append);
+    if (!journal_.open(mode))
+    {
+        LogError("SceneJournal: Failed to open " + JournalFile() + " for writing.");
+        return false;
+    }
+    if (journal_.size() == 0)
+    {
+        QByteArray header;
+        SceneBinaryIndex::AppendValue<u32>(header, cMagic);
+        SceneBinaryIndex::AppendValue<u32>(header, cVersion);
+        journal_.write(header);
+        SceneSnapshot::FlushToDisk(journal_);
+    }
+    return true;
+}
+
+void SceneJournal::RestoreOldJournal()
+{
+    if (!QFile::exists(OldJournalFile()))
+        return;
+
+    journal_.close();
+    QByteArray records;
+    QFile current(JournalFile());
+    if (current.open(QIODevice::ReadOnly))
+    {
+        records = current.readAll().mid(2 * sizeof(u32));
+        current.close();
+    }
+    QFile old(OldJournalFile());
+    if (!old.open(QIODevice::WriteOnly | QIODevice::Append) || old.write(records) != records.size() || !SceneSnapshot::FlushToDisk(old))
+    {
+        LogError("SceneJournal: Failed to restore " + OldJournalFile() + ".");
+        OpenJournal(false);
+        return;
+    }
+    old.close();
+    QFile::remove(JournalFile());
+    QFile::rename(OldJournalFile(), JournalFile());
+    OpenJournal(false);
+}
+
+int SceneJournal::Replay(const QString &filename)
+{
+    ScenePtr scene = scene_.lock();
+    QFile file(filename);
+    if (!scene || !file.open(QIODevice::ReadOnly))
+        return 0;
+    QByteArray data = file.readAll();
+    file.close();
+
+    const AttributeChange::Type change = AttributeChange::LocalOnly;
+    int records = 0;
+    size_t pos = 0;
+    try
+    {
+        if ((size_t)data.size() < 2 * sizeof(u32))
+            return 0;
+        DataDeserializer header(data.data(), 2 * sizeof(u32));
+        if (header.Read<u32>() != cMagic || header.Read<u32>() != cVersion)
+        {
+            LogError("SceneJournal: " + filename + " is not a supported scene journal.");
+            return 0;
+        }
+        pos = 2 * sizeof(u32);
+
+        const size_t recordHeaderSize = sizeof(u8) + sizeof(u32);
+        while(pos + recordHeaderSize <= (size_t)data.size())
+        {
+            DataDeserializer recordHeader(data.data() + pos, recordHeaderSize);
+            u8 type = recordHeader.Read<u8>();
+            u32 size = recordHeader.Read<u32>();
+            if (pos + recordHeaderSize + size > (size_t)data.size())
+                break; // The last record was written only partially
+            DataDeserializer source(data.data() + pos + recordHeaderSize, size);
+            pos += recordHeaderSize + size;
+
+            entity_id_t id = source.Read<u32>();
+            EntityPtr entity = scene->EntityById(id);
+            switch(type)
+            {
+            case EntityUpsert:
+            case ComponentUpsert:
+            {
+                bool replicated = source.Read<u8>() != 0;
+                bool created = false;
+                if (!entity)
+                {
+                    entity = scene->CreateEntity(id, QStringList(), change, replicated);
+                    created = true;
+                }
+                if (!entity)
+                {
+                    LogError("SceneJournal: Failed to create entity " + QString::number(id) + ".");
+                    break;
+                }
+                if (type == EntityUpsert)
+                {
+                    // The record has all the components of the entity, so remove the ones not in it
+                    std::set<std::pair<QString, QString> > components;
+                    u32 numComponents = source.Read<u32>();
+                    for(u32 i = 0; i < numComponents; ++i)
+                        components.insert(ReadComponent(source, entity.get(), change));
+                    std::vector<ComponentPtr> removed;
+                    const Entity::ComponentMap &comps = entity->Components();
+                    for(Entity::ComponentMap::const_iterator i = comps.begin(); i != comps.end(); ++i)
+                        if (!i->second->IsTemporary() && components.find(std::make_pair(i->second->TypeName(), i->second->Name())) == components.end())
+                            removed.push_back(i->second);
+                    for(size_t i = 0; i < removed.size(); ++i)
+                        entity->RemoveComponent(removed[i], change);
+                }
+                else
+                    ReadComponent(source, entity.get(), change);
+                if (created)
+                    scene->EmitEntityCreated(entity.get(), change);
+                break;
+            }
+            case EntityRemove:
+                if (entity)
+                    scene->RemoveEntity(id, change);
+                break;
+            case ComponentRemove:
+            {
+                QString typeName = SceneBinaryIndex::ReadString(source);
+                QString name = SceneBinaryIndex::ReadString(source);
+                if (entity)
+                    entity->RemoveComponent(typeName, name, change);
+                break;
+            }
+            default:
+                LogWarning("SceneJournal: Skipping unknown record type " + QString::number(type) + " in " + filename + ".");
+                break;
+            }
+            ++records;
+        }
+    }
+    catch(...)
+    {
+        LogError("SceneJournal: Failed to read " + filename + " at offset " + QString::number(pos) + ", ignoring the rest of the journal.");
+    }
+    return records;
+}
+
+void SceneJournal::MarkComponent(Entity *entity, IComponent *comp)
+{
+    if (replaying_ || !entity || !comp)
+        return;
+    pending_[entity->Id()].components.insert(std::make_pair(comp->TypeName(), comp->Name()));
+}
+
+void SceneJournal::OnEntityChanged(Entity *entity, AttributeChange::Type /*change*/)
+{
+    if (replaying_ || !entity)
+        return;
+    pending_[entity->Id()].full = true;
+}
+
+void SceneJournal::OnComponentChanged(Entity *entity, IComponent *comp, AttributeChange::Type /*change*/)
+{
+    MarkComponent(entity, comp);
+}
+
+void SceneJournal::OnAttributeChanged(IComponent *comp, IAttribute * /*attribute*/, AttributeChange::Type /*change*/)
+{
+    if (comp)
+        MarkComponent(comp->ParentEntity(), comp);
+}
+
+void SceneJournal::OnAttributesChanged(IComponent *comp, const AttributeChangeSet & /*changes*/)
+{
+    if (comp)
+        MarkComponent(comp->ParentEntity(), comp);
+}
+
+void SceneJournal::OnPostFrameUpdate(float /*frameTime*/)
+{
+    Flush();
+    if (compactPending_)
+        Compact();
+}
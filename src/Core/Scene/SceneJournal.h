@@ -0,0 +1,153 @@
+/**
+    For conditions of distribution and use, see copyright notice in LICENSE
+
+    @file   SceneJournal.h
+    @brief  Append-only change journal for incremental scene persistence. */
+
+#pragma once
+
+#include "SceneFwd.h"
+#include "CoreTypes.h"
+#include "AttributeChangeType.h"
+
+#include <QObject>
+#include <QFile>
+#include <QString>
+
+#include <map>
+#include <set>
+
+struct AttributeChangeSet;
+
+/// Persists a scene incrementally as a binary scene snapshot and an append-only journal of the changes made after it.
+/** The journal listens to the entity, component and attribute change signals of the scene and, at the end of each frame,
+    appends the current state of each entity and component that changed during the frame, and flushes the journal to the disk.
+    The cost of persisting is thus proportional to the rate of change instead of the size of the scene. When the journal grows larger than the compaction
+    threshold, the scene is compacted: a new snapshot is written on a worker thread, after which the old journal is discarded.
+
+    After a crash, Recover loads the last snapshot and replays the journal on top of it. The journal records contain the full state
+    of an entity or a component rather than deltas, so replaying a record more than once is harmless, and a partially written
+    last record is ignored.
+
+    Like SaveSceneBinary with default parameters, local and temporary entities and temporary components are not persisted.
+    Changes made with AttributeChange::Disconnected are not signalled, and are persisted only with the next change of the component
+    or the next compaction.
+
+    Files, for a snapshot file name "scene.tbin":
+    - scene.tbin: The last snapshot, in the indexed binary scene format.
+    - scene.tbin.journal: Changes made after the last snapshot.
+    - scene.tbin.journal.old: Changes made before the snapshot being written by an ongoing compaction.
+    - scene.tbin.tmp: The snapshot being written by an ongoing compaction.
+
+    Journal file layout, all values little-endian: u32 magic, u32 version, followed by the records. Each record is an u8 record type,
+    u32 payload size and the payload. Strings are stored as an u16 byte length followed by the UTF-8 bytes, and components as
+    type name string, name string, u8 replicated, u32 data size and the data written by IComponent::SerializeToBinary.
+    - EntityUpsert: u32 entity id, u8 replicated, u32 component count and the components.
+    - EntityRemove: u32 entity id.
+    - ComponentUpsert: u32 entity id, u8 entity replicated and the component.
+    - ComponentRemove: u32 entity id, type name string and name string. */
+class SceneJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const u32 cMagic = 0x4C4E4A54; ///< "TJNL"
+    static const u32 cVersion = 1;
+
+    /// Journal record types
+    enum RecordType
+    {
+        EntityUpsert = 1,
+        EntityRemove,
+        ComponentUpsert,
+        ComponentRemove
+    };
+
+    /// Starts journaling the changes of a scene.
+    /** If there is a snapshot or a journal from an earlier run, call Recover to restore the scene from them. Otherwise call Compact
+        to write the initial snapshot.
+        @param scene Scene to persist.
+        @param snapshotFile File name of the binary snapshot. The other files are named after it. */
+    SceneJournal(const ScenePtr &scene, const QString &snapshotFile);
+    ~SceneJournal();
+
+    /// Returns whether a snapshot or a journal exists from an earlier run.
+    bool HasPersistedState() const { return HasPersistedState(snapshotFile_); }
+
+    /// Returns whether a snapshot or a journal exists for a snapshot file name.
+    static bool HasPersistedState(const QString &snapshotFile);
+
+    /// Returns the size of the journal in bytes above which the scene is compacted.
+    qint64 CompactionThreshold() const { return compactionThreshold_; }
+
+    /// Returns whether a compaction is in progress.
+    bool IsCompacting() const { return compacting_; }
+
+public slots:
+    /// Replaces the contents of the scene with the last snapshot, and replays the journal on top of it.
+    /** The snapshot and the journal are applied with AttributeChange::LocalOnly, after which the recovered entities are signalled
+        created once with AttributeChange::Replicate. The recovered state is then written synchronously as a new snapshot,
+        and the journals are discarded.
+        @return Number of journal records replayed, or -1 on failure. */
+    int Recover();
+
+    /// Writes the changes of this frame to the journal. Called automatically at the end of each frame.
+    void Flush();
+
+    /// Writes a new snapshot of the scene on a worker thread, and discards the journal when the snapshot has been written.
+    /** If the scene is being loaded incrementally, or another background save of the scene is in progress, the compaction is started
+        at the end of the first frame after the load or the save has finished.
+        @return True if the compaction was started now. */
+    bool Compact();
+
+    /// Sets the size of the journal in bytes above which the scene is compacted. 0 disables automatic compaction.
+    void SetCompactionThreshold(qint64 bytes) { compactionThreshold_ = bytes; }
+
+signals:
+    /// Emitted when a compaction has finished, and the new snapshot has replaced the old one.
+    void Compacted(const QString &snapshotFile);
+
+private slots:
+    void OnEntityChanged(Entity *entity, AttributeChange::Type change);
+    void OnComponentChanged(Entity *entity, IComponent *comp, AttributeChange::Type change);
+    void OnAttributeChanged(IComponent *comp, IAttribute *attribute, AttributeChange::Type change);
+    void OnAttributesChanged(IComponent *comp, const AttributeChangeSet &changes);
+    void OnBackgroundSaveFinished(const QString &filename, bool success);
+    void OnPostFrameUpdate(float frameTime);
+
+private:
+    /// Changes of an entity during the current frame
+    struct PendingEntity
+    {
+        PendingEntity() : full(false) {}
+        bool full; ///< Write the whole entity.
+        std::set<std::pair<QString, QString> > components; ///< Type names and names of the changed components.
+    };
+
+    /// Marks a component changed.
+    void MarkComponent(Entity *entity, IComponent *comp);
+
+    /// Opens the journal file for appending, writing the header if the file is new.
+    /** @param truncate If true, the existing contents are discarded. */
+    bool OpenJournal(bool truncate);
+
+    /// Appends the records of the .old journal to the current journal, after a failed compaction.
+    void RestoreOldJournal();
+
+    /// Replays the records of a journal file on the scene. Returns number of records replayed.
+    int Replay(const QString &filename);
+
+    QString JournalFile() const { return snapshotFile_ + ".journal"; }
+    QString OldJournalFile() const { return snapshotFile_ + ".journal.old"; }
+    QString TempSnapshotFile() const { return snapshotFile_ + ".tmp"; }
+
+    SceneWeakPtr scene_; ///< Journaled scene.
+    QString snapshotFile_; ///< File name of the snapshot.
+    QFile journal_; ///< Journal file, open for appending.
+    std::map<entity_id_t, PendingEntity> pending_; ///< Changes of the current frame.
+    std::set<entity_id_t> persisted_; ///< Entities in the snapshot or the journal, whose removal needs to be recorded.
+    qint64 compactionThreshold_; ///< Journal size that triggers compaction, or 0.
+    bool compacting_; ///< Compaction in progress -flag.
+    bool compactPending_; ///< Compaction postponed until the scene is idle -flag.
+    bool replaying_; ///< Recovering from the journal -flag. Changes are not journaled while set.
+};
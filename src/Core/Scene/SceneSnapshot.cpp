@@ -0,0 +1,305 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "SceneSnapshot.h"
+#include "SceneBinaryIndex.h"
+#include "IComponent.h"
+#include "IAttribute.h"
+#include "EC_DynamicComponent.h"
+#include "CoreStringUtils.h"
+#include "LoggingFunctions.h"
+
+#include <QDomDocument>
+#include <QFile>
+#include <QHash>
+#include <QList>
+
+#include <kNet.h>
+
+#include <cmath>
+#include <limits>
+
+#ifdef _WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "MemoryLeakCheck.h"
+
+/// Returns index of a string in the string table of an indexed binary scene, adding the string if necessary.
+static u32 BinaryStringIndex(const QString &str, QHash<QString, u32> &indices, QList<QString> &strings)
+{
+    QHash<QString, u32>::const_iterator iter = indices.find(str);
+    if (iter != indices.end())
+        return iter.value();
+    u32 index = (u32)strings.size();
+    indices[str] = index;
+    strings.append(str);
+    return index;
+}
+
+/// Region cell of the indexed binary scene format
+struct BinaryRegionCell
+{
+    int x, y, z;
+    bool operator <(const BinaryRegionCell &rhs) const
+    {
+        if (x != rhs.x) return x < rhs.x;
+        if (y != rhs.y) return y < rhs.y;
+        return z < rhs.z;
+    }
+};
+
+ComponentSnapshot::~ComponentSnapshot()
+{
+    for(size_t i = 0; i < attributes.size(); ++i)
+        delete attributes[i];
+}
+
+void ComponentSnapshot::WriteXml(QDomDocument &doc, QDomElement &entityElement) const
+{
+    QDomElement comp_element = doc.createElement("component");
+    comp_element.setAttribute("type", typeName);
+    if (!name.isEmpty())
+        comp_element.setAttribute("name", name);
+    comp_element.setAttribute("sync", BoolToString(replicated));
+
+    for(size_t i = 0; i < attributes.size(); ++i)
+    {
+        if (!attributes[i])
+            continue;
+        QDomElement attribute_element = doc.createElement("attribute");
+        attribute_element.setAttribute("name", attributes[i]->Name());
+        attribute_element.setAttribute("value", QString(attributes[i]->ToString().c_str()));
+        if (dynamic)
+            attribute_element.setAttribute("type", attributes[i]->TypeName());
+        comp_element.appendChild(attribute_element);
+    }
+
+    entityElement.appendChild(comp_element);
+}
+
+QByteArray ComponentSnapshot::ToBinary() const
+{
+    // Assume 64KB max per component, like SceneBinaryIndex::ComponentData
+    QByteArray bytes(64 * 1024, 0);
+    kNet::DataSerializer dest(bytes.data(), bytes.size());
+    if (dynamic)
+        EC_DynamicComponent::SerializeAttributesToBinary(attributes, dest);
+    else
+    {
+        dest.Add<u8>((u8)attributes.size());
+        for(size_t i = 0; i < attributes.size(); ++i)
+            if (attributes[i])
+                attributes[i]->ToBinary(dest);
+    }
+    return bytes.left((int)dest.BytesFilled());
+}
+
+QByteArray SceneSnapshot::ToXml() const
+{
+    QDomDocument scene_doc("Scene");
+    QDomElement scene_elem = scene_doc.createElement("scene");
+
+    for(size_t i = 0; i < entities.size(); ++i)
+    {
+        const EntitySnapshot &entity = entities[i];
+        QDomElement entity_elem = scene_doc.createElement("entity");
+
+        QString id_str;
+        id_str.setNum((int)entity.id);
+        entity_elem.setAttribute("id", id_str);
+        entity_elem.setAttribute("sync", QString::fromStdString(::ToString<bool>(entity.replicated)));
+
+        for(size_t j = 0; j < entity.components.size(); ++j)
+            entity.components[j]->WriteXml(scene_doc, entity_elem);
+
+        scene_elem.appendChild(entity_elem);
+    }
+    scene_doc.appendChild(scene_elem);
+
+    return scene_doc.toByteArray();
+}
+
+QByteArray SceneSnapshot::ToBinary(float regionSize) const
+{
+    // Entities without a position are stored first, then the entities of each region.
+    std::vector<const EntitySnapshot *> unplaced;
+    std::map<BinaryRegionCell, std::vector<const EntitySnapshot *> > regions;
+    for(size_t i = 0; i < entities.size(); ++i)
+    {
+        if (regionSize > 0.f && entities[i].hasPosition)
+        {
+            const float3 &pos = entities[i].position;
+            BinaryRegionCell cell = { (int)floor(pos.x / regionSize), (int)floor(pos.y / regionSize), (int)floor(pos.z / regionSize) };
+            regions[cell].push_back(&entities[i]);
+        }
+        else
+            unplaced.push_back(&entities[i]);
+    }
+
+    std::vector<const EntitySnapshot *> ordered = unplaced;
+    std::vector<SceneBinaryIndex::Region> regionTable;
+    for(std::map<BinaryRegionCell, std::vector<const EntitySnapshot *> >::const_iterator iter = regions.begin(); iter != regions.end(); ++iter)
+    {
+        SceneBinaryIndex::Region region = { iter->first.x, iter->first.y, iter->first.z, (u32)ordered.size(), (u32)iter->second.size() };
+        regionTable.push_back(region);
+        ordered.insert(ordered.end(), iter->second.begin(), iter->second.end());
+    }
+
+    // QByteArray, and so the whole file, is limited to 2 GB, which also keeps the u32 offsets from overflowing.
+    const quint64 cMaxSize = (quint64)std::numeric_limits<int>::max();
+
+    // Write the entity records. Offsets are relative to the beginning of the records until the string table size is known.
+    QHash<QString, u32> stringIndices;
+    QList<QString> strings;
+    std::vector<SceneBinaryIndex::Entry> index;
+    QByteArray records;
+    for(size_t i = 0; i < ordered.size(); ++i)
+    {
+        const EntitySnapshot &entity = *ordered[i];
+        SceneBinaryIndex::Entry entry = { entity.id, (u32)records.size(), 0 };
+
+        std::vector<const ComponentSnapshot *> components;
+        for(size_t j = 0; j < entity.components.size(); ++j)
+            if (!entity.components[j]->temporary)
+                components.push_back(entity.components[j].get());
+
+        if ((quint64)records.size() + 9 > cMaxSize)
+            return QByteArray();
+        SceneBinaryIndex::AppendValue<u32>(records, entity.id);
+        SceneBinaryIndex::AppendValue<u8>(records, entity.replicated ? 1 : 0);
+        SceneBinaryIndex::AppendValue<u32>(records, (u32)components.size());
+        for(size_t j = 0; j < components.size(); ++j)
+        {
+            const ComponentSnapshot &comp = *components[j];
+            const QByteArray data = comp.ToBinary();
+            if ((quint64)records.size() + 13 + data.size() > cMaxSize)
+                return QByteArray();
+            SceneBinaryIndex::AppendValue<u32>(records, BinaryStringIndex(comp.typeName, stringIndices, strings));
+            SceneBinaryIndex::AppendValue<u32>(records, BinaryStringIndex(comp.name, stringIndices, strings));
+            SceneBinaryIndex::AppendValue<u8>(records, comp.replicated ? 1 : 0);
+
+            SceneBinaryIndex::AppendValue<u32>(records, (u32)data.size());
+            records.append(data);
+        }
+
+        entry.size = (u32)records.size() - entry.offset;
+        index.push_back(entry);
+    }
+
+    QByteArray stringTable;
+    SceneBinaryIndex::AppendValue<u32>(stringTable, (u32)strings.size());
+    foreach(const QString &str, strings)
+    {
+        if ((quint64)stringTable.size() + 2 + str.size() * 3 > cMaxSize)
+            return QByteArray();
+        SceneBinaryIndex::AppendString(stringTable, str);
+    }
+
+    const quint64 totalSize = (quint64)SceneBinaryIndex::cHeaderSize + stringTable.size() + records.size() +
+        (quint64)index.size() * SceneBinaryIndex::cIndexEntrySize + (quint64)regionTable.size() * SceneBinaryIndex::cRegionEntrySize;
+    if (totalSize > cMaxSize)
+        return QByteArray();
+
+    const u32 stringTableOffset = SceneBinaryIndex::cHeaderSize;
+    const u32 recordsOffset = stringTableOffset + stringTable.size();
+    const u32 indexOffset = recordsOffset + records.size();
+    const u32 regionTableOffset = indexOffset + (u32)index.size() * SceneBinaryIndex::cIndexEntrySize;
+
+    QByteArray bytes;
+    bytes.reserve((int)totalSize);
+    SceneBinaryIndex::AppendValue<u32>(bytes, SceneBinaryIndex::cMagic);
+    SceneBinaryIndex::AppendValue<u32>(bytes, SceneBinaryIndex::cVersion);
+    SceneBinaryIndex::AppendValue<u32>(bytes, (u32)index.size());
+    SceneBinaryIndex::AppendValue<u32>(bytes, stringTableOffset);
+    SceneBinaryIndex::AppendValue<u32>(bytes, indexOffset);
+    SceneBinaryIndex::AppendValue<u32>(bytes, regionTableOffset);
+    SceneBinaryIndex::AppendValue<u32>(bytes, (u32)regionTable.size());
+    SceneBinaryIndex::AppendValue<float>(bytes, regionTable.empty() ? 0.f : regionSize);
+    bytes.append(stringTable);
+    bytes.append(records);
+    for(size_t i = 0; i < index.size(); ++i)
+    {
+        SceneBinaryIndex::AppendValue<u32>(bytes, index[i].id);
+        SceneBinaryIndex::AppendValue<u32>(bytes, recordsOffset + index[i].offset);
+        SceneBinaryIndex::AppendValue<u32>(bytes, index[i].size);
+    }
+    for(size_t i = 0; i < regionTable.size(); ++i)
+    {
+        SceneBinaryIndex::AppendValue<s32>(bytes, regionTable[i].x);
+        SceneBinaryIndex::AppendValue<s32>(bytes, regionTable[i].y);
+        SceneBinaryIndex::AppendValue<s32>(bytes, regionTable[i].z);
+        SceneBinaryIndex::AppendValue<u32>(bytes, regionTable[i].firstEntry);
+        SceneBinaryIndex::AppendValue<u32>(bytes, regionTable[i].numEntries);
+    }
+
+    return bytes;
+}
+
+bool SceneSnapshot::WriteFile(const QString &filename, const QByteArray &data)
+{
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+    bool success = file.write(data) == data.size() && FlushToDisk(file);
+    file.close();
+    return success;
+}
+
+bool SceneSnapshot::FlushToDisk(QFile &file)
+{
+    if (!file.flush())
+        return false;
+#ifdef _WINDOWS
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+ComponentSnapshotPtr SceneSnapshotCache::Capture(const ComponentPtr &component)
+{
+    Entry &entry = entries_[component.get()];
+    entry.used = true;
+    // Reuse the previous snapshot if the component is the same object and has not changed since. Also check that the pointer
+    // has not been reused by a new component after the previous one was destroyed.
+    if (entry.snapshot && entry.component.lock() == component && entry.revision == component->Revision() &&
+        entry.snapshot->name == component->Name() && entry.snapshot->replicated == component->IsReplicated() &&
+        entry.snapshot->temporary == component->IsTemporary())
+        return entry.snapshot;
+
+    boost::shared_ptr<ComponentSnapshot> snapshot(new ComponentSnapshot());
+    snapshot->typeName = component->TypeName();
+    snapshot->name = component->Name();
+    snapshot->replicated = component->IsReplicated();
+    snapshot->temporary = component->IsTemporary();
+    snapshot->dynamic = (component->TypeId() == EC_DynamicComponent::TypeIdStatic());
+    // Only the values are copied here. The serialization is left to the thread that serializes the snapshot.
+    const AttributeVector &attributes = component->Attributes();
+    snapshot->attributes.reserve(attributes.size());
+    for(size_t i = 0; i < attributes.size(); ++i)
+        snapshot->attributes.push_back(attributes[i] ? attributes[i]->Clone() : 0);
+
+    entry.component = component;
+    entry.revision = component->Revision();
+    entry.snapshot = snapshot;
+    return entry.snapshot;
+}
+
+void SceneSnapshotCache::Prune()
+{
+    for(std::map<IComponent *, Entry>::iterator iter = entries_.begin(); iter != entries_.end();)
+    {
+        if (!iter->second.used)
+            entries_.erase(iter++);
+        else
+        {
+            iter->second.used = false;
+            ++iter;
+        }
+    }
+}
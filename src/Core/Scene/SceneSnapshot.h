@@ -0,0 +1,117 @@
+/**
+    For conditions of distribution and use, see copyright notice in LICENSE
+
+    @file   SceneSnapshot.h
+    @brief  Immutable copy of the entity and attribute data of a scene, for serializing a scene outside the main thread. */
+
+#pragma once
+
+#include "SceneFwd.h"
+#include "CoreTypes.h"
+#include "Math/float3.h"
+
+#include <QString>
+#include <QByteArray>
+
+class QFile;
+class QDomDocument;
+class QDomElement;
+
+#include <vector>
+#include <map>
+
+/// Immutable copy of the data of a component.
+/** The attributes are copied with IAttribute::Clone when the snapshot is taken. The string, variant and asset reference values are implicitly
+    shared with the component, so copying them is cheap, and the copies are serialized later on any thread. Snapshots of unchanged components
+    are shared between consecutive scene snapshots.
+    The component is written in the same way as IComponent::SerializeTo and IComponent::SerializeToBinary write it, or, for EC_DynamicComponent,
+    which is the only component that overrides them, as EC_DynamicComponent writes it. */
+struct ComponentSnapshot
+{
+    ComponentSnapshot() : replicated(false), temporary(false), dynamic(false) {}
+    ~ComponentSnapshot();
+
+    /// Appends the component element to the entity element, in the format of IComponent::SerializeTo.
+    void WriteXml(QDomDocument &doc, QDomElement &entityElement) const;
+
+    /// Returns the component data in the format of IComponent::SerializeToBinary.
+    QByteArray ToBinary() const;
+
+    QString typeName;
+    QString name;
+    bool replicated;
+    bool temporary;
+    /// Whether the component is an EC_DynamicComponent, whose attribute types are written along with the values.
+    bool dynamic;
+    /// Copies of the attributes, owned by the snapshot. The holes in the attribute vector of the component are null.
+    AttributeVector attributes;
+
+private:
+    Q_DISABLE_COPY(ComponentSnapshot)
+};
+
+typedef boost::shared_ptr<const ComponentSnapshot> ComponentSnapshotPtr;
+
+/// Immutable copy of the data of an entity.
+struct EntitySnapshot
+{
+    entity_id_t id;
+    bool replicated;
+    /// Whether the entity has an EC_Placeable, whose position is in position.
+    bool hasPosition;
+    float3 position;
+    std::vector<ComponentSnapshotPtr> components;
+};
+
+/// Immutable copy of the entity and attribute data of a scene.
+/** A snapshot is taken on the main thread with Scene::TakeSnapshot. Taking a snapshot only copies the attributes of the components that have
+    changed since the previous snapshot, and shares the rest, so it is cheap compared to serializing the scene. The snapshot can then be
+    serialized on a worker thread while the scene keeps changing, f.ex. by Scene::SaveSceneXMLInBackground and Scene::SaveSceneBinaryInBackground. */
+class SceneSnapshot
+{
+public:
+    /// Returns the snapshot in the XML scene format.
+    QByteArray ToXml() const;
+
+    /// Returns the snapshot in the indexed binary scene format. Temporary components are not included.
+    /** @param regionSize Size of the region cells the entities are grouped in by position, or 0 for no regions. @sa SceneBinaryIndex
+        @return The scene data, or an empty array if the data would not fit in the 2 GB a QByteArray, and the u32 offsets of the format, can hold. */
+    QByteArray ToBinary(float regionSize = 0.f) const;
+
+    /// Writes data to a file, and waits until it has been written to the disk. Can be called from any thread.
+    /** @return True if the whole data was written. */
+    static bool WriteFile(const QString &filename, const QByteArray &data);
+
+    /// Flushes the buffered data of an open file and waits until the operating system has written it to the disk. Can be called from any thread.
+    /** @return True on success. */
+    static bool FlushToDisk(QFile &file);
+
+    /// Entities of the snapshot, in ascending id order.
+    std::vector<EntitySnapshot> entities;
+};
+
+/// Caches component snapshots between consecutive scene snapshots.
+/** @cond PRIVATE */
+class SceneSnapshotCache
+{
+public:
+    /// Returns snapshot of a component, reusing the previous one if the component has not changed since.
+    ComponentSnapshotPtr Capture(const ComponentPtr &component);
+
+    /// Forgets the cached snapshots of the components not captured since the last call.
+    void Prune();
+
+    /// Forgets all cached snapshots.
+    void Clear() { entries_.clear(); }
+
+private:
+    struct Entry
+    {
+        ComponentWeakPtr component;
+        u32 revision;
+        bool used;
+        ComponentSnapshotPtr snapshot;
+    };
+    std::map<IComponent *, Entry> entries_;
+};
+/** @endcond */
@@ -0,0 +1,266 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "DebugOperatorNew.h"
+
+#include "SceneBenchmark.h"
+#include "Framework.h"
+#include "SceneAPI.h"
+#include "Scene.h"
+#include "Entity.h"
+#include "SceneSnapshot.h"
+#include "IComponentFactory.h"
+#include "EC_Name.h"
+#include "EC_DynamicComponent.h"
+#include "HighPerfClock.h"
+#include "LoggingFunctions.h"
+
+#include <algorithm>
+
+#include "MemoryLeakCheck.h"
+
+namespace
+{
+/// Measures the wall clock time between construction and Elapsed().
+class BenchmarkTimer
+{
+public:
+    BenchmarkTimer() : start(GetCurrentClockTime()) {}
+    double Elapsed() const { return (double)(GetCurrentClockTime() - start) / (double)GetCurrentClockFreq(); }
+private:
+    tick_t start;
+};
+
+/// Number of EntitiesWithComponent queries run per iteration.
+const unsigned int cNumQueries = 10;
+}
+
+SceneBenchmark::SceneBenchmark(Framework *fw) :
+    framework(fw),
+    numAttributeChanges(0),
+    numIterations(0)
+{
+    // The components are normally registered by TundraLogicModule, which is not loaded here.
+    SceneAPI *sceneAPI = framework->Scene();
+    if (!sceneAPI->IsComponentFactoryRegistered(EC_Name::TypeNameStatic()))
+        sceneAPI->RegisterComponentFactory(ComponentFactoryPtr(new GenericComponentFactory<EC_Name>));
+    if (!sceneAPI->IsComponentFactoryRegistered(EC_DynamicComponent::TypeNameStatic()))
+        sceneAPI->RegisterComponentFactory(ComponentFactoryPtr(new GenericComponentFactory<EC_DynamicComponent>));
+}
+
+SceneBenchmark::~SceneBenchmark()
+{
+}
+
+void SceneBenchmark::Run(const std::vector<unsigned int> &sizes, unsigned int iterations)
+{
+    results.clear();
+    numIterations = std::max(iterations, 1u);
+    for(size_t i = 0; i < sizes.size(); ++i)
+    {
+        LogInfo("SceneBenchmark: Running with " + QString::number(sizes[i]) + " entities.");
+        RunSize(sizes[i], numIterations);
+    }
+}
+
+ScenePtr SceneBenchmark::CreateBenchmarkScene(const QString &name)
+{
+    framework->Scene()->RemoveScene(name);
+    return framework->Scene()->CreateScene(name, false, true);
+}
+
+void SceneBenchmark::Populate(Scene *scene, unsigned int numEntities)
+{
+    const QStringList components = QStringList() << EC_Name::TypeNameStatic() << EC_DynamicComponent::TypeNameStatic();
+    for(unsigned int i = 0; i < numEntities; ++i)
+    {
+        EntityPtr entity = scene->CreateEntity(0, components, AttributeChange::Disconnected);
+        EC_DynamicComponent *dc = static_cast<EC_DynamicComponent *>(entity->GetComponent(EC_DynamicComponent::TypeIdStatic()).get());
+        dc->CreateAttribute("real", "speed", AttributeChange::Disconnected);
+        dc->CreateAttribute("string", "state", AttributeChange::Disconnected);
+        dc->SetAttribute(0, (double)i, AttributeChange::Disconnected);
+        dc->SetAttribute(1, QString("idle"), AttributeChange::Disconnected);
+    }
+}
+
+void SceneBenchmark::RunSize(unsigned int numEntities, unsigned int iterations)
+{
+    for(unsigned int iter = 0; iter < iterations; ++iter)
+    {
+        ScenePtr scene = CreateBenchmarkScene("SceneBenchmark");
+        connect(scene.get(), SIGNAL(AttributeChanged(IComponent*, IAttribute*, AttributeChange::Type)),
+            SLOT(OnAttributeChanged(IComponent*, IAttribute*, AttributeChange::Type)));
+
+        // Entity creation, including the components and their creation signals.
+        const QStringList components = QStringList() << EC_Name::TypeNameStatic() << EC_DynamicComponent::TypeNameStatic();
+        std::vector<entity_id_t> ids;
+        ids.reserve(numEntities);
+        {
+            BenchmarkTimer timer;
+            for(unsigned int i = 0; i < numEntities; ++i)
+                ids.push_back(scene->CreateEntity(0, components, AttributeChange::Default)->Id());
+            AddResult("createEntities", numEntities, numEntities, timer.Elapsed());
+        }
+        scene->RemoveAllEntities(false);
+        ids.clear();
+        Populate(scene.get(), numEntities);
+        for(Scene::iterator it = scene->begin(); it != scene->end(); ++it)
+            if (it->second->IsActive())
+                ids.push_back(it->first);
+
+        // Component lookup by type name and by type id.
+        {
+            unsigned int found = 0;
+            BenchmarkTimer timer;
+            for(size_t i = 0; i < ids.size(); ++i)
+            {
+                Entity *entity = scene->EntityById(ids[i]).get();
+                if (entity->GetComponent(EC_Name::TypeNameStatic()))
+                    ++found;
+                if (entity->GetComponent(EC_DynamicComponent::TypeIdStatic()))
+                    ++found;
+            }
+            AddResult("componentLookup", numEntities, (unsigned int)ids.size() * 2, timer.Elapsed());
+            if (found != ids.size() * 2)
+                LogWarning("SceneBenchmark: Component lookup found " + QString::number(found) + " components, expected " + QString::number(ids.size() * 2) + ".");
+        }
+
+        // Attribute set, including the change signal dispatch to a connected slot.
+        {
+            const QString values[2] = { "first", "second" };
+            numAttributeChanges = 0;
+            BenchmarkTimer timer;
+            for(size_t i = 0; i < ids.size(); ++i)
+            {
+                EC_Name *name = static_cast<EC_Name *>(scene->EntityById(ids[i])->GetComponent(EC_Name::TypeIdStatic()).get());
+                name->description.Set(values[i & 1], AttributeChange::Default);
+            }
+            AddResult("attributeSet", numEntities, (unsigned int)ids.size(), timer.Elapsed());
+            if (numAttributeChanges != ids.size())
+                LogWarning("SceneBenchmark: Received " + QString::number(numAttributeChanges) + " attribute change signals, expected " + QString::number(ids.size()) + ".");
+        }
+
+        // EntitiesWithComponent queries.
+        {
+            BenchmarkTimer timer;
+            for(unsigned int i = 0; i < cNumQueries; ++i)
+                scene->EntitiesWithComponent(EC_DynamicComponent::TypeNameStatic());
+            AddResult("entitiesWithComponent", numEntities, cNumQueries, timer.Elapsed());
+        }
+
+        // XML serialization and deserialization into an empty scene.
+        QByteArray xml;
+        {
+            BenchmarkTimer timer;
+            xml = scene->GetSceneXML(true, true);
+            AddResult("serializeXml", numEntities, numEntities, timer.Elapsed());
+        }
+        {
+            ScenePtr target = CreateBenchmarkScene("SceneBenchmarkXml");
+            BenchmarkTimer timer;
+            target->CreateContentFromXml(QString::fromUtf8(xml.data(), xml.size()), false, AttributeChange::Default);
+            AddResult("deserializeXml", numEntities, numEntities, timer.Elapsed());
+            framework->Scene()->RemoveScene(target->Name());
+        }
+        xml.clear();
+
+        // Binary serialization and deserialization into an empty scene.
+        QByteArray binary;
+        {
+            BenchmarkTimer timer;
+            binary = scene->TakeSnapshot(true, true)->ToBinary();
+            AddResult("serializeBinary", numEntities, numEntities, timer.Elapsed());
+        }
+        {
+            ScenePtr target = CreateBenchmarkScene("SceneBenchmarkBinary");
+            BenchmarkTimer timer;
+            target->CreateContentFromBinary(binary.data(), binary.size(), false, AttributeChange::Default);
+            AddResult("deserializeBinary", numEntities, numEntities, timer.Elapsed());
+            framework->Scene()->RemoveScene(target->Name());
+        }
+        binary.clear();
+
+        // Clone every entity.
+        std::vector<entity_id_t> clones;
+        clones.reserve(ids.size());
+        {
+            BenchmarkTimer timer;
+            for(size_t i = 0; i < ids.size(); ++i)
+            {
+                EntityPtr clone = scene->EntityById(ids[i])->Clone(false, false);
+                if (clone)
+                    clones.push_back(clone->Id());
+            }
+            AddResult("cloneEntities", numEntities, (unsigned int)ids.size(), timer.Elapsed());
+        }
+        for(size_t i = 0; i < clones.size(); ++i)
+            scene->RemoveEntity(clones[i], AttributeChange::Disconnected);
+
+        // Entity removal, including the removal signals.
+        {
+            BenchmarkTimer timer;
+            for(size_t i = 0; i < ids.size(); ++i)
+                scene->RemoveEntity(ids[i], AttributeChange::Default);
+            AddResult("removeEntities", numEntities, (unsigned int)ids.size(), timer.Elapsed());
+        }
+
+        framework->Scene()->RemoveScene(scene->Name());
+    }
+}
+
+void SceneBenchmark::AddResult(const QString &operation, unsigned int numEntities, unsigned int numOperations, double seconds)
+{
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        SceneBenchmarkResult &result = results[i];
+        if (result.operation == operation && result.numEntities == numEntities)
+        {
+            result.bestSeconds = std::min(result.bestSeconds, seconds);
+            result.meanSeconds += seconds / numIterations;
+            return;
+        }
+    }
+
+    SceneBenchmarkResult result;
+    result.operation = operation;
+    result.numEntities = numEntities;
+    result.numOperations = numOperations;
+    result.bestSeconds = seconds;
+    result.meanSeconds = seconds / numIterations;
+    results.push_back(result);
+}
+
+void SceneBenchmark::OnAttributeChanged(IComponent * /*comp*/, IAttribute * /*attribute*/, AttributeChange::Type /*change*/)
+{
+    ++numAttributeChanges;
+}
+
+QByteArray SceneBenchmark::ToJson() const
+{
+    QString json = "{\n  \"benchmark\": \"SceneBenchmark\",\n  \"iterations\": " + QString::number(numIterations) + ",\n  \"results\": [";
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        const SceneBenchmarkResult &r = results[i];
+        json += (i > 0 ? ",\n    {" : "\n    {");
+        json += "\"operation\": \"" + r.operation + "\", ";
+        json += "\"entities\": " + QString::number(r.numEntities) + ", ";
+        json += "\"operations\": " + QString::number(r.numOperations) + ", ";
+        json += "\"bestSeconds\": " + QString::number(r.bestSeconds, 'g', 9) + ", ";
+        json += "\"meanSeconds\": " + QString::number(r.meanSeconds, 'g', 9) + ", ";
+        json += "\"nsPerOperation\": " + QString::number(r.NanosecondsPerOperation(), 'f', 1) + "}";
+    }
+    json += "\n  ]\n}\n";
+    return json.toUtf8();
+}
+
+QByteArray SceneBenchmark::ToCsv() const
+{
+    QString csv = "operation,entities,operations,bestSeconds,meanSeconds,nsPerOperation\n";
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        const SceneBenchmarkResult &r = results[i];
+        csv += r.operation + "," + QString::number(r.numEntities) + "," + QString::number(r.numOperations) + "," +
+            QString::number(r.bestSeconds, 'g', 9) + "," + QString::number(r.meanSeconds, 'g', 9) + "," +
+            QString::number(r.NanosecondsPerOperation(), 'f', 1) + "\n";
+    }
+    return csv.toUtf8();
+}
@@ -0,0 +1,78 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#include "SceneFwd.h"
+#include "AttributeChangeType.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+class Framework;
+class IAttribute;
+
+/// Result of one benchmarked scene operation at one scene size.
+struct SceneBenchmarkResult
+{
+    SceneBenchmarkResult() : numEntities(0), numOperations(0), bestSeconds(0.0), meanSeconds(0.0) {}
+
+    QString operation; ///< Name of the operation, f.ex. "createEntities".
+    unsigned int numEntities; ///< Number of entities in the scene the operation was run on.
+    unsigned int numOperations; ///< Number of individual operations performed per iteration.
+    double bestSeconds; ///< Fastest iteration, in seconds.
+    double meanSeconds; ///< Mean of all iterations, in seconds.
+
+    /// Returns the time of a single operation of the fastest iteration, in nanoseconds.
+    double NanosecondsPerOperation() const { return numOperations > 0 ? bestSeconds * 1e9 / numOperations : 0.0; }
+};
+
+/// Measures the core Scene and Entity operations on a headless Framework.
+/** Each operation is run on scenes of the given sizes, populated with entities that have an EC_Name and an EC_DynamicComponent.
+    The results can be written as JSON or CSV so that they can be compared between builds. */
+class SceneBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SceneBenchmark(Framework *framework);
+    ~SceneBenchmark();
+
+    /// Runs all the benchmarks for each scene size.
+    /** @param sizes Scene sizes, in number of entities.
+        @param iterations How many times each operation is repeated. The fastest and the mean time are reported. */
+    void Run(const std::vector<unsigned int> &sizes, unsigned int iterations);
+
+    /// Returns the results of the last Run.
+    const std::vector<SceneBenchmarkResult> &Results() const { return results; }
+
+    /// Returns the results as a JSON document.
+    QByteArray ToJson() const;
+
+    /// Returns the results as CSV, with one header row.
+    QByteArray ToCsv() const;
+
+private slots:
+    /// Counts the attribute change signals the scene dispatches.
+    void OnAttributeChanged(IComponent *comp, IAttribute *attribute, AttributeChange::Type change);
+
+private:
+    /// Creates an empty scene for a benchmark run.
+    ScenePtr CreateBenchmarkScene(const QString &name);
+
+    /// Fills the scene with numEntities entities.
+    void Populate(Scene *scene, unsigned int numEntities);
+
+    /// Runs the benchmarks for one scene size.
+    void RunSize(unsigned int numEntities, unsigned int iterations);
+
+    /// Adds a measurement to the results, merging it with the earlier iterations of the same operation and size.
+    void AddResult(const QString &operation, unsigned int numEntities, unsigned int numOperations, double seconds);
+
+    Framework *framework;
+    std::vector<SceneBenchmarkResult> results;
+    unsigned long long numAttributeChanges;
+    unsigned int numIterations;
+};
@@ -0,0 +1,73 @@
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include "DebugOperatorNew.h"
+
+#include "SceneBenchmark.h"
+#include "Framework.h"
+#include "LoggingFunctions.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <vector>
+
+#include "MemoryLeakCheck.h"
+
+/// Runs the scene benchmarks on a headless Framework and writes the results.
+/** Command line options, in addition to the Framework options:
+    --sizes      Comma-separated list of scene sizes in entities. Default: 1000,10000,100000,1000000.
+    --iterations How many times each operation is repeated. Default: 3.
+    --output     File to write the results to. Default: SceneBenchmark.json or SceneBenchmark.csv in the working directory.
+    --format     Output format, 'json' or 'csv'. Default: json. */
+int main(int argc, char **argv)
+{
+    // The benchmark never needs a window or a renderer.
+    std::vector<char *> args(argv, argv + argc);
+    char headless[] = "--headless";
+    args.push_back(headless);
+    int numArgs = (int)args.size();
+
+    int returnValue = EXIT_SUCCESS;
+    Framework *fw = new Framework(numArgs, &args[0]);
+    if (!fw->IsExiting())
+    {
+        std::vector<unsigned int> sizes;
+        QStringList sizeParam = fw->CommandLineParameters("--sizes");
+        QStringList sizeList = sizeParam.size() > 0 ? sizeParam.last().split(",", QString::SkipEmptyParts) : QString("1000,10000,100000,1000000").split(",");
+        foreach(const QString &size, sizeList)
+        {
+            bool ok = false;
+            unsigned int numEntities = size.trimmed().toUInt(&ok);
+            if (ok && numEntities > 0)
+                sizes.push_back(numEntities);
+            else
+                LogWarning("SceneBenchmark: Ignoring invalid scene size \"" + size + "\".");
+        }
+
+        unsigned int iterations = 3;
+        QStringList iterationParam = fw->CommandLineParameters("--iterations");
+        if (iterationParam.size() > 0)
+            iterations = std::max(iterationParam.last().toUInt(), 1u);
+
+        QStringList formatParam = fw->CommandLineParameters("--format");
+        bool csv = formatParam.size() > 0 && formatParam.last().compare("csv", Qt::CaseInsensitive) == 0;
+
+        SceneBenchmark benchmark(fw);
+        benchmark.Run(sizes, iterations);
+        QByteArray output = csv ? benchmark.ToCsv() : benchmark.ToJson();
+
+        QStringList outputParam = fw->CommandLineParameters("--output");
+        QString outputFile = outputParam.size() > 0 ? outputParam.last() : QString(csv ? "SceneBenchmark.csv" : "SceneBenchmark.json");
+        QFile file(outputFile);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(output) == output.size())
+            LogInfo("SceneBenchmark: Wrote results to " + outputFile);
+        else
+        {
+            LogError("SceneBenchmark: Could not write results to " + outputFile);
+            returnValue = EXIT_FAILURE;
+        }
+    }
+    delete fw;
+
+    return returnValue;
+}
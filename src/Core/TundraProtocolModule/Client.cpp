@@ -158,6 +158,12 @@ void Client::Login(const QString& address, unsigned short port, kNet::SocketTran
     SetLoginProperty("client-organization", Application::OrganizationName());
 
     KristalliProtocolModule *kristalli = framework_->GetModule<KristalliProtocolModule>();
+    if (!kristalli->HasMessageHandler(MsgLoginReply::messageID))
+    {
+        kristalli->RegisterMessageHandler<MsgLoginReply>(boost::bind(&Client::HandleLoginReply, this, _1, _2));
+        kristalli->RegisterMessageHandler<MsgClientJoined>(boost::bind(&Client::HandleClientJoined, this, _1, _2));
+        kristalli->RegisterMessageHandler<MsgClientLeft>(boost::bind(&Client::HandleClientLeft, this, _1, _2));
+    }
     connect(kristalli, SIGNAL(NetworkMessageReceived(kNet::MessageConnection *, kNet::packet_id_t, kNet::message_id_t, const char *, size_t)), 
             this, SLOT(HandleKristalliMessage(kNet::MessageConnection*, kNet::packet_id_t, kNet::message_id_t, const char*, size_t)), Qt::UniqueConnection);
     connect(kristalli, SIGNAL(ConnectionAttemptFailed()), this, SLOT(OnConnectionAttemptFailed()), Qt::UniqueConnection);
@@ -209,6 +215,9 @@ void Client::DoLogout(bool fail)
     }
 
     KristalliProtocolModule *kristalli = framework_->GetModule<KristalliProtocolModule>();
+    kristalli->UnregisterMessageHandler(MsgLoginReply::messageID);
+    kristalli->UnregisterMessageHandler(MsgClientJoined::messageID);
+    kristalli->UnregisterMessageHandler(MsgClientLeft::messageID);
     disconnect(kristalli, SIGNAL(NetworkMessageReceived(kNet::MessageConnection *, kNet::packet_id_t, kNet::message_id_t, const char *, size_t)), 
         this, SLOT(HandleKristalliMessage(kNet::MessageConnection*, kNet::packet_id_t, kNet::message_id_t, const char*, size_t)));
 
@@ -313,32 +322,17 @@ void Client::HandleKristalliMessage(MessageConnection* source, packet_id_t packe
         return;
     }
     
-    switch(messageId)
-    {
-    case MsgLoginReply::messageID:
-        {
-            MsgLoginReply msg(data, numBytes);
-            HandleLoginReply(source, msg);
-        }
-        break;
-    case MsgClientJoined::messageID:
-        {
-            MsgClientJoined msg(data, numBytes);
-            HandleClientJoined(source, msg);
-        }
-        break;
-    case MsgClientLeft::messageID:
-        {
-            MsgClientLeft msg(data, numBytes);
-            HandleClientLeft(source, msg);
-        }
-        break;
-    }
     emit NetworkMessageReceived(packetId, messageId, data, numBytes);
 }
 
 void Client::HandleLoginReply(MessageConnection* source, const MsgLoginReply& msg)
 {
+    if (source != GetConnection())
+    {
+        ::LogWarning("Client: dropping login reply from unknown source");
+        return;
+    }
+
     if (msg.success)
     {
         loginstate_ = LoggedIn;
@@ -381,12 +375,22 @@ void Client::HandleLoginReply(MessageConnection* source, const MsgLoginReply& ms
     }
 }
 
-void Client::HandleClientJoined(MessageConnection* /*source*/, const MsgClientJoined& /*msg*/)
+void Client::HandleClientJoined(MessageConnection* source, const MsgClientJoined& /*msg*/)
 {
+    if (source != GetConnection())
+    {
+        ::LogWarning("Client: dropping client joined message from unknown source");
+        return;
+    }
 }
 
-void Client::HandleClientLeft(MessageConnection* /*source*/, const MsgClientLeft& /*msg*/)
+void Client::HandleClientLeft(MessageConnection* source, const MsgClientLeft& /*msg*/)
 {
+    if (source != GetConnection())
+    {
+        ::LogWarning("Client: dropping client left message from unknown source");
+        return;
+    }
 }
 
 }
@@ -123,7 +123,7 @@ signals:
     /// @param responseData This is the data that the server sent back to the client related to the connection.
     void Connected(UserConnectedResponseData *responseData);
 
-    /// Triggered whenever a new message is received from the network.
+    /// Triggered whenever a message without a registered handler, f.ex. a custom message sent by a script, is received from the server.
     void NetworkMessageReceived(kNet::packet_id_t, kNet::message_id_t id, const char *data, size_t numBytes);
 
     /// This signal is emitted when the client has disconnected from the server.
@@ -133,7 +133,7 @@ signals:
     void LoginFailed(const QString &reason);
 
 private slots:
-    /// Handles a Kristalli protocol message
+    /// Handles a Kristalli protocol message that has no registered handler.
     void HandleKristalliMessage(kNet::MessageConnection* source, kNet::packet_id_t, kNet::message_id_t id, const char* data, size_t numBytes);
 
     void OnConnectionAttemptFailed();
@@ -15,6 +15,7 @@
 
 #include <kNet.h>
 #include <kNet/UDPMessageConnection.h>
+#include <kNet/Clock.h>
 
 #include <algorithm>
 #include <utility>
@@ -28,6 +29,9 @@ using namespace kNet;
 namespace
 {
 
+/// Message ids below this are stored directly in the dispatch table; statistics of larger ids go to a map.
+const kNet::message_id_t cMaxMessageTableSize = 1024;
+
 /*
     const struct
     {
@@ -130,6 +134,9 @@ void KristalliProtocolModule::Initialize()
 #ifdef KNET_USE_QT
     framework_->Console()->RegisterCommand("kNet", "Shows the kNet statistics window.", this, SLOT(OpenKNetLogWindow()));
 #endif
+    framework_->Console()->RegisterCommand("netMessageStats", "Prints the call count, bytes and handler time of each received network message id.",
+        this, SLOT(PrintMessageStats()));
+    framework_->Console()->RegisterCommand("resetNetMessageStats", "Clears the network message statistics.", this, SLOT(ResetMessageStats()));
 }
 
 void KristalliProtocolModule::Uninitialize()
@@ -345,9 +352,17 @@ void KristalliProtocolModule::HandleMessage(kNet::MessageConnection *source, kNe
     assert(source);
     assert(data || numBytes == 0);
 
+    kNet::tick_t startTime = kNet::Clock::Tick();
     try
     {
-        emit NetworkMessageReceived(source, packetId, messageId, data, numBytes);
+        if (messageId < messageHandlers.size() && messageHandlers[messageId].handler)
+        {
+            // Invoke a copy, as the handler is allowed to unregister itself.
+            KristalliMessageHandler handler = messageHandlers[messageId].handler;
+            handler(source, packetId, data, numBytes);
+        }
+        else
+            emit NetworkMessageReceived(source, packetId, messageId, data, numBytes);
     } catch(std::exception &e)
     {
         ::LogError("KristalliProtocolModule: Exception \"" + std::string(e.what()) + "\" thrown when handling network message id " +
@@ -360,6 +375,102 @@ void KristalliProtocolModule::HandleMessage(kNet::MessageConnection *source, kNe
         // kNet will call back to KristalliProtocolModule::ClientDisconnected() to clean up the high-level Tundra UserConnection object.
 #endif
     }
+
+    double handlerTime = kNet::Clock::SecondsSinceD(startTime);
+    KristalliMessageStats &stats = StatsFor(messageId);
+    ++stats.numMessages;
+    stats.numBytes += numBytes;
+    stats.handlerTime += handlerTime;
+    stats.maxHandlerTime = std::max(stats.maxHandlerTime, handlerTime);
+}
+
+bool KristalliProtocolModule::RegisterMessageHandler(kNet::message_id_t id, const QString &name, const KristalliMessageHandler &handler)
+{
+    if (id >= cMaxMessageTableSize)
+    {
+        ::LogError("KristalliProtocolModule::RegisterMessageHandler: message id " + QString::number(id) + " (" + name + ") is too large for the dispatch table.");
+        return false;
+    }
+    if (!handler)
+    {
+        ::LogError("KristalliProtocolModule::RegisterMessageHandler: null handler given for message id " + QString::number(id) + " (" + name + ").");
+        return false;
+    }
+    if (HasMessageHandler(id))
+    {
+        ::LogError("KristalliProtocolModule::RegisterMessageHandler: message id " + QString::number(id) + " (" + name + ") is already handled by " +
+            messageHandlers[id].stats.name + ".");
+        return false;
+    }
+
+    StatsFor(id).name = name;
+    messageHandlers[id].handler = handler;
+    return true;
+}
+
+void KristalliProtocolModule::UnregisterMessageHandler(kNet::message_id_t id)
+{
+    if (id < messageHandlers.size())
+        messageHandlers[id].handler.clear();
+}
+
+bool KristalliProtocolModule::HasMessageHandler(kNet::message_id_t id) const
+{
+    return id < messageHandlers.size() && !messageHandlers[id].handler.empty();
+}
+
+std::map<kNet::message_id_t, KristalliMessageStats> KristalliProtocolModule::MessageStats() const
+{
+    std::map<kNet::message_id_t, KristalliMessageStats> stats = largeIdMessageStats;
+    for(size_t i = 0; i < messageHandlers.size(); ++i)
+        if (messageHandlers[i].stats.numMessages > 0)
+            stats[(kNet::message_id_t)i] = messageHandlers[i].stats;
+    return stats;
+}
+
+void KristalliProtocolModule::PrintMessageStats()
+{
+    std::map<kNet::message_id_t, KristalliMessageStats> stats = MessageStats();
+    if (stats.empty())
+    {
+        ::LogInfo("No network messages received.");
+        return;
+    }
+
+    ::LogInfo("Id    Name                      Count       Bytes         Total ms    Avg ms    Max ms");
+    for(std::map<kNet::message_id_t, KristalliMessageStats>::const_iterator iter = stats.begin(); iter != stats.end(); ++iter)
+    {
+        const KristalliMessageStats &s = iter->second;
+        double avgTime = s.numMessages > 0 ? s.handlerTime / s.numMessages : 0.0;
+        ::LogInfo(QString("%1 %2 %3 %4 %5 %6 %7")
+            .arg(iter->first, -5)
+            .arg(s.name.isEmpty() ? QString("(unregistered)") : s.name, -25)
+            .arg(s.numMessages, -11)
+            .arg(s.numBytes, -13)
+            .arg(s.handlerTime * 1000.0, -11, 'f', 3)
+            .arg(avgTime * 1000.0, -9, 'f', 4)
+            .arg(s.maxHandlerTime * 1000.0, -9, 'f', 4));
+    }
+}
+
+void KristalliProtocolModule::ResetMessageStats()
+{
+    for(size_t i = 0; i < messageHandlers.size(); ++i)
+    {
+        QString name = messageHandlers[i].stats.name;
+        messageHandlers[i].stats = KristalliMessageStats();
+        messageHandlers[i].stats.name = name;
+    }
+    largeIdMessageStats.clear();
+}
+
+KristalliMessageStats &KristalliProtocolModule::StatsFor(kNet::message_id_t id)
+{
+    if (id >= cMaxMessageTableSize)
+        return largeIdMessageStats[id];
+    if (id >= messageHandlers.size())
+        messageHandlers.resize(id + 1);
+    return messageHandlers[id].stats;
 }
 
 u8 KristalliProtocolModule::AllocateNewConnectionID() const
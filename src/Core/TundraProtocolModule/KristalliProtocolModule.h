@@ -4,18 +4,39 @@
 
 #include "IModule.h"
 #include "TundraProtocolModuleApi.h"
+#include "TundraProtocolModuleFwd.h"
 #include "UserConnection.h"
 
 #include <kNet/IMessageHandler.h>
 #include <kNet/INetworkServerListener.h>
 #include <kNet/Network.h>
 
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+
+#include <map>
+
 #ifdef KNET_USE_QT
 #include <QPointer>
 namespace kNet { class NetworkDialog; }
 #endif
 
+/// Receive statistics of a single Kristalli message id.
+struct KristalliMessageStats
+{
+    KristalliMessageStats() : numMessages(0), numBytes(0), handlerTime(0.0), maxHandlerTime(0.0) {}
+
+    QString name; ///< Name of the registered handler, or empty if the message was delivered through NetworkMessageReceived.
+    unsigned long long numMessages; ///< Number of messages received.
+    unsigned long long numBytes; ///< Total size of the received message payloads.
+    double handlerTime; ///< Total time spent in the handler, in seconds.
+    double maxHandlerTime; ///< Longest single handler invocation, in seconds.
+};
+
 /// Implements kNet protocol -based server and client functionality.
+/** Incoming messages are dispatched through a table indexed by message id. Modules that consume a built-in message
+    register a handler for it with RegisterMessageHandler, and the message is delivered only to that handler.
+    Messages without a registered handler, f.ex. custom messages sent by scripts, are emitted with NetworkMessageReceived. */
 class TUNDRAPROTOCOL_MODULE_API KristalliProtocolModule : public IModule, public kNet::IMessageHandler, public kNet::INetworkServerListener
 {
     Q_OBJECT
@@ -73,14 +94,49 @@ public:
     UserConnectionPtr GetUserConnection(kNet::MessageConnection* source) const;
     UserConnectionPtr GetUserConnection(u8 id) const; ///< @overload @param id Connection ID.
 
+    /// Registers @c handler as the sole consumer of the message @c id.
+    /** @param name Human-readable name of the message, shown in the message statistics.
+        @return false if a handler for @c id is already registered. */
+    bool RegisterMessageHandler(kNet::message_id_t id, const QString &name, const KristalliMessageHandler &handler);
+
+    /// Registers a handler that receives the message decoded to its generated message struct, f.ex. MsgLogin.
+    /** The struct provides the message id and name. Call as RegisterMessageHandler<MsgLogin>(boost::bind(&Server::HandleLogin, this, _1, _2)). */
+    template<typename Msg>
+    bool RegisterMessageHandler(const boost::function<void(kNet::MessageConnection*, Msg&)> &handler)
+    {
+        return RegisterMessageHandler(Msg::messageID, Msg::Name(), TypedMessageHandler<Msg>(handler));
+    }
+
+    /// Removes the handler of the message @c id. Afterwards the message is emitted with NetworkMessageReceived.
+    void UnregisterMessageHandler(kNet::message_id_t id);
+
+    /// Returns whether a handler is registered for the message @c id.
+    bool HasMessageHandler(kNet::message_id_t id) const;
+
+    /// Wraps a handler taking a generated message struct into a raw handler that decodes the message first.
+    template<typename Msg>
+    static KristalliMessageHandler TypedMessageHandler(const boost::function<void(kNet::MessageConnection*, Msg&)> &handler)
+    {
+        return boost::bind(&KristalliProtocolModule::DecodeAndInvoke<Msg>, handler, _1, _2, _3, _4);
+    }
+
+    /// Returns the receive statistics of all message ids received since startup or the last ResetMessageStats.
+    std::map<kNet::message_id_t, KristalliMessageStats> MessageStats() const;
+
     /// What trasport layer to use. Read on startup from "--protocol <udp|tcp>". Defaults to UDP if no start param was given.
     kNet::SocketTransportLayer defaultTransport;
 
 public slots:
     void OpenKNetLogWindow();
 
+    /// Prints the per-message-id receive statistics to the log.
+    void PrintMessageStats();
+
+    /// Clears the per-message-id receive statistics.
+    void ResetMessageStats();
+
 signals:
-    /// Triggered whenever a new message is received rom the network.
+    /// Triggered whenever a message without a registered handler is received from the network.
     void NetworkMessageReceived(kNet::MessageConnection *source, kNet::packet_id_t packetId, kNet::message_id_t messageId, const char *data, size_t numBytes);
 
     /// Triggered on the server side when a new user connects.
@@ -93,6 +149,30 @@ signals:
     void ConnectionAttemptFailed();
 
 private:
+    /// Entry of the message dispatch table.
+    struct MessageHandlerEntry
+    {
+        KristalliMessageHandler handler;
+        KristalliMessageStats stats;
+    };
+
+    template<typename Msg>
+    static void DecodeAndInvoke(const boost::function<void(kNet::MessageConnection*, Msg&)> &handler,
+        kNet::MessageConnection *source, kNet::packet_id_t, const char *data, size_t numBytes)
+    {
+        Msg msg(data, numBytes);
+        handler(source, msg);
+    }
+
+    /// Returns the statistics of the message @c id, growing the dispatch table if needed.
+    KristalliMessageStats &StatsFor(kNet::message_id_t id);
+
+    /// Dispatch table indexed by message id.
+    std::vector<MessageHandlerEntry> messageHandlers;
+
+    /// Statistics of message ids that are too large to be stored in the dispatch table.
+    std::map<kNet::message_id_t, KristalliMessageStats> largeIdMessageStats;
+
     /// This timer tracks when we perform the next reconnection attempt when the connection is lost.
     kNet::PolledTimer reconnectTimer;
 
@@ -16,7 +16,11 @@
 #include "EC_Placeable.h"
 #include "EC_Mesh.h"
 #include "EC_Name.h"
+#ifndef TUNDRA_NO_OGRE
 #include "Renderer.h"
+#else
+#include "OgreMeshGeometry.h"
+#endif
 #include "AssetAPI.h"
 #include "LoggingFunctions.h"
 #include "SceneAPI.h"
@@ -24,7 +28,9 @@
 #include "CoreException.h"
 #include "QtUtils.h"
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
+#endif
 
 #include <QDomDocument>
 #include <QFile>
@@ -276,6 +282,23 @@ bool SceneImporter::ParseMeshForMaterialsAndSkeleton(const QString& meshname, QS
     {
         QByteArray mesh_bytes = mesh_in.readAll();
         mesh_in.close();
+#ifdef TUNDRA_NO_OGRE
+        OgreMeshGeometry geometry;
+        QString errorMessage;
+        if (!OgreRenderer::ReadOgreMeshGeometry((const u8*)mesh_bytes.data(), mesh_bytes.size(), geometry, &errorMessage))
+        {
+            LogError("SceneImporter::ParseMeshForMaterialsAndSkeleton: Failed to read mesh " + meshname + ": " + errorMessage);
+            return false;
+        }
+        for(size_t i = 0; i < geometry.submeshes.size(); ++i)
+        {
+            // Replace / with _ from material name
+            QString submeshmat = geometry.submeshes[i].materialName;
+            submeshmat.replace('/', '_');
+            material_names.push_back(submeshmat);
+        }
+        skeleton_name = geometry.skeletonName;
+#else
         OgreRenderer::RendererPtr renderer = scene_->GetFramework()->GetModule<OgreRenderer::OgreRenderingModule>()->GetRenderer();
         if (!renderer)
         {
@@ -322,6 +345,7 @@ bool SceneImporter::ParseMeshForMaterialsAndSkeleton(const QString& meshname, QS
             LogError("SceneImporter::ParseMeshForMaterialsAndSkeleton: Exception while inspecting mesh " + meshname);
             return false;
         }
+#endif
     }
     
     return true;
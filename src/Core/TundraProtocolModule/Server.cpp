@@ -104,6 +104,7 @@ bool Server::Start(unsigned short port, QString protocol)
     emit ServerStarted();
 
     KristalliProtocolModule *kristalli = framework_->GetModule<KristalliProtocolModule>();
+    kristalli->RegisterMessageHandler<MsgLogin>(boost::bind(&Server::HandleLogin, this, _1, _2));
     connect(kristalli, SIGNAL(NetworkMessageReceived(kNet::MessageConnection *, kNet::packet_id_t, kNet::message_id_t, const char *, size_t)), 
         this, SLOT(HandleKristalliMessage(kNet::MessageConnection*, kNet::packet_id_t, kNet::message_id_t, const char*, size_t)), Qt::UniqueConnection);
 
@@ -124,6 +125,7 @@ void Server::Stop()
         emit ServerStopped();
 
         KristalliProtocolModule *kristalli = framework_->GetModule<KristalliProtocolModule>();
+        kristalli->UnregisterMessageHandler(MsgLogin::messageID);
         disconnect(kristalli, SIGNAL(NetworkMessageReceived(kNet::MessageConnection *, kNet::packet_id_t, kNet::message_id_t, const char *, size_t)), 
             this, SLOT(HandleKristalliMessage(kNet::MessageConnection*, kNet::packet_id_t, kNet::message_id_t, const char*, size_t)));
 
@@ -239,21 +241,12 @@ void Server::HandleKristalliMessage(kNet::MessageConnection* source, kNet::packe
         return;
     }
 
-    // If we are server, only allow the login message from an unauthenticated user
-    if (messageId != MsgLogin::messageID && user->properties["authenticated"] != "true")
-    {
-        UserConnectionPtr user = GetUserConnection(source);
-        if (!user || user->properties["authenticated"] != "true")
-        {
-            ::LogWarning("Server: dropping message " + QString::number(messageId) + " from unauthenticated user.");
-            /// \todo something more severe, like disconnecting the user
-            return;
-        }
-    }
-    else if (messageId == MsgLogin::messageID)
+    // The login message has its own handler, so only messages from authenticated users are allowed here
+    if (user->properties["authenticated"] != "true")
     {
-        MsgLogin msg(data, numBytes);
-        HandleLogin(source, msg);
+        ::LogWarning("Server: dropping message " + QString::number(messageId) + " from unauthenticated user.");
+        /// \todo something more severe, like disconnecting the user
+        return;
     }
 
     emit MessageReceived(user.get(), packetId, messageId, data, numBytes);
@@ -98,6 +98,7 @@ signals:
         @todo the connectionID parameter is unnecessary as it can be retrieved from connection. */
     void UserConnected(int connectionID, UserConnection* connection, UserConnectedResponseData *responseData);
 
+    /// Triggered whenever a message without a registered handler, f.ex. a custom message sent by a script, is received from an authenticated user.
     void MessageReceived(UserConnection *connection, kNet::packet_id_t, kNet::message_id_t id, const char* data, size_t numBytes);
 
     /// A user has disconnected
@@ -111,7 +112,7 @@ signals:
     void ServerStopped();
 
 private slots:
-    /// Handle a Kristalli protocol message
+    /// Handle a Kristalli protocol message that has no registered handler.
     void HandleKristalliMessage(kNet::MessageConnection* source, kNet::packet_id_t, kNet::message_id_t id, const char* data, size_t numBytes);
 
     /// Handle a user disconnecting
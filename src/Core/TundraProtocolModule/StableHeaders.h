@@ -14,7 +14,9 @@
 
 #include <QtCore>
 
+#ifndef TUNDRA_NO_OGRE
 #include <Ogre.h>
+#endif
 
 #endif
 
@@ -87,13 +87,26 @@ SyncManager::SyncManager(TundraLogicModule* owner) :
     updatePeriod_(1.0f / 20.0f),
     updateAcc_(0.0)
 {
-    KristalliProtocolModule *kristalli = framework_->GetModule<KristalliProtocolModule>();
-    connect(kristalli, SIGNAL(NetworkMessageReceived(kNet::MessageConnection *, kNet::packet_id_t, kNet::message_id_t, const char *, size_t)), 
-        this, SLOT(HandleKristalliMessage(kNet::MessageConnection*, kNet::packet_id_t, kNet::message_id_t, const char*, size_t)));
+    RegisterSyncMessageHandler(cCreateEntityMessage, "CreateEntity", boost::bind(&SyncManager::HandleCreateEntity, this, _1, _3, _4));
+    RegisterSyncMessageHandler(cCreateComponentsMessage, "CreateComponents", boost::bind(&SyncManager::HandleCreateComponents, this, _1, _3, _4));
+    RegisterSyncMessageHandler(cCreateAttributesMessage, "CreateAttributes", boost::bind(&SyncManager::HandleCreateAttributes, this, _1, _3, _4));
+    RegisterSyncMessageHandler(cEditAttributesMessage, "EditAttributes", boost::bind(&SyncManager::HandleEditAttributes, this, _1, _3, _4));
+    RegisterSyncMessageHandler(cRemoveAttributesMessage, "RemoveAttributes", boost::bind(&SyncManager::HandleRemoveAttributes, this, _1, _3, _4));
+    RegisterSyncMessageHandler(cRemoveComponentsMessage, "RemoveComponents", boost::bind(&SyncManager::HandleRemoveComponents, this, _1, _3, _4));
+    RegisterSyncMessageHandler(cRemoveEntityMessage, "RemoveEntity", boost::bind(&SyncManager::HandleRemoveEntity, this, _1, _3, _4));
+    RegisterSyncMessageHandler(cCreateEntityReplyMessage, "CreateEntityReply", boost::bind(&SyncManager::HandleCreateEntityReply, this, _1, _3, _4));
+    RegisterSyncMessageHandler(cCreateComponentsReplyMessage, "CreateComponentsReply", boost::bind(&SyncManager::HandleCreateComponentsReply, this, _1, _3, _4));
+    RegisterSyncMessageHandler(cRigidBodyUpdateMessage, "RigidBodyUpdate", boost::bind(&SyncManager::HandleRigidBodyChanges, this, _1, _2, _3, _4));
+    RegisterSyncMessageHandler(MsgEntityAction::messageID, MsgEntityAction::Name(), KristalliProtocolModule::TypedMessageHandler<MsgEntityAction>(
+        boost::bind(&SyncManager::HandleEntityAction, this, _1, _2)));
 }
 
 SyncManager::~SyncManager()
 {
+    KristalliProtocolModule *kristalli = framework_->GetModule<KristalliProtocolModule>();
+    if (kristalli)
+        for(size_t i = 0; i < registeredMessageIds_.size(); ++i)
+            kristalli->UnregisterMessageHandler(registeredMessageIds_[i]);
 }
 
 void SyncManager::SetUpdatePeriod(float period)
@@ -143,6 +156,8 @@ void SyncManager::RegisterToScene(ScenePtr scene)
     
     connect(sceneptr, SIGNAL( AttributeChanged(IComponent*, IAttribute*, AttributeChange::Type) ),
         SLOT( OnAttributeChanged(IComponent*, IAttribute*, AttributeChange::Type) ));
+    connect(sceneptr, SIGNAL( AttributesChanged(IComponent*, const AttributeChangeSet &) ),
+        SLOT( OnAttributesChanged(IComponent*, const AttributeChangeSet &) ));
     connect(sceneptr, SIGNAL( AttributeAdded(IComponent*, IAttribute*, AttributeChange::Type) ),
         SLOT( OnAttributeAdded(IComponent*, IAttribute*, AttributeChange::Type) ));
     connect(sceneptr, SIGNAL( AttributeRemoved(IComponent*, IAttribute*, AttributeChange::Type) ),
@@ -155,57 +170,32 @@ void SyncManager::RegisterToScene(ScenePtr scene)
         SLOT( OnEntityCreated(Entity*, AttributeChange::Type) ));
     connect(sceneptr, SIGNAL( EntityRemoved(Entity*, AttributeChange::Type) ),
         SLOT( OnEntityRemoved(Entity*, AttributeChange::Type) ));
+    connect(sceneptr, SIGNAL( EntityDeactivated(Entity*, AttributeChange::Type) ),
+        SLOT( OnEntityDeactivated(Entity*, AttributeChange::Type) ));
+    connect(sceneptr, SIGNAL( EntityReactivated(Entity*, AttributeChange::Type) ),
+        SLOT( OnEntityReactivated(Entity*, AttributeChange::Type) ));
     connect(sceneptr, SIGNAL( ActionTriggered(Entity *, const QString &, const QStringList &, EntityAction::ExecTypeField) ),
         SLOT( OnActionTriggered(Entity *, const QString &, const QStringList &, EntityAction::ExecTypeField)));
 }
 
-void SyncManager::HandleKristalliMessage(kNet::MessageConnection* source, kNet::packet_id_t packetId, kNet::message_id_t messageId, const char* data, size_t numBytes)
+void SyncManager::RegisterSyncMessageHandler(kNet::message_id_t id, const QString &name, const KristalliMessageHandler &handler)
+{
+    KristalliProtocolModule *kristalli = framework_->GetModule<KristalliProtocolModule>();
+    if (kristalli->RegisterMessageHandler(id, name, boost::bind(&SyncManager::InvokeSyncMessageHandler, this, handler, id, _1, _2, _3, _4)))
+        registeredMessageIds_.push_back(id);
+}
+
+void SyncManager::InvokeSyncMessageHandler(const KristalliMessageHandler &handler, kNet::message_id_t messageId, kNet::MessageConnection* source,
+    kNet::packet_id_t packetId, const char* data, size_t numBytes)
 {
     try
     {
-        switch(messageId)
-        {
-        case cCreateEntityMessage:
-            HandleCreateEntity(source, data, numBytes);
-            break;
-        case cCreateComponentsMessage:
-            HandleCreateComponents(source, data, numBytes);
-            break;
-        case cCreateAttributesMessage:
-            HandleCreateAttributes(source, data, numBytes);
-            break;
-        case cEditAttributesMessage:
-            HandleEditAttributes(source, data, numBytes);
-            break;
-        case cRemoveAttributesMessage:
-            HandleRemoveAttributes(source, data, numBytes);
-            break;
-        case cRemoveComponentsMessage:
-            HandleRemoveComponents(source, data, numBytes);
-            break;
-        case cRemoveEntityMessage:
-            HandleRemoveEntity(source, data, numBytes);
-            break;
-        case cCreateEntityReplyMessage:
-            HandleCreateEntityReply(source, data, numBytes);
-            break;
-        case cCreateComponentsReplyMessage:
-            HandleCreateComponentsReply(source, data, numBytes);
-            break;
-        case cRigidBodyUpdateMessage:
-            HandleRigidBodyChanges(source, packetId, data, numBytes);
-            break;
-        case cEntityActionMessage:
-            {
-                MsgEntityAction msg(data, numBytes);
-                HandleEntityAction(source, msg);
-            }
-            break;
-        }
+        handler(source, packetId, data, numBytes);
     }
     catch (kNet::NetException& e)
     {
         LogError("Exception while handling scene sync network message " + QString::number(messageId) + ": " + QString(e.what()));
+        currentSender = 0;
         throw; // Propagate the message so that Tundra server will kill the connection (if we are the server).
     }
     currentSender = 0;
@@ -250,11 +240,15 @@ void SyncManager::OnAttributeChanged(IComponent* comp, IAttribute* attr, Attribu
         return;
 
     bool isServer = owner_->IsServer();
+    ScenePtr scene = scene_.lock();
     
+    // When the scene batches attribute changes, the changes are consumed as dirty bitmasks in OnAttributesChanged instead.
+    if (scene && scene->AttributeChangeBatching())
+        return;
+
     // Client: Check for stopping interpolation, if we change a currently interpolating variable ourselves
     if (!isServer) // Since the server never interpolates attributes, we don't need to do this check on the server at all.
     {
-        ScenePtr scene = scene_.lock();
         if (scene && !scene->IsInterpolating() && !currentSender)
         {
             if (attr->Metadata() && attr->Metadata()->interpolation == AttributeMetadata::Interpolate)
@@ -270,6 +264,12 @@ void SyncManager::OnAttributeChanged(IComponent* comp, IAttribute* attr, Attribu
     Entity* entity = comp->ParentEntity();
     if (!entity || entity->IsLocal())
         return; // This is a local entity, don't take it to network.
+    if (!entity->IsActive())
+    {
+        // The entity is held in the entity pool. Its changes are replicated when it is reactivated.
+        inactiveChanges_[entity->Id()].insert(comp->Id());
+        return;
+    }
     
     if (isServer)
     {
@@ -288,6 +288,54 @@ void SyncManager::OnAttributeChanged(IComponent* comp, IAttribute* attr, Attribu
     }
 }
 
+void SyncManager::OnAttributesChanged(IComponent* comp, const AttributeChangeSet &changes)
+{
+    assert(comp);
+    if (!comp)
+        return;
+
+    bool isServer = owner_->IsServer();
+
+    // Client: Check for stopping interpolation, if we change a currently interpolating variable ourselves.
+    // Interpolation steps and changes received from the server are applied as LocalOnly, so only replicated changes can be our own.
+    if (!isServer && changes.change == AttributeChange::Replicate)
+    {
+        ScenePtr scene = scene_.lock();
+        if (scene)
+        {
+            const AttributeVector &attrs = comp->Attributes();
+            for(uint i = 0; i < attrs.size() && i < 256; ++i)
+                if (attrs[i] && changes.IsDirty((u8)i) && attrs[i]->Metadata() && attrs[i]->Metadata()->interpolation == AttributeMetadata::Interpolate)
+                    scene->EndAttributeInterpolation(attrs[i]);
+        }
+    }
+
+    // Is this change even supposed to go to the network?
+    if (changes.change != AttributeChange::Replicate || comp->IsLocal())
+        return;
+
+    Entity* entity = comp->ParentEntity();
+    if (!entity || entity->IsLocal())
+        return; // This is a local entity, don't take it to network.
+    if (!entity->IsActive())
+    {
+        inactiveChanges_[entity->Id()].insert(comp->Id());
+        return;
+    }
+
+    if (isServer)
+    {
+        UserConnectionList& users = owner_->GetKristalliModule()->GetUserConnections();
+        for(UserConnectionList::iterator i = users.begin(); i != users.end(); ++i)
+            if ((*i)->syncState)
+                (*i)->syncState->MarkAttributesDirty(entity->Id(), comp->Id(), changes.dirty);
+    }
+    else
+    {
+        server_syncstate_.MarkAttributesDirty(entity->Id(), comp->Id(), changes.dirty);
+    }
+}
+
 void SyncManager::OnAttributeAdded(IComponent* comp, IAttribute* attr, AttributeChange::Type change)
 {
     assert(comp && attr);
@@ -426,6 +474,7 @@ void SyncManager::OnEntityRemoved(Entity* entity, AttributeChange::Type change)
     assert(entity);
     if (!entity)
         return;
+    inactiveChanges_.erase(entity->Id());
     if (change != AttributeChange::Replicate)
         return;
     if (entity->IsLocal())
@@ -443,6 +492,75 @@ void SyncManager::OnEntityRemoved(Entity* entity, AttributeChange::Type change)
     }
 }
 
+void SyncManager::OnEntityDeactivated(Entity* entity, AttributeChange::Type change)
+{
+    assert(entity);
+    if (!entity)
+        return;
+    // Changes made from now on are held back until the reactivation.
+    inactiveChanges_.erase(entity->Id());
+    if ((change != AttributeChange::Replicate) || (entity->IsLocal()))
+        return;
+
+    // Make sure the hiding of the entity is replicated, also when the scene batches the attribute changes and
+    // the change is dispatched only after the deactivation.
+    ComponentPtr placeable = entity->GetComponent("EC_Placeable");
+    IAttribute *visible = placeable && placeable->IsReplicated() ? placeable->GetAttribute("Visible") : 0;
+    if (!visible)
+        return;
+    if (owner_->IsServer())
+    {
+        UserConnectionList& users = owner_->GetKristalliModule()->GetUserConnections();
+        for(UserConnectionList::iterator i = users.begin(); i != users.end(); ++i)
+            if ((*i)->syncState)
+                (*i)->syncState->MarkAttributeDirty(entity->Id(), placeable->Id(), visible->Index());
+    }
+    else
+    {
+        server_syncstate_.MarkAttributeDirty(entity->Id(), placeable->Id(), visible->Index());
+    }
+}
+
+void SyncManager::OnEntityReactivated(Entity* entity, AttributeChange::Type change)
+{
+    assert(entity);
+    if (!entity)
+        return;
+
+    std::map<entity_id_t, std::set<component_id_t> >::iterator iter = inactiveChanges_.find(entity->Id());
+    if (iter == inactiveChanges_.end())
+        return;
+    std::set<component_id_t> compIds;
+    compIds.swap(iter->second);
+    inactiveChanges_.erase(iter);
+    if ((change != AttributeChange::Replicate) || (entity->IsLocal()))
+        return;
+
+    // The held back changes are not known attribute by attribute, so send all the attributes of the changed components.
+    // The attributes that differ from the prototype were already marked dirty by Scene::AcquireEntity.
+    for(std::set<component_id_t>::const_iterator i = compIds.begin(); i != compIds.end(); ++i)
+    {
+        ComponentPtr comp = entity->GetComponentById(*i);
+        if (!comp || comp->IsLocal())
+            continue;
+        const AttributeVector &attrs = comp->Attributes();
+        for(uint j = 0; j < attrs.size() && j < 256; ++j)
+        {
+            if (!attrs[j])
+                continue;
+            if (owner_->IsServer())
+            {
+                UserConnectionList& users = owner_->GetKristalliModule()->GetUserConnections();
+                for(UserConnectionList::iterator k = users.begin(); k != users.end(); ++k)
+                    if ((*k)->syncState)
+                        (*k)->syncState->MarkAttributeDirty(entity->Id(), comp->Id(), (u8)j);
+            }
+            else
+                server_syncstate_.MarkAttributeDirty(entity->Id(), comp->Id(), (u8)j);
+        }
+    }
+}
+
 void SyncManager::OnActionTriggered(Entity *entity, const QString &action, const QStringList &params, EntityAction::ExecTypeField type)
 {
     // If we are the server and the local script on this machine has requested a script to be executed on the server, it
@@ -6,6 +6,7 @@
 #include "SyncState.h"
 #include "SceneFwd.h"
 #include "AttributeChangeType.h"
+#include "AttributeChangeSet.h"
 #include "EntityAction.h"
 
 #include <kNetFwd.h>
@@ -59,6 +60,9 @@ private slots:
     /// Trigger EC sync because of component attributes changing
     void OnAttributeChanged(IComponent* comp, IAttribute* attr, AttributeChange::Type change);
 
+    /// Trigger EC sync because of a coalesced set of component attributes changing (batched attribute change dispatch)
+    void OnAttributesChanged(IComponent* comp, const AttributeChangeSet &changes);
+
     /// Trigger EC sync because of component attribute added
     void OnAttributeAdded(IComponent* comp, IAttribute* attr, AttributeChange::Type change);
 
@@ -77,16 +81,26 @@ private slots:
     /// Trigger sync of entity removal
     void OnEntityRemoved(Entity* entity, AttributeChange::Type change);
 
+    /// Stop replicating the attribute changes of an entity that was moved to the entity pool
+    void OnEntityDeactivated(Entity* entity, AttributeChange::Type change);
+
+    /// Trigger sync of the attribute changes that were held back while a pooled entity was inactive
+    void OnEntityReactivated(Entity* entity, AttributeChange::Type change);
+
     /// Trigger sync of entity action.
     void OnActionTriggered(Entity *entity, const QString &action, const QStringList &params, EntityAction::ExecTypeField type);
 
     /// Trigger sync of entity action to specific user
     void OnUserActionTriggered(UserConnection* user, Entity *entity, const QString &action, const QStringList &params);
 
-    /// Handle a Kristalli protocol message
-    void HandleKristalliMessage(kNet::MessageConnection* source, kNet::packet_id_t, kNet::message_id_t id, const char* data, size_t numBytes);
-
 private:
+    /// Registers a scene sync message handler to KristalliProtocolModule, wrapped by InvokeSyncMessageHandler.
+    void RegisterSyncMessageHandler(kNet::message_id_t id, const QString &name, const KristalliMessageHandler &handler);
+
+    /// Invokes a scene sync message handler, logs the network exceptions it throws, and clears the current sender afterwards.
+    void InvokeSyncMessageHandler(const KristalliMessageHandler &handler, kNet::message_id_t messageId, kNet::MessageConnection* source,
+        kNet::packet_id_t packetId, const char* data, size_t numBytes);
+
     /// Queue a message to the receiver from a given DataSerializer.
     void QueueMessage(kNet::MessageConnection* connection, kNet::message_id_t id, bool reliable, bool inOrder, kNet::DataSerializer& ds);
     
@@ -154,6 +168,9 @@ private:
     
     /// Server sync state (client only)
     SceneSyncState server_syncstate_;
+
+    /// Components of inactive pooled entities whose attribute changes were not replicated, by entity ID
+    std::map<entity_id_t, std::set<component_id_t> > inactiveChanges_;
     
     /// Fixed buffers for crafting messages
     char createEntityBuffer_[64 * 1024];
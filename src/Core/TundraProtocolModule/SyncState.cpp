@@ -27,6 +27,26 @@ SceneSyncState::~SceneSyncState()
 {
 }
 
+size_t SceneSyncState::MemoryUsage() const
+{
+    const size_t mapNodeOverhead = 4 * sizeof(void*); // Color, parent and child links of a std::map node.
+    const size_t listNodeOverhead = 2 * sizeof(void*); // Links of a std::list node.
+
+    size_t usage = sizeof(SceneSyncState) + pendingEntities_.capacity() * sizeof(entity_id_t);
+    usage += dirtyQueue.size() * (sizeof(EntitySyncState*) + listNodeOverhead);
+    usage += entityInterpolations.size() * (sizeof(std::pair<const entity_id_t, RigidBodyInterpolationState>) + mapNodeOverhead);
+    for(std::map<entity_id_t, EntitySyncState>::const_iterator iter = entities.begin(); iter != entities.end(); ++iter)
+    {
+        const EntitySyncState &entityState = iter->second;
+        usage += sizeof(std::pair<const entity_id_t, EntitySyncState>) + mapNodeOverhead;
+        usage += entityState.dirtyQueue.size() * (sizeof(ComponentSyncState*) + listNodeOverhead);
+        for(std::map<component_id_t, ComponentSyncState>::const_iterator compIter = entityState.components.begin(); compIter != entityState.components.end(); ++compIter)
+            usage += sizeof(std::pair<const component_id_t, ComponentSyncState>) + mapNodeOverhead +
+                compIter->second.newAndRemovedAttributes.size() * (sizeof(std::pair<const u8, bool>) + mapNodeOverhead);
+    }
+    return usage;
+}
+
 // Public slots
 
 /// @remark Enables a 'pending' logic in SyncManager, with which a script can throttle the sending of entities to clients.
@@ -255,6 +275,15 @@ void SceneSyncState::MarkAttributeDirty(entity_id_t id, component_id_t compId, u
     compState.MarkAttributeDirty(attrIndex);
 }
 
+void SceneSyncState::MarkAttributesDirty(entity_id_t id, component_id_t compId, const u8 *attrBitmask)
+{
+    MarkEntityDirty(id);
+    EntitySyncState& entityState = entities[id];
+    entityState.MarkComponentDirty(compId);
+    ComponentSyncState& compState = entityState.components[compId];
+    compState.MarkAttributesDirty(attrBitmask);
+}
+
 void SceneSyncState::MarkAttributeCreated(entity_id_t id, component_id_t compId, u8 attrIndex)
 {
     MarkEntityDirty(id);
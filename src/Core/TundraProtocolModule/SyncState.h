@@ -35,6 +35,13 @@ struct ComponentSyncState
         dirtyAttributes[attrIndex >> 3] |= (1 << (attrIndex & 7));
     }
     
+    /// Marks dirty all the attributes set in a 256-bit attribute bitmask, such as AttributeChangeSet::dirty.
+    void MarkAttributesDirty(const u8 *attrBitmask)
+    {
+        for (unsigned i = 0; i < 32; ++i)
+            dirtyAttributes[i] |= attrBitmask[i];
+    }
+    
     void MarkAttributeCreated(u8 attrIndex)
     {
         newAndRemovedAttributes[attrIndex] = true;
@@ -318,6 +325,9 @@ public slots:
 public:
     void SetParentScene(SceneWeakPtr scene);
     void Clear();
+
+    /// Returns the approximate number of bytes used by this sync state.
+    size_t MemoryUsage() const;
     
     void RemoveFromQueue(entity_id_t id);
 
@@ -331,6 +341,7 @@ public:
     void MarkComponentRemoved(entity_id_t id, component_id_t compId);
 
     void MarkAttributeDirty(entity_id_t id, component_id_t compId, u8 attrIndex);
+    void MarkAttributesDirty(entity_id_t id, component_id_t compId, const u8 *attrBitmask);
     void MarkAttributeCreated(entity_id_t id, component_id_t compId, u8 attrIndex);
     void MarkAttributeRemoved(entity_id_t id, component_id_t compId, u8 attrIndex);
 
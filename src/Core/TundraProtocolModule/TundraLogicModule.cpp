@@ -18,6 +18,8 @@
 #include "ConfigAPI.h"
 #include "IComponentFactory.h"
 #include "Scene.h"
+#include "SceneJournal.h"
+#include "AssetPrefetchManifest.h"
 #include "AssetAPI.h"
 #include "ConsoleAPI.h"
 #include "AssetAPI.h"
@@ -65,6 +67,12 @@
 #include "EC_LaserPointer.h"
 #endif
 
+#ifdef TUNDRA_NO_OGRE
+#include "PlaceholderComponent.h"
+#endif
+
+#include <algorithm>
+
 #include "MemoryLeakCheck.h"
 
 namespace TundraLogic
@@ -72,6 +80,171 @@ namespace TundraLogic
 
 static const unsigned short cDefaultPort = 2345;
 
+#ifdef TUNDRA_NO_OGRE
+typedef boost::shared_ptr<PlaceholderComponentFactory> PlaceholderComponentFactoryPtr;
+
+/// Registers attribute-only placeholders for the components that need Ogre or a UI, and so are not built in a headless server build.
+/** The attributes must match the original components, in declaration order and with the same default values. */
+static void RegisterPlaceholderComponents(SceneAPI *sceneAPI)
+{
+    std::vector<PlaceholderComponentFactoryPtr> factories;
+    PlaceholderComponentFactoryPtr factory;
+
+    // TundraProtocolModule's optional ECs
+#ifndef EC_Highlight_ENABLED
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_Highlight", 28));
+    factory->AddAttribute("bool", "Is visible")
+        .AddAttribute("color", "Solid color", "0.3 0.5 0.1 0.5")
+        .AddAttribute("color", "Outline color", "1 1 1 0.5");
+    factories.push_back(factory);
+#endif
+#ifndef EC_HoveringText_ENABLED
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_HoveringText", 29));
+    factory->AddAttribute("string", "Text")
+        .AddAttribute("string", "Font", "Arial")
+        .AddAttribute("int", "Font Size", "100")
+        .AddAttribute("color", "Font Color")
+        .AddAttribute("color", "Background Color", "1 1 1 0")
+        .AddAttribute("color", "Border Color", "0 0 0 0")
+        .AddAttribute("real", "Border Thickness")
+        .AddAttribute("float3", "Position")
+        .AddAttribute("bool", "Use Gradient")
+        .AddAttribute("color", "Gradient Start", "0 0 0 1")
+        .AddAttribute("color", "Gradient End", "1 1 1 1")
+        .AddAttribute("real", "Overlay Alpha", "1")
+        .AddAttribute("real", "Width", "1")
+        .AddAttribute("real", "Height", "1")
+        .AddAttribute("real", "Texture Width", "256")
+        .AddAttribute("real", "Texture Height", "256")
+        .AddAttribute("float2", "Corner Radius", "20 20")
+        .AddAttribute("bool", "Enable Mipmapping", "true")
+        .AddAttribute("assetreference", "Material", "local://HoveringText.material");
+    factories.push_back(factory);
+#endif
+#ifndef EC_ParticleSystem_ENABLED
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_ParticleSystem", 27));
+    factory->AddAttribute("assetreference", "Particle ref")
+        .AddAttribute("bool", "Cast shadows")
+        .AddAttribute("bool", "Enabled", "true")
+        .AddAttribute("real", "Rendering distance");
+    factories.push_back(factory);
+#endif
+#ifndef EC_PlanarMirror_ENABLED
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_PlanarMirror", 34));
+    factory->AddAttribute("bool", "Show reflection plane", "true");
+    factories.push_back(factory);
+#endif
+#ifndef EC_Billboard_ENABLED
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_Billboard", 2));
+    factory->AddAttribute("assetreference", "Material ref")
+        .AddAttribute("float3", "Position")
+        .AddAttribute("real", "Size X", "1")
+        .AddAttribute("real", "Size Y", "1")
+        .AddAttribute("real", "Rotation")
+        .AddAttribute("bool", "Show billboard", "true");
+    factories.push_back(factory);
+#endif
+#ifndef EC_TransformGizmo_ENABLED
+    factories.push_back(PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_TransformGizmo", 30)));
+#endif
+#ifndef EC_LaserPointer_ENABLED
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_LaserPointer", 40));
+    factory->AddAttribute("float3", "Start position")
+        .AddAttribute("float3", "End position")
+        .AddAttribute("color", "Color", "1 0 0 1")
+        .AddAttribute("bool", "Enabled");
+    factories.push_back(factory);
+#endif
+
+    // EnvironmentModule
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_EnvironmentLight", 8));
+    factory->AddAttribute("color", "Sunlight color", "0.639 0.639 0.639 1")
+        .AddAttribute("color", "Ambient light color", "0.364 0.364 0.364 1")
+        .AddAttribute("float3", "Sunlight direction vector", "-1 -1 -1")
+        .AddAttribute("bool", "Sunlight cast shadows", "true")
+        .AddAttribute("real", "Brightness", "1");
+    factories.push_back(factory);
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_Fog", 9));
+    factory->AddAttribute("int", "Mode", "3")
+        .AddAttribute("color", "Color", "0.707792 0.770537 0.831373 1")
+        .AddAttribute("real", "Start distance", "100")
+        .AddAttribute("real", "End distance", "2000")
+        .AddAttribute("real", "Exponential density", "0.001");
+    factories.push_back(factory);
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_Sky", 10));
+    factory->AddAttribute("assetreference", "Material", "RexSkyBox")
+        .AddAttribute("assetreferencelist", "Texture")
+        .AddAttribute("real", "Distance", "50")
+        .AddAttribute("quat", "Orientation")
+        .AddAttribute("bool", "Draw first", "true");
+    factories.push_back(factory);
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_Terrain", 11));
+    factory->AddAttribute("transform", "Transform")
+        .AddAttribute("int", "Grid Width", "1")
+        .AddAttribute("int", "Grid Height", "1")
+        .AddAttribute("real", "Tex. U scale", "0.13")
+        .AddAttribute("real", "Tex. V scale", "0.13")
+        .AddAttribute("assetreference", "Material", "Ogre Media:RexTerrainPCF.material")
+        .AddAttribute("assetreference", "Heightmap");
+    factories.push_back(factory);
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_WaterPlane", 12));
+    factory->AddAttribute("int", "x-size", "5000")
+        .AddAttribute("int", "y-size", "5000")
+        .AddAttribute("int", "Depth", "20")
+        .AddAttribute("float3", "Position")
+        .AddAttribute("quat", "Rotation")
+        .AddAttribute("real", "U factor", "0.0002")
+        .AddAttribute("real", "V factor", "0.0002")
+        .AddAttribute("int", "Segments in x", "10")
+        .AddAttribute("int", "Segments in y", "10")
+        .AddAttribute("string", "Material", "Ocean")
+        .AddAttribute("assetreference", "Material ref")
+        .AddAttribute("color", "Fog color", "0.2 0.4 0.35 1")
+        .AddAttribute("real", "Fog start dist.", "100")
+        .AddAttribute("real", "Fog end dist.", "2000")
+        .AddAttribute("int", "Fog mode", "3")
+        .AddAttribute("real", "Fog exponential density", "0.001");
+    factories.push_back(factory);
+
+    // AvatarModule
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_Avatar", 1));
+    factory->AddAttribute("assetreference", "Appearance ref");
+    factories.push_back(factory);
+
+    // SceneWidgetComponents
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_SlideShow", 41));
+    factory->AddAttribute("qvariantlist", "Slides")
+        .AddAttribute("int", "Change Interval")
+        .AddAttribute("int", "Current Slide")
+        .AddAttribute("int", "Render Submesh")
+        .AddAttribute("bool", "Enabled", "true")
+        .AddAttribute("bool", "Interactive")
+        .AddAttribute("bool", "Illuminating", "true");
+    factories.push_back(factory);
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_WebView", 36));
+    factory->AddAttribute("string", "View URL")
+        .AddAttribute("qpoint", "View Size", "800 600")
+        .AddAttribute("int", "Render Submesh")
+        .AddAttribute("int", "Render FPS")
+        .AddAttribute("bool", "Enabled", "true")
+        .AddAttribute("bool", "Interactive")
+        .AddAttribute("bool", "Illuminating", "true")
+        .AddAttribute("int", "ControllerId", "-1");
+    factories.push_back(factory);
+    factory = PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_WidgetBillboard", 42));
+    factory->AddAttribute("assetreference", "UI ref")
+        .AddAttribute("bool", "Visible", "true")
+        .AddAttribute("bool", "Accept Input", "true")
+        .AddAttribute("float3", "Position")
+        .AddAttribute("int", "Pixels per meter", "300");
+    factories.push_back(factory);
+    factories.push_back(PlaceholderComponentFactoryPtr(new PlaceholderComponentFactory("EC_WidgetCanvas", 35)));
+
+    for(size_t i = 0; i < factories.size(); ++i)
+        sceneAPI->RegisterComponentFactory(factories[i]);
+}
+#endif
+
 TundraLogicModule::TundraLogicModule() :
     IModule("TundraLogic"),
     autoStartServer_(false),
@@ -120,6 +293,11 @@ void TundraLogicModule::Load()
 #ifdef EC_LaserPointer_ENABLED
     framework_->Scene()->RegisterComponentFactory(ComponentFactoryPtr(new GenericComponentFactory<EC_LaserPointer>));
 #endif
+
+#ifdef TUNDRA_NO_OGRE
+    // The headless server keeps the data of the components it cannot build, so that scenes made with the full client survive a load and save.
+    RegisterPlaceholderComponents(framework_->Scene());
+#endif
 }
 
 void TundraLogicModule::Initialize()
@@ -151,6 +329,10 @@ void TundraLogicModule::Initialize()
         "Saves scene into XML or binary. Usage: savescene(filename,asBinary=false,saveTemporaryEntities=false,saveLocalEntities=true)",
         this, SLOT(SaveScene(QString, bool, bool, bool)), SLOT(SaveScene(QString)));
 
+    framework_->Console()->RegisterCommand("savescenebackground",
+        "Saves scene into XML or binary on a worker thread. Usage: savescenebackground(filename,asBinary=false,saveTemporaryEntities=false,saveLocalEntities=true)",
+        this, SLOT(SaveSceneInBackground(QString, bool, bool, bool)), SLOT(SaveSceneInBackground(QString)));
+
     framework_->Console()->RegisterCommand("loadscene",
         "Loads scene from XML or binary. Usage: loadscene(filename,clearScene=true,useEntityIDsFromFile=true)",
         this, SLOT(LoadScene(QString, bool, bool)));
@@ -165,6 +347,16 @@ void TundraLogicModule::Initialize()
         "Usage: importmesh(filename, pos = 0 0 0, rot = 0 0 0, scale = 1 1 1, inspectForMaterialsAndSkeleton=true)",
         this, SLOT(ImportMesh(QString, const float3 &, const float3 &, const float3 &, bool)), SLOT(ImportMesh(QString)));
 
+    framework_->Console()->RegisterCommand("sceneMemory",
+        "Prints the approximate memory usage of the scenes per component type and per entity, and the sync state of each client connection. "
+        "Usage: sceneMemory(numEntities=10)",
+        this, SLOT(PrintSceneMemoryUsage(int)), SLOT(PrintSceneMemoryUsage()));
+
+    framework_->Console()->RegisterCommand("saveprefetchmanifest",
+        "Writes the assets of a scene file, or of the current scene, ordered by their distance from the origin to an asset prefetch manifest. "
+        "Usage: saveprefetchmanifest(manifestFilename,sceneFilename=\"\")",
+        this, SLOT(SavePrefetchManifest(QString, QString)), SLOT(SavePrefetchManifest(QString)));
+
     // Take a pointer to KristalliProtocolModule so that we don't have to take/check it every time
     kristalliModule_ = framework_->GetModule<KristalliProtocolModule>();
     if (!kristalliModule_)
@@ -217,6 +409,7 @@ void TundraLogicModule::Initialize()
 void TundraLogicModule::Uninitialize()
 {
     kristalliModule_ = 0;
+    sceneJournal_.reset();
     syncManager_.reset();
     client_.reset();
     server_.reset();
@@ -227,12 +420,29 @@ void TundraLogicModule::Update(f64 frametime)
     PROFILE(TundraLogicModule_Update);
     ///\todo Remove this hack and find a better solution
     static bool checkDefaultServerStart = true;
+    if (checkDefaultServerStart && framework_->HasCommandLineParameter("--prefetchManifestOut"))
+    {
+        // Only inspect the startup scene for its assets, without loading it.
+        WriteStartupPrefetchManifest();
+        checkDefaultServerStart = false;
+    }
     if (checkDefaultServerStart)
     {
         if (autoStartServer_)
             server_->Start(autoStartServerPort_); 
+        // A journal persisted by an earlier run has a newer state of the scene than the startup scene it was started from,
+        // so the startup scene is not loaded over the scene that will be recovered.
+        QStringList journals = framework_->CommandLineParameters("--journal");
+        const bool recoverJournal = !journals.isEmpty() && SceneJournal::HasPersistedState(journals.first().trimmed());
         if (framework_->HasCommandLineParameter("--file")) // Load startup scene here (if we have one)
-            LoadStartupScene();
+        {
+            if (recoverJournal)
+                LogInfo("TundraLogicModule: Recovering the scene from the journal " + journals.first().trimmed() + " instead of loading the startup scene.");
+            else
+                LoadStartupScene();
+        }
+        if (framework_->HasCommandLineParameter("--journal"))
+            StartSceneJournal();
         checkDefaultServerStart = false;
     }
     ///\todo Remove this hack and find a better solution
@@ -330,6 +540,54 @@ void TundraLogicModule::LoadStartupScene()
     }
 }
 
+void TundraLogicModule::StartSceneJournal()
+{
+    QStringList files = framework_->CommandLineParameters("--journal");
+    if (files.isEmpty())
+    {
+        LogError("TundraLogicModule: --journal specified without a value.");
+        return;
+    }
+
+    Scene *mainScene = framework_->Scene()->MainCameraScene();
+    ScenePtr scene = mainScene ? mainScene->shared_from_this() : ScenePtr();
+    if (!scene)
+        scene = framework_->Scene()->CreateScene("TundraServer", true, true);
+    if (!scene)
+    {
+        LogError("TundraLogicModule: No scene to journal.");
+        return;
+    }
+
+    sceneJournal_ = boost::shared_ptr<SceneJournal>(new SceneJournal(scene, files.first().trimmed()));
+    if (sceneJournal_->HasPersistedState())
+        sceneJournal_->Recover();
+    else
+        sceneJournal_->Compact();
+}
+
+void TundraLogicModule::WriteStartupPrefetchManifest()
+{
+    QStringList outputs = framework_->CommandLineParameters("--prefetchManifestOut");
+    QStringList files = framework_->CommandLineParameters("--file");
+    if (outputs.isEmpty() || files.isEmpty())
+        LogError("TundraLogicModule: --prefetchManifestOut needs a manifest filename and a startup scene specified with --file.");
+    else
+    {
+        // If the file parameter uses the full storage specifier format, parse the "src" keyvalue
+        QString file = files.first();
+        if (file.indexOf(';') != -1 || file.indexOf('=') != -1)
+            file = AssetAPI::ParseAssetStorageString(file)["src"];
+
+        AssetAPI::AssetRefType sceneRefType = AssetAPI::ParseAssetRef(file);
+        if (sceneRefType != AssetAPI::AssetRefLocalPath && sceneRefType != AssetAPI::AssetRefRelativePath)
+            LogError("TundraLogicModule: --prefetchManifestOut supports only startup scenes on the local file system, not " + file);
+        else
+            SavePrefetchManifest(outputs.first(), file);
+    }
+    framework_->Exit();
+}
+
 void TundraLogicModule::StartupSceneTransfedSucceeded(AssetPtr asset)
 {
     QString sceneDiskSource = asset->DiskSource();
@@ -367,6 +625,27 @@ bool TundraLogicModule::SaveScene(QString filename, bool asBinary, bool saveTemp
     return success;
 }
 
+bool TundraLogicModule::SaveSceneInBackground(QString filename, bool asBinary, bool saveTemporaryEntities, bool saveLocalEntities)
+{
+    Scene *scene = GetFramework()->Scene()->MainCameraScene();
+    if (!scene)
+    {
+        LogError("TundraLogicModule::SaveSceneInBackground: No active scene found!");
+        return false;
+    }
+    filename = filename.trimmed();
+    if (filename.isEmpty())
+    {
+        LogError("TundraLogicModule::SaveSceneInBackground: Empty filename given!");
+        return false;
+    }
+
+    if (asBinary)
+        return scene->SaveSceneBinaryInBackground(filename, saveTemporaryEntities, saveLocalEntities);
+    else
+        return scene->SaveSceneXMLInBackground(filename, saveTemporaryEntities, saveLocalEntities);
+}
+
 bool TundraLogicModule::LoadScene(QString filename, bool clearScene, bool useEntityIDsFromFile)
 {
     Scene *scene = GetFramework()->Scene()->MainCameraScene();
@@ -382,6 +661,16 @@ bool TundraLogicModule::LoadScene(QString filename, bool clearScene, bool useEnt
         return false;
     }
 
+    // With --incrementalLoad the entities are instantiated over several frames, so that the main loop keeps running meanwhile.
+    if (framework_->HasCommandLineParameter("--incrementalLoad"))
+    {
+        float msPerFrame = 10.f;
+        QStringList budgetParam = framework_->CommandLineParameters("--incrementalLoad");
+        if (budgetParam.size() > 0 && budgetParam.first().toFloat() > 0.f)
+            msPerFrame = budgetParam.first().toFloat();
+        return scene->LoadSceneIncremental(filename, clearScene, useEntityIDsFromFile, AttributeChange::Default, msPerFrame);
+    }
+
     LogInfo("Loading startup scene from " + filename + " ...");
     kNet::PolledTimer timer;
     bool useBinary = filename.indexOf(".tbin", 0, Qt::CaseInsensitive) != -1;
@@ -445,6 +734,87 @@ bool TundraLogicModule::ImportMesh(QString filename, const float3 &pos, const fl
     return entity != 0;
 }
 
+bool TundraLogicModule::SavePrefetchManifest(QString manifestFilename, QString sceneFilename)
+{
+    manifestFilename = manifestFilename.trimmed();
+    sceneFilename = sceneFilename.trimmed();
+    if (manifestFilename.isEmpty())
+    {
+        LogError("TundraLogicModule::SavePrefetchManifest: Empty filename given!");
+        return false;
+    }
+
+    // Inspecting a scene file needs a scene for the component factories, but does not modify it.
+    Scene *scene = GetFramework()->Scene()->MainCameraScene();
+    ScenePtr inspectScene;
+    if (!scene && !sceneFilename.isEmpty())
+    {
+        inspectScene = framework_->Scene()->CreateScene("PrefetchManifest", false, true);
+        scene = inspectScene.get();
+    }
+    if (!scene)
+    {
+        LogError("TundraLogicModule::SavePrefetchManifest: No active scene found!");
+        return false;
+    }
+
+    AssetPrefetchManifest manifest;
+    if (sceneFilename.isEmpty())
+        manifest = scene->CreatePrefetchManifest();
+    else if (sceneFilename.indexOf(".tbin", 0, Qt::CaseInsensitive) != -1)
+        manifest = scene->CreatePrefetchManifest(scene->CreateSceneDescFromBinary(sceneFilename));
+    else
+        manifest = scene->CreatePrefetchManifest(scene->CreateSceneDescFromXml(sceneFilename));
+    if (inspectScene)
+        framework_->Scene()->RemoveScene(inspectScene->Name());
+
+    if (!manifest.SaveToFile(manifestFilename))
+        return false;
+    LogInfo(QString("Wrote prefetch manifest of %1 assets (%2 KB) to %3.").arg(manifest.NumAssets()).arg(manifest.TotalSize() / 1024).arg(manifestFilename));
+    return true;
+}
+
+void TundraLogicModule::PrintSceneMemoryUsage(int numEntities)
+{
+    const SceneMap &scenes = framework_->Scene()->Scenes();
+    for(SceneMap::const_iterator iter = scenes.begin(); iter != scenes.end(); ++iter)
+    {
+        SceneMemoryUsage usage = iter->second->MemoryUsage();
+        LogInfo(QString("Scene \"%1\": %2 KB total, %3 entities (%4 KB), components %5 KB, %6 pooled entities (%7 KB), scene %8 KB, %9 shared resources (%10 KB)")
+            .arg(iter->first).arg(usage.Total() / 1024).arg(usage.numEntities).arg(usage.entityBytes / 1024).arg(usage.componentBytes / 1024)
+            .arg(usage.numPooledEntities).arg(usage.pooledEntityBytes / 1024).arg(usage.sceneBytes / 1024)
+            .arg(usage.numSharedResources).arg(usage.sharedResourceBytes / 1024));
+
+        // Sort the component types by their memory usage
+        std::vector<std::pair<size_t, QString> > types;
+        for(std::map<QString, ComponentTypeMemoryUsage>::const_iterator typeIter = usage.componentTypes.begin(); typeIter != usage.componentTypes.end(); ++typeIter)
+            types.push_back(std::make_pair(typeIter->second.numBytes, typeIter->first));
+        std::sort(types.rbegin(), types.rend());
+        for(size_t i = 0; i < types.size(); ++i)
+        {
+            const ComponentTypeMemoryUsage &typeUsage = usage.componentTypes[types[i].second];
+            LogInfo(QString("  %1 %2 components %3 KB, avg. %4 bytes").arg(types[i].second, -30).arg(typeUsage.numComponents, 8)
+                .arg(typeUsage.numBytes / 1024, 8).arg(typeUsage.numBytes / std::max(typeUsage.numComponents, 1u)));
+        }
+
+        for(int i = 0; i < numEntities && i < (int)usage.entities.size(); ++i)
+        {
+            EntityPtr entity = iter->second->EntityById(usage.entities[i].first);
+            LogInfo(QString("  Entity %1 \"%2\": %3 bytes").arg(usage.entities[i].first).arg(entity ? entity->Name() : QString())
+                .arg(usage.entities[i].second));
+        }
+    }
+
+    if (IsServer())
+    {
+        const UserConnectionList &connections = kristalliModule_->GetUserConnections();
+        for(UserConnectionList::const_iterator iter = connections.begin(); iter != connections.end(); ++iter)
+            if ((*iter)->syncState)
+                LogInfo(QString("Sync state of connection %1: %2 entities, %3 KB").arg((int)(*iter)->userID)
+                    .arg((*iter)->syncState->entities.size()).arg((*iter)->syncState->MemoryUsage() / 1024));
+    }
+}
+
 bool TundraLogicModule::IsServer() const
 {
     return kristalliModule_->IsServer();
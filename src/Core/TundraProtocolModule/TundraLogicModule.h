@@ -11,6 +11,8 @@
 #include <kNetFwd.h>
 #include <kNet/Types.h>
 
+class SceneJournal;
+
 namespace TundraLogic
 {
 /// Implements the Tundra protocol server and client functionality.
@@ -50,6 +52,14 @@ public slots:
         @return Was the operation successful.*/
     bool SaveScene(QString filename, bool asBinary = false, bool saveTemporaryEntities = false, bool saveLocalEntities = true);
 
+    /// Saves scene to a file on a worker thread
+    /** Takes a snapshot of the scene and writes it on a worker thread, so that the main loop is not blocked for the serialization.
+        @param asBinary If true, saves as .tbin. Otherwise saves as .txml.
+        @param saveTemporaryEntities Do we want to save temporary entities.
+        @param saveLocalEntities Do we want to save local entities.
+        @return Was the save started.*/
+    bool SaveSceneInBackground(QString filename, bool asBinary = false, bool saveTemporaryEntities = false, bool saveLocalEntities = true);
+
     /// Loads scene from an XML file.
     /** @param asBinary If true, saves as .tbin. Otherwise saves as .txml.
         @param clearScene Do we want to clear existing scene contents.
@@ -76,6 +86,16 @@ public slots:
     bool ImportMesh(QString filename, const float3 &pos = float3(0.f,0.f,0.f), const float3 &rot = float3(0.f,0.f,0.f),
         const float3 &scale = float3(1.f,1.f,1.f), bool inspectForMaterialsAndSkeleton = true);
 
+    /// Prints the approximate memory usage of all scenes per component type, the largest entities, and the sync state of each client connection.
+    /** @param numEntities Number of the largest entities to print per scene. */
+    void PrintSceneMemoryUsage(int numEntities = 10);
+
+    /// Writes an asset prefetch manifest of a scene file, or of the current main scene.
+    /** @param manifestFilename File to write the manifest to.
+        @param sceneFilename The .txml or .tbin file to create the manifest from. If empty, the manifest is recorded from the current main scene.
+        @return Was the operation successful. */
+    bool SavePrefetchManifest(QString manifestFilename, QString sceneFilename = "");
+
 private slots:
     void StartupSceneTransfedSucceeded(AssetPtr asset);
     void StartupSceneTransferFailed(IAssetTransfer *transfer, QString reason);
@@ -87,12 +107,19 @@ private:
     /// Loads the startup scene(s) specified by --file command line parameter.
     void LoadStartupScene();
 
+    /// Starts journaling the main scene to the snapshot file specified by --journal command line parameter, recovering the scene first if it has been journaled before.
+    void StartSceneJournal();
+
+    /// Writes the prefetch manifest of the startup scene to the file specified by --prefetchManifestOut command line parameter, and exits.
+    void WriteStartupPrefetchManifest();
+
     boost::shared_ptr<SyncManager> syncManager_; ///< Sync manager
     boost::shared_ptr<Client> client_; ///< Client
     boost::shared_ptr<Server> server_; ///< Server
     KristalliProtocolModule *kristalliModule_; ///< KristalliProtocolModule pointer
     bool autoStartServer_; ///< Whether to autostart the server
     unsigned short autoStartServerPort_; ///< Autostart server port
+    boost::shared_ptr<SceneJournal> sceneJournal_; ///< Journal of the main scene, if enabled with --journal
 };
 
 }
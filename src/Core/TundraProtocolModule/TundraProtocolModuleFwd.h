@@ -7,10 +7,12 @@
 #pragma once
 
 #include <kNetFwd.h>
+#include <kNet/Types.h>
 
 #include <QString>
 
 #include <boost/smart_ptr.hpp>
+#include <boost/function.hpp>
 #include <list>
 #include <map>
 
@@ -34,6 +36,9 @@ struct EntitySyncState;
 struct ComponentSyncState;
 struct UserConnectedResponseData;
 
+/// Handler for an incoming Kristalli message: source connection, packet id, message data and its size in bytes. @see KristalliProtocolModule::RegisterMessageHandler.
+typedef boost::function<void(kNet::MessageConnection*, kNet::packet_id_t, const char*, size_t)> KristalliMessageHandler;
+
 typedef std::map<QString, QString> LoginPropertyMap; ///< propertyName-propertyValue map of login properties.
 
 struct MsgLogin;
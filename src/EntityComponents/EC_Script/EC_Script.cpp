@@ -15,6 +15,8 @@
 #include "AssetRefListener.h"
 #include "LoggingFunctions.h"
 
+#include <QTimer>
+
 #include "MemoryLeakCheck.h"
 
 EC_Script::~EC_Script()
@@ -37,6 +39,7 @@ void EC_Script::SetScriptInstance(IScriptInstance *instance)
         SAFE_DELETE(scriptInstance_);
     }
     scriptInstance_ = instance;
+    suspended_ = false;
 }
 
 void EC_Script::SetScriptApplication(EC_Script* app)
@@ -118,7 +121,8 @@ EC_Script::EC_Script(Scene* scene):
     className(this, "Script class name"),
     scriptInstance_(0),
     isClient_(false),
-    isServer_(false)
+    isServer_(false),
+    suspended_(false)
 {
     static AttributeMetadata scriptRefData;
     static AttributeMetadata runModeData;
@@ -240,6 +244,34 @@ void EC_Script::RegisterActions()
     {
         entity->ConnectAction("RunScript", this, SLOT(Run(const QString &)));
         entity->ConnectAction("UnloadScript", this, SLOT(Unload(const QString &)));
+        connect(entity, SIGNAL(Deactivated(Entity*, AttributeChange::Type)), SLOT(OnEntityDeactivated()), Qt::UniqueConnection);
+        connect(entity, SIGNAL(Reactivated(Entity*, AttributeChange::Type)), SLOT(OnEntityReactivated()), Qt::UniqueConnection);
     }
 }
 
+void EC_Script::OnEntityDeactivated()
+{
+    QTimer::singleShot(0, this, SLOT(SuspendScript()));
+}
+
+void EC_Script::SuspendScript()
+{
+    // The entity may have been reactivated already
+    Entity *entity = ParentEntity();
+    if (!entity || entity->IsActive() || !scriptInstance_ || !scriptInstance_->IsEvaluated() || suspended_)
+        return;
+
+    scriptInstance_->Unload();
+    suspended_ = true;
+}
+
+void EC_Script::OnEntityReactivated()
+{
+    if (!suspended_ || !scriptInstance_)
+        return;
+
+    suspended_ = false;
+    scriptInstance_->Load();
+    scriptInstance_->Run();
+}
+
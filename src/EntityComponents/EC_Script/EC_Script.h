@@ -156,6 +156,15 @@ private slots:
     /// Registers the actions this component provides when parent entity is set.
     void RegisterActions();
 
+    /// Called when the parent entity has been moved to the entity pool. Suspends the script on the next frame.
+    void OnEntityDeactivated();
+
+    /// Unloads the script of an inactive entity. Deferred, as the script itself may have released its entity.
+    void SuspendScript();
+
+    /// Called when the parent entity has been taken from the entity pool. Runs the script again if it was suspended.
+    void OnEntityReactivated();
+
 private:
     /// Handles the downloading of script assets.
     std::vector<boost::shared_ptr<AssetRefListener> > scriptAssets;
@@ -170,4 +179,6 @@ private:
     bool isClient_;
     /// IsServer flag, for checking run mode
     bool isServer_;
+    /// True if the script was running when it was unloaded because of the deactivation of the parent entity
+    bool suspended_;
 };
@@ -8,6 +8,18 @@
 #include "ScriptAsset.h"
 #include "AssetAPI.h"
 
+namespace
+{
+/// Text and unresolved asset references of a script asset, decoded on an asset load thread.
+class ScriptDecodeData : public IAssetDecodeData
+{
+public:
+    QString content;
+    std::vector<std::pair<QString, QString> > refs;
+    QStringList includes;
+};
+}
+
 ScriptAsset::~ScriptAsset()
 {
     Unload();
@@ -29,6 +41,26 @@ bool ScriptAsset::DeserializeFromData(const u8 *data, size_t numBytes, bool allo
     return true;
 }
 
+AssetDecodeDataPtr ScriptAsset::DecodeData(const u8 *data, size_t numBytes) const
+{
+    boost::shared_ptr<ScriptDecodeData> decoded(new ScriptDecodeData);
+    decoded->content = QByteArray((const char *)data, numBytes);
+    FindReferences(decoded->content, decoded->refs, decoded->includes);
+    return decoded;
+}
+
+bool ScriptAsset::LoadFromDecodedData(const AssetDecodeDataPtr &decoded)
+{
+    const ScriptDecodeData *script = dynamic_cast<const ScriptDecodeData *>(decoded.get());
+    if (!script)
+        return false;
+
+    scriptContent = script->content;
+    ResolveReferences(script->refs, script->includes);
+    assetAPI->AssetLoadCompleted(Name());
+    return true;
+}
+
 bool ScriptAsset::SerializeTo(std::vector<u8> &dst, const QString &serializationParameters) const
 {
     QByteArray arr(scriptContent.toStdString().c_str());
@@ -38,11 +70,33 @@ bool ScriptAsset::SerializeTo(std::vector<u8> &dst, const QString &serialization
 }
 
 void ScriptAsset::ParseReferences()
+{
+    std::vector<std::pair<QString, QString> > refs;
+    QStringList includes;
+    FindReferences(scriptContent, refs, includes);
+    ResolveReferences(refs, includes);
+}
+
+void ScriptAsset::FindReferences(const QString &content, std::vector<std::pair<QString, QString> > &refs, QStringList &includes)
+{
+    std::string text = content.toStdString();
+    boost::sregex_iterator searchEnd;
+
+    // Script asset dependencies are expressed in code comments using lines like "// !ref: http://myserver.com/myasset.png".
+    // The asset type can be specified using a comma: "// !ref: http://myserver.com/avatarasset.xml, Avatar".
+    boost::regex expression("!ref:\\s*(.*?)(\\s*,\\s*(.*?))?\\s*(\\n|$)");
+    for(boost::sregex_iterator iter(text.begin(), text.end(), expression); iter != searchEnd; ++iter)
+        refs.push_back(std::make_pair(QString((*iter)[1].str().c_str()), (*iter)[3].matched ? QString((*iter)[3].str().c_str()) : QString()));
+
+    expression = boost::regex("engine.IncludeFile\\(\\s*\"\\s*(.*?)\\s*\"\\s*\\)");
+    for(boost::sregex_iterator iter(text.begin(), text.end(), expression); iter != searchEnd; ++iter)
+        includes << (*iter)[1].str().c_str();
+}
+
+void ScriptAsset::ResolveReferences(const std::vector<std::pair<QString, QString> > &refs, const QStringList &includes)
 {
     references.clear();
     QStringList addedRefs;
-    std::string content = scriptContent.toStdString();
-    boost::sregex_iterator searchEnd;
 
     // In headless mode we dont want to mark certain asset types as
     // dependencies for the script, as they will fail Load() anyways
@@ -50,15 +104,11 @@ void ScriptAsset::ParseReferences()
     if (assetAPI->IsHeadless())
         ignoredAssetTypes << "QtUiFile" << "Texture" << "OgreParticle" << "OgreMaterial" << "Audio";
 
-    // Script asset dependencies are expressed in code comments using lines like "// !ref: http://myserver.com/myasset.png".
-    // The asset type can be specified using a comma: "// !ref: http://myserver.com/avatarasset.xml, Avatar".
-    boost::regex expression("!ref:\\s*(.*?)(\\s*,\\s*(.*?))?\\s*(\\n|$)");
-    for(boost::sregex_iterator iter(content.begin(), content.end(), expression); iter != searchEnd; ++iter)
+    for(size_t i = 0; i < refs.size(); ++i)
     {
         AssetReference ref;
-        ref.ref = assetAPI->ResolveAssetRef(Name(), (*iter)[1].str().c_str());
-        if ((*iter)[3].matched)
-            ref.type = (*iter)[3].str().c_str();
+        ref.ref = assetAPI->ResolveAssetRef(Name(), refs[i].first);
+        ref.type = refs[i].second;
         
         if (ignoredAssetTypes.contains(AssetAPI::GetResourceTypeFromAssetRef(ref.ref)))
             continue;
@@ -69,21 +119,19 @@ void ScriptAsset::ParseReferences()
         }
     }
 
-    expression = boost::regex("engine.IncludeFile\\(\\s*\"\\s*(.*?)\\s*\"\\s*\\)");
-    for(boost::sregex_iterator iter(content.begin(), content.end(), expression); iter != searchEnd; ++iter)
+    foreach(const QString &include, includes)
     {
         // First check if this is a relative ref directly to jsmodules
         // We don't want to add these to the references list as it will request them via asset api
         // with a relative path and it will always fail (as we dont have working file:// schema etc.)
         // The IncludeFile function will take care of relative refs when the script is ran.
-        QString regexResult = (*iter)[1].str().c_str();
-        if (QDir::isRelativePath(regexResult) && (regexResult.startsWith("jsmodules") ||
-            regexResult.startsWith("/jsmodules") || regexResult.startsWith("./jsmodules")))
+        if (QDir::isRelativePath(include) && (include.startsWith("jsmodules") ||
+            include.startsWith("/jsmodules") || include.startsWith("./jsmodules")))
             continue;
 
         // Ask AssetAPI to resolve the ref
         AssetReference ref;
-        ref.ref = assetAPI->ResolveAssetRef(Name(), regexResult);
+        ref.ref = assetAPI->ResolveAssetRef(Name(), include);
         if (!addedRefs.contains(ref.ref, Qt::CaseInsensitive))
         {
             references.push_back(ref);
@@ -5,6 +5,8 @@
 #include <boost/shared_ptr.hpp>
 #include "IAsset.h"
 
+#include <QStringList>
+
 /// Contains data of a script file loaded to the system.
 class ScriptAsset : public IAsset
 {
@@ -21,6 +23,16 @@ public:
     /// Load script asset from memory
     virtual bool DeserializeFromData(const u8 *data, size_t numBytes, bool allowAsynchronous);
 
+    /// The script text is converted and searched for asset references on the asset load threads.
+    /// Only the found references are resolved on the main thread.
+    virtual bool SupportsThreadedDecode() const { return true; }
+
+    /// Converts the script text and finds the asset references in it. Called on an asset load thread.
+    virtual AssetDecodeDataPtr DecodeData(const u8 *data, size_t numBytes) const;
+
+    /// Takes the script text produced by DecodeData and resolves its asset references.
+    virtual bool LoadFromDecodedData(const AssetDecodeDataPtr &decoded);
+
     /// Load script asset into memory
     virtual bool SerializeTo(std::vector<u8> &dst, const QString &serializationParameters) const;
 
@@ -42,6 +54,15 @@ public:
 private slots:
     /// Parse internal references from script
     void ParseReferences();
+
+private:
+    /// Finds the asset references in the script text, without resolving them. Does not access AssetAPI, so that it can be called on an asset load thread.
+    /** @param refs [out] The "!ref:" references, and their asset types or empty strings if the type was not specified.
+        @param includes [out] The files included with engine.IncludeFile. */
+    static void FindReferences(const QString &content, std::vector<std::pair<QString, QString> > &refs, QStringList &includes);
+
+    /// Resolves the references found by FindReferences and stores them to the references member.
+    void ResolveReferences(const std::vector<std::pair<QString, QString> > &refs, const QStringList &includes);
 };
 
 typedef boost::shared_ptr<ScriptAsset> ScriptAssetPtr;
@@ -14,6 +14,7 @@
 #include "FrameAPI.h"
 #include "IAsset.h"
 #include "IAssetTransfer.h"
+#include "AssetRefListener.h"
 #include "EC_Placeable.h"
 #include "EC_SoundListener.h"
 #include "LoggingFunctions.h"
@@ -39,6 +40,10 @@ EC_Sound::EC_Sound(Scene* scene):
     static AttributeMetadata metaData("", "0", "1", "0.1");
     soundGain.SetMetadata(&metaData);
 
+    // Refer to the audio asset through an AssetRefListener, so that it is not unloaded to stay within the asset memory budget while in use.
+    soundAsset = AssetRefListenerPtr(new AssetRefListener());
+    connect(soundAsset.get(), SIGNAL(Loaded(AssetPtr)), this, SLOT(AudioAssetLoaded(AssetPtr)), Qt::UniqueConnection);
+
     connect(this, SIGNAL(ParentEntitySet()), SLOT(UpdateSignals()));
     connect(this, SIGNAL(AttributeChanged(IAttribute*, AttributeChange::Type)), SLOT(OnAttributeUpdated(IAttribute*)));
 }
@@ -54,11 +59,7 @@ void EC_Sound::OnAttributeUpdated(IAttribute *attribute)
         return;
 
     if (attribute == &soundRef)
-    {
-        AssetTransferPtr tranfer =  framework->Asset()->RequestAsset(soundRef.Get().ref);
-        if (tranfer.get())
-            connect(tranfer.get(), SIGNAL(Succeeded(AssetPtr)), this, SLOT(AudioAssetLoaded(AssetPtr)), Qt::UniqueConnection);
-    }
+        soundAsset->HandleAssetRefChange(&soundRef);
     else if (attribute == &playOnLoad)
     {
         /// \todo check sound channels audio asset if its different, then play the new one
@@ -66,7 +67,7 @@ void EC_Sound::OnAttributeUpdated(IAttribute *attribute)
         {
             if (soundRef.Get().ref.isEmpty())
                 return;
-            AssetPtr audioAsset = GetFramework()->Asset()->GetAsset(soundRef.Get().ref);
+            AssetPtr audioAsset = soundAsset->Asset();
             if (audioAsset.get())
             {
                 // Channel not created yet
@@ -136,7 +137,7 @@ void EC_Sound::PlaySound()
     if (soundRef.Get().ref.isEmpty())
         return;
 
-    AssetPtr audioAsset = GetFramework()->Asset()->GetAsset(soundRef.Get().ref);
+    AssetPtr audioAsset = soundAsset->Asset();
     if (!audioAsset)
     {
         LogWarning("PlaySound called before audio asset was loaded.");
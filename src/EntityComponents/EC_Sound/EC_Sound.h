@@ -142,4 +142,5 @@ private slots:
 private:
     ComponentPtr FindPlaceable() const;
     SoundChannelPtr soundChannel;
+    AssetRefListenerPtr soundAsset;
 };
@@ -46,6 +46,7 @@ TEST0 = "Example-skeleton"
 TEST1 = "js-viewer-server-test"
 TEST2 = "avatar-test"
 TEST3 = "launchtundra"
+TEST4 = "http-scheduler-test"
 # misc
 tempCount = "count.txt"
 tempErrors = "errors.txt"
@@ -82,6 +83,8 @@ def whichTestWasRun(option):
         avatarTest()
     elif option == TEST3:
         launchTundra()
+    elif option == TEST4:
+        httpSchedulerTest()
     else:
         print("Error: test config not found")
 
@@ -143,6 +146,25 @@ def launchTundra():
     outputFile = glob.glob(logDir + '/*') #everything in outputDir, script presumes test outputs everything to its own output folder, files can also be added to a list individually
     operation()
 
+def httpSchedulerTest():
+    global testName
+    global testComment
+    global errorPattern
+    global logDir
+    global logFile
+    global outputFile
+
+    testName = TEST4
+    testComment = "This test loads http assets from a local server, checking the request limits, the cache freshness TTL and revalidation"
+    logDir = "logs/http-scheduler"
+    errorPattern = [
+        'FAIL: ',
+        'Result: false'
+    ]
+    logFile = glob.glob(logDir + '/*.out')
+    outputFile = glob.glob(logDir + '/*.out') + glob.glob(logDir + '/*.js')
+    operation()
+
 def operation():
     global html
 
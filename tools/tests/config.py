@@ -64,3 +64,6 @@ wiresTempDir = os.path.abspath(os.path.join(scriptDir, 'wireshark_temp'))
 
 # FILE: LAUNCHTUNDRA-TEST
 tundraLogsDir = os.path.abspath(os.path.join(scriptDir, 'logs/launchtundra/'))
+
+# FILE: HTTP-SCHEDULER-TEST
+httpSchedulerLogsDir = os.path.abspath(os.path.join(scriptDir, 'logs/http-scheduler/'))
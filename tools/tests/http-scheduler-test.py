@@ -0,0 +1,199 @@
+#!/usr/local/bin/python
+
+##
+# Tests the http asset request scheduling of HttpAssetProvider against a local http server run in this process.
+# - the number of requests in flight stays within --httpMaxConnectionsPerHost and --httpMaxConnections
+# - with --httpCacheTtl, cached assets are loaded without contacting the server
+# - a cached file that has been deleted is downloaded again instead of failing
+# - without the TTL, cached assets are revalidated with If-Modified-Since and loaded from the cache on 304
+##
+import os
+import os.path
+import shutil
+import subprocess
+import threading
+import time
+import BaseHTTPServer
+import SocketServer
+from optparse import OptionParser
+import config
+import autoreport
+
+testName = "http-scheduler-test"
+
+#folder config
+scriptDir = config.scriptDir
+rexbinDir = config.rexbinDir
+logsDir = config.httpSchedulerLogsDir
+cacheDir = logsDir + "/assetcache"
+requestScript = logsDir + "/request.js"
+
+# test config
+numAssets = 40
+maxPerHost = 2
+maxTotal = 3
+cacheTtl = 3600
+responseDelay = 0.1 # seconds, so that the requests overlap
+hosts = ["127.0.0.1", "localhost"] # two host names for the same server, the scheduler limits them separately
+
+lastModified = "Mon, 01 Oct 2012 12:00:00 GMT"
+
+
+class RequestStats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with self.lock:
+            self.numRequests = 0
+            self.numNotModified = 0
+            self.inFlight = {}
+            self.maxInFlight = {}
+            self.totalInFlight = 0
+            self.maxTotalInFlight = 0
+
+    def started(self, host):
+        with self.lock:
+            self.numRequests += 1
+            self.inFlight[host] = self.inFlight.get(host, 0) + 1
+            self.maxInFlight[host] = max(self.maxInFlight.get(host, 0), self.inFlight[host])
+            self.totalInFlight += 1
+            self.maxTotalInFlight = max(self.maxTotalInFlight, self.totalInFlight)
+
+    def finished(self, host, notModified):
+        with self.lock:
+            self.inFlight[host] -= 1
+            self.totalInFlight -= 1
+            if notModified:
+                self.numNotModified += 1
+
+stats = RequestStats()
+
+
+class AssetHandler(BaseHTTPServer.BaseHTTPRequestHandler):
+    def do_GET(self):
+        host = self.headers.get("Host", "").split(":")[0]
+        stats.started(host)
+        notModified = False
+        try:
+            time.sleep(responseDelay)
+            if self.headers.get("If-Modified-Since"):
+                notModified = True
+                self.send_response(304)
+                self.end_headers()
+                return
+            body = "asset " + self.path
+            self.send_response(200)
+            self.send_header("Content-Type", "application/octet-stream")
+            self.send_header("Content-Length", str(len(body)))
+            self.send_header("Last-Modified", lastModified)
+            self.end_headers()
+            self.wfile.write(body)
+        finally:
+            stats.finished(host, notModified)
+
+    def log_message(self, format, *args):
+        pass
+
+
+class ThreadedHttpServer(SocketServer.ThreadingMixIn, BaseHTTPServer.HTTPServer):
+    daemon_threads = True
+
+
+def main():
+    makePreparations()
+    server = ThreadedHttpServer(("", 0), AssetHandler)
+    port = server.server_address[1]
+    serverThread = threading.Thread(target=server.serve_forever)
+    serverThread.daemon = True
+    serverThread.start()
+    makeScript(port)
+
+    os.chdir(rexbinDir)
+    results = []
+    results.append(runPass("download", ["--httpCacheTtl", str(cacheTtl)], numAssets, False))
+    results.append(runPass("ttl", ["--httpCacheTtl", str(cacheTtl)], 0, False))
+    removeCachedFiles()
+    results.append(runPass("deleted-cache-files", ["--httpCacheTtl", str(cacheTtl)], numAssets, False))
+    results.append(runPass("revalidate", [], numAssets, True))
+    os.chdir(scriptDir)
+
+    server.shutdown()
+    writeResult(all(results))
+    autoreport.autoreport(testName)
+
+def makePreparations():
+    if os.path.exists(logsDir):
+        shutil.rmtree(logsDir, ignore_errors=True)
+    os.makedirs(logsDir)
+
+def makeScript(port):
+    # Requests the assets from both host names, and exits when all of them have succeeded or failed.
+    refs = ["http://%s:%d/asset%d.bin" % (hosts[i % len(hosts)], port, i) for i in range(numAssets)]
+    with open(requestScript, 'w') as f:
+        f.write("var refs = [" + ", ".join(['"' + ref + '"' for ref in refs]) + "];\n")
+        f.write("""
+var numSucceeded = 0;
+var numFailed = 0;
+function CheckDone()
+{
+    if (numSucceeded + numFailed == refs.length)
+    {
+        print("HTTPTEST succeeded " + numSucceeded + " failed " + numFailed);
+        framework.Exit();
+    }
+}
+for(var i = 0; i < refs.length; ++i)
+{
+    var transfer = asset.RequestAsset(refs[i], "Binary", true);
+    transfer.Succeeded.connect(function(a) { ++numSucceeded; CheckDone(); });
+    transfer.Failed.connect(function(t, reason) { print("HTTPTEST failure: " + reason); ++numFailed; CheckDone(); });
+}
+""")
+
+def runPass(name, params, expectedRequests, expectNotModified):
+    stats.reset()
+    output = logsDir + "/" + name + ".out"
+    command = ["./Tundra", "--headless", "--assetCacheDir", cacheDir, "--run", requestScript,
+        "--httpMaxConnectionsPerHost", str(maxPerHost), "--httpMaxConnections", str(maxTotal)] + params
+    with open(output, 'w') as f:
+        subprocess.call(command, stdout=f, stderr=subprocess.STDOUT)
+    with open(output) as f:
+        log = f.read()
+
+    failures = []
+    if ("HTTPTEST succeeded %d failed 0" % numAssets) not in log:
+        failures.append("not all assets were loaded")
+    if stats.numRequests != expectedRequests:
+        failures.append("%d requests were made, expected %d" % (stats.numRequests, expectedRequests))
+    for host in stats.maxInFlight:
+        if stats.maxInFlight[host] > maxPerHost:
+            failures.append("%d requests were in flight to %s, the limit is %d" % (stats.maxInFlight[host], host, maxPerHost))
+    if stats.maxTotalInFlight > maxTotal:
+        failures.append("%d requests were in flight in total, the limit is %d" % (stats.maxTotalInFlight, maxTotal))
+    if expectNotModified and stats.numNotModified != expectedRequests:
+        failures.append("%d requests were revalidated with If-Modified-Since, expected %d" % (stats.numNotModified, expectedRequests))
+
+    with open(output, 'a') as f:
+        for failure in failures:
+            f.write("FAIL: " + name + ": " + failure + "\n")
+    print(name + ": " + ("ok" if not failures else "; ".join(failures)))
+    return not failures
+
+def removeCachedFiles():
+    dataDir = cacheDir + "/data"
+    for fileName in os.listdir(dataDir):
+        os.remove(os.path.join(dataDir, fileName))
+
+def writeResult(success):
+    with open(logsDir + "/result.out", 'w') as f:
+        f.write("Result: " + str(success).lower() + "\n")
+
+if __name__ == "__main__":
+    parser = OptionParser()
+    parser.add_option("-n", "--assets", dest="numAssets", type="int")
+    (options, args) = parser.parse_args()
+    if options.numAssets:
+        numAssets = options.numAssets
+    main()